@@ -0,0 +1,33 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPMacros.h"
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Argon2id (RFC 9106), version 0x13. Used by the Argon2 S2K (RFC 9580 3.7.1.4).
+@interface PGPArgon2 : NSObject
+
+PGP_EMPTY_INIT_UNAVAILABLE;
+
+/**
+ *  Derive key. Lanes of every slice are filled concurrently, one thread per lane.
+ *
+ *  @param passes      Number of passes (t), at least 1.
+ *  @param parallelism Number of lanes (p), at least 1.
+ *  @param memorySize  Memory size in KiB (m), at least 8 * parallelism.
+ *  @param length      Output length (octets), at least 4.
+ *
+ *  @return Derived key or nil for invalid parameters or when the memory can't be allocated.
+ */
++ (nullable NSData *)deriveKeyFromPassword:(NSData *)password salt:(NSData *)salt passes:(UInt32)passes parallelism:(UInt32)parallelism memorySize:(UInt32)memorySize length:(NSUInteger)length;
+
+@end
+
+NS_ASSUME_NONNULL_END
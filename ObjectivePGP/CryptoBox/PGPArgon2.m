@@ -0,0 +1,497 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+//  Argon2id, RFC 9106. BLAKE2b with variable output length (RFC 7693) is not exposed by OpenSSL 1.1.1, hence is implemented here.
+//
+
+#import "PGPArgon2.h"
+#import "PGPMacros+Private.h"
+#import "PGPLogging.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+#pragma mark - BLAKE2b
+
+typedef struct {
+    uint64_t h[8];
+    uint64_t t[2];
+    uint64_t f[2];
+    uint8_t buf[128];
+    size_t buflen;
+    size_t outlen;
+} pgp_blake2b_state;
+
+static const uint64_t pgp_blake2b_IV[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t pgp_blake2b_sigma[12][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+    { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+    { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+    { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+    { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+    { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+    { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+    { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+    { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+};
+
+static inline uint64_t pgp_rotr64(uint64_t w, unsigned c) {
+    return (w >> c) | (w << (64 - c));
+}
+
+static inline uint64_t pgp_load64(const uint8_t *p) {
+    return ((uint64_t)p[0]) | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+           ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static inline void pgp_store64(uint8_t *p, uint64_t w) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(w >> (8 * i));
+    }
+}
+
+static inline void pgp_store32(uint8_t *p, uint32_t w) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(w >> (8 * i));
+    }
+}
+
+#define PGP_B2B_G(r, i, a, b, c, d)                          \
+    do {                                                     \
+        a = a + b + m[pgp_blake2b_sigma[r][2 * i + 0]];      \
+        d = pgp_rotr64(d ^ a, 32);                           \
+        c = c + d;                                           \
+        b = pgp_rotr64(b ^ c, 24);                           \
+        a = a + b + m[pgp_blake2b_sigma[r][2 * i + 1]];      \
+        d = pgp_rotr64(d ^ a, 16);                           \
+        c = c + d;                                           \
+        b = pgp_rotr64(b ^ c, 63);                           \
+    } while (0)
+
+static void pgp_blake2b_compress(pgp_blake2b_state *S, const uint8_t block[128]) {
+    uint64_t m[16];
+    uint64_t v[16];
+
+    for (int i = 0; i < 16; i++) {
+        m[i] = pgp_load64(block + i * 8);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        v[i] = S->h[i];
+        v[i + 8] = pgp_blake2b_IV[i];
+    }
+    v[12] ^= S->t[0];
+    v[13] ^= S->t[1];
+    v[14] ^= S->f[0];
+    v[15] ^= S->f[1];
+
+    for (int r = 0; r < 12; r++) {
+        PGP_B2B_G(r, 0, v[0], v[4], v[8], v[12]);
+        PGP_B2B_G(r, 1, v[1], v[5], v[9], v[13]);
+        PGP_B2B_G(r, 2, v[2], v[6], v[10], v[14]);
+        PGP_B2B_G(r, 3, v[3], v[7], v[11], v[15]);
+        PGP_B2B_G(r, 4, v[0], v[5], v[10], v[15]);
+        PGP_B2B_G(r, 5, v[1], v[6], v[11], v[12]);
+        PGP_B2B_G(r, 6, v[2], v[7], v[8], v[13]);
+        PGP_B2B_G(r, 7, v[3], v[4], v[9], v[14]);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        S->h[i] ^= v[i] ^ v[i + 8];
+    }
+}
+
+#undef PGP_B2B_G
+
+static void pgp_blake2b_increment_counter(pgp_blake2b_state *S, uint64_t inc) {
+    S->t[0] += inc;
+    S->t[1] += (S->t[0] < inc);
+}
+
+static void pgp_blake2b_init(pgp_blake2b_state *S, size_t outlen) {
+    memset(S, 0, sizeof(pgp_blake2b_state));
+    for (int i = 0; i < 8; i++) {
+        S->h[i] = pgp_blake2b_IV[i];
+    }
+    // parameter block: digest length, no key, fanout 1, depth 1
+    S->h[0] ^= 0x01010000ULL ^ (uint64_t)outlen;
+    S->outlen = outlen;
+}
+
+static void pgp_blake2b_update(pgp_blake2b_state *S, const uint8_t *input, size_t inlen) {
+    if (inlen == 0) {
+        return;
+    }
+
+    size_t left = S->buflen;
+    size_t fill = 128 - left;
+    if (inlen > fill) {
+        // the last block is kept in the buffer until final
+        S->buflen = 0;
+        memcpy(S->buf + left, input, fill);
+        pgp_blake2b_increment_counter(S, 128);
+        pgp_blake2b_compress(S, S->buf);
+        input += fill;
+        inlen -= fill;
+        while (inlen > 128) {
+            pgp_blake2b_increment_counter(S, 128);
+            pgp_blake2b_compress(S, input);
+            input += 128;
+            inlen -= 128;
+        }
+    }
+    memcpy(S->buf + S->buflen, input, inlen);
+    S->buflen += inlen;
+}
+
+static void pgp_blake2b_final(pgp_blake2b_state *S, uint8_t *output) {
+    uint8_t buffer[64];
+    pgp_blake2b_increment_counter(S, S->buflen);
+    S->f[0] = UINT64_MAX;
+    memset(S->buf + S->buflen, 0, 128 - S->buflen);
+    pgp_blake2b_compress(S, S->buf);
+
+    for (int i = 0; i < 8; i++) {
+        pgp_store64(buffer + i * 8, S->h[i]);
+    }
+    memcpy(output, buffer, S->outlen);
+    memset_s(buffer, sizeof(buffer), 0, sizeof(buffer));
+}
+
+// H' variable-length hash function, RFC 9106 3.3
+static void pgp_blake2b_long(uint8_t *output, uint32_t outlen, const uint8_t *input, size_t inlen) {
+    pgp_blake2b_state S;
+    uint8_t outlenBytes[4];
+    pgp_store32(outlenBytes, outlen);
+
+    if (outlen <= 64) {
+        pgp_blake2b_init(&S, outlen);
+        pgp_blake2b_update(&S, outlenBytes, 4);
+        pgp_blake2b_update(&S, input, inlen);
+        pgp_blake2b_final(&S, output);
+        return;
+    }
+
+    uint8_t V[64];
+    pgp_blake2b_init(&S, 64);
+    pgp_blake2b_update(&S, outlenBytes, 4);
+    pgp_blake2b_update(&S, input, inlen);
+    pgp_blake2b_final(&S, V);
+    memcpy(output, V, 32);
+    output += 32;
+    uint32_t remaining = outlen - 32;
+
+    while (remaining > 64) {
+        pgp_blake2b_init(&S, 64);
+        pgp_blake2b_update(&S, V, 64);
+        pgp_blake2b_final(&S, V);
+        memcpy(output, V, 32);
+        output += 32;
+        remaining -= 32;
+    }
+
+    pgp_blake2b_init(&S, remaining);
+    pgp_blake2b_update(&S, V, 64);
+    pgp_blake2b_final(&S, output);
+}
+
+#pragma mark - Argon2
+
+#define PGP_ARGON2_BLOCK_WORDS 128
+#define PGP_ARGON2_BLOCK_SIZE 1024
+#define PGP_ARGON2_SYNC_POINTS 4
+#define PGP_ARGON2_VERSION 0x13
+#define PGP_ARGON2_TYPE_ID 2
+
+typedef struct {
+    uint64_t v[PGP_ARGON2_BLOCK_WORDS];
+} pgp_argon2_block;
+
+typedef struct {
+    pgp_argon2_block *memory;
+    uint32_t passes;
+    uint32_t lanes;
+    uint32_t laneLength;
+    uint32_t segmentLength;
+    uint32_t memoryBlocks;
+} pgp_argon2_instance;
+
+static inline uint64_t pgp_argon2_fBlaMka(uint64_t x, uint64_t y) {
+    const uint64_t m = 0xFFFFFFFFULL;
+    return x + y + 2 * ((x & m) * (y & m));
+}
+
+#define PGP_ARGON2_G(a, b, c, d)                    \
+    do {                                            \
+        a = pgp_argon2_fBlaMka(a, b);               \
+        d = pgp_rotr64(d ^ a, 32);                  \
+        c = pgp_argon2_fBlaMka(c, d);               \
+        b = pgp_rotr64(b ^ c, 24);                  \
+        a = pgp_argon2_fBlaMka(a, b);               \
+        d = pgp_rotr64(d ^ a, 16);                  \
+        c = pgp_argon2_fBlaMka(c, d);               \
+        b = pgp_rotr64(b ^ c, 63);                  \
+    } while (0)
+
+#define PGP_ARGON2_ROUND(v0, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15) \
+    do {                                                                                       \
+        PGP_ARGON2_G(v0, v4, v8, v12);                                                         \
+        PGP_ARGON2_G(v1, v5, v9, v13);                                                         \
+        PGP_ARGON2_G(v2, v6, v10, v14);                                                        \
+        PGP_ARGON2_G(v3, v7, v11, v15);                                                        \
+        PGP_ARGON2_G(v0, v5, v10, v15);                                                        \
+        PGP_ARGON2_G(v1, v6, v11, v12);                                                        \
+        PGP_ARGON2_G(v2, v7, v8, v13);                                                         \
+        PGP_ARGON2_G(v3, v4, v9, v14);                                                         \
+    } while (0)
+
+// Compression function G (RFC 9106 3.5). With `withXor` the result is XORed into the existing `next` block (passes after the first).
+static void pgp_argon2_fill_block(const pgp_argon2_block *prev, const pgp_argon2_block *ref, pgp_argon2_block *next, BOOL withXor) {
+    pgp_argon2_block R;
+    pgp_argon2_block tmp;
+
+    for (int i = 0; i < PGP_ARGON2_BLOCK_WORDS; i++) {
+        R.v[i] = ref->v[i] ^ prev->v[i];
+        tmp.v[i] = withXor ? R.v[i] ^ next->v[i] : R.v[i];
+    }
+
+    uint64_t *v = R.v;
+    // rows
+    for (int i = 0; i < 8; i++) {
+        PGP_ARGON2_ROUND(v[16 * i], v[16 * i + 1], v[16 * i + 2], v[16 * i + 3],
+                         v[16 * i + 4], v[16 * i + 5], v[16 * i + 6], v[16 * i + 7],
+                         v[16 * i + 8], v[16 * i + 9], v[16 * i + 10], v[16 * i + 11],
+                         v[16 * i + 12], v[16 * i + 13], v[16 * i + 14], v[16 * i + 15]);
+    }
+    // columns
+    for (int i = 0; i < 8; i++) {
+        PGP_ARGON2_ROUND(v[2 * i], v[2 * i + 1], v[2 * i + 16], v[2 * i + 17],
+                         v[2 * i + 32], v[2 * i + 33], v[2 * i + 48], v[2 * i + 49],
+                         v[2 * i + 64], v[2 * i + 65], v[2 * i + 80], v[2 * i + 81],
+                         v[2 * i + 96], v[2 * i + 97], v[2 * i + 112], v[2 * i + 113]);
+    }
+
+    for (int i = 0; i < PGP_ARGON2_BLOCK_WORDS; i++) {
+        next->v[i] = tmp.v[i] ^ R.v[i];
+    }
+}
+
+#undef PGP_ARGON2_ROUND
+#undef PGP_ARGON2_G
+
+static void pgp_argon2_next_addresses(pgp_argon2_block *addressBlock, pgp_argon2_block *inputBlock, const pgp_argon2_block *zeroBlock) {
+    inputBlock->v[6]++;
+    pgp_argon2_fill_block(zeroBlock, inputBlock, addressBlock, NO);
+    pgp_argon2_fill_block(zeroBlock, addressBlock, addressBlock, NO);
+}
+
+static uint32_t pgp_argon2_index_alpha(const pgp_argon2_instance *instance, uint32_t pass, uint32_t slice, uint32_t index, uint32_t pseudoRand, BOOL sameLane) {
+    uint32_t referenceAreaSize;
+    if (pass == 0) {
+        if (slice == 0) {
+            referenceAreaSize = index - 1;
+        } else if (sameLane) {
+            referenceAreaSize = slice * instance->segmentLength + index - 1;
+        } else {
+            referenceAreaSize = slice * instance->segmentLength + ((index == 0) ? -1 : 0);
+        }
+    } else {
+        if (sameLane) {
+            referenceAreaSize = instance->laneLength - instance->segmentLength + index - 1;
+        } else {
+            referenceAreaSize = instance->laneLength - instance->segmentLength + ((index == 0) ? -1 : 0);
+        }
+    }
+
+    uint64_t relativePosition = pseudoRand;
+    relativePosition = relativePosition * relativePosition >> 32;
+    relativePosition = referenceAreaSize - 1 - (referenceAreaSize * relativePosition >> 32);
+
+    uint32_t startPosition = 0;
+    if (pass != 0) {
+        startPosition = (slice == PGP_ARGON2_SYNC_POINTS - 1) ? 0 : (slice + 1) * instance->segmentLength;
+    }
+
+    return (uint32_t)((startPosition + relativePosition) % instance->laneLength);
+}
+
+static void pgp_argon2_fill_segment(const pgp_argon2_instance *instance, uint32_t pass, uint32_t lane, uint32_t slice) {
+    // Argon2id: data-independent addressing for the first half of the first pass
+    BOOL dataIndependent = pass == 0 && slice < PGP_ARGON2_SYNC_POINTS / 2;
+
+    pgp_argon2_block zeroBlock;
+    pgp_argon2_block inputBlock;
+    pgp_argon2_block addressBlock;
+    if (dataIndependent) {
+        memset(&zeroBlock, 0, sizeof(zeroBlock));
+        memset(&inputBlock, 0, sizeof(inputBlock));
+        inputBlock.v[0] = pass;
+        inputBlock.v[1] = lane;
+        inputBlock.v[2] = slice;
+        inputBlock.v[3] = instance->memoryBlocks;
+        inputBlock.v[4] = instance->passes;
+        inputBlock.v[5] = PGP_ARGON2_TYPE_ID;
+    }
+
+    uint32_t startingIndex = 0;
+    if (pass == 0 && slice == 0) {
+        // first two blocks of every lane are already generated
+        startingIndex = 2;
+        if (dataIndependent) {
+            pgp_argon2_next_addresses(&addressBlock, &inputBlock, &zeroBlock);
+        }
+    }
+
+    uint32_t currentOffset = lane * instance->laneLength + slice * instance->segmentLength + startingIndex;
+    uint32_t previousOffset = (currentOffset % instance->laneLength == 0) ? currentOffset + instance->laneLength - 1 : currentOffset - 1;
+
+    for (uint32_t i = startingIndex; i < instance->segmentLength; i++, currentOffset++, previousOffset++) {
+        if (currentOffset % instance->laneLength == 1) {
+            previousOffset = currentOffset - 1;
+        }
+
+        uint64_t pseudoRand;
+        if (dataIndependent) {
+            if (i % PGP_ARGON2_BLOCK_WORDS == 0) {
+                pgp_argon2_next_addresses(&addressBlock, &inputBlock, &zeroBlock);
+            }
+            pseudoRand = addressBlock.v[i % PGP_ARGON2_BLOCK_WORDS];
+        } else {
+            pseudoRand = instance->memory[previousOffset].v[0];
+        }
+
+        uint32_t refLane = (uint32_t)((pseudoRand >> 32) % instance->lanes);
+        if (pass == 0 && slice == 0) {
+            refLane = lane;
+        }
+
+        uint32_t refIndex = pgp_argon2_index_alpha(instance, pass, slice, i, (uint32_t)(pseudoRand & 0xFFFFFFFF), refLane == lane);
+        let refBlock = instance->memory + (size_t)instance->laneLength * refLane + refIndex;
+        let currentBlock = instance->memory + currentOffset;
+        pgp_argon2_fill_block(instance->memory + previousOffset, refBlock, currentBlock, pass != 0);
+    }
+}
+
+static void pgp_argon2_block_from_bytes(pgp_argon2_block *block, const uint8_t *bytes) {
+    for (int i = 0; i < PGP_ARGON2_BLOCK_WORDS; i++) {
+        block->v[i] = pgp_load64(bytes + i * 8);
+    }
+}
+
+static void pgp_argon2_block_to_bytes(uint8_t *bytes, const pgp_argon2_block *block) {
+    for (int i = 0; i < PGP_ARGON2_BLOCK_WORDS; i++) {
+        pgp_store64(bytes + i * 8, block->v[i]);
+    }
+}
+
+@implementation PGPArgon2
+
++ (nullable NSData *)deriveKeyFromPassword:(NSData *)password salt:(NSData *)salt passes:(UInt32)passes parallelism:(UInt32)parallelism memorySize:(UInt32)memorySize length:(NSUInteger)length {
+    if (passes < 1 || parallelism < 1 || parallelism > 0xFFFFFF || memorySize < 8 * parallelism || length < 4 || length > UINT32_MAX || salt.length < 8) {
+        PGPLogWarning(@"Invalid Argon2 parameters.");
+        return nil;
+    }
+
+    // Memory blocks, rounded down to a multiple of 4 * p
+    uint32_t memoryBlocks = (memorySize / (PGP_ARGON2_SYNC_POINTS * parallelism)) * (PGP_ARGON2_SYNC_POINTS * parallelism);
+    pgp_argon2_instance instance = {
+        .passes = passes,
+        .lanes = parallelism,
+        .laneLength = memoryBlocks / parallelism,
+        .segmentLength = memoryBlocks / (parallelism * PGP_ARGON2_SYNC_POINTS),
+        .memoryBlocks = memoryBlocks,
+        .memory = NULL
+    };
+
+    size_t memoryLength = (size_t)memoryBlocks * sizeof(pgp_argon2_block);
+    instance.memory = malloc(memoryLength);
+    if (!instance.memory) {
+        PGPLogWarning(@"Can't allocate Argon2 memory (%@ KiB).", @(memorySize));
+        return nil;
+    }
+    pgp_defer {
+        memset_s(instance.memory, memoryLength, 0, memoryLength);
+        free(instance.memory);
+    };
+
+    // H0
+    uint8_t H0[64 + 8];
+    {
+        pgp_blake2b_state S;
+        uint8_t value[4];
+        pgp_blake2b_init(&S, 64);
+        uint32_t parameters[6] = {parallelism, (uint32_t)length, memorySize, passes, PGP_ARGON2_VERSION, PGP_ARGON2_TYPE_ID};
+        for (int i = 0; i < 6; i++) {
+            pgp_store32(value, parameters[i]);
+            pgp_blake2b_update(&S, value, 4);
+        }
+        pgp_store32(value, (uint32_t)password.length);
+        pgp_blake2b_update(&S, value, 4);
+        pgp_blake2b_update(&S, password.bytes, password.length);
+        pgp_store32(value, (uint32_t)salt.length);
+        pgp_blake2b_update(&S, value, 4);
+        pgp_blake2b_update(&S, salt.bytes, salt.length);
+        // no secret value K, no associated data X
+        pgp_store32(value, 0);
+        pgp_blake2b_update(&S, value, 4);
+        pgp_blake2b_update(&S, value, 4);
+        pgp_blake2b_final(&S, H0);
+    }
+
+    // First two blocks of every lane
+    uint8_t blockBytes[PGP_ARGON2_BLOCK_SIZE];
+    for (uint32_t lane = 0; lane < parallelism; lane++) {
+        for (uint32_t column = 0; column < 2; column++) {
+            pgp_store32(H0 + 64, column);
+            pgp_store32(H0 + 68, lane);
+            pgp_blake2b_long(blockBytes, PGP_ARGON2_BLOCK_SIZE, H0, sizeof(H0));
+            pgp_argon2_block_from_bytes(instance.memory + (size_t)lane * instance.laneLength + column, blockBytes);
+        }
+    }
+    memset_s(H0, sizeof(H0), 0, sizeof(H0));
+
+    // Segments of the same slice are independent, lanes synchronize at the end of every slice.
+    let queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+    let instancePtr = &instance;
+    for (uint32_t pass = 0; pass < passes; pass++) {
+        for (uint32_t slice = 0; slice < PGP_ARGON2_SYNC_POINTS; slice++) {
+            if (parallelism == 1) {
+                pgp_argon2_fill_segment(instancePtr, pass, 0, slice);
+                continue;
+            }
+            dispatch_apply(parallelism, queue, ^(size_t lane) {
+                pgp_argon2_fill_segment(instancePtr, pass, (uint32_t)lane, slice);
+            });
+        }
+    }
+
+    // Final block: XOR of the last column
+    pgp_argon2_block finalBlock = instance.memory[instance.laneLength - 1];
+    for (uint32_t lane = 1; lane < parallelism; lane++) {
+        let lastBlock = instance.memory + (size_t)lane * instance.laneLength + instance.laneLength - 1;
+        for (int i = 0; i < PGP_ARGON2_BLOCK_WORDS; i++) {
+            finalBlock.v[i] ^= lastBlock->v[i];
+        }
+    }
+    pgp_argon2_block_to_bytes(blockBytes, &finalBlock);
+
+    let output = [NSMutableData dataWithLength:length];
+    pgp_blake2b_long(output.mutableBytes, (uint32_t)length, blockBytes, PGP_ARGON2_BLOCK_SIZE);
+    memset_s(blockBytes, sizeof(blockBytes), 0, sizeof(blockBytes));
+    memset_s(&finalBlock, sizeof(finalBlock), 0, sizeof(finalBlock));
+    return output;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
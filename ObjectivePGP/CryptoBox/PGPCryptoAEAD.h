@@ -0,0 +1,56 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPTypes.h"
+#import "PGPMacros.h"
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Authentication tag size (octets) of every AEAD mode defined by RFC 9580.
+extern const NSUInteger PGPAEADTagSize;
+
+/// Authenticated encryption (OCB, GCM) used by v2 SEIPD and v6 SKESK packets.
+@interface PGPCryptoAEAD : NSObject
+
+PGP_EMPTY_INIT_UNAVAILABLE;
+
++ (BOOL)isSupportedAEADAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm;
++ (NSUInteger)nonceSizeOfAEADAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm;
+
+/// Encrypt data at once. Returns ciphertext followed by the authentication tag.
++ (nullable NSData *)encryptData:(NSData *)data key:(NSData *)key nonce:(NSData *)nonce associatedData:(nullable NSData *)associatedData symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm error:(NSError * __autoreleasing _Nullable *)error;
+
+/// Decrypt ciphertext followed by the authentication tag. Returns nil if authentication fails.
++ (nullable NSData *)decryptData:(NSData *)data key:(NSData *)key nonce:(NSData *)nonce associatedData:(nullable NSData *)associatedData symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ *  Chunked AEAD encryption (RFC 9580 5.13.2). Chunks are independent and encrypted concurrently.
+ *
+ *  @param iv The leftmost (nonce size - 8) octets of every chunk nonce. The rightmost 8 octets are the chunk index.
+ *
+ *  @return Encrypted chunks, each followed by its tag, then the final authentication tag.
+ */
++ (nullable NSData *)encryptChunkedData:(NSData *)data key:(NSData *)key iv:(NSData *)iv associatedData:(NSData *)associatedData chunkSize:(NSUInteger)chunkSize symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ *  Chunked AEAD decryption. Chunks are authenticated concurrently, a window at a time, and passed
+ *  to the block in order. A chunk is passed only after its own tag is verified; the final tag,
+ *  that protects against truncation, is verified after the last chunk.
+ *
+ *  @return YES if every chunk and the final tag authenticates. NO if the block stops the decryption,
+ *          as the final tag is not verified then.
+ */
++ (BOOL)decryptChunkedData:(NSData *)data key:(NSData *)key iv:(NSData *)iv associatedData:(NSData *)associatedData chunkSize:(NSUInteger)chunkSize symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm error:(NSError * __autoreleasing _Nullable *)error usingBlock:(NS_NOESCAPE void (^)(NSData *plaintextChunk, BOOL *stop))block;
+
+/// HKDF (RFC 5869) with SHA256.
++ (nullable NSData *)HKDFSHA256WithKey:(NSData *)key salt:(nullable NSData *)salt info:(NSData *)info length:(NSUInteger)length;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,377 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPCryptoAEAD.h"
+#import "PGPCryptoUtils.h"
+#import "PGPFoundation.h"
+#import "PGPLogging.h"
+#import "PGPMacros+Private.h"
+
+#import <openssl/err.h>
+#import <openssl/evp.h>
+#import <openssl/kdf.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+const NSUInteger PGPAEADTagSize = 16;
+
+// Number of chunks decrypted concurrently before the verified plaintext is handed over.
+static const NSUInteger PGPAEADChunksWindowFactor = 4;
+
+static const EVP_CIPHER * _Nullable pgp_aead_cipher(PGPSymmetricAlgorithm symmetricAlgorithm, PGPAEADAlgorithm aeadAlgorithm) {
+    switch (aeadAlgorithm) {
+        case PGPAEADOCB:
+            switch (symmetricAlgorithm) {
+                case PGPSymmetricAES128:
+                    return EVP_aes_128_ocb();
+                case PGPSymmetricAES192:
+                    return EVP_aes_192_ocb();
+                case PGPSymmetricAES256:
+                    return EVP_aes_256_ocb();
+                default:
+                    return NULL;
+            }
+        case PGPAEADGCM:
+            switch (symmetricAlgorithm) {
+                case PGPSymmetricAES128:
+                    return EVP_aes_128_gcm();
+                case PGPSymmetricAES192:
+                    return EVP_aes_192_gcm();
+                case PGPSymmetricAES256:
+                    return EVP_aes_256_gcm();
+                default:
+                    return NULL;
+            }
+        case PGPAEADEAX:
+            // EAX is not provided by OpenSSL
+        case PGPAEADUnknown:
+            return NULL;
+    }
+    return NULL;
+}
+
+// One AEAD operation. For encryption the tag is written to `tag`, for decryption `tag` is the expected tag.
+static BOOL pgp_aead_crypt(const EVP_CIPHER *cipher, BOOL encrypt, BOOL isOCB, const uint8_t *key, const uint8_t *nonce, int nonceLength, const uint8_t * _Nullable ad, int adLength, const uint8_t * _Nullable input, int inputLength, uint8_t * _Nullable output, uint8_t *tag) {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        return NO;
+    }
+    pgp_defer {
+        EVP_CIPHER_CTX_free(ctx);
+    };
+
+    int enc = encrypt ? 1 : 0;
+    if (EVP_CipherInit_ex(ctx, cipher, NULL, NULL, NULL, enc) != 1) {
+        return NO;
+    }
+
+    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, nonceLength, NULL) != 1) {
+        return NO;
+    }
+
+    // OCB tag length has to be set before the key
+    if (isOCB && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, (int)PGPAEADTagSize, NULL) != 1) {
+        return NO;
+    }
+
+    if (EVP_CipherInit_ex(ctx, NULL, NULL, key, nonce, enc) != 1) {
+        return NO;
+    }
+
+    if (!encrypt && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, (int)PGPAEADTagSize, tag) != 1) {
+        return NO;
+    }
+
+    int outLength = 0;
+    if (ad && adLength > 0 && EVP_CipherUpdate(ctx, NULL, &outLength, ad, adLength) != 1) {
+        return NO;
+    }
+
+    int written = 0;
+    if (input && inputLength > 0) {
+        if (EVP_CipherUpdate(ctx, output, &outLength, input, inputLength) != 1) {
+            return NO;
+        }
+        written = outLength;
+    }
+
+    uint8_t finalBlock[EVP_MAX_BLOCK_LENGTH];
+    if (EVP_CipherFinal_ex(ctx, output ? output + written : finalBlock, &outLength) != 1) {
+        // authentication failure on decrypt
+        return NO;
+    }
+
+    if (encrypt && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, (int)PGPAEADTagSize, tag) != 1) {
+        return NO;
+    }
+
+    return YES;
+}
+
+static void pgp_aead_chunk_nonce(uint8_t *nonce, NSData *iv, UInt64 index) {
+    memcpy(nonce, iv.bytes, iv.length);
+    for (int i = 0; i < 8; i++) {
+        nonce[iv.length + i] = (uint8_t)(index >> (56 - i * 8));
+    }
+}
+
+@implementation PGPCryptoAEAD
+
++ (BOOL)isSupportedAEADAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm {
+    return pgp_aead_cipher(symmetricAlgorithm, aeadAlgorithm) != NULL;
+}
+
++ (NSUInteger)nonceSizeOfAEADAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm {
+    switch (aeadAlgorithm) {
+        case PGPAEADEAX:
+            return 16;
+        case PGPAEADOCB:
+            return 15;
+        case PGPAEADGCM:
+            return 12;
+        case PGPAEADUnknown:
+            break;
+    }
+    return NSNotFound;
+}
+
++ (nullable NSData *)encryptData:(NSData *)data key:(NSData *)key nonce:(NSData *)nonce associatedData:(nullable NSData *)associatedData symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm error:(NSError * __autoreleasing _Nullable *)error {
+    let cipher = pgp_aead_cipher(symmetricAlgorithm, aeadAlgorithm);
+    if (!cipher || key.length != [PGPCryptoUtils keySizeOfSymmetricAlgorithm:symmetricAlgorithm]) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unsupported AEAD algorithm." }];
+        }
+        return nil;
+    }
+
+    let output = [NSMutableData dataWithLength:data.length + PGPAEADTagSize];
+    uint8_t *outputBytes = output.mutableBytes;
+    if (!pgp_aead_crypt(cipher, YES, aeadAlgorithm == PGPAEADOCB, key.bytes, nonce.bytes, (int)nonce.length, associatedData.bytes, (int)associatedData.length, data.bytes, (int)data.length, outputBytes, outputBytes + data.length)) {
+        #if PGP_LOG_LEVEL >= PGP_DEBUG_LEVEL
+        char *err_str = ERR_error_string(ERR_get_error(), NULL);
+        PGPLogDebug(@"%@", [NSString stringWithCString:err_str encoding:NSASCIIStringEncoding]);
+        #endif
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Encryption failed." }];
+        }
+        return nil;
+    }
+    return output;
+}
+
++ (nullable NSData *)decryptData:(NSData *)data key:(NSData *)key nonce:(NSData *)nonce associatedData:(nullable NSData *)associatedData symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm error:(NSError * __autoreleasing _Nullable *)error {
+    let cipher = pgp_aead_cipher(symmetricAlgorithm, aeadAlgorithm);
+    if (!cipher || key.length != [PGPCryptoUtils keySizeOfSymmetricAlgorithm:symmetricAlgorithm]) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unsupported AEAD algorithm." }];
+        }
+        return nil;
+    }
+
+    if (data.length < PGPAEADTagSize) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Missing authentication tag." }];
+        }
+        return nil;
+    }
+
+    NSUInteger ciphertextLength = data.length - PGPAEADTagSize;
+    let output = [NSMutableData dataWithLength:ciphertextLength];
+    const uint8_t *inputBytes = data.bytes;
+    uint8_t tag[PGPAEADTagSize];
+    memcpy(tag, inputBytes + ciphertextLength, PGPAEADTagSize);
+    if (!pgp_aead_crypt(cipher, NO, aeadAlgorithm == PGPAEADOCB, key.bytes, nonce.bytes, (int)nonce.length, associatedData.bytes, (int)associatedData.length, inputBytes, (int)ciphertextLength, output.mutableBytes, tag)) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Authentication failed." }];
+        }
+        return nil;
+    }
+    return output;
+}
+
+#pragma mark - Chunked
+
++ (NSData *)finalAssociatedData:(NSData *)associatedData totalLength:(UInt64)totalLength {
+    let finalAD = [NSMutableData dataWithData:associatedData];
+    UInt64 totalLengthBE = CFSwapInt64HostToBig(totalLength);
+    [finalAD appendBytes:&totalLengthBE length:8];
+    return finalAD;
+}
+
++ (nullable NSData *)encryptChunkedData:(NSData *)data key:(NSData *)key iv:(NSData *)iv associatedData:(NSData *)associatedData chunkSize:(NSUInteger)chunkSize symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm error:(NSError * __autoreleasing _Nullable *)error {
+    let cipher = pgp_aead_cipher(symmetricAlgorithm, aeadAlgorithm);
+    NSUInteger nonceSize = [self nonceSizeOfAEADAlgorithm:aeadAlgorithm];
+    if (!cipher || chunkSize == 0 || iv.length + 8 != nonceSize || key.length != [PGPCryptoUtils keySizeOfSymmetricAlgorithm:symmetricAlgorithm]) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unsupported AEAD algorithm." }];
+        }
+        return nil;
+    }
+
+    BOOL isOCB = aeadAlgorithm == PGPAEADOCB;
+    NSUInteger chunksCount = (data.length + chunkSize - 1) / chunkSize;
+    let output = [NSMutableData dataWithLength:data.length + (chunksCount + 1) * PGPAEADTagSize];
+    uint8_t *outputBytes = output.mutableBytes;
+    const uint8_t *inputBytes = data.bytes;
+    const uint8_t *keyBytes = key.bytes;
+
+    // Every chunk writes to its own, precomputed, range of the output buffer.
+    __block BOOL failed = NO;
+    dispatch_apply(chunksCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        NSUInteger inputOffset = index * chunkSize;
+        NSUInteger inputLength = MIN(chunkSize, data.length - inputOffset);
+        NSUInteger outputOffset = index * (chunkSize + PGPAEADTagSize);
+
+        uint8_t nonce[nonceSize];
+        pgp_aead_chunk_nonce(nonce, iv, index);
+        if (!pgp_aead_crypt(cipher, YES, isOCB, keyBytes, nonce, (int)nonceSize, associatedData.bytes, (int)associatedData.length, inputBytes + inputOffset, (int)inputLength, outputBytes + outputOffset, outputBytes + outputOffset + inputLength)) {
+            failed = YES;
+        }
+    });
+
+    // Final authentication tag: empty plaintext, associated data includes the total plaintext length.
+    let finalAD = [self finalAssociatedData:associatedData totalLength:data.length];
+    uint8_t nonce[nonceSize];
+    pgp_aead_chunk_nonce(nonce, iv, chunksCount);
+    if (failed || !pgp_aead_crypt(cipher, YES, isOCB, keyBytes, nonce, (int)nonceSize, finalAD.bytes, (int)finalAD.length, NULL, 0, NULL, outputBytes + output.length - PGPAEADTagSize)) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Encryption failed." }];
+        }
+        return nil;
+    }
+
+    return output;
+}
+
++ (BOOL)decryptChunkedData:(NSData *)data key:(NSData *)key iv:(NSData *)iv associatedData:(NSData *)associatedData chunkSize:(NSUInteger)chunkSize symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm error:(NSError * __autoreleasing _Nullable *)error usingBlock:(NS_NOESCAPE void (^)(NSData *plaintextChunk, BOOL *stop))block {
+    let cipher = pgp_aead_cipher(symmetricAlgorithm, aeadAlgorithm);
+    NSUInteger nonceSize = [self nonceSizeOfAEADAlgorithm:aeadAlgorithm];
+    if (!cipher || chunkSize == 0 || iv.length + 8 != nonceSize || key.length != [PGPCryptoUtils keySizeOfSymmetricAlgorithm:symmetricAlgorithm]) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unsupported AEAD algorithm." }];
+        }
+        return NO;
+    }
+
+    if (data.length < PGPAEADTagSize) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Missing authentication tag." }];
+        }
+        return NO;
+    }
+
+    // Chunks layout: [chunk || tag] ... [last chunk || tag] final tag
+    NSUInteger encryptedChunkSize = chunkSize + PGPAEADTagSize;
+    NSUInteger chunksDataLength = data.length - PGPAEADTagSize;
+    NSUInteger chunksCount = (chunksDataLength + encryptedChunkSize - 1) / encryptedChunkSize;
+    NSUInteger lastChunkLength = chunksDataLength - (chunksCount > 0 ? (chunksCount - 1) * encryptedChunkSize : 0);
+    if (chunksCount > 0 && lastChunkLength < PGPAEADTagSize) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Invalid chunk." }];
+        }
+        return NO;
+    }
+
+    BOOL isOCB = aeadAlgorithm == PGPAEADOCB;
+    const uint8_t *inputBytes = data.bytes;
+    const uint8_t *keyBytes = key.bytes;
+    NSUInteger windowSize = MAX((NSUInteger)1, NSProcessInfo.processInfo.activeProcessorCount * PGPAEADChunksWindowFactor);
+    let window = [NSMutableData dataWithLength:MIN(windowSize, MAX(chunksCount, (NSUInteger)1)) * chunkSize];
+    UInt64 totalLength = 0;
+
+    for (NSUInteger windowStart = 0; windowStart < chunksCount; windowStart += windowSize) {
+        NSUInteger windowCount = MIN(windowSize, chunksCount - windowStart);
+        uint8_t *windowBytes = window.mutableBytes;
+        __block BOOL failed = NO;
+        dispatch_apply(windowCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t windowIndex) {
+            NSUInteger index = windowStart + windowIndex;
+            NSUInteger inputOffset = index * encryptedChunkSize;
+            NSUInteger inputLength = (index == chunksCount - 1 ? lastChunkLength : encryptedChunkSize) - PGPAEADTagSize;
+
+            uint8_t nonce[nonceSize];
+            pgp_aead_chunk_nonce(nonce, iv, index);
+            uint8_t tag[PGPAEADTagSize];
+            memcpy(tag, inputBytes + inputOffset + inputLength, PGPAEADTagSize);
+            if (!pgp_aead_crypt(cipher, NO, isOCB, keyBytes, nonce, (int)nonceSize, associatedData.bytes, (int)associatedData.length, inputBytes + inputOffset, (int)inputLength, windowBytes + windowIndex * chunkSize, tag)) {
+                failed = YES;
+            }
+        });
+
+        if (failed) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Authentication failed. Content modification detected." }];
+            }
+            return NO;
+        }
+
+        // Hand over the verified chunks, in order
+        for (NSUInteger windowIndex = 0; windowIndex < windowCount; windowIndex++) {
+            NSUInteger index = windowStart + windowIndex;
+            NSUInteger plaintextLength = (index == chunksCount - 1 ? lastChunkLength : encryptedChunkSize) - PGPAEADTagSize;
+            totalLength += plaintextLength;
+            BOOL stop = NO;
+            block([NSData dataWithBytes:windowBytes + windowIndex * chunkSize length:plaintextLength], &stop);
+            if (stop) {
+                // The final tag is not verified, the passed chunks may be a truncated message.
+                if (error) {
+                    *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Decryption stopped. The final authentication tag is not verified." }];
+                }
+                return NO;
+            }
+        }
+    }
+
+    let finalAD = [self finalAssociatedData:associatedData totalLength:totalLength];
+    uint8_t nonce[nonceSize];
+    pgp_aead_chunk_nonce(nonce, iv, chunksCount);
+    uint8_t tag[PGPAEADTagSize];
+    memcpy(tag, inputBytes + chunksDataLength, PGPAEADTagSize);
+    if (!pgp_aead_crypt(cipher, NO, isOCB, keyBytes, nonce, (int)nonceSize, finalAD.bytes, (int)finalAD.length, NULL, 0, NULL, tag)) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Final authentication tag mismatch. Content truncated or modified." }];
+        }
+        return NO;
+    }
+
+    return YES;
+}
+
+#pragma mark - KDF
+
++ (nullable NSData *)HKDFSHA256WithKey:(NSData *)key salt:(nullable NSData *)salt info:(NSData *)info length:(NSUInteger)length {
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
+    if (!pctx) {
+        return nil;
+    }
+    pgp_defer {
+        EVP_PKEY_CTX_free(pctx);
+    };
+
+    if (EVP_PKEY_derive_init(pctx) <= 0 ||
+        EVP_PKEY_CTX_set_hkdf_md(pctx, EVP_sha256()) <= 0 ||
+        (salt.length > 0 && EVP_PKEY_CTX_set1_hkdf_salt(pctx, salt.bytes, (int)salt.length) <= 0) ||
+        EVP_PKEY_CTX_set1_hkdf_key(pctx, key.bytes, (int)key.length) <= 0 ||
+        EVP_PKEY_CTX_add1_hkdf_info(pctx, info.bytes, (int)info.length) <= 0) {
+        #if PGP_LOG_LEVEL >= PGP_DEBUG_LEVEL
+        char *err_str = ERR_error_string(ERR_get_error(), NULL);
+        PGPLogDebug(@"%@", [NSString stringWithCString:err_str encoding:NSASCIIStringEncoding]);
+        #endif
+        return nil;
+    }
+
+    let output = [NSMutableData dataWithLength:length];
+    size_t outputLength = length;
+    if (EVP_PKEY_derive(pctx, output.mutableBytes, &outputLength) <= 0 || outputLength != length) {
+        return nil;
+    }
+    return output;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -22,11 +22,31 @@ PGP_EMPTY_INIT_UNAVAILABLE;
 
 + (nullable NSData *)generate25519PrivateEphemeralKeyWith:(NSData *)publicKeyEphemeralPart curveKind:(PGPCurve)curveKind privateKey:(NSData *)privateKey;
 
+/// ECDH shared secret of the ephemeral public key and the secret key, for any supported curve.
++ (nullable NSData *)ECDHSharedKeyWithEphemeralPublicKey:(NSData *)publicPartEphemeralKey secretKeyPacket:(PGPSecretKeyPacket *)secretKeyPacket;
+
 + (BOOL)publicEncrypt:(nonnull NSData *)data withPublicKeyPacket:(PGPPublicKeyPacket *)publicKeyPacket publicKey:(NSData * __autoreleasing _Nullable * _Nullable)publicKey encodedSymmetricKey:(NSData * __autoreleasing _Nullable * _Nullable)encodedSymmetricKey;
 
 + (NSArray<PGPMPI *> *)sign:(NSData *)toSign key:(PGPKey *)key withHashAlgorithm:(PGPHashAlgorithm)hashAlgorithm;
 + (BOOL)verify:(NSData *)toVerify signature:(PGPSignaturePacket *)signaturePacket withPublicKeyPacket:(PGPPublicKeyPacket *)publicKeyPacket withHashAlgorithm:(PGPHashAlgorithm)hashAlgorithm;
 
+/**
+ *  Verify many Ed25519 signatures. Every distinct public key is decoded once, and the
+ *  signatures are verified concurrently, each with the single signature check. This is not
+ *  the randomized batch equation: OpenSSL has no Ed25519 group arithmetic to build it on.
+ *  The arrays must have the same count, otherwise every signature fails.
+ *
+ *  @param digests    Signed digests.
+ *  @param signatures Signatures, R || S, 64 octets each.
+ *  @param publicKeys Public keys, 32 octets each (without the 0x40 prefix).
+ *
+ *  @return Indexes of the signatures that failed to verify. Empty if every signature is valid.
+ */
++ (NSIndexSet *)verifyEd25519Digests:(NSArray<NSData *> *)digests signatures:(NSArray<NSData *> *)signatures publicKeys:(NSArray<NSData *> *)publicKeys;
+
+/// Ed25519 signature (R || S) of the signature MPIs. MPIs drop leading zero octets, these are restored.
++ (nullable NSData *)ed25519SignatureDataWithR:(NSData *)r s:(NSData *)s;
+
 //new keys
 + (nullable PGPKeyMaterial *)generateNewKeyMPIArray:(PGPCurve)curve;
 
@@ -38,6 +38,131 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+static const NSUInteger PGPEd25519KeySize = 32;
+static const NSUInteger PGPEd25519SignatureSize = 64;
+
+#pragma mark - NIST and Brainpool curves
+
+static int pgp_ec_curve_nid(PGPCurve curveKind) {
+    switch (curveKind) {
+        case PGPCurveP256:
+            return NID_X9_62_prime256v1;
+        case PGPCurveP384:
+            return NID_secp384r1;
+        case PGPCurveP521:
+            return NID_secp521r1;
+        case PGPCurveBrainpoolP256r1:
+            return NID_brainpoolP256r1;
+        case PGPCurveBrainpoolP512r1:
+            return NID_brainpoolP512r1;
+        case PGPCurveEd25519:
+        case PGPCurve25519:
+            break;
+    }
+    return NID_undef;
+}
+
+/// Curve group, built once per curve and shared by every key on the curve (EC_KEY_set_group keeps a reference).
+/// No generator table is precomputed: OpenSSL multiplies the generator with the constant time ladder
+/// when signing or generating keys, which ignores the table.
+static const EC_GROUP * _Nullable pgp_ec_shared_group(PGPCurve curveKind) {
+    static EC_GROUP *groups[PGPCurve25519 + 1];
+    static dispatch_once_t onceTokens[PGPCurve25519 + 1];
+
+    let nid = pgp_ec_curve_nid(curveKind);
+    if (nid == NID_undef) {
+        return NULL;
+    }
+
+    dispatch_once(&onceTokens[curveKind], ^{
+        groups[curveKind] = EC_GROUP_new_by_curve_name(nid);
+    });
+    return groups[curveKind];
+}
+
+static EVP_PKEY * _Nullable pgp_ec_pkey_with_ec_key(EC_KEY *ec_key) {
+    let pkey = EVP_PKEY_new();
+    if (!pkey || EVP_PKEY_assign_EC_KEY(pkey, ec_key) != 1) {
+        EVP_PKEY_free(pkey);
+        EC_KEY_free(ec_key);
+        return NULL;
+    }
+    return pkey;
+}
+
+/// Key from the encoded public point, and the private scalar if given.
+static EVP_PKEY * _Nullable pgp_ec_pkey(PGPCurve curveKind, NSData *publicPoint, NSData * _Nullable privateKey) {
+    let group = pgp_ec_shared_group(curveKind);
+    let ec_key = EC_KEY_new();
+    if (!group || !ec_key || EC_KEY_set_group(ec_key, group) != 1) {
+        EC_KEY_free(ec_key);
+        return NULL;
+    }
+
+    let point = EC_POINT_new(group);
+    BOOL success = point && EC_POINT_oct2point(group, point, publicPoint.bytes, publicPoint.length, NULL) == 1 && EC_KEY_set_public_key(ec_key, point) == 1;
+    EC_POINT_free(point);
+
+    if (success && privateKey) {
+        let d = BN_bin2bn(privateKey.bytes, (int)privateKey.length, NULL);
+        success = d && EC_KEY_set_private_key(ec_key, d) == 1;
+        BN_clear_free(d);
+    }
+
+    if (!success) {
+        EC_KEY_free(ec_key);
+        return NULL;
+    }
+    return pgp_ec_pkey_with_ec_key(ec_key);
+}
+
+static EVP_PKEY * _Nullable pgp_ec_generate_pkey(PGPCurve curveKind) {
+    let group = pgp_ec_shared_group(curveKind);
+    let ec_key = EC_KEY_new();
+    if (!group || !ec_key || EC_KEY_set_group(ec_key, group) != 1 || EC_KEY_generate_key(ec_key) != 1) {
+        EC_KEY_free(ec_key);
+        return NULL;
+    }
+    return pgp_ec_pkey_with_ec_key(ec_key);
+}
+
+/// Uncompressed public point, 0x04 || x || y.
+static NSData * _Nullable pgp_ec_public_point(EVP_PKEY *pkey) {
+    let ec_key = EVP_PKEY_get0_EC_KEY(pkey);
+    let group = EC_KEY_get0_group(ec_key);
+    let point = EC_KEY_get0_public_key(ec_key);
+    let length = EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, NULL, 0, NULL);
+    if (length == 0) {
+        return nil;
+    }
+
+    let data = [NSMutableData dataWithLength:length];
+    if (EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, data.mutableBytes, length, NULL) != length) {
+        return nil;
+    }
+    return data;
+}
+
+/// Shared secret: the x coordinate of the shared point, padded to the field size.
+static NSData * _Nullable pgp_ec_derive(EVP_PKEY *pkey, EVP_PKEY *peer) {
+    let ctx = EVP_PKEY_CTX_new(pkey, NULL);
+    pgp_defer {
+        EVP_PKEY_CTX_free(ctx);
+    };
+
+    size_t length = 0;
+    if (!ctx || EVP_PKEY_derive_init(ctx) <= 0 || EVP_PKEY_derive_set_peer(ctx, peer) <= 0 || EVP_PKEY_derive(ctx, NULL, &length) <= 0) {
+        return nil;
+    }
+
+    let shared = [NSMutableData dataWithLength:length];
+    if (EVP_PKEY_derive(ctx, shared.mutableBytes, &length) <= 0) {
+        return nil;
+    }
+    shared.length = length;
+    return shared;
+}
+
 @implementation PGPEC
 
 /// Generate ECDHE secret from private key and public part of ephemeral key
@@ -136,75 +261,78 @@ NS_ASSUME_NONNULL_BEGIN
     return public_key;
 }
 
-+ (BOOL)publicEncrypt:(nonnull NSData *)data withPublicKeyPacket:(PGPPublicKeyPacket *)publicKeyPacket publicKey:(NSData * __autoreleasing _Nullable *)publicKey encodedSymmetricKey:(NSData * __autoreleasing _Nullable *)encodedSymmetricKey {
-    switch (publicKeyPacket.curveOID.curveKind) {
-        case PGPCurve25519: {
-            NSData *sharedKey = nil;
+/// Generate ephemeral key on the NIST or Brainpool curve of the public key packet, and the ECDH shared secret.
++ (nullable NSData *)generateECPublicEphemeralKeyWith:(PGPPublicKeyPacket *)publicKeyPacket sharedKey:(NSData * __autoreleasing _Nullable *)shared {
+    let curveKind = publicKeyPacket.curveOID.curveKind;
+    let Q = [[publicKeyPacket publicMPI:PGPMPIdentifierQ] bodyData]; // recipient public key
+    if (!Q) {
+        return nil;
+    }
 
-            if (publicKey) {
-                *publicKey = [self generate25519PublicEphemeralKeyWith:publicKeyPacket sharedKey:&sharedKey]; // X25519
-            }
+    let recipientKey = pgp_ec_pkey(curveKind, PGPNN(Q), nil);
+    let ephemeralKey = pgp_ec_generate_pkey(curveKind);
+    pgp_defer {
+        EVP_PKEY_free(recipientKey);
+        EVP_PKEY_free(ephemeralKey);
+    };
 
-            // Build symmetric key wrapped and encoded using sharedKey
-
-            // kdf param
-            // - The KDF parameters https://datatracker.ietf.org/doc/html/rfc6637#section-8
-            let kdfParam = [NSMutableData data];
-            // one-octet size of the following field. the octets representing a curve OID
-            [kdfParam pgp_appendData:[publicKeyPacket.curveOID export:nil]];
-            // one-octet public key algorithm ID
-            //[kdfParam appendBytes:&keyAlgorithm length:1];
-            [kdfParam pgp_appendByte:publicKeyPacket.publicKeyAlgorithm];
-            // KDF params
-            [kdfParam pgp_appendData:[publicKeyPacket.curveKDFParameters export:nil]];
-            // 20 octets representing the UTF-8 encoding of the string "Anonymous Sender    "
-            const unsigned char anonymous_sender[] = {0x41, 0x6E, 0x6F, 0x6E, 0x79, 0x6D, 0x6F, 0x75, 0x73, 0x20, 0x53, 0x65, 0x6E, 0x64, 0x65, 0x72, 0x20, 0x20, 0x20, 0x20};
-            [kdfParam appendBytes:anonymous_sender length:20];
-            // 20 octets representing a recipient encryption subkey or a master key fingerprint
-            [kdfParam pgp_appendData:publicKeyPacket.fingerprint.hashedData];
-            // KDF produces a symmetric key that is used as a key-encryption key (KEK)
-            // https://datatracker.ietf.org/doc/html/rfc6637#section-7
-            const unsigned char prefix_bytes[] = {0x00, 0x00, 0x00, 0x01};
-            let kdfInput =  [NSMutableData dataWithBytes:prefix_bytes length:4];
-            [kdfInput pgp_appendData:sharedKey];
-            [kdfInput pgp_appendData:kdfParam];
-
-            // truncated KEK
-            let KEK = [[kdfInput pgp_HashedWithAlgorithm:publicKeyPacket.curveKDFParameters.hashAlgorithm] subdataWithRange:NSMakeRange(0, [PGPCryptoUtils keySizeOfSymmetricAlgorithm:publicKeyPacket.curveKDFParameters.symmetricAlgorithm])];
-
-            // Add PKCS5 padding
-            let paddedData = [data pgp_PKCS5Padded];
-
-            // Key wrap
-            AES_KEY *aes_key = OPENSSL_secure_malloc(sizeof(AES_KEY));
-            pgp_defer {
-                OPENSSL_secure_clear_free(aes_key, sizeof(AES_KEY));
-            };
+    if (!recipientKey || !ephemeralKey) {
+        #if PGP_LOG_LEVEL >= PGP_DEBUG_LEVEL
+        char *err_str = ERR_error_string(ERR_get_error(), NULL);
+        PGPLogDebug(@"%@", [NSString stringWithCString:err_str encoding:NSASCIIStringEncoding]);
+        #endif
+        return nil;
+    }
 
-            if (AES_set_encrypt_key(KEK.bytes, (int)KEK.length * sizeof(UInt64), aes_key) < 0) {
-                return NO;
-            }
+    if (shared) {
+        *shared = pgp_ec_derive(ephemeralKey, recipientKey);
+    }
+    return pgp_ec_public_point(ephemeralKey);
+}
 
-            if (AES_set_encrypt_key(KEK.bytes, (int)KEK.length * sizeof(UInt64), aes_key) < 0) {
-                return NO;
-            }
++ (nullable NSData *)ECDHSharedKeyWithEphemeralPublicKey:(NSData *)publicPartEphemeralKey secretKeyPacket:(PGPSecretKeyPacket *)secretKeyPacket {
+    let curveKind = secretKeyPacket.curveOID.curveKind;
+    let D = [[secretKeyPacket secretMPI:PGPMPIdentifierD] bodyData]; // private key
+    if (!D) {
+        return nil;
+    }
 
-            unsigned long wrapped_buf_length = paddedData.length + sizeof(UInt64);
-            unsigned char *wrapped_buf = OPENSSL_secure_malloc(wrapped_buf_length);
+    switch (curveKind) {
+        case PGPCurve25519:
+            return [self generate25519PrivateEphemeralKeyWith:publicPartEphemeralKey curveKind:curveKind privateKey:PGPNN(D)];
+        case PGPCurveEd25519:
+            return nil;
+        case PGPCurveP256:
+        case PGPCurveP384:
+        case PGPCurveP521:
+        case PGPCurveBrainpoolP256r1:
+        case PGPCurveBrainpoolP512r1: {
+            let Q = [[secretKeyPacket publicMPI:PGPMPIdentifierQ] bodyData];
+            if (!Q) {
+                return nil;
+            }
+            let privateKey = pgp_ec_pkey(curveKind, PGPNN(Q), D);
+            let ephemeralKey = pgp_ec_pkey(curveKind, publicPartEphemeralKey, nil);
             pgp_defer {
-                OPENSSL_secure_clear_free(wrapped_buf, wrapped_buf_length);
+                EVP_PKEY_free(privateKey);
+                EVP_PKEY_free(ephemeralKey);
             };
-
-            if (AES_wrap_key(aes_key, NULL, wrapped_buf, paddedData.bytes, (int)paddedData.length) <= 0) {
-                return NO;
-            }
-
-            if (encodedSymmetricKey) {
-                *encodedSymmetricKey = [NSData dataWithBytes:wrapped_buf length:wrapped_buf_length];
+            if (!privateKey || !ephemeralKey) {
+                return nil;
             }
+            return pgp_ec_derive(privateKey, ephemeralKey);
+        }
+    }
+    return nil;
+}
 
-            return YES;
-        } break;
++ (BOOL)publicEncrypt:(nonnull NSData *)data withPublicKeyPacket:(PGPPublicKeyPacket *)publicKeyPacket publicKey:(NSData * __autoreleasing _Nullable *)publicKey encodedSymmetricKey:(NSData * __autoreleasing _Nullable *)encodedSymmetricKey {
+    NSData *sharedKey = nil;
+    NSData *ephemeralPublicKey = nil;
+    switch (publicKeyPacket.curveOID.curveKind) {
+        case PGPCurve25519:
+            ephemeralPublicKey = [self generate25519PublicEphemeralKeyWith:publicKeyPacket sharedKey:&sharedKey]; // X25519
+            break;
         case PGPCurveEd25519: {
             NSAssert(NO,@"ED25519 is not used for encryption");
             return NO;
@@ -212,14 +340,79 @@ NS_ASSUME_NONNULL_BEGIN
         case PGPCurveP256:
         case PGPCurveP384:
         case PGPCurveP521:
-            // ellipticPrivateEphemeralKey
         case PGPCurveBrainpoolP256r1:
         case PGPCurveBrainpoolP512r1:
-            // TODO: Implement!
+            ephemeralPublicKey = [self generateECPublicEphemeralKeyWith:publicKeyPacket sharedKey:&sharedKey];
             break;
     }
 
-    return NO;
+    if (!ephemeralPublicKey || !sharedKey) {
+        return NO;
+    }
+
+    if (publicKey) {
+        *publicKey = ephemeralPublicKey;
+    }
+
+    // Build symmetric key wrapped and encoded using sharedKey
+
+    // kdf param
+    // - The KDF parameters https://datatracker.ietf.org/doc/html/rfc6637#section-8
+    let kdfParam = [NSMutableData data];
+    // one-octet size of the following field. the octets representing a curve OID
+    [kdfParam pgp_appendData:[publicKeyPacket.curveOID export:nil]];
+    // one-octet public key algorithm ID
+    //[kdfParam appendBytes:&keyAlgorithm length:1];
+    [kdfParam pgp_appendByte:publicKeyPacket.publicKeyAlgorithm];
+    // KDF params
+    [kdfParam pgp_appendData:[publicKeyPacket.curveKDFParameters export:nil]];
+    // 20 octets representing the UTF-8 encoding of the string "Anonymous Sender    "
+    const unsigned char anonymous_sender[] = {0x41, 0x6E, 0x6F, 0x6E, 0x79, 0x6D, 0x6F, 0x75, 0x73, 0x20, 0x53, 0x65, 0x6E, 0x64, 0x65, 0x72, 0x20, 0x20, 0x20, 0x20};
+    [kdfParam appendBytes:anonymous_sender length:20];
+    // 20 octets representing a recipient encryption subkey or a master key fingerprint
+    [kdfParam pgp_appendData:publicKeyPacket.fingerprint.hashedData];
+    // KDF produces a symmetric key that is used as a key-encryption key (KEK)
+    // https://datatracker.ietf.org/doc/html/rfc6637#section-7
+    const unsigned char prefix_bytes[] = {0x00, 0x00, 0x00, 0x01};
+    let kdfInput =  [NSMutableData dataWithBytes:prefix_bytes length:4];
+    [kdfInput pgp_appendData:sharedKey];
+    [kdfInput pgp_appendData:kdfParam];
+
+    // truncated KEK
+    let KEK = [[kdfInput pgp_HashedWithAlgorithm:publicKeyPacket.curveKDFParameters.hashAlgorithm] subdataWithRange:NSMakeRange(0, [PGPCryptoUtils keySizeOfSymmetricAlgorithm:publicKeyPacket.curveKDFParameters.symmetricAlgorithm])];
+
+    // Add PKCS5 padding
+    let paddedData = [data pgp_PKCS5Padded];
+
+    // Key wrap
+    AES_KEY *aes_key = OPENSSL_secure_malloc(sizeof(AES_KEY));
+    pgp_defer {
+        OPENSSL_secure_clear_free(aes_key, sizeof(AES_KEY));
+    };
+
+    if (AES_set_encrypt_key(KEK.bytes, (int)KEK.length * sizeof(UInt64), aes_key) < 0) {
+        return NO;
+    }
+
+    if (AES_set_encrypt_key(KEK.bytes, (int)KEK.length * sizeof(UInt64), aes_key) < 0) {
+        return NO;
+    }
+
+    unsigned long wrapped_buf_length = paddedData.length + sizeof(UInt64);
+    unsigned char *wrapped_buf = OPENSSL_secure_malloc(wrapped_buf_length);
+    pgp_defer {
+        OPENSSL_secure_clear_free(wrapped_buf, wrapped_buf_length);
+    };
+
+    if (AES_wrap_key(aes_key, NULL, wrapped_buf, paddedData.bytes, (int)paddedData.length) <= 0) {
+        return NO;
+    }
+
+    if (encodedSymmetricKey) {
+        *encodedSymmetricKey = [NSData dataWithBytes:wrapped_buf length:wrapped_buf_length];
+    }
+
+    return YES;
 }
 
 + (NSArray<PGPMPI *> *)sign:(NSData *)toSign key:(PGPKey *)key withHashAlgorithm:(PGPHashAlgorithm)hashAlgorithm {
@@ -297,8 +490,7 @@ NS_ASSUME_NONNULL_BEGIN
                 case PGPCurveP521:
                 case PGPCurveBrainpoolP256r1:
                 case PGPCurveBrainpoolP512r1:
-                    // TODO: Implement ECDSA verification
-                    break;
+                    return [self ECDSASign:toSign secretKeyPacket:PGPNN(key.signingSecretKey) withHashAlgorithm:hashAlgorithm];
             }
         } break;
         case PGPPublicKeyAlgorithmRSA:
@@ -364,10 +556,11 @@ NS_ASSUME_NONNULL_BEGIN
 
             let r = [[signaturePacket signatureMPI:PGPMPIdentifierR] bodyData];
             let s = [[signaturePacket signatureMPI:PGPMPIdentifierS] bodyData];
-            let signatureData = [NSMutableData data];
-            [signatureData appendData:r];
-            [signatureData appendData:s];
-            
+            let signatureData = [self ed25519SignatureDataWithR:r s:s];
+            if (!signatureData) {
+                return NO;
+            }
+
             NSData* hash = [toVerify pgp_HashedWithAlgorithm:hashAlgorithm];
             
             //let ret = EVP_DigestVerify(ctx, signatureData.bytes, signatureData.length, toVerify.bytes, toVerify.length);
@@ -386,7 +579,7 @@ NS_ASSUME_NONNULL_BEGIN
 
         } break;
         case PGPPublicKeyAlgorithmECDSA:
-            // TODO: Implement ECDSA verification
+            return [self ECDSAVerify:toVerify signature:signaturePacket withPublicKeyPacket:publicKeyPacket withHashAlgorithm:hashAlgorithm];
         case PGPPublicKeyAlgorithmRSA:
         case PGPPublicKeyAlgorithmRSAEncryptOnly:
         case PGPPublicKeyAlgorithmRSASignOnly:
@@ -414,6 +607,178 @@ NS_ASSUME_NONNULL_BEGIN
     return NO;
 }
 
+#pragma mark - ECDSA
+
++ (NSArray<PGPMPI *> *)ECDSASign:(NSData *)toSign secretKeyPacket:(PGPSecretKeyPacket *)secretKeyPacket withHashAlgorithm:(PGPHashAlgorithm)hashAlgorithm {
+    let Q = [[secretKeyPacket publicMPI:PGPMPIdentifierQ] bodyData];
+    let D = [[secretKeyPacket secretMPI:PGPMPIdentifierD] bodyData];
+    if (!Q || !D) {
+        return @[];
+    }
+
+    let pkey = pgp_ec_pkey(secretKeyPacket.curveOID.curveKind, PGPNN(Q), D);
+    let ctx = pkey ? EVP_PKEY_CTX_new(pkey, NULL) : NULL;
+    pgp_defer {
+        EVP_PKEY_CTX_free(ctx);
+        EVP_PKEY_free(pkey);
+    };
+
+    let hash = [toSign pgp_HashedWithAlgorithm:hashAlgorithm];
+    size_t siglen = 0;
+    if (!ctx || EVP_PKEY_sign_init(ctx) <= 0 || EVP_PKEY_sign(ctx, NULL, &siglen, hash.bytes, hash.length) <= 0) {
+        #if PGP_LOG_LEVEL >= PGP_DEBUG_LEVEL
+        char *err_str = ERR_error_string(ERR_get_error(), NULL);
+        PGPLogDebug(@"%@", [NSString stringWithCString:err_str encoding:NSASCIIStringEncoding]);
+        #endif
+        return @[];
+    }
+
+    let derSignature = [NSMutableData dataWithLength:siglen];
+    if (EVP_PKEY_sign(ctx, derSignature.mutableBytes, &siglen, hash.bytes, hash.length) <= 0) {
+        #if PGP_LOG_LEVEL >= PGP_DEBUG_LEVEL
+        char *err_str = ERR_error_string(ERR_get_error(), NULL);
+        PGPLogDebug(@"%@", [NSString stringWithCString:err_str encoding:NSASCIIStringEncoding]);
+        #endif
+        return @[];
+    }
+
+    // DER encoded Ecdsa-Sig-Value to the r and s MPIs
+    const unsigned char *der = derSignature.bytes;
+    let sig = d2i_ECDSA_SIG(NULL, &der, (long)siglen);
+    if (!sig) {
+        return @[];
+    }
+    pgp_defer {
+        ECDSA_SIG_free(sig);
+    };
+
+    const BIGNUM *r;
+    const BIGNUM *s;
+    ECDSA_SIG_get0(sig, &r, &s);
+    let MPI_R = [[PGPMPI alloc] initWithBigNum:[[PGPBigNum alloc] initWithBIGNUM:(BIGNUM *)r] identifier:PGPMPIdentifierR];
+    let MPI_S = [[PGPMPI alloc] initWithBigNum:[[PGPBigNum alloc] initWithBIGNUM:(BIGNUM *)s] identifier:PGPMPIdentifierS];
+    return @[MPI_R, MPI_S];
+}
+
++ (BOOL)ECDSAVerify:(NSData *)toVerify signature:(PGPSignaturePacket *)signaturePacket withPublicKeyPacket:(PGPPublicKeyPacket *)publicKeyPacket withHashAlgorithm:(PGPHashAlgorithm)hashAlgorithm {
+    let Q = [[publicKeyPacket publicMPI:PGPMPIdentifierQ] bodyData];
+    let r = [signaturePacket signatureMPI:PGPMPIdentifierR].bigNum.bignumRef;
+    let s = [signaturePacket signatureMPI:PGPMPIdentifierS].bigNum.bignumRef;
+    if (!Q || !r || !s) {
+        return NO;
+    }
+
+    let pkey = pgp_ec_pkey(publicKeyPacket.curveOID.curveKind, PGPNN(Q), nil);
+    let ctx = pkey ? EVP_PKEY_CTX_new(pkey, NULL) : NULL;
+    let sig = ECDSA_SIG_new();
+    pgp_defer {
+        ECDSA_SIG_free(sig);
+        EVP_PKEY_CTX_free(ctx);
+        EVP_PKEY_free(pkey);
+    };
+
+    if (!ctx || !sig || ECDSA_SIG_set0(sig, BN_dup(r), BN_dup(s)) != 1) {
+        return NO;
+    }
+
+    unsigned char *der = NULL;
+    let derLength = i2d_ECDSA_SIG(sig, &der);
+    if (derLength <= 0) {
+        return NO;
+    }
+    pgp_defer {
+        OPENSSL_free(der);
+    };
+
+    let hash = [toVerify pgp_HashedWithAlgorithm:hashAlgorithm];
+    if (EVP_PKEY_verify_init(ctx) <= 0) {
+        return NO;
+    }
+    return EVP_PKEY_verify(ctx, der, (size_t)derLength, hash.bytes, hash.length) == 1;
+}
+
+#pragma mark - Ed25519
+
++ (nullable NSData *)ed25519SignatureDataWithR:(NSData *)r s:(NSData *)s {
+    let half = PGPEd25519SignatureSize / 2;
+    if (r.length > half || s.length > half) {
+        return nil;
+    }
+
+    let signatureData = [NSMutableData dataWithLength:PGPEd25519SignatureSize];
+    [signatureData replaceBytesInRange:(NSRange){half - r.length, r.length} withBytes:r.bytes];
+    [signatureData replaceBytesInRange:(NSRange){PGPEd25519SignatureSize - s.length, s.length} withBytes:s.bytes];
+    return signatureData;
+}
+
++ (NSIndexSet *)verifyEd25519Digests:(NSArray<NSData *> *)digests signatures:(NSArray<NSData *> *)signatures publicKeys:(NSArray<NSData *> *)publicKeys {
+    if (digests.count != signatures.count || signatures.count != publicKeys.count) {
+        PGPLogWarning(@"Mismatched count of Ed25519 digests, signatures and public keys.");
+        return [NSIndexSet indexSetWithIndexesInRange:(NSRange){0, MAX(digests.count, MAX(signatures.count, publicKeys.count))}];
+    }
+
+    let count = digests.count;
+    let invalid = [NSMutableIndexSet indexSet];
+    if (count == 0) {
+        return invalid;
+    }
+
+    // Decode every distinct public key once. A key that doesn't decode fails its signatures.
+    let keyIndexes = [NSMutableDictionary<NSData *, NSNumber *> dictionary];
+    EVP_PKEY **pkeys = calloc(count, sizeof(EVP_PKEY *));
+    NSUInteger *pkeyIndexes = calloc(count, sizeof(NSUInteger));
+    BOOL *valid = calloc(count, sizeof(BOOL));
+    pgp_defer {
+        for (NSUInteger i = 0; i < keyIndexes.count; i++) {
+            EVP_PKEY_free(pkeys[i]);
+        }
+        free(pkeys);
+        free(pkeyIndexes);
+        free(valid);
+    };
+
+    for (NSUInteger i = 0; i < count; i++) {
+        let publicKey = publicKeys[i];
+        let keyIndex = keyIndexes[publicKey];
+        if (keyIndex) {
+            pkeyIndexes[i] = keyIndex.unsignedIntegerValue;
+            continue;
+        }
+
+        pkeyIndexes[i] = keyIndexes.count;
+        pkeys[keyIndexes.count] = publicKey.length == PGPEd25519KeySize ? EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, NULL, publicKey.bytes, publicKey.length) : NULL;
+        keyIndexes[publicKey] = @(keyIndexes.count);
+    }
+
+    // One digest context per worker, reused for its share of signatures.
+    let workersCount = MIN(count, NSProcessInfo.processInfo.activeProcessorCount);
+    dispatch_apply(workersCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t worker) {
+        let ctx = EVP_MD_CTX_new();
+        pgp_defer {
+            EVP_MD_CTX_free(ctx);
+        };
+
+        for (NSUInteger i = worker; i < count && ctx; i += workersCount) {
+            let pkey = pkeys[pkeyIndexes[i]];
+            let signature = signatures[i];
+            let digest = digests[i];
+            if (!pkey || signature.length != PGPEd25519SignatureSize) {
+                continue;
+            }
+
+            EVP_MD_CTX_reset(ctx);
+            valid[i] = EVP_DigestVerifyInit(ctx, NULL, NULL, NULL, pkey) == 1 && EVP_DigestVerify(ctx, signature.bytes, signature.length, digest.bytes, digest.length) == 1;
+        }
+    });
+
+    for (NSUInteger i = 0; i < count; i++) {
+        if (!valid[i]) {
+            [invalid addIndex:i];
+        }
+    }
+    return invalid;
+}
+
 + (nullable PGPKeyMaterial *)generateNewKeyMPIArray:(PGPCurve)curve {
     
     let keyMaterial = [[PGPKeyMaterial alloc] init];
@@ -430,10 +795,25 @@ NS_ASSUME_NONNULL_BEGIN
         case PGPCurveP384:
         case PGPCurveP521:
         case PGPCurveBrainpoolP256r1:
-        case PGPCurveBrainpoolP512r1:
-            // TODO: implement NIST curves
-            curveID = -1;
-            break;
+        case PGPCurveBrainpoolP512r1: {
+            let pkey = pgp_ec_generate_pkey(curve);
+            if (!pkey) {
+                return nil;
+            }
+            pgp_defer {
+                EVP_PKEY_free(pkey);
+            };
+
+            let public_key = pgp_ec_public_point(pkey);
+            let private_key_bn = EC_KEY_get0_private_key(EVP_PKEY_get0_EC_KEY(pkey));
+            if (!public_key || !private_key_bn) {
+                return nil;
+            }
+
+            keyMaterial.q = [[PGPMPI alloc] initWithData:PGPNN(public_key) identifier:PGPMPIdentifierQ];
+            keyMaterial.d = [[PGPMPI alloc] initWithBigNum:[[PGPBigNum alloc] initWithBIGNUM:(BIGNUM *)private_key_bn] identifier:PGPMPIdentifierD];
+            return keyMaterial;
+        }
     }
 
     if (curveID == -1) {
@@ -22,6 +22,12 @@ NS_ASSUME_NONNULL_BEGIN
 
 PGP_EMPTY_INIT_UNAVAILABLE;
 
+/// Number of keys whose Montgomery context and fixed-base tables are kept, the least recently used dropped first.
+/// The tables of a 2048-bit key take about 750 KB. Default 64, 0 disables the cache.
+@property (class, atomic) NSUInteger contextCacheCapacity;
+/// Number of keys with a cached context.
+@property (class, atomic, readonly) NSUInteger cachedContextsCount;
+
 // encryption
 + (nullable NSArray<PGPBigNum *> *)publicEncrypt:(NSData *)toEncrypt withPublicKeyPacket:(PGPPublicKeyPacket *)publicKeyPacket;
 + (nullable NSData *)privateDecrypt:(NSData *)toDecrypt withSecretKeyPacket:(PGPSecretKeyPacket *)secretKeyPacket gk:(PGPMPI *)gkMPI;
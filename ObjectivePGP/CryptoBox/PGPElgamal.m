@@ -15,6 +15,7 @@
 #import "PGPPublicKeyPacket.h"
 #import "PGPSecretKeyPacket.h"
 #import "PGPBigNum+Private.h"
+#import "NSMutableData+PGPUtils.h"
 
 #import "PGPLogging.h"
 #import "PGPMacros+Private.h"
@@ -26,83 +27,356 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@implementation PGPElgamal
+// Fixed-base exponentiation window size (bits)
+#define PGP_ELGAMAL_WINDOW_BITS 4
+#define PGP_ELGAMAL_WINDOW_SIZE (1 << PGP_ELGAMAL_WINDOW_BITS)
+// Number of recipient keys with cached precomputation
+#define PGP_ELGAMAL_CACHE_LIMIT 64
 
 static int decide_k_bits(int p_bits) {
     return (p_bits <= 5120) ? p_bits / 10 + 160 : (p_bits / 8 + 200) * 3 / 2;
 }
 
+#pragma mark - Fixed-base exponentiation
+
+// Powers of a fixed base in Montgomery form. Row i holds base^(j * 2^(w * i)) for j in [0, 2^w),
+// every entry padded to the same size so that a row can be scanned in constant time.
+typedef struct {
+    int windows;
+    size_t entrySize; // octets, multiple of 8
+    UInt64 *entries;
+} pgp_elgamal_fixed_base;
+
+static void pgp_elgamal_fixed_base_free(pgp_elgamal_fixed_base *table) {
+    free(table->entries);
+    table->entries = NULL;
+}
+
+static BOOL pgp_elgamal_fixed_base_init(pgp_elgamal_fixed_base *table, const BIGNUM *base, const BIGNUM *p, int exponentBits, BN_MONT_CTX *mont, BN_CTX *ctx) {
+    table->windows = (exponentBits + PGP_ELGAMAL_WINDOW_BITS - 1) / PGP_ELGAMAL_WINDOW_BITS;
+    table->entrySize = ((size_t)BN_num_bytes(p) + sizeof(UInt64) - 1) / sizeof(UInt64) * sizeof(UInt64);
+    table->entries = calloc((size_t)table->windows * PGP_ELGAMAL_WINDOW_SIZE, table->entrySize);
+    if (!table->entries) {
+        return NO;
+    }
+
+    BN_CTX_start(ctx);
+    let one = BN_CTX_get(ctx);
+    let power = BN_CTX_get(ctx);
+    let entry = BN_CTX_get(ctx);
+    BOOL success = one && power && entry
+                   && BN_to_montgomery(one, BN_value_one(), mont, ctx)
+                   && BN_nnmod(power, base, p, ctx)
+                   && BN_to_montgomery(power, power, mont, ctx);
+
+    for (int window = 0; success && window < table->windows; window++) {
+        let row = (UInt8 *)table->entries + (size_t)window * PGP_ELGAMAL_WINDOW_SIZE * table->entrySize;
+        success = BN_copy(entry, one) != NULL;
+        for (int j = 0; success && j < PGP_ELGAMAL_WINDOW_SIZE; j++) {
+            success = BN_bn2binpad(entry, row + (size_t)j * table->entrySize, (int)table->entrySize) > 0
+                      && BN_mod_mul_montgomery(entry, entry, power, mont, ctx);
+        }
+        // The base of the next window: power^(2^w)
+        success = success && BN_copy(power, entry) != NULL;
+    }
+    BN_CTX_end(ctx);
+
+    if (!success) {
+        pgp_elgamal_fixed_base_free(table);
+    }
+    return success;
+}
+
+// r = base^exponent, in Montgomery form. The exponent is secret, each row is read whole.
+static BOOL pgp_elgamal_fixed_base_exp(BIGNUM *r, const pgp_elgamal_fixed_base *table, const BIGNUM *exponent, BN_MONT_CTX *mont, BN_CTX *ctx) {
+    if (BN_num_bits(exponent) > table->windows * PGP_ELGAMAL_WINDOW_BITS) {
+        return NO;
+    }
+
+    let words = table->entrySize / sizeof(UInt64);
+    UInt64 *selected = OPENSSL_secure_zalloc(table->entrySize);
+    if (!selected) {
+        return NO;
+    }
+    pgp_defer {
+        OPENSSL_secure_clear_free(selected, table->entrySize);
+    };
+
+    BN_CTX_start(ctx);
+    let entry = BN_CTX_get(ctx);
+    BOOL success = entry && BN_to_montgomery(r, BN_value_one(), mont, ctx);
+    for (int window = 0; success && window < table->windows; window++) {
+        UInt64 digit = 0;
+        for (int bit = 0; bit < PGP_ELGAMAL_WINDOW_BITS; bit++) {
+            digit |= (UInt64)BN_is_bit_set(exponent, window * PGP_ELGAMAL_WINDOW_BITS + bit) << bit;
+        }
+
+        let row = table->entries + (size_t)window * PGP_ELGAMAL_WINDOW_SIZE * words;
+        memset(selected, 0, table->entrySize);
+        for (UInt64 j = 0; j < PGP_ELGAMAL_WINDOW_SIZE; j++) {
+            let diff = j ^ digit;
+            let mask = ((diff | (0 - diff)) >> 63) - 1; // all ones when j == digit
+            for (size_t word = 0; word < words; word++) {
+                selected[word] |= row[j * words + word] & mask;
+            }
+        }
+
+        success = BN_bin2bn((const unsigned char *)selected, (int)table->entrySize, entry)
+                  && BN_mod_mul_montgomery(r, r, entry, mont, ctx);
+    }
+    BN_CTX_end(ctx);
+    return success;
+}
+
+#pragma mark - Key context
+
+// State of a single Elgamal key reused across operations, shared across threads.
+// The Montgomery context is immutable once set; the fixed-base tables are built on first encryption.
+@interface PGPElgamalKeyContext : NSObject {
+    pgp_elgamal_fixed_base _gTable;
+    pgp_elgamal_fixed_base _yTable;
+}
+
+@property (nonatomic, readonly) BN_MONT_CTX *mont;
+@property (nonatomic, readonly) dispatch_queue_t tablesQueue;
+@property (nonatomic) BOOL tablesReady;
+
+@end
+
+@implementation PGPElgamalKeyContext
+
+- (nullable instancetype)initWithPrime:(const BIGNUM *)p {
+    if ((self = [super init])) {
+        let ctx = BN_CTX_new();
+        pgp_defer {
+            BN_CTX_free(ctx);
+        };
+
+        _mont = BN_MONT_CTX_new();
+        if (!ctx || !_mont || !BN_MONT_CTX_set(_mont, p, ctx)) {
+            return nil;
+        }
+        _tablesQueue = dispatch_queue_create("com.objectivepgp.elgamal.tables", DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
+// Fixed-base tables for g and y, built once.
+- (BOOL)prepareTablesWithGenerator:(const BIGNUM *)g publicValue:(const BIGNUM *)y prime:(const BIGNUM *)p {
+    dispatch_sync(self.tablesQueue, ^{
+        if (self.tablesReady) {
+            return;
+        }
+
+        let ctx = BN_CTX_new();
+        if (!ctx) {
+            return;
+        }
+        let exponentBits = decide_k_bits(BN_num_bits(p));
+        if (pgp_elgamal_fixed_base_init(&self->_gTable, g, p, exponentBits, self.mont, ctx)) {
+            if (pgp_elgamal_fixed_base_init(&self->_yTable, y, p, exponentBits, self.mont, ctx)) {
+                self.tablesReady = YES;
+            } else {
+                pgp_elgamal_fixed_base_free(&self->_gTable);
+            }
+        }
+        BN_CTX_free(ctx);
+    });
+    return self.tablesReady;
+}
+
+// r = g^k, in Montgomery form
+- (BOOL)generatorPower:(BIGNUM *)r exponent:(const BIGNUM *)k context:(BN_CTX *)ctx {
+    return self.tablesReady && pgp_elgamal_fixed_base_exp(r, &_gTable, k, self.mont, ctx);
+}
+
+// r = y^k, in Montgomery form
+- (BOOL)publicValuePower:(BIGNUM *)r exponent:(const BIGNUM *)k context:(BN_CTX *)ctx {
+    return self.tablesReady && pgp_elgamal_fixed_base_exp(r, &_yTable, k, self.mont, ctx);
+}
+
+- (void)dealloc {
+    pgp_elgamal_fixed_base_free(&_gTable);
+    pgp_elgamal_fixed_base_free(&_yTable);
+    BN_MONT_CTX_free(_mont);
+}
+
+@end
+
+@implementation PGPElgamal
+
+static NSUInteger PGPElgamalContextCacheCapacity = PGP_ELGAMAL_CACHE_LIMIT;
+// Least recently used first.
+static NSMutableOrderedSet<NSData *> *PGPElgamalContextKeys;
+static NSMutableDictionary<NSData *, PGPElgamalKeyContext *> *PGPElgamalContexts;
+
++ (dispatch_queue_t)contextsQueue {
+    static dispatch_queue_t contextsQueue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        PGPElgamalContextKeys = [NSMutableOrderedSet orderedSet];
+        PGPElgamalContexts = [NSMutableDictionary dictionary];
+        contextsQueue = dispatch_queue_create("com.objectivepgp.elgamal.contexts", DISPATCH_QUEUE_SERIAL);
+    });
+    return contextsQueue;
+}
+
++ (NSUInteger)contextCacheCapacity {
+    __block NSUInteger capacity = 0;
+    dispatch_sync(self.contextsQueue, ^{
+        capacity = PGPElgamalContextCacheCapacity;
+    });
+    return capacity;
+}
+
++ (void)setContextCacheCapacity:(NSUInteger)contextCacheCapacity {
+    dispatch_sync(self.contextsQueue, ^{
+        PGPElgamalContextCacheCapacity = contextCacheCapacity;
+        [self trimContextsToCount:contextCacheCapacity];
+    });
+}
+
++ (NSUInteger)cachedContextsCount {
+    __block NSUInteger count = 0;
+    dispatch_sync(self.contextsQueue, ^{
+        count = PGPElgamalContextKeys.count;
+    });
+    return count;
+}
+
+// On the contexts queue.
++ (void)trimContextsToCount:(NSUInteger)count {
+    while (PGPElgamalContextKeys.count > count) {
+        let cacheKey = PGPNN(PGPElgamalContextKeys.firstObject);
+        [PGPElgamalContextKeys removeObjectAtIndex:0];
+        [PGPElgamalContexts removeObjectForKey:cacheKey];
+    }
+}
+
+// Cached context of the key, nil if the key has no valid Elgamal public values.
++ (nullable PGPElgamalKeyContext *)contextForKeyPacket:(PGPPublicKeyPacket *)keyPacket {
+    let mpiP = [keyPacket publicMPI:PGPMPIdentifierP];
+    let mpiG = [keyPacket publicMPI:PGPMPIdentifierG];
+    let mpiY = [keyPacket publicMPI:PGPMPIdentifierY];
+    let p = mpiP.bigNum.bignumRef;
+    if (!mpiP || !mpiG || !mpiY || !p || !BN_is_odd(p)) {
+        return nil;
+    }
+
+    // Keyed by the public values: the same key can come from different packets
+    let cacheKeyData = [NSMutableData data];
+    for (PGPMPI *mpi in @[PGPNN(mpiP), PGPNN(mpiG), PGPNN(mpiY)]) {
+        [cacheKeyData pgp_appendData:[mpi exportMPI]];
+    }
+    let cacheKey = (NSData *)cacheKeyData.copy;
+
+    __block PGPElgamalKeyContext *context = nil;
+    dispatch_sync(self.contextsQueue, ^{
+        context = PGPElgamalContexts[cacheKey];
+        if (context) {
+            // Most recently used
+            [PGPElgamalContextKeys removeObject:cacheKey];
+            [PGPElgamalContextKeys addObject:cacheKey];
+            return;
+        }
+
+        context = [[PGPElgamalKeyContext alloc] initWithPrime:p];
+        if (context && PGPElgamalContextCacheCapacity > 0) {
+            [self trimContextsToCount:PGPElgamalContextCacheCapacity - 1];
+            [PGPElgamalContextKeys addObject:cacheKey];
+            PGPElgamalContexts[cacheKey] = context;
+        }
+    });
+    return context;
+}
+
 // encrypt the bytes, returns encrypted m
 + (nullable NSArray<PGPBigNum *> *)publicEncrypt:(NSData *)toEncrypt withPublicKeyPacket:(PGPPublicKeyPacket *)publicKeyPacket {
-    let m = BN_bin2bn(toEncrypt.bytes, toEncrypt.length & INT_MAX, NULL);
-    let p = BN_dup([[[publicKeyPacket publicMPI:PGPMPIdentifierP] bigNum] bignumRef]);
-    let g = BN_dup([[[publicKeyPacket publicMPI:PGPMPIdentifierG] bigNum] bignumRef]);
-    let y = BN_dup([[[publicKeyPacket publicMPI:PGPMPIdentifierY] bigNum] bignumRef]);
+    let p = [[[publicKeyPacket publicMPI:PGPMPIdentifierP] bigNum] bignumRef];
+    let g = [[[publicKeyPacket publicMPI:PGPMPIdentifierG] bigNum] bignumRef];
+    let y = [[[publicKeyPacket publicMPI:PGPMPIdentifierY] bigNum] bignumRef];
+    let context = [self contextForKeyPacket:publicKeyPacket];
+    if (!p || !g || !y || !context || ![context prepareTablesWithGenerator:g publicValue:y prime:p]) {
+        return nil;
+    }
 
+    let m = BN_bin2bn(toEncrypt.bytes, toEncrypt.length & INT_MAX, NULL);
     let k = BN_secure_new();
-    let yk = BN_secure_new();
     let c1 = BN_secure_new();
     let c2 = BN_secure_new();
+    let yk = BN_secure_new();
     let tmp = BN_CTX_secure_new();
+    pgp_defer {
+        BN_CTX_free(tmp);
+        BN_clear_free(yk);
+        BN_clear_free(c2);
+        BN_clear_free(c1);
+        BN_clear_free(k);
+        BN_clear_free(m);
+    };
 
     // k
     let k_bits = decide_k_bits(BN_num_bits(p));
-    BN_rand(k, k_bits, 0, 0);
-
-    // c1 = g^k c2 = m * y^k
-    BN_mod_exp(c1, g, k, p, tmp);
-    BN_mod_exp(yk, y, k, p, tmp);
-    BN_mod_mul(c2, m, yk, p, tmp);
-
     // c1 = g^k
     // c2 = m * y^k
+    // Both powers come from the fixed-base tables, y^k stays in Montgomery form: the Montgomery
+    // product with m removes the factor.
+    if (!m || !k || !c1 || !c2 || !yk || !tmp
+        || !BN_rand(k, k_bits, 0, 0)
+        || ![context generatorPower:c1 exponent:k context:tmp]
+        || !BN_from_montgomery(c1, c1, context.mont, tmp)
+        || ![context publicValuePower:yk exponent:k context:tmp]
+        || !BN_mod_mul_montgomery(c2, m, yk, context.mont, tmp)) {
+        #if PGP_LOG_LEVEL >= PGP_DEBUG_LEVEL
+        char *err_str = ERR_error_string(ERR_get_error(), NULL);
+        PGPLogDebug(@"%@", [NSString stringWithCString:err_str encoding:NSASCIIStringEncoding]);
+        #endif
+        return nil;
+    }
+
     let g_k = [[PGPBigNum alloc] initWithBIGNUM:c1];
     let encm = [[PGPBigNum alloc] initWithBIGNUM:c2];
-
-    BN_CTX_free(tmp);
-    BN_clear_free(c2);
-    BN_clear_free(c1);
-    BN_clear_free(yk);
-    BN_clear_free(k);
-    BN_clear_free(g);
-    BN_clear_free(p);
-    BN_clear_free(y);
-    BN_clear_free(m);
-
     return @[g_k, encm];
 }
 
 + (nullable NSData *)privateDecrypt:(NSData *)toDecrypt withSecretKeyPacket:(PGPSecretKeyPacket *)secretKeyPacket gk:(PGPMPI *)gkMPI {
-    let c2 = BN_bin2bn(toDecrypt.bytes, toDecrypt.length & INT_MAX, NULL);
-    let c1 = BN_dup([[gkMPI bigNum] bignumRef]);
-    let p = BN_dup([[[secretKeyPacket publicMPI:PGPMPIdentifierP] bigNum] bignumRef]);
-    let x = BN_dup([[[secretKeyPacket secretMPI:PGPMPIdentifierX] bigNum] bignumRef]);
-
+    let c1 = [[gkMPI bigNum] bignumRef];
+    let p = [[[secretKeyPacket publicMPI:PGPMPIdentifierP] bigNum] bignumRef];
+    let x = [[[secretKeyPacket secretMPI:PGPMPIdentifierX] bigNum] bignumRef];
+    let context = [self contextForKeyPacket:secretKeyPacket];
+    if (!c1 || !p || !x || !context) {
+        return nil;
+    }
 
+    let c2 = BN_bin2bn(toDecrypt.bytes, toDecrypt.length & INT_MAX, NULL);
     let c1x = BN_secure_new();
     let bndiv = BN_secure_new();
     let m = BN_secure_new();
     let tmp = BN_CTX_secure_new();
+    pgp_defer {
+        BN_CTX_free(tmp);
+        BN_clear_free(m);
+        BN_clear_free(bndiv);
+        BN_clear_free(c1x);
+        BN_clear_free(c2);
+    };
 
-    BN_mod_exp(c1x, c1, x, p, tmp);
-    BN_mod_inverse(bndiv, c1x, p, tmp);
-    BN_mod_mul(m, c2, bndiv, p, tmp);
+    // m = c2 / c1^x, the exponent is secret
+    if (!c2 || !c1x || !bndiv || !m || !tmp
+        || !BN_mod_exp_mont_consttime(c1x, c1, x, p, tmp, context.mont)
+        || !BN_mod_inverse(bndiv, c1x, p, tmp)
+        || !BN_mod_mul(m, c2, bndiv, p, tmp)) {
+        #if PGP_LOG_LEVEL >= PGP_DEBUG_LEVEL
+        char *err_str = ERR_error_string(ERR_get_error(), NULL);
+        PGPLogDebug(@"%@", [NSString stringWithCString:err_str encoding:NSASCIIStringEncoding]);
+        #endif
+        return nil;
+    }
 
     let decm = [[PGPBigNum alloc] initWithBIGNUM:m];
-
-    BN_CTX_free(tmp);
-    BN_clear_free(c1x);
-    BN_clear_free(bndiv);
-    BN_clear_free(m);
-    BN_clear_free(p);
-    BN_clear_free(x);
-    BN_clear_free(c1);
-    BN_clear_free(c2);
-
     return [decm data];
 }
 
-
 @end
 
 NS_ASSUME_NONNULL_END
@@ -76,3 +76,9 @@ FOUNDATION_EXPORT const unsigned char ObjectivePGPVersionString[];
 #import <ObjectivePGP/PGPBigNum+Private.h>
 #import <ObjectivePGP/PGPPartialKey+Private.h>
 #import <ObjectivePGP/PGPSignatureSubpacketEmbeddedSignature.h>
+#import <ObjectivePGP/PGPCryptoAEAD.h>
+#import <ObjectivePGP/PGPArgon2.h>
+#import <ObjectivePGP/PGPMessage+Private.h>
+#import <ObjectivePGP/ObjectivePGPObject+Private.h>
+#import <ObjectivePGP/PGPKeyValidator.h>
+#import <ObjectivePGP/PGPVerificationCache.h>
@@ -26,3 +26,11 @@ FOUNDATION_EXPORT const unsigned char ObjectivePGPVersionString[];
 #import <ObjectivePGP/PGPKey.h>
 #import <ObjectivePGP/PGPExportableProtocol.h>
 #import <ObjectivePGP/PGPArmor.h>
+#import <ObjectivePGP/PGPSessionKey.h>
+#import <ObjectivePGP/PGPEncryptedLiteralReader.h>
+#import <ObjectivePGP/PGPPacketParser.h>
+#import <ObjectivePGP/PGPMessage.h>
+#import <ObjectivePGP/PGPKeyringIndex.h>
+#import <ObjectivePGP/PGPKeyringStore.h>
+#import <ObjectivePGP/PGPKeyProfile.h>
+#import <ObjectivePGP/PGPTrustGraph.h>
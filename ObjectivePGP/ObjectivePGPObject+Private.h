@@ -0,0 +1,28 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/ObjectivePGPObject.h>
+#import <ObjectivePGP/PGPPacket.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface ObjectivePGP ()
+
++ (NSArray<PGPPacket *> *)readPacketsFromData:(NSData *)data;
++ (nullable NSData *)decryptSessionKeyFromPackets:(NSArray<PGPPacket *> *)packets usingKeys:(NSArray<PGPKey *> *)keys passphrase:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock sessionKeyAlgorithm:(PGPSymmetricAlgorithm * _Nullable)sessionKeyAlgorithm error:(NSError * __autoreleasing _Nullable *)error;
++ (nullable NSData *)decryptSessionKeyFromPackets:(NSArray<PGPPacket *> *)packets usingKeys:(NSArray<PGPKey *> *)keys passphrase:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock sessionKeyAlgorithm:(PGPSymmetricAlgorithm * _Nullable)sessionKeyAlgorithm decryptingKey:(PGPKey * _Nullable __autoreleasing * _Nullable)decryptingKey error:(NSError * __autoreleasing _Nullable *)error;
++ (nullable NSArray<PGPPacket *> *)decryptPacketsIfNeeded:(NSArray<PGPPacket *> *)encryptedPackets usingKeys:(NSArray<PGPKey *> *)keys passphrase:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock sessionKey:(nullable PGPSessionKey *)sessionKey decryptedSessionKey:(PGPSessionKey * _Nullable __autoreleasing * _Nullable)decryptedSessionKey error:(NSError * __autoreleasing _Nullable *)error;
++ (nullable NSArray<NSValue *> *)keyRangesInData:(NSData *)messageData resyncPolicy:(PGPPacketResyncPolicy)resyncPolicy error:(NSError * __autoreleasing _Nullable *)error;
++ (NSArray<id> *)readPartialKeysFromData:(NSData *)messageData ranges:(NSArray<NSValue *> *)keyRanges;
++ (nullable PGPPartialKey *)readPartialKeyFromData:(NSData *)messageData range:(NSRange)range;
++ (BOOL)verifyPackets:(NSArray *)accumulatedPackets usingKeys:(NSArray<PGPKey *> *)keys certifyWithRootKey:(BOOL)certifyWithRootKey passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey *key))passphraseForKeyBlock error:(NSError * __autoreleasing _Nullable *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -8,6 +8,7 @@
 
 #import <ObjectivePGP/PGPKey.h>
 #import <ObjectivePGP/PGPKeyring.h>
+#import <ObjectivePGP/PGPSessionKey.h>
 #import <Foundation/Foundation.h>
 
 NS_ASSUME_NONNULL_BEGIN
@@ -40,6 +41,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (nullable NSArray<PGPKey *> *)readKeysFromData:(NSData *)data error:(NSError * __autoreleasing _Nullable *)error;
 
+/**
+ Read binary or armored (ASCII) PGP keys from the input that may be corrupted.
+
+ @param data Key data or keyring data.
+ @param resyncPolicy What to do with invalid data between packets. `readKeysFromData:error:` skips it.
+ @return Array of read keys.
+ */
++ (nullable NSArray<PGPKey *> *)readKeysFromData:(NSData *)data resyncPolicy:(PGPPacketResyncPolicy)resyncPolicy error:(NSError * __autoreleasing _Nullable *)error;
+
 /**
  Read binary or armored (ASCII) PGP keys from the input.
 
@@ -99,6 +109,46 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (nullable NSData *)encrypt:(NSData *)data addSignature:(BOOL)sign usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey *key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error;
 
+/**
+ Encrypt data with a passphrase. Output in binary.
+
+ @param data Data to encrypt.
+ @param passphrase Passphrase to use to decrypt the message.
+ @param error Optional. Error.
+ @return Encrypted data.
+
+ @note The S2K iterations count is calibrated on the device on the first use.
+ */
++ (nullable NSData *)encrypt:(NSData *)data withPassphrase:(NSString *)passphrase error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ Encrypt data with a passphrase and/or given keys. The message can be decrypted with the passphrase or with any of the keys. Output in binary.
+
+ @param data Data to encrypt.
+ @param passphrase Optional. Passphrase to use to decrypt the message.
+ @param sign Whether message should be encrypte and signed.
+ @param keys Keys to use to encrypte `data`. Can be empty if `passphrase` is set.
+ @param passphraseBlock Optional. Handler for passphrase protected keys. Return passphrase for a key in question.
+ @param error Optional. Error.
+ @return Encrypted data.
+ */
++ (nullable NSData *)encrypt:(NSData *)data withPassphrase:(nullable NSString *)passphrase addSignature:(BOOL)sign usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey *key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ Encrypt the same data to many recipient groups, one message per group. Output in binary.
+
+ The literal data is built, signed and compressed once. Every message has its own session key
+ and encrypted data packet; the messages are encrypted concurrently.
+
+ @param data Data to encrypt.
+ @param recipients Recipient groups. A message is encrypted to all keys of a group.
+ @param signingKeys Optional. Keys to sign the data with.
+ @param passphraseBlock Optional. Handler for passphrase protected keys. Return passphrase for a key in question.
+ @param error Optional. Error.
+ @return Encrypted messages, in the order of the recipient groups, or `nil` if any failed.
+ */
++ (nullable NSArray<NSData *> *)encrypt:(NSData *)data forRecipients:(NSArray<NSArray<PGPKey *> *> *)recipients signUsingKeys:(nullable NSArray<PGPKey *> *)signingKeys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey *key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error;
+
 /**
  Decrypt PGP encrypted data.
 
@@ -140,6 +190,59 @@ NS_ASSUME_NONNULL_BEGIN
 + (nullable NSData *)decrypt:(NSData *)data verified:(int * _Nullable)verified certifyWithRootKey:(BOOL)certifyWithRootKey usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseForKeyBlock decryptionError:(NSError * __autoreleasing _Nullable *)decryptionError verificationError:(NSError * __autoreleasing _Nullable *)verificationError;
 
 
+/**
+ Decrypt PGP encrypted data and return the decrypted session key.
+
+ The session key can be used to decrypt the same message again with
+ `decrypt:withSessionKey:andVerifySignature:usingKeys:error:`, without the private key operations.
+
+ @param data data to decrypt.
+ @param verifySignature `YES` if should verify the signature used during encryption, if message is encrypted and signed.
+ @param keys private keys to use.
+ @param passphraseBlock Optional. Handler for passphrase protected keys. Return passphrase for a key in question.
+ @param sessionKey Optional. The session key of the message.
+ @param error Optional. Error.
+ @return Decrypted data, or `nil` if failed.
+ */
++ (nullable NSData *)decrypt:(NSData *)data andVerifySignature:(BOOL)verifySignature usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock sessionKey:(PGPSessionKey * _Nullable __autoreleasing * _Nullable)sessionKey error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ Decrypt PGP encrypted data with the session key. The message session key packets are ignored.
+
+ @param data data to decrypt.
+ @param sessionKey The session key of the message.
+ @param verifySignature `YES` if should verify the signature used during encryption, if message is encrypted and signed.
+ @param keys Public keys to verify the signature with.
+ @param error Optional. Error.
+ @return Decrypted data, or `nil` if failed.
+ */
++ (nullable NSData *)decrypt:(NSData *)data withSessionKey:(PGPSessionKey *)sessionKey andVerifySignature:(BOOL)verifySignature usingKeys:(NSArray<PGPKey *> *)keys error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ Re-encrypt the session key of a binary message to new recipients, without re-encrypting the message.
+
+ The session key is decrypted from the message session key packets and encrypted to the recipients.
+ The encrypted data packet is not read; the rewrapped message is the returned session key packets
+ followed by the input bytes from `encryptedDataOffset`.
+
+ @param data Binary encrypted message.
+ @param recipients Keys to encrypt the session key to.
+ @param keepExistingRecipients `YES` to keep the existing session key packets, `NO` to replace them.
+ @param keys Private keys to decrypt the session key.
+ @param passphraseForKeyBlock Optional. Handler for passphrase protected keys. Return passphrase for a key in question.
+ @param encryptedDataOffset Offset of the encrypted data packet in `data`.
+ @param error Optional. Error.
+ @return Session key packets, or `nil` if failed.
+ */
++ (nullable NSData *)sessionKeyPacketsRewrappingMessage:(NSData *)data toRecipients:(NSArray<PGPKey *> *)recipients keepExistingRecipients:(BOOL)keepExistingRecipients usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseForKeyBlock encryptedDataOffset:(NSUInteger *)encryptedDataOffset error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ Rewrap the binary message file for new recipients. The encrypted data is copied as is.
+
+ @see `sessionKeyPacketsRewrappingMessage:toRecipients:keepExistingRecipients:usingKeys:passphraseForKey:encryptedDataOffset:error:`
+ */
++ (BOOL)rewrapMessageAtURL:(NSURL *)sourceURL toURL:(NSURL *)destinationURL recipients:(NSArray<PGPKey *> *)recipients keepExistingRecipients:(BOOL)keepExistingRecipients usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseForKeyBlock error:(NSError * __autoreleasing _Nullable *)error;
+
 /**
  Return list of key identifiers used in the given message. Determine keys that a message has been encrypted.
  */
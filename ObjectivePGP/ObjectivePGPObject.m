@@ -7,22 +7,28 @@
 //
 
 #import "ObjectivePGPObject.h"
+#import "ObjectivePGPObject+Private.h"
 #import "PGPArmor.h"
 #import "PGPCompressedPacket.h"
 #import "PGPCryptoUtils.h"
+#import "PGPCryptoAEAD.h"
 #import "PGPKey+Private.h"
 #import "PGPKey.h"
 #import "PGPLiteralPacket.h"
+#import "PGPMessage.h"
 #import "PGPMPI.h"
 #import "PGPS2K.h"
 #import "PGPModificationDetectionCodePacket.h"
 #import "PGPOnePassSignaturePacket.h"
 #import "PGPPacketFactory.h"
+#import "PGPPacketHeader.h"
 #import "PGPPartialKey.h"
+#import "PGPPartialKey+Private.h"
 #import "PGPPublicKeyEncryptedSessionKeyPacket.h"
 #import "PGPSymetricKeyEncryptedSessionKeyPacket.h"
 #import "PGPPublicKeyPacket.h"
 #import "PGPSecretKeyPacket.h"
+#import "PGPSessionKey.h"
 #import "PGPSignaturePacket.h"
 #import "PGPPartialSubKey.h"
 #import "PGPSymmetricallyEncryptedDataPacket.h"
@@ -33,6 +39,7 @@
 #import "NSArray+PGPUtils.h"
 #import "PGPKeyring.h"
 #import "PGPKeyring+Private.h"
+#import "PGPKeyValidator.h"
 
 #import "PGPFoundation.h"
 #import "PGPLogging.h"
@@ -41,6 +48,9 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+// Version 2 encrypted data chunk size octet. Chunk size is 2^(12 + 6) octets.
+static const UInt8 PGPDefaultAEADChunkSizeOctet = 12;
+
 @implementation ObjectivePGP
 
 - (instancetype)init {
@@ -85,6 +95,23 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 + (nullable NSData *)decrypt:(NSData *)data verified:(int * _Nullable)verified certifyWithRootKey:(BOOL)certifyWithRootKey usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseForKeyBlock decryptionError:(NSError * __autoreleasing _Nullable *)decryptionError verificationError:(NSError * __autoreleasing _Nullable *)verificationError {
+    return [self decrypt:data verified:verified certifyWithRootKey:certifyWithRootKey usingKeys:keys passphraseForKey:passphraseForKeyBlock sessionKey:nil decryptedSessionKey:nil decryptionError:decryptionError verificationError:verificationError];
+}
+
++ (nullable NSData *)decrypt:(NSData *)data andVerifySignature:(BOOL)verifySignature usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock sessionKey:(PGPSessionKey * _Nullable __autoreleasing * _Nullable)sessionKey error:(NSError * __autoreleasing _Nullable *)error {
+    int isVerified;
+    return [self decrypt:data verified:verifySignature ? &isVerified : nil certifyWithRootKey:NO usingKeys:keys passphraseForKey:passphraseBlock sessionKey:nil decryptedSessionKey:sessionKey decryptionError:error verificationError:error];
+}
+
++ (nullable NSData *)decrypt:(NSData *)data withSessionKey:(PGPSessionKey *)sessionKey andVerifySignature:(BOOL)verifySignature usingKeys:(NSArray<PGPKey *> *)keys error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(sessionKey, PGPSessionKey);
+
+    int isVerified;
+    return [self decrypt:data verified:verifySignature ? &isVerified : nil certifyWithRootKey:NO usingKeys:keys passphraseForKey:nil sessionKey:sessionKey decryptedSessionKey:nil decryptionError:error verificationError:error];
+}
+
+// Decrypt with the given session key, or with the session key decrypted from the message session key packets.
++ (nullable NSData *)decrypt:(NSData *)data verified:(int * _Nullable)verified certifyWithRootKey:(BOOL)certifyWithRootKey usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseForKeyBlock sessionKey:(nullable PGPSessionKey *)sessionKey decryptedSessionKey:(PGPSessionKey * _Nullable __autoreleasing * _Nullable)decryptedSessionKey decryptionError:(NSError * __autoreleasing _Nullable *)decryptionError verificationError:(NSError * __autoreleasing _Nullable *)verificationError {
     PGPAssertClass(data, NSData);
     PGPAssertClass(keys, NSArray);
 
@@ -99,7 +126,7 @@ NS_ASSUME_NONNULL_BEGIN
 
     // Parse packets. Decrypt encrypted packages if needed
     let allPackets = [ObjectivePGP readPacketsFromData:binaryMessage];
-    let decryptedPackets = [self decryptPacketsIfNeeded:allPackets usingKeys:keys passphrase:passphraseForKeyBlock error:decryptionError];
+    let decryptedPackets = [self decryptPacketsIfNeeded:allPackets usingKeys:keys passphrase:passphraseForKeyBlock sessionKey:sessionKey decryptedSessionKey:decryptedSessionKey error:decryptionError];
     if (decryptionError && *decryptionError) {
         return nil;
     }
@@ -138,34 +165,47 @@ NS_ASSUME_NONNULL_BEGIN
     return plaintextData;
 }
 
-// Decrypt packets. Passphrase may be related to the key or to the symmetric encrypted message (no key in that keys)
-+ (nullable NSArray<PGPPacket *> *)decryptPacketsIfNeeded:(NSArray<PGPPacket *> *)encryptedPackets usingKeys:(NSArray<PGPKey *> *)keys passphrase:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error {
+// Session key of the message. Passphrase may be related to the key or to the symmetric encrypted message (no key in that keys)
++ (nullable NSData *)decryptSessionKeyFromPackets:(NSArray<PGPPacket *> *)packets usingKeys:(NSArray<PGPKey *> *)keys passphrase:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock sessionKeyAlgorithm:(PGPSymmetricAlgorithm * _Nullable)sessionKeyAlgorithm error:(NSError * __autoreleasing _Nullable *)error {
+    return [self decryptSessionKeyFromPackets:packets usingKeys:keys passphrase:passphraseBlock sessionKeyAlgorithm:sessionKeyAlgorithm decryptingKey:nil error:error];
+}
+
+// The decrypting key is the key of the decrypted Public-Key Encrypted Session Key packet, nil for a passphrase.
++ (nullable NSData *)decryptSessionKeyFromPackets:(NSArray<PGPPacket *> *)packets usingKeys:(NSArray<PGPKey *> *)keys passphrase:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock sessionKeyAlgorithm:(PGPSymmetricAlgorithm * _Nullable)sessionKeyAlgorithm decryptingKey:(PGPKey * _Nullable __autoreleasing * _Nullable)decryptingKey error:(NSError * __autoreleasing _Nullable *)error {
     // If the Symmetrically Encrypted Data packet is preceded by one or
     // more Symmetric-Key Encrypted Session Key packets, each specifies a
     // passphrase that may be used to decrypt the message.  This allows a
     // message to be encrypted to a number of public keys, and also to one
     // or more passphrases.
-    PGPSymmetricAlgorithm sessionKeyAlgorithm = PGPSymmetricPlaintext;
-    let packets = [NSMutableArray arrayWithArray:encryptedPackets];
 
-    // 1. search for valid and known (do I have specified key?) ESK
+    // Search for valid and known (do I have specified key?) ESK
+    PGPSymmetricAlgorithm resolvedSessionKeyAlgorithm = PGPSymmetricPlaintext;
     id <PGPEncryptedSessionKeyPacketProtocol> _Nullable eskPacket = nil;
+    PGPKey * _Nullable resolvedDecryptionKey = nil;
     NSData * _Nullable sessionKeyData = nil;
 
     // Resolve session key: PGPSymetricKeyEncryptedSessionKeyPacket and/or PGPPublicKeyEncryptedSessionKeyPacket is expected
     for (PGPPacket *packet in packets) {
         if (packet.tag == PGPSymetricKeyEncryptedSessionKeyPacketTag) {
             let sESKPacket = PGPCast(packet, PGPSymetricKeyEncryptedSessionKeyPacket);
-            sessionKeyAlgorithm = sESKPacket.symmetricAlgorithm;
-            sessionKeyData = sESKPacket.encryptedSessionKey;
-
-            // The S2K algorithm applied to the passphrase produces the session key for decrypting the file
             let passphrase = passphraseBlock ? passphraseBlock(nil) : nil;
-            if (passphrase && !sESKPacket.encryptedSessionKey) {
-                sessionKeyData = [sESKPacket.s2k produceSessionKeyWithPassphrase:passphrase symmetricAlgorithm:sESKPacket.symmetricAlgorithm];
+            if (!sESKPacket || !passphrase || sessionKeyData) {
+                continue;
             }
 
+            // The S2K algorithm applied to the passphrase produces the session key for decrypting the file,
+            // or the key to decrypt the encrypted session key.
+            PGPSymmetricAlgorithm decryptedSessionKeyAlgorithm = PGPSymmetricPlaintext;
+            let decryptedSessionKeyData = [sESKPacket decryptSessionKeyWithPassphrase:PGPNN(passphrase) sessionKeyAlgorithm:&decryptedSessionKeyAlgorithm error:nil];
+            if (!decryptedSessionKeyData) {
+                // Can't proceed with this packet, but there may be other valid packet.
+                continue;
+            }
+
+            resolvedSessionKeyAlgorithm = decryptedSessionKeyAlgorithm;
+            sessionKeyData = decryptedSessionKeyData;
             eskPacket = sESKPacket;
+            resolvedDecryptionKey = nil;
         }
 
         if (packet.tag == PGPPublicKeyEncryptedSessionKeyPacketTag) {
@@ -202,16 +242,57 @@ NS_ASSUME_NONNULL_BEGIN
             }
             eskPacket = pkESKPacket;
 
-            sessionKeyData = [pkESKPacket decryptSessionKeyData:PGPNN(decryptionSecretKeyPacket) sessionKeyAlgorithm:&sessionKeyAlgorithm error:error];
-            NSAssert(sessionKeyAlgorithm < PGPSymmetricMax, @"Invalid session key algorithm");
+            sessionKeyData = [pkESKPacket decryptSessionKeyData:PGPNN(decryptionSecretKeyPacket) sessionKeyAlgorithm:&resolvedSessionKeyAlgorithm error:error];
+            NSAssert(resolvedSessionKeyAlgorithm < PGPSymmetricMax, @"Invalid session key algorithm");
+            resolvedDecryptionKey = decryptionKey;
+        }
+    }
+
+    if ((error && *error) || !eskPacket || !sessionKeyData) {
+        return nil;
+    }
+
+    // Version 6 session key packets don't carry the session key algorithm, the version 2 encrypted data packet does.
+    if (resolvedSessionKeyAlgorithm == PGPSymmetricPlaintext) {
+        for (PGPPacket *packet in packets) {
+            let symEncryptedDataPacket = PGPCast(packet, PGPSymmetricallyEncryptedIntegrityProtectedDataPacket);
+            if (symEncryptedDataPacket.version == 2) {
+                resolvedSessionKeyAlgorithm = symEncryptedDataPacket.symmetricAlgorithm;
+                break;
+            }
         }
     }
 
+    if (sessionKeyAlgorithm) {
+        *sessionKeyAlgorithm = resolvedSessionKeyAlgorithm;
+    }
+    if (decryptingKey) {
+        *decryptingKey = resolvedDecryptionKey;
+    }
+    return sessionKeyData;
+}
+
+// Decrypt packets. Passphrase may be related to the key or to the symmetric encrypted message (no key in that keys)
++ (nullable NSArray<PGPPacket *> *)decryptPacketsIfNeeded:(NSArray<PGPPacket *> *)encryptedPackets usingKeys:(NSArray<PGPKey *> *)keys passphrase:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error {
+    return [self decryptPacketsIfNeeded:encryptedPackets usingKeys:keys passphrase:passphraseBlock sessionKey:nil decryptedSessionKey:nil error:error];
+}
+
+// A given session key skips the session key packets.
++ (nullable NSArray<PGPPacket *> *)decryptPacketsIfNeeded:(NSArray<PGPPacket *> *)encryptedPackets usingKeys:(NSArray<PGPKey *> *)keys passphrase:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock sessionKey:(nullable PGPSessionKey *)sessionKey decryptedSessionKey:(PGPSessionKey * _Nullable __autoreleasing * _Nullable)decryptedSessionKey error:(NSError * __autoreleasing _Nullable *)error {
+    PGPSymmetricAlgorithm sessionKeyAlgorithm = sessionKey ? sessionKey.algorithm : PGPSymmetricPlaintext;
+    let packets = [NSMutableArray arrayWithArray:encryptedPackets];
+
+    // 1. search for valid and known (do I have specified key?) ESK
+    let sessionKeyData = sessionKey ? sessionKey.keyData : [self decryptSessionKeyFromPackets:packets usingKeys:keys passphrase:passphraseBlock sessionKeyAlgorithm:&sessionKeyAlgorithm error:error];
     if (error && *error) {
         return nil;
     }
 
-    if (eskPacket && sessionKeyData) {
+    if (sessionKeyData && decryptedSessionKey) {
+        *decryptedSessionKey = [[PGPSessionKey alloc] initWithAlgorithm:sessionKeyAlgorithm keyData:sessionKeyData];
+    }
+
+    if (sessionKeyData) {
         // 2 Decrypt encrypted data
         for (PGPPacket *packet in packets) {
             switch (packet.tag) {
@@ -249,54 +330,147 @@ NS_ASSUME_NONNULL_BEGIN
     return packets;
 }
 
-+ (nullable NSData *)encrypt:(NSData *)dataToEncrypt addSignature:(BOOL)shouldSign usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey *key))passphraseForKeyBlock error:(NSError * __autoreleasing _Nullable *)error {
-    let publicPartialKeys = [NSMutableArray<PGPPartialKey *> array];
-    for (PGPKey *key in keys) {
-        [publicPartialKeys pgp_addObject:key.publicKey];
+// Key packet of the recipient to encrypt to. Not a revoked or expired key.
++ (nullable PGPPublicKeyPacket *)encryptionKeyPacketOfKey:(PGPKey *)key error:(NSError * __autoreleasing _Nullable *)error {
+    let _Nullable encryptionKeyPacket = PGPCast(key.publicKey ? key.profile.encryptionKeyPacket : nil, PGPPublicKeyPacket);
+    if (!encryptionKeyPacket && error) {
+        *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Encryption key not found for %@. The key is revoked, expired, or not allowed to encrypt.", key.keyID] }];
     }
+    return encryptionKeyPacket;
+}
 
-    let encryptedMessage = [NSMutableData data];
+// Public-Key Encrypted Session Key packets, in the order of the key packets. Every packet is a separate public key
+// operation, these run concurrently.
++ (nullable NSArray<NSData *> *)exportSessionKeyPacketsForKeyPackets:(NSArray<PGPPublicKeyPacket *> *)encryptionKeyPackets version:(UInt8)version sessionKeyData:(NSData *)sessionKeyData sessionKeyAlgorithm:(PGPSymmetricAlgorithm)sessionKeyAlgorithm error:(NSError * __autoreleasing _Nullable *)error {
+    let count = encryptionKeyPackets.count;
+    let results = [NSMutableArray<id> arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [results addObject:NSNull.null];
+    }
+    let resultsLock = [[NSLock alloc] init];
 
-    // PGPPublicKeyEncryptedSessionKeyPacket goes here
-    let preferredSymmeticAlgorithm = [PGPPartialKey preferredSymmetricAlgorithmForKeys:publicPartialKeys];
+    dispatch_apply(count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        @autoreleasepool {
+            let encryptionKeyPacket = encryptionKeyPackets[i];
+            let pkESKeyPacket = [[PGPPublicKeyEncryptedSessionKeyPacket alloc] init];
+            pkESKeyPacket.version = version;
+            pkESKeyPacket.keyID = encryptionKeyPacket.keyID;
+            pkESKeyPacket.publicKeyAlgorithm = encryptionKeyPacket.publicKeyAlgorithm;
+
+            NSError *packetError = nil;
+            id result = nil;
+            if ([pkESKeyPacket encrypt:encryptionKeyPacket sessionKeyData:sessionKeyData sessionKeyAlgorithm:sessionKeyAlgorithm error:&packetError] && !packetError) {
+                result = [pkESKeyPacket export:&packetError];
+            }
+            if (!result || packetError) {
+                result = packetError ?: [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Failed to encrypt the session key." }];
+            }
 
-    // Random bytes as a string to be used as a key
-    NSUInteger keySize = [PGPCryptoUtils keySizeOfSymmetricAlgorithm:preferredSymmeticAlgorithm];
-    let sessionKeyData = [PGPCryptoUtils randomData:keySize];
+            [resultsLock lock];
+            results[i] = result;
+            [resultsLock unlock];
+        }
+    });
 
-    for (PGPPartialKey *publicPartialKey in publicPartialKeys) {
-        // Encrypted Message :- Encrypted Data | ESK Sequence, Encrypted Data.
-        // Encrypted Data :- Symmetrically Encrypted Data Packet | Symmetrically Encrypted Integrity Protected Data Packet
-        // ESK :- Public-Key Encrypted Session Key Packet | Symmetric-Key Encrypted Session Key Packet.
+    // Report the first failure, as if built in order
+    for (id result in results) {
+        let packetError = PGPCast(result, NSError);
+        if (packetError) {
+            PGPLogDebug(@"Failed encrypt Public-Key Encrypted Session Key packet. Error: %@", packetError);
+            if (error) {
+                *error = packetError;
+            }
+            return nil;
+        }
+    }
+    return results;
+}
 
-        // ESK
-        let encryptionKeyPacket = PGPCast([publicPartialKey encryptionKeyPacket:error], PGPPublicKeyPacket);
-        if (!encryptionKeyPacket) {
-            continue;
++ (nullable NSData *)encrypt:(NSData *)dataToEncrypt addSignature:(BOOL)shouldSign usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey *key))passphraseForKeyBlock error:(NSError * __autoreleasing _Nullable *)error {
+    return [self encrypt:dataToEncrypt withPassphrase:nil addSignature:shouldSign usingKeys:keys passphraseForKey:passphraseForKeyBlock error:error];
+}
+
++ (nullable NSData *)encrypt:(NSData *)dataToEncrypt withPassphrase:(NSString *)passphrase error:(NSError * __autoreleasing _Nullable *)error {
+    return [self encrypt:dataToEncrypt withPassphrase:passphrase addSignature:NO usingKeys:@[] passphraseForKey:nil error:error];
+}
+
++ (nullable NSData *)encrypt:(NSData *)dataToEncrypt withPassphrase:(nullable NSString *)passphrase addSignature:(BOOL)shouldSign usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey *key))passphraseForKeyBlock error:(NSError * __autoreleasing _Nullable *)error {
+    if (!passphrase && keys.count == 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Missing passphrase or keys to encrypt." }];
         }
+        return nil;
+    }
 
-        let pkESKeyPacket = [[PGPPublicKeyEncryptedSessionKeyPacket alloc] init];
-        pkESKeyPacket.keyID = encryptionKeyPacket.keyID;
-        pkESKeyPacket.publicKeyAlgorithm = encryptionKeyPacket.publicKeyAlgorithm;
-        BOOL encrypted = [pkESKeyPacket encrypt:encryptionKeyPacket sessionKeyData:sessionKeyData sessionKeyAlgorithm:preferredSymmeticAlgorithm error:error];
-        if (!encrypted || (error && *error)) {
-            PGPLogDebug(@"Failed encrypt Symmetric-key Encrypted Session Key packet. Error: %@", error ? *error : @"Unknown");
+    let content = [self encryptionContentForData:dataToEncrypt signUsingKeys:shouldSign ? keys : nil compressionAlgorithm:[self preferredCompressionAlgorithmForKeys:keys] passphraseForKey:passphraseForKeyBlock error:error];
+    if (!content) {
+        return nil;
+    }
+
+    return [self encryptContent:PGPNN(content) withPassphrase:passphrase usingKeys:keys error:error];
+}
+
++ (nullable NSArray<NSData *> *)encrypt:(NSData *)dataToEncrypt forRecipients:(NSArray<NSArray<PGPKey *> *> *)recipients signUsingKeys:(nullable NSArray<PGPKey *> *)signingKeys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey *key))passphraseForKeyBlock error:(NSError * __autoreleasing _Nullable *)error {
+    for (NSArray<PGPKey *> *keys in recipients) {
+        if (keys.count == 0) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Missing keys to encrypt." }];
+            }
             return nil;
         }
-        [encryptedMessage pgp_appendData:[pkESKeyPacket export:error]];
-        if (error && *error) {
-            PGPLogDebug(@"Missing literal data. Error: %@", error ? *error : @"Unknown");
-            return nil;
+    }
+
+    // Literal data is built, signed and compressed once, then shared by every message. Compressed with the algorithm common to every recipient.
+    let allRecipientKeys = [NSMutableArray<PGPKey *> array];
+    for (NSArray<PGPKey *> *keys in recipients) {
+        [allRecipientKeys addObjectsFromArray:keys];
+    }
+    let content = [self encryptionContentForData:dataToEncrypt signUsingKeys:signingKeys.count > 0 ? signingKeys : nil compressionAlgorithm:[self preferredCompressionAlgorithmForKeys:allRecipientKeys] passphraseForKey:passphraseForKeyBlock error:error];
+    if (!content) {
+        return nil;
+    }
+
+    let count = recipients.count;
+    let results = [NSMutableArray<id> arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [results addObject:NSNull.null];
+    }
+    let resultsLock = [[NSLock alloc] init];
+
+    // Every message has its own session key
+    dispatch_apply(count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        @autoreleasepool {
+            NSError *messageError = nil;
+            id result = [self encryptContent:PGPNN(content) withPassphrase:nil usingKeys:recipients[i] error:&messageError];
+            if (!result || messageError) {
+                result = messageError ?: [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unable to encrypt the message." }];
+            }
+
+            [resultsLock lock];
+            results[i] = result;
+            [resultsLock unlock];
         }
+    });
 
-        // TODO: find the compression type most common to the used keys
+    for (id result in results) {
+        let messageError = PGPCast(result, NSError);
+        if (messageError) {
+            if (error) {
+                *error = messageError;
+            }
+            return nil;
+        }
     }
+    return results;
+}
 
+// Compressed literal data, or the compressed signed message if signing keys are given. Input of the encrypted data packet.
++ (nullable NSData *)encryptionContentForData:(NSData *)dataToEncrypt signUsingKeys:(nullable NSArray<PGPKey *> *)signingKeys compressionAlgorithm:(PGPCompressionAlgorithm)compressionAlgorithm passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey *key))passphraseForKeyBlock error:(NSError * __autoreleasing _Nullable *)error {
     NSData *content;
-    if (shouldSign) {
+    if (signingKeys) {
         // sign data if requested
-        content = [self sign:dataToEncrypt detached:NO usingKeys:keys passphraseForKey:passphraseForKeyBlock error:error];
-        let compressedPacket = [[PGPCompressedPacket alloc] initWithData:content type:PGPCompressionZLIB];
+        content = [self sign:dataToEncrypt detached:NO usingKeys:PGPNN(signingKeys) passphraseForKey:passphraseForKeyBlock error:error];
+        let compressedPacket = [[PGPCompressedPacket alloc] initWithData:content type:compressionAlgorithm];
         content = [compressedPacket export:error];
     } else {
         // Prepare literal packet
@@ -309,17 +483,100 @@ NS_ASSUME_NONNULL_BEGIN
             PGPLogDebug(@"Missing literal packet data. Error: %@", *error);
             return nil;
         }
-        // FIXME: do not use hardcoded value for compression type
-        let compressedPacket = [[PGPCompressedPacket alloc] initWithData:literalPacketData type:PGPCompressionZLIB];
+        let compressedPacket = [[PGPCompressedPacket alloc] initWithData:literalPacketData type:compressionAlgorithm];
         content = [compressedPacket export:error];
     }
-    
+
     if (!content || (error && *error)) {
         return nil;
     }
+    return content;
+}
+
+// Compression algorithm common to the public keys.
++ (PGPCompressionAlgorithm)preferredCompressionAlgorithmForKeys:(NSArray<PGPKey *> *)keys {
+    let profiles = [NSMutableArray<PGPKeyProfile *> arrayWithCapacity:keys.count];
+    for (PGPKey *key in keys) {
+        if (key.isPublic) {
+            [profiles addObject:key.profile];
+        }
+    }
+    return [PGPKeyProfile preferredCompressionAlgorithmForProfiles:profiles];
+}
+
+// Encrypted message of the prepared content: a new session key, the session key packets and the encrypted data packet.
++ (nullable NSData *)encryptContent:(NSData *)content withPassphrase:(nullable NSString *)passphrase usingKeys:(NSArray<PGPKey *> *)keys error:(NSError * __autoreleasing _Nullable *)error {
+    // Recipient capabilities and preferences, computed once per key.
+    let publicKeys = [keys pgp_objectsPassingTest:^BOOL(PGPKey *key, BOOL *stop) {
+        return key.isPublic;
+    }];
+    let profiles = [NSMutableArray<PGPKeyProfile *> arrayWithCapacity:publicKeys.count];
+    for (PGPKey *key in publicKeys) {
+        [profiles addObject:key.profile];
+    }
+
+    let encryptedMessage = [NSMutableData data];
+
+    // PGPPublicKeyEncryptedSessionKeyPacket goes here
+    // Without recipient keys there are no preferences, then use AES-256.
+    let preferredSymmeticAlgorithm = profiles.count > 0 ? [PGPKeyProfile preferredSymmetricAlgorithmForProfiles:profiles] : PGPSymmetricAES256;
+
+    // Random bytes as a string to be used as a key
+    NSUInteger keySize = [PGPCryptoUtils keySizeOfSymmetricAlgorithm:preferredSymmeticAlgorithm];
+    let sessionKeyData = [PGPCryptoUtils randomData:keySize];
+
+    // Version 2 encrypted data (AEAD) and version 6 session key packets, if every recipient supports it.
+    BOOL useAEAD = [PGPKeyProfile isFeature:PGPFeatureSEIPDv2 supportedByProfiles:profiles] && [PGPCryptoAEAD isSupportedAEADAlgorithm:PGPAEADOCB symmetricAlgorithm:preferredSymmeticAlgorithm];
+
+    // Encrypted Message :- Encrypted Data | ESK Sequence, Encrypted Data.
+    // Encrypted Data :- Symmetrically Encrypted Data Packet | Symmetrically Encrypted Integrity Protected Data Packet
+    // ESK :- Public-Key Encrypted Session Key Packet | Symmetric-Key Encrypted Session Key Packet.
+
+    // Resolve the recipient encryption keys once
+    let encryptionKeyPackets = [NSMutableArray<PGPPublicKeyPacket *> arrayWithCapacity:publicKeys.count];
+    for (PGPKey *key in publicKeys) {
+        let _Nullable encryptionKeyPacket = [self encryptionKeyPacketOfKey:key error:error];
+        if (!encryptionKeyPacket) {
+            return nil;
+        }
+        [encryptionKeyPackets addObject:PGPNN(encryptionKeyPacket)];
+    }
+
+    // ESK
+    let sessionKeyPacketsData = [self exportSessionKeyPacketsForKeyPackets:encryptionKeyPackets version:useAEAD ? 6 : 3 sessionKeyData:sessionKeyData sessionKeyAlgorithm:preferredSymmeticAlgorithm error:error];
+    if (!sessionKeyPacketsData) {
+        return nil;
+    }
+    for (NSData *sessionKeyPacketData in sessionKeyPacketsData) {
+        [encryptedMessage pgp_appendData:sessionKeyPacketData];
+    }
+
+    if (passphrase) {
+        // Symmetric-Key Encrypted Session Key. Version 6 goes with the version 2 encrypted data, version 4 with version 1.
+        let s2k = [[PGPS2K alloc] initWithSpecifier:PGPS2KSpecifierIteratedAndSalted hashAlgorithm:PGPHashSHA256];
+        s2k.iterationsCount = [PGPS2K calibratedIterationsCountForHashAlgorithm:s2k.hashAlgorithm];
+
+        let skESKPacket = [[PGPSymetricKeyEncryptedSessionKeyPacket alloc] init];
+        skESKPacket.version = useAEAD ? 6 : 4;
+        skESKPacket.symmetricAlgorithm = preferredSymmeticAlgorithm;
+        skESKPacket.aeadAlgorithm = useAEAD ? PGPAEADOCB : PGPAEADUnknown;
+        skESKPacket.s2k = s2k;
+        if (![skESKPacket encryptSessionKeyData:sessionKeyData sessionKeyAlgorithm:preferredSymmeticAlgorithm passphrase:PGPNN(passphrase) error:error]) {
+            PGPLogDebug(@"Failed encrypt Symmetric-key Encrypted Session Key packet. Error: %@", error ? *error : @"Unknown");
+            return nil;
+        }
+        [encryptedMessage pgp_appendData:[skESKPacket export:error]];
+        if (error && *error) {
+            return nil;
+        }
+    }
 
     let symEncryptedDataPacket = [[PGPSymmetricallyEncryptedIntegrityProtectedDataPacket alloc] init];
-    [symEncryptedDataPacket encrypt:content symmetricAlgorithm:preferredSymmeticAlgorithm sessionKeyData:sessionKeyData error:error];
+    if (useAEAD) {
+        [symEncryptedDataPacket encrypt:content symmetricAlgorithm:preferredSymmeticAlgorithm aeadAlgorithm:PGPAEADOCB chunkSizeOctet:PGPDefaultAEADChunkSizeOctet sessionKeyData:sessionKeyData error:error];
+    } else {
+        [symEncryptedDataPacket encrypt:content symmetricAlgorithm:preferredSymmeticAlgorithm sessionKeyData:sessionKeyData error:error];
+    }
 
     if (error && *error) {
         return nil;
@@ -333,15 +590,151 @@ NS_ASSUME_NONNULL_BEGIN
     return encryptedMessage;
 }
 
+#pragma mark - Session key
+
++ (nullable NSData *)sessionKeyPacketsRewrappingMessage:(NSData *)data toRecipients:(NSArray<PGPKey *> *)recipients keepExistingRecipients:(BOOL)keepExistingRecipients usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseForKeyBlock encryptedDataOffset:(NSUInteger *)encryptedDataOffset error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(data, NSData);
+    PGPAssertClass(recipients, NSArray);
+
+    // Encrypted Message :- ESK Sequence, Encrypted Data.
+    // Only the session key packets are read, the scan stops at the header of the encrypted data packet.
+    let sessionKeyPackets = [NSMutableArray<PGPPacket *> array];
+    let existingPacketsData = [NSMutableData data];
+    NSUInteger offset = 0;
+    PGPPacketHeader *encryptedDataHeader = nil;
+    while (offset < data.length && !encryptedDataHeader) {
+        var header = [PGPPacketHeader headerFromData:data offset:offset];
+        if (!header) {
+            break;
+        }
+
+        switch (header.packetTag) {
+            case PGPSymmetricallyEncryptedIntegrityProtectedDataPacketTag:
+            case PGPSymmetricallyEncryptedDataPacketTag:
+                encryptedDataHeader = header;
+                continue;
+            case PGPPublicKeyEncryptedSessionKeyPacketTag:
+            case PGPSymetricKeyEncryptedSessionKeyPacketTag:
+            case PGPMarkerPacketTag:
+                break;
+            default:
+                header = nil;
+                break;
+        }
+
+        // Session key packets have a definite length
+        if (!header || header.isPartialLength || header.isIndeterminateLength || header.bodyLength > data.length - offset - header.headerLength) {
+            break;
+        }
+
+        let packetData = [data subdataWithRange:(NSRange){offset, header.headerLength + header.bodyLength}];
+        let packet = [PGPPacketFactory packetWithData:packetData offset:0 consumedBytes:nil];
+        if (packet && packet.tag != PGPMarkerPacketTag) {
+            [sessionKeyPackets addObject:packet];
+            [existingPacketsData appendData:packetData];
+        }
+        offset += packetData.length;
+    }
+
+    if (!encryptedDataHeader || offset + encryptedDataHeader.headerLength >= data.length) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Invalid message. Expected session key packets followed by the encrypted data." }];
+        }
+        return nil;
+    }
+
+    // The session key packet version follows the encrypted data packet version.
+    UInt8 encryptedDataVersion = 1;
+    if (encryptedDataHeader.packetTag == PGPSymmetricallyEncryptedIntegrityProtectedDataPacketTag) {
+        [data getBytes:&encryptedDataVersion range:(NSRange){offset + encryptedDataHeader.headerLength, 1}];
+    }
+
+    PGPSymmetricAlgorithm sessionKeyAlgorithm = PGPSymmetricPlaintext;
+    let sessionKeyData = [self decryptSessionKeyFromPackets:sessionKeyPackets usingKeys:keys passphrase:passphraseForKeyBlock sessionKeyAlgorithm:&sessionKeyAlgorithm error:error];
+    if (!sessionKeyData) {
+        if (error && !*error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt the session key. Missing private key or passphrase." }];
+        }
+        return nil;
+    }
+
+    let encryptionKeyPackets = [NSMutableArray<PGPPublicKeyPacket *> arrayWithCapacity:recipients.count];
+    for (PGPKey *recipient in recipients) {
+        let _Nullable encryptionKeyPacket = [self encryptionKeyPacketOfKey:recipient error:error];
+        if (!encryptionKeyPacket) {
+            return nil;
+        }
+        [encryptionKeyPackets addObject:PGPNN(encryptionKeyPacket)];
+    }
+
+    let newPacketsData = [self exportSessionKeyPacketsForKeyPackets:encryptionKeyPackets version:encryptedDataVersion == 2 ? 6 : 3 sessionKeyData:sessionKeyData sessionKeyAlgorithm:sessionKeyAlgorithm error:error];
+    if (!newPacketsData) {
+        return nil;
+    }
+
+    let sessionKeyPacketsData = [NSMutableData dataWithData:keepExistingRecipients ? existingPacketsData : [NSData data]];
+    for (NSData *packetData in newPacketsData) {
+        [sessionKeyPacketsData appendData:packetData];
+    }
+
+    *encryptedDataOffset = offset;
+    return sessionKeyPacketsData;
+}
+
++ (BOOL)rewrapMessageAtURL:(NSURL *)sourceURL toURL:(NSURL *)destinationURL recipients:(NSArray<PGPKey *> *)recipients keepExistingRecipients:(BOOL)keepExistingRecipients usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseForKeyBlock error:(NSError * __autoreleasing _Nullable *)error {
+    // Mapped, the encrypted data is copied page by page and never loaded as a whole.
+    let data = [NSData dataWithContentsOfURL:sourceURL options:NSDataReadingMappedAlways error:error];
+    if (!data) {
+        return NO;
+    }
+
+    NSUInteger encryptedDataOffset = 0;
+    let sessionKeyPacketsData = [self sessionKeyPacketsRewrappingMessage:PGPNN(data) toRecipients:recipients keepExistingRecipients:keepExistingRecipients usingKeys:keys passphraseForKey:passphraseForKeyBlock encryptedDataOffset:&encryptedDataOffset error:error];
+    if (!sessionKeyPacketsData) {
+        return NO;
+    }
+
+    let outputStream = [NSOutputStream outputStreamWithURL:destinationURL append:NO];
+    [outputStream open];
+    pgp_defer {
+        [outputStream close];
+    };
+
+    BOOL written = [self writeBytes:sessionKeyPacketsData.bytes length:sessionKeyPacketsData.length toStream:PGPNN(outputStream)];
+    const NSUInteger chunkSize = 1 << 20;
+    for (NSUInteger position = encryptedDataOffset; written && position < data.length; position += chunkSize) {
+        @autoreleasepool {
+            written = [self writeBytes:(const UInt8 *)data.bytes + position length:MIN(chunkSize, data.length - position) toStream:PGPNN(outputStream)];
+        }
+    }
+
+    if (!written) {
+        if (error) {
+            *error = outputStream.streamError ?: [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unable to write the message." }];
+        }
+        return NO;
+    }
+    return YES;
+}
+
++ (BOOL)writeBytes:(const UInt8 *)bytes length:(NSUInteger)length toStream:(NSOutputStream *)outputStream {
+    NSUInteger written = 0;
+    while (written < length) {
+        let result = [outputStream write:bytes + written maxLength:length - written];
+        if (result <= 0) {
+            return NO;
+        }
+        written += (NSUInteger)result;
+    }
+    return YES;
+}
+
 #pragma mark - Sign & Verify
 
 + (nullable NSData *)sign:(NSData *)data detached:(BOOL)detached usingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey *key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error {
     PGPAssertClass(data, NSData);
     PGPAssertClass(keys, NSArray);
 
-    // TODO: Use prefered hash alhorithm for key
-    PGPHashAlgorithm preferedHashAlgorithm = PGPHashSHA512;
-
     // Calculate signatures signatures
     let signatures = [NSMutableArray<PGPSignaturePacket *> array];
     for (PGPKey *key in keys) {
@@ -350,7 +743,7 @@ NS_ASSUME_NONNULL_BEGIN
             continue;
         }
         // Signed Message :- Signature Packet, Literal Message
-        let signaturePacket = [PGPSignaturePacket signaturePacket:PGPSignatureBinaryDocument hashAlgorithm:preferedHashAlgorithm];
+        let signaturePacket = [PGPSignaturePacket signaturePacket:PGPSignatureBinaryDocument hashAlgorithm:key.profile.preferredHashAlgorithm];
         let passphrase = passphraseBlock ? passphraseBlock(key) : nil;
         if (![signaturePacket signData:data withKey:key subKey:nil passphrase:passphrase userID:nil error:error]) {
             PGPLogDebug(@"Can't sign data");
@@ -701,9 +1094,11 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 + (nullable NSArray<PGPKey *> *)readKeysFromData:(NSData *)fileData error:(NSError * __autoreleasing _Nullable *)error {
-    PGPAssertClass(fileData, NSData);
+    return [self readKeysFromData:fileData resyncPolicy:PGPPacketResyncPolicySkip error:error];
+}
 
-    var keys = [NSArray<PGPKey *> array];
++ (nullable NSArray<PGPKey *> *)readKeysFromData:(NSData *)fileData resyncPolicy:(PGPPacketResyncPolicy)resyncPolicy error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(fileData, NSData);
 
     if (fileData.length == 0) {
         PGPLogError(@"Empty input data");
@@ -722,42 +1117,32 @@ NS_ASSUME_NONNULL_BEGIN
         return nil;
     }
 
+    let partialKeys = [NSMutableArray<PGPPartialKey *> array];
     for (NSData *data in binRingData) {
-        let readPartialKeys = [self readPartialKeysFromData:data];
-        for (PGPPartialKey *key in readPartialKeys) {
-            keys = [PGPKeyring addOrUpdatePartialKey:key inContainer:keys];
+        let readPartialKeys = [self readPartialKeysFromData:data resyncPolicy:resyncPolicy error:error];
+        if (!readPartialKeys) {
+            return nil;
         }
+        [partialKeys addObjectsFromArray:readPartialKeys];
     }
 
-    return keys;
+    return [PGPKeyring keysByMergingPartialKeys:partialKeys];
 }
 
 + (nullable NSArray<PGPKeyID *> *)recipientsKeyIDForMessage:(NSData *)data error:(NSError * __autoreleasing _Nullable *)error {
     PGPAssertClass(data, NSData);
 
     // TODO: Decrypt all messages
-    let binaryMessage = [PGPArmor convertArmoredMessage2BinaryBlocksWhenNecessary:data error:error].firstObject;
-    if (!binaryMessage) {
+    let message = [[PGPMessage alloc] initWithData:data error:error];
+    if (!message) {
         if (error) {
             *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Invalid message to decrypt." }];
         }
         return nil;
     }
 
-    // parse packets
-    let foundKeys = [NSMutableOrderedSet<PGPKeyID *> orderedSetWithCapacity:1];
-    var packets = [ObjectivePGP readPacketsFromData:binaryMessage];
-    for (PGPPacket *packet in packets) {
-        switch (packet.tag) {
-            case PGPPublicKeyEncryptedSessionKeyPacketTag: {
-                let publicKeyEncrypteSessionKey = PGPCast(packet, PGPPublicKeyEncryptedSessionKeyPacket);
-                [foundKeys addObject:publicKeyEncrypteSessionKey.keyID];
-            } break;
-            default:
-                break;
-        }
-    }
-    return foundKeys.count > 0 ? foundKeys.array : nil;
+    let recipientKeyIDs = message.recipientKeyIDs;
+    return recipientKeyIDs.count > 0 ? recipientKeyIDs : nil;
 }
 
 #pragma mark - Private
@@ -788,9 +1173,11 @@ NS_ASSUME_NONNULL_BEGIN
                 [accumulatedPackets addObjectsFromArray:uncompressedPackets ?: @[]];
             }
 
-            // corrupted data. Move by one byte in hope we find some packet there, or EOF.
+            // corrupted data. Skip to the next packet, or EOF.
             if (consumedBytes == 0) {
-                offset++;
+                let nextOffset = [PGPPacketFactory offsetOfNextPacketInData:data fromOffset:offset + 1];
+                offset = nextOffset == NSNotFound ? data.length : nextOffset;
+                continue;
             }
             offset += consumedBytes;
         }
@@ -799,49 +1186,143 @@ NS_ASSUME_NONNULL_BEGIN
     return accumulatedPackets;
 }
 
-+ (NSArray<PGPPartialKey *> *)readPartialKeysFromData:(NSData *)messageData {
-    let partialKeys = [NSMutableArray<PGPPartialKey *> array];
-    let accumulatedPackets = [NSMutableArray<PGPPacket *> array];
-    NSUInteger position = 0;
-    NSUInteger consumedBytes = 0;
+// Two phases: a header-only scan splits the data at the primary key packets, then the keys are read concurrently.
++ (nullable NSArray<PGPPartialKey *> *)readPartialKeysFromData:(NSData *)messageData resyncPolicy:(PGPPacketResyncPolicy)resyncPolicy error:(NSError * __autoreleasing _Nullable *)error {
+    let keyRanges = [self keyRangesInData:messageData resyncPolicy:resyncPolicy error:error];
+    if (!keyRanges) {
+        return nil;
+    }
 
-    while (position < messageData.length) {
+    return [[self readPartialKeysFromData:messageData ranges:keyRanges] pgp_objectsPassingTest:^BOOL(id result, BOOL *stop) {
+        return [result isKindOfClass:PGPPartialKey.class];
+    }];
+}
+
+// Keys of the ranges, read concurrently. NSNull for a range without a valid key.
++ (NSArray<id> *)readPartialKeysFromData:(NSData *)messageData ranges:(NSArray<NSValue *> *)keyRanges {
+    // A batch of keys per iteration, the results are stored in order.
+    let batchSize = (NSUInteger)64;
+    let batchesCount = (keyRanges.count + batchSize - 1) / batchSize;
+    let results = [NSMutableArray<id> arrayWithCapacity:keyRanges.count];
+    for (NSUInteger i = 0; i < keyRanges.count; i++) {
+        [results addObject:NSNull.null];
+    }
+    let resultsLock = [[NSLock alloc] init];
+
+    dispatch_apply(batchesCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t batch) {
         @autoreleasepool {
-            let _Nullable packet = [PGPPacketFactory packetWithData:messageData offset:position consumedBytes:&consumedBytes];
-            if (!packet) {
-                position += (consumedBytes > 0) ? consumedBytes : 1;
-                continue;
+            let batchRange = (NSRange){batch * batchSize, MIN(batchSize, keyRanges.count - batch * batchSize)};
+            let batchKeys = [NSMutableArray<id> arrayWithCapacity:batchRange.length];
+            for (NSUInteger i = batchRange.location; i < NSMaxRange(batchRange); i++) {
+                [batchKeys addObject:[self readPartialKeyFromData:messageData range:keyRanges[i].rangeValue] ?: NSNull.null];
             }
 
-            if ((accumulatedPackets.count > 1) && ((packet.tag == PGPPublicKeyPacketTag) || (packet.tag == PGPSecretKeyPacketTag))) {
-                PGPPublicKeyPacket *pubPacket = (PGPPublicKeyPacket*) packet;
-                if ((pubPacket.isSupported) ) {
-                    let partialKey = [[PGPPartialKey alloc] initWithPackets:accumulatedPackets];
-                    [partialKeys addObject:partialKey];
+            [resultsLock lock];
+            [results replaceObjectsInRange:batchRange withObjectsFromArray:batchKeys];
+            [resultsLock unlock];
+        }
+    });
+
+    return results;
+}
+
+// Ranges of the keys: from a primary key packet to the next one.
++ (nullable NSArray<NSValue *> *)keyRangesInData:(NSData *)messageData resyncPolicy:(PGPPacketResyncPolicy)resyncPolicy error:(NSError * __autoreleasing _Nullable *)error {
+    let keyRanges = [NSMutableArray<NSValue *> array];
+    NSUInteger keyOffset = NSNotFound;
+    NSUInteger position = 0;
+    while (position < messageData.length) {
+        PGPPacketTag tag = PGPInvalidPacketTag;
+        let packetLength = [PGPPacketFactory lengthOfPacketInData:messageData offset:position packetTag:&tag];
+        if (packetLength == 0) {
+            // corrupted data
+            if (resyncPolicy == PGPPacketResyncPolicyReport) {
+                if (error) {
+                    *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Can't read keys. Invalid packet data at offset %@.", @(position)]}];
                 }
-                [accumulatedPackets removeAllObjects];
+                return nil;
             }
 
-            [accumulatedPackets pgp_addObject:packet];
-            position += consumedBytes;
+            let nextPosition = resyncPolicy == PGPPacketResyncPolicySkip ? [PGPPacketFactory offsetOfNextPacketInData:messageData fromOffset:position + 1] : NSNotFound;
+            if (nextPosition == NSNotFound) {
+                break;
+            }
+            position = nextPosition;
+            continue;
         }
+
+        if (tag == PGPPublicKeyPacketTag || tag == PGPSecretKeyPacketTag) {
+            if (keyOffset != NSNotFound) {
+                [keyRanges addObject:[NSValue valueWithRange:(NSRange){keyOffset, position - keyOffset}]];
+            }
+            keyOffset = position;
+        }
+        position += packetLength;
     }
 
-    
-    if (accumulatedPackets.count > 1) {
-        for (PGPPacket *p in accumulatedPackets) {
-            if (p.tag == PGPPublicKeyPacketTag || p.tag == PGPSecretKeyPacketTag) {
-                PGPPublicKeyPacket *pubPacket = (PGPPublicKeyPacket*) p;
-                if ((pubPacket.isSupported) ) {
-                    let key = [[PGPPartialKey alloc] initWithPackets:accumulatedPackets];
-                    [partialKeys addObject:key];
+    if (keyOffset != NSNotFound) {
+        [keyRanges addObject:[NSValue valueWithRange:(NSRange){keyOffset, MIN(position, messageData.length) - keyOffset}]];
+    }
+    return keyRanges;
+}
+
+// Key of the packets in range. Invalid data in the range is skipped.
+// The packets of the users, from the first user packet to the first subkey, are parsed when the users are accessed.
++ (nullable PGPPartialKey *)readPartialKeyFromData:(NSData *)messageData range:(NSRange)range {
+    let packets = [NSMutableArray<PGPPacket *> array];
+    let userPacketRanges = [NSMutableArray<NSValue *> array];
+    NSUInteger userPacketsOffset = NSNotFound;
+    NSUInteger userPacketsEnd = 0;
+    BOOL userPackets = NO;
+
+    NSUInteger position = range.location;
+    while (position < NSMaxRange(range)) {
+        PGPPacketTag tag = PGPInvalidPacketTag;
+        NSUInteger consumedBytes = [PGPPacketFactory lengthOfPacketInData:messageData offset:position packetTag:&tag];
+        if (consumedBytes > 0) {
+            if (tag == PGPUserIDPacketTag || tag == PGPUserAttributePacketTag) {
+                userPackets = YES;
+            } else if (tag == PGPPublicSubkeyPacketTag || tag == PGPSecretSubkeyPacketTag) {
+                userPackets = NO;
+            }
+
+            if (userPackets) {
+                if (userPacketsOffset == NSNotFound) {
+                    userPacketsOffset = position;
                 }
+                [userPacketRanges addObject:[NSValue valueWithRange:(NSRange){position - userPacketsOffset, consumedBytes}]];
+                userPacketsEnd = position + consumedBytes;
+                position += consumedBytes;
+                continue;
             }
+
+            [packets pgp_addObject:[PGPPacketFactory packetWithData:messageData offset:position consumedBytes:&consumedBytes]];
+        }
+
+        if (consumedBytes == 0) {
+            let nextPosition = [PGPPacketFactory offsetOfNextPacketInData:messageData fromOffset:position + 1];
+            position = MIN(nextPosition, NSMaxRange(range));
+            continue;
         }
-        [accumulatedPackets removeAllObjects];
+        position += consumedBytes;
+    }
+
+    let primaryKeyPacket = PGPCast(packets.firstObject, PGPPublicKeyPacket);
+    if (packets.count + userPacketRanges.count < 2 || !primaryKeyPacket.isSupported) {
+        return nil;
+    }
+
+    PGPPartialKey *partialKey;
+    if (userPacketRanges.count == 0) {
+        partialKey = [[PGPPartialKey alloc] initWithPackets:packets];
+    } else {
+        let userPacketsData = [messageData subdataWithRange:(NSRange){userPacketsOffset, userPacketsEnd - userPacketsOffset}];
+        partialKey = [[PGPPartialKey alloc] initWithPackets:packets userPacketsData:userPacketsData ranges:userPacketRanges];
     }
 
-    return partialKeys;
+    // Verify the self-signatures once, on import.
+    [PGPKeyValidator validatePartialKeys:@[partialKey]];
+    return partialKey;
 }
 
 @end
@@ -26,6 +26,9 @@ PGP_EMPTY_INIT_UNAVAILABLE
 
 + (instancetype)defaultParameters;
 
+/// KDF parameters recommended for the curve (RFC 6637 section 13).
++ (instancetype)defaultParametersForCurve:(PGPCurve)curve;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -48,6 +48,22 @@ NS_ASSUME_NONNULL_BEGIN
     return [[PGPCurveKDFParameters alloc] initWithHashAlgorithm:PGPHashSHA256 symmetricAlgorithm:PGPSymmetricAES128];
 }
 
++ (instancetype)defaultParametersForCurve:(PGPCurve)curve {
+    switch (curve) {
+        case PGPCurveP384:
+            return [[PGPCurveKDFParameters alloc] initWithHashAlgorithm:PGPHashSHA384 symmetricAlgorithm:PGPSymmetricAES192];
+        case PGPCurveP521:
+        case PGPCurveBrainpoolP512r1:
+            return [[PGPCurveKDFParameters alloc] initWithHashAlgorithm:PGPHashSHA512 symmetricAlgorithm:PGPSymmetricAES256];
+        case PGPCurveP256:
+        case PGPCurveBrainpoolP256r1:
+        case PGPCurveEd25519:
+        case PGPCurve25519:
+            break;
+    }
+    return [self defaultParameters];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
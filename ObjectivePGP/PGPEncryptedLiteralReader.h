@@ -0,0 +1,61 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMacros.h>
+#import <ObjectivePGP/PGPSessionKey.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Random access to the literal data of an encrypted message.
+
+ The message packet boundaries, including partial body lengths, are indexed once. A read decrypts
+ only the cipher blocks of the requested range. The literal data has to be uncompressed, in a
+ version 1 encrypted data packet (CFB mode, where a block decrypts with the previous ciphertext block).
+
+ @note Reads are not integrity protected. Use `verifyIntegrity:` to check the whole message.
+ The reader does not change after initialization and can be read from many threads.
+ */
+NS_SWIFT_NAME(EncryptedLiteralReader) @interface PGPEncryptedLiteralReader : NSObject
+
+/// Length of the literal data.
+@property (readonly, nonatomic) NSUInteger length;
+
+/// Filename of the literal data.
+@property (readonly, copy, nonatomic, nullable) NSString *filename;
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+/**
+ Index the binary encrypted message.
+
+ @param data Binary encrypted message. Mapped data is read in place.
+ @param sessionKey The session key of the message.
+ @param error Optional. Error.
+ */
+- (nullable instancetype)initWithData:(NSData *)data sessionKey:(PGPSessionKey *)sessionKey error:(NSError * __autoreleasing _Nullable *)error NS_DESIGNATED_INITIALIZER;
+
+/// Index the binary encrypted message file. The file is mapped.
+- (nullable instancetype)initWithURL:(NSURL *)url sessionKey:(PGPSessionKey *)sessionKey error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ Read the literal data range.
+
+ @param range Range of the literal data.
+ @param error Optional. Error.
+ @return Decrypted literal data, or `nil` if the range is out of bounds.
+ */
+- (nullable NSData *)readRange:(NSRange)range error:(NSError * __autoreleasing _Nullable *)error;
+
+/// Decrypt the whole message and check the modification detection code.
+- (BOOL)verifyIntegrity:(NSError * __autoreleasing _Nullable *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
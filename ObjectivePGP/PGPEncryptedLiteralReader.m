@@ -0,0 +1,369 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPEncryptedLiteralReader.h"
+#import "PGPPacketHeader.h"
+#import "PGPCryptoCFB.h"
+#import "PGPCryptoUtils.h"
+#import "PGPTypes.h"
+#import "PGPMacros+Private.h"
+#import "PGPFoundation.h"
+
+#import <openssl/crypto.h>
+#import <openssl/sha.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Modification Detection Code packet: header octets 0xD3, 0x14 and the SHA-1 hash
+static const NSUInteger PGPMDCPacketLength = 22;
+// Decryption unit of the integrity check
+static const NSUInteger PGPIntegrityChunkSize = 1 << 20;
+
+// Part of a packet body. A partial body length packet has a segment per chunk.
+typedef struct {
+    NSUInteger position; // position in the packet body
+    NSUInteger offset; // offset in the container
+    NSUInteger length;
+} PGPBodySegment;
+
+// Index of the segment at the body position
+static NSUInteger PGPBodySegmentIndex(NSData *segmentsData, NSUInteger position) {
+    const PGPBodySegment *segments = segmentsData.bytes;
+    NSUInteger low = 0;
+    NSUInteger high = segmentsData.length / sizeof(PGPBodySegment);
+    while (high - low > 1) {
+        let middle = low + (high - low) / 2;
+        if (segments[middle].position <= position) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Container ranges of the body range, in order
+static void PGPBodySegmentsEnumerateRange(NSData *segmentsData, NSRange range, NS_NOESCAPE void (^block)(NSUInteger offset, NSUInteger length)) {
+    const PGPBodySegment *segments = segmentsData.bytes;
+    let count = segmentsData.length / sizeof(PGPBodySegment);
+    NSUInteger position = range.location;
+    for (NSUInteger i = PGPBodySegmentIndex(segmentsData, position); i < count && position < NSMaxRange(range); i++) {
+        let skip = position - segments[i].position;
+        let length = MIN(segments[i].length - skip, NSMaxRange(range) - position);
+        block(segments[i].offset + skip, length);
+        position += length;
+    }
+}
+
+@interface PGPEncryptedLiteralReader ()
+
+@property (nonatomic, readwrite) NSUInteger length;
+@property (copy, nonatomic, readwrite, nullable) NSString *filename;
+
+@end
+
+@implementation PGPEncryptedLiteralReader {
+    NSData *_data;
+    PGPSessionKey *_sessionKey;
+    NSUInteger _blockSize;
+    // Encrypted data packet body, in the message data
+    NSData *_encryptedBodySegments;
+    // Length of the ciphertext, the body without the version octet
+    NSUInteger _ciphertextLength;
+    // Literal packet body, in the plaintext
+    NSData *_literalBodySegments;
+    // Literal data position in the literal packet body
+    NSUInteger _literalDataPosition;
+}
+
+- (nullable instancetype)initWithURL:(NSURL *)url sessionKey:(PGPSessionKey *)sessionKey error:(NSError * __autoreleasing _Nullable *)error {
+    let data = [NSData dataWithContentsOfURL:url options:NSDataReadingMappedAlways error:error];
+    if (!data) {
+        return nil;
+    }
+    return [self initWithData:PGPNN(data) sessionKey:sessionKey error:error];
+}
+
+- (nullable instancetype)initWithData:(NSData *)data sessionKey:(PGPSessionKey *)sessionKey error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(data, NSData);
+    PGPAssertClass(sessionKey, PGPSessionKey);
+
+    if ((self = [super init])) {
+        _data = data;
+        _sessionKey = sessionKey;
+        _blockSize = [PGPCryptoUtils blockSizeOfSymmetricAlhorithm:sessionKey.algorithm];
+        if (![self indexEncryptedData:error] || ![self indexLiteralData:error]) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+#pragma mark - Index
+
+// Encrypted Message :- ESK Sequence, Encrypted Data.
+- (BOOL)indexEncryptedData:(NSError * __autoreleasing _Nullable *)error {
+    let data = _data;
+    NSUInteger offset = 0;
+    PGPPacketHeader *header = nil;
+    while ((header = [PGPPacketHeader headerFromData:data offset:offset])) {
+        if (header.packetTag == PGPSymmetricallyEncryptedIntegrityProtectedDataPacketTag) {
+            break;
+        }
+
+        let isSessionKeyPacket = header.packetTag == PGPPublicKeyEncryptedSessionKeyPacketTag || header.packetTag == PGPSymetricKeyEncryptedSessionKeyPacketTag || header.packetTag == PGPMarkerPacketTag;
+        if (!isSessionKeyPacket || header.isPartialLength || header.isIndeterminateLength || header.bodyLength > data.length - offset - header.headerLength) {
+            header = nil;
+            break;
+        }
+        offset += header.headerLength + header.bodyLength;
+    }
+
+    NSUInteger bodyLength = 0;
+    let segments = header ? [self bodySegmentsOfPacket:PGPNN(header) atOffset:offset containerLength:data.length bodyLength:&bodyLength readBytes:^NSData *(NSRange range) {
+        return [data subdataWithRange:range];
+    }] : nil;
+
+    UInt8 version = 0;
+    if (segments && bodyLength > 0) {
+        [data getBytes:&version range:(NSRange){((const PGPBodySegment *)segments.bytes)[0].offset, 1}];
+    }
+
+    // A version 2 packet (AEAD) authenticates chunks and can't be read at random.
+    if (!segments || version != 1 || bodyLength - 1 < _blockSize + 2 + PGPMDCPacketLength) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Invalid message. Expected a version 1 symmetrically encrypted integrity protected data packet." }];
+        }
+        return NO;
+    }
+
+    _encryptedBodySegments = segments;
+    _ciphertextLength = bodyLength - 1;
+    return YES;
+}
+
+// The encrypted data is: prefix, packets, MDC packet. The literal packet may follow one-pass signature packets.
+- (BOOL)indexLiteralData:(NSError * __autoreleasing _Nullable *)error {
+    // The prefix is random block followed by a copy of its last two octets.
+    let prefixData = [self decryptPlaintextRange:(NSRange){0, _blockSize + 2}];
+    let prefixBytes = (const UInt8 *)prefixData.bytes;
+    if (!prefixData || memcmp(prefixBytes + _blockSize - 2, prefixBytes + _blockSize, 2) != 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Validation failed. Random suffix mismatch." }];
+        }
+        return NO;
+    }
+
+    let contentLength = _ciphertextLength - PGPMDCPacketLength;
+    NSUInteger offset = _blockSize + 2;
+    PGPPacketHeader *header = nil;
+    while (offset < contentLength) {
+        let headerData = [self decryptPlaintextRange:(NSRange){offset, MIN((NSUInteger)6, contentLength - offset)}];
+        header = headerData ? [PGPPacketHeader headerFromData:PGPNN(headerData) offset:0] : nil;
+        if (!header || header.packetTag != PGPOnePassSignaturePacketTag || header.isPartialLength || header.isIndeterminateLength) {
+            break;
+        }
+        offset += header.headerLength + header.bodyLength;
+    }
+
+    if (!header || header.packetTag != PGPLiteralDataPacketTag) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to read. Expected uncompressed literal data." }];
+        }
+        return NO;
+    }
+
+    NSUInteger bodyLength = 0;
+    let segments = [self bodySegmentsOfPacket:header atOffset:offset containerLength:contentLength bodyLength:&bodyLength readBytes:^NSData *(NSRange range) {
+        return [self decryptPlaintextRange:range];
+    }];
+    if (!segments) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Invalid literal data packet." }];
+        }
+        return NO;
+    }
+    _literalBodySegments = segments;
+
+    // Literal packet body: format, filename length, filename, date, literal data.
+    UInt8 filenameLength = 0;
+    let formatData = [self readLiteralBodyRange:(NSRange){0, MIN((NSUInteger)2, bodyLength)}];
+    if (formatData.length == 2) {
+        [formatData getBytes:&filenameLength range:(NSRange){1, 1}];
+    }
+    _literalDataPosition = 2 + filenameLength + 4;
+    if (formatData.length < 2 || bodyLength < _literalDataPosition) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Invalid literal data packet." }];
+        }
+        return NO;
+    }
+
+    if (filenameLength > 0) {
+        self.filename = [[NSString alloc] initWithData:[self readLiteralBodyRange:(NSRange){2, filenameLength}] encoding:NSUTF8StringEncoding];
+    }
+    self.length = bodyLength - _literalDataPosition;
+    return YES;
+}
+
+// Body segments of the packet at the offset, following the partial body length chain.
+- (nullable NSData *)bodySegmentsOfPacket:(PGPPacketHeader *)header atOffset:(NSUInteger)packetOffset containerLength:(NSUInteger)containerLength bodyLength:(NSUInteger *)bodyLength readBytes:(NS_NOESCAPE NSData * _Nullable (^)(NSRange range))readBytes {
+    let segments = [NSMutableData data];
+    NSUInteger position = 0;
+    NSUInteger offset = packetOffset + header.headerLength;
+    // Indeterminate length packet takes the rest of the container
+    NSUInteger length = header.isIndeterminateLength ? containerLength - MIN(offset, containerLength) : header.bodyLength;
+    BOOL isPartial = header.isPartialLength;
+    while (YES) {
+        if (offset > containerLength || length > containerLength - offset) {
+            return nil;
+        }
+
+        PGPBodySegment segment = { .position = position, .offset = offset, .length = length };
+        [segments appendBytes:&segment length:sizeof(segment)];
+        position += length;
+        offset += length;
+
+        if (!isPartial) {
+            break;
+        }
+
+        // Length octets of the next chunk
+        let lengthOctets = [NSMutableData dataWithLength:5];
+        let available = MIN((NSUInteger)5, containerLength - offset);
+        let readData = available > 0 ? readBytes((NSRange){offset, available}) : nil;
+        if (!readData) {
+            return nil;
+        }
+        [lengthOctets replaceBytesInRange:(NSRange){0, readData.length} withBytes:readData.bytes];
+
+        UInt8 bytesCount = 0;
+        isPartial = NO;
+        [PGPPacketHeader getLengthFromNewFormatOctets:lengthOctets bodyLength:&length bytesCount:&bytesCount isPartial:&isPartial];
+        if (length == PGPUnknownLength || bytesCount > available) {
+            return nil;
+        }
+        offset += bytesCount;
+    }
+
+    *bodyLength = position;
+    return segments;
+}
+
+#pragma mark - Read
+
+- (nullable NSData *)readRange:(NSRange)range error:(NSError * __autoreleasing _Nullable *)error {
+    if (range.location > self.length || range.length > self.length - range.location) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Range out of bounds." }];
+        }
+        return nil;
+    }
+
+    let data = [self readLiteralBodyRange:(NSRange){_literalDataPosition + range.location, range.length}];
+    if (!data && error) {
+        *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt." }];
+    }
+    return data;
+}
+
+// Decrypt the plaintext span of the range once and gather the literal body chunks from it.
+- (nullable NSData *)readLiteralBodyRange:(NSRange)range {
+    if (range.length == 0) {
+        return [NSData data];
+    }
+
+    __block NSUInteger spanStart = NSNotFound;
+    __block NSUInteger spanEnd = 0;
+    PGPBodySegmentsEnumerateRange(_literalBodySegments, range, ^(NSUInteger offset, NSUInteger length) {
+        spanStart = MIN(spanStart, offset);
+        spanEnd = offset + length;
+    });
+
+    let spanData = [self decryptPlaintextRange:(NSRange){spanStart, spanEnd - spanStart}];
+    if (!spanData) {
+        return nil;
+    }
+
+    let data = [NSMutableData dataWithCapacity:range.length];
+    PGPBodySegmentsEnumerateRange(_literalBodySegments, range, ^(NSUInteger offset, NSUInteger length) {
+        [data appendBytes:(const UInt8 *)spanData.bytes + (offset - spanStart) length:length];
+    });
+    return data;
+}
+
+// In CFB mode a block decrypts with the previous ciphertext block as the IV. The first block with zero IV.
+- (nullable NSData *)decryptPlaintextRange:(NSRange)range {
+    if (range.length == 0 || NSMaxRange(range) > _ciphertextLength) {
+        return nil;
+    }
+
+    let blockStart = range.location - range.location % _blockSize;
+    let ivStart = blockStart > 0 ? blockStart - _blockSize : 0;
+
+    // Ciphertext follows the version octet of the packet body
+    let ciphertext = [NSMutableData dataWithCapacity:NSMaxRange(range) - ivStart];
+    let data = _data;
+    PGPBodySegmentsEnumerateRange(_encryptedBodySegments, (NSRange){1 + ivStart, NSMaxRange(range) - ivStart}, ^(NSUInteger offset, NSUInteger length) {
+        [ciphertext appendBytes:(const UInt8 *)data.bytes + offset length:length];
+    });
+
+    let ivData = blockStart > 0 ? [ciphertext subdataWithRange:(NSRange){0, _blockSize}] : [NSMutableData dataWithLength:_blockSize];
+    let encryptedData = [ciphertext subdataWithRange:(NSRange){blockStart - ivStart, ciphertext.length - (blockStart - ivStart)}];
+    let decryptedData = [PGPCryptoCFB decryptData:encryptedData sessionKeyData:_sessionKey.keyData symmetricAlgorithm:_sessionKey.algorithm iv:ivData syncCFB:NO];
+    if (decryptedData.length != encryptedData.length) {
+        return nil;
+    }
+    return [decryptedData subdataWithRange:(NSRange){range.location - blockStart, range.length}];
+}
+
+#pragma mark - Integrity
+
+- (BOOL)verifyIntegrity:(NSError * __autoreleasing _Nullable *)error {
+    // The hash covers the prefix, the packets and the two octets of the MDC packet header.
+    let hashedLength = _ciphertextLength - SHA_DIGEST_LENGTH;
+    let mdcData = [NSMutableData dataWithCapacity:PGPMDCPacketLength];
+
+    SHA_CTX ctx;
+    SHA1_Init(&ctx);
+    for (NSUInteger position = 0; position < _ciphertextLength; position += PGPIntegrityChunkSize) {
+        @autoreleasepool {
+            let plaintext = [self decryptPlaintextRange:(NSRange){position, MIN(PGPIntegrityChunkSize, _ciphertextLength - position)}];
+            if (!plaintext) {
+                break;
+            }
+
+            let bytes = (const UInt8 *)plaintext.bytes;
+            if (position < hashedLength) {
+                SHA1_Update(&ctx, bytes, MIN(plaintext.length, hashedLength - position));
+            }
+
+            let mdcStart = _ciphertextLength - PGPMDCPacketLength;
+            if (position + plaintext.length > mdcStart) {
+                let skip = mdcStart > position ? mdcStart - position : 0;
+                [mdcData appendBytes:bytes + skip length:plaintext.length - skip];
+            }
+        }
+    }
+
+    UInt8 hash[SHA_DIGEST_LENGTH];
+    SHA1_Final(hash, &ctx);
+
+    let mdcBytes = (const UInt8 *)mdcData.bytes;
+    if (mdcData.length != PGPMDCPacketLength || mdcBytes[0] != 0xD3 || mdcBytes[1] != 0x14 || CRYPTO_memcmp(hash, mdcBytes + 2, SHA_DIGEST_LENGTH) != 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Validation failed. Content modification detected." }];
+        }
+        return NO;
+    }
+    return YES;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
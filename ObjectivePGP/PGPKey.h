@@ -7,6 +7,7 @@
 //
 
 #import "PGPPartialKey.h"
+#import "PGPKeyProfile.h"
 #import "PGPTypes.h"
 
 #import "PGPExportableProtocol.h"
@@ -34,6 +35,9 @@ PGP_EMPTY_INIT_UNAVAILABLE;
 
 @property (nonatomic, nullable, readonly) PGPSecretKeyPacket *signingSecretKey;
 
+/// Capabilities and preferences of the key. Computed on first use and reset when the key changes.
+@property (nonatomic, readonly) PGPKeyProfile *profile;
+
 
 /// Initialize the key with partial keys
 - (instancetype)initWithSecretKey:(nullable PGPPartialKey *)secretKey publicKey:(nullable PGPPartialKey *)publicKey NS_DESIGNATED_INITIALIZER;
@@ -8,6 +8,7 @@
 
 #import "PGPKey.h"
 #import "PGPKey+Private.h"
+#import "PGPPartialKey+Private.h"
 #import "PGPPartialSubKey.h"
 #import "PGPLogging.h"
 #import "PGPMacros+Private.h"
@@ -61,18 +62,56 @@ NS_ASSUME_NONNULL_BEGIN
     return self.publicKey.keyID ?: self.secretKey.keyID;
 }
 
+- (void)setPublicKey:(nullable PGPPartialKey *)publicKey {
+    @synchronized(self) {
+        _publicKey = [publicKey copy];
+    }
+}
+
+- (void)setSecretKey:(nullable PGPPartialKey *)secretKey {
+    @synchronized(self) {
+        _secretKey = [secretKey copy];
+    }
+}
+
+- (PGPKeyProfile *)profile {
+    // Cached by the partial key
+    return PGPNN(self.publicKey ?: self.secretKey).profile;
+}
+
+- (void)invalidateProfile {
+    [self.publicKey invalidateProfile];
+    [self.secretKey invalidateProfile];
+}
+
 - (nullable PGPSecretKeyPacket *)signingSecretKey {
     if (!self.secretKey) {
         PGPLogDebug(@"Need secret key to sign");
         return nil;
     }
 
-    // find secret key based on the public key signature (unless self signed secret key)
-    let signingPacket = PGPCast(self.secretKey.signingKeyPacket, PGPSecretKeyPacket);
+    // Secret key packet of the signing key packet of the profile. Favor subkey over primary key, not a revoked or expired key.
+    let profile = self.profile;
+    for (PGPPacket *signingKeyPacket in profile.signingKeyPackets) {
+        let keyID = PGPCast(signingKeyPacket, PGPPublicKeyPacket).keyID;
+        for (PGPPacket *keyPacket in self.secretKey.allKeyPackets) {
+            let _Nullable secretKeyPacket = PGPCast(keyPacket, PGPSecretKeyPacket);
+            if (secretKeyPacket && PGPEqualObjects(secretKeyPacket.keyID, keyID)) {
+                return secretKeyPacket;
+            }
+        }
+    }
+
+    if (profile.isRevoked || profile.isExpired) {
+        PGPLogWarning(@"Can't sign with the revoked or expired key %@", self.keyID);
+        return nil;
+    }
+
+    // By convention, the top-level key provides signature services
+    let signingPacket = PGPCast(self.secretKey.primaryKeyPacket, PGPSecretKeyPacket);
     if (!signingPacket) {
         PGPLogWarning(@"Need secret key to sign");
     }
-
     return signingPacket;
 }
 
@@ -147,6 +186,7 @@ NS_ASSUME_NONNULL_BEGIN
         [muPublicUsers addObject:publicUser];
         self.publicKey.users = muPublicUsers.copy;
     }
+    [self invalidateProfile];
 }
 
 -(void)removeUserId:(NSString*)userId{
@@ -179,6 +219,7 @@ NS_ASSUME_NONNULL_BEGIN
             self.publicKey.users = muPublicUsers.copy;
         }
     }
+    [self invalidateProfile];
 }
 
 - (NSArray<PGPSignatureSubpacket *> *)signatureCommonHashedSubpackets {
@@ -21,6 +21,8 @@ NS_SWIFT_NAME(KeyGenerator) @interface PGPKeyGenerator : NSObject
 @property (nonatomic) PGPCurve curveKind;
 @property (nonatomic) UInt8 version;
 @property (nonatomic) NSDate *createDate;
+/// Protect the secret keys with the Argon2 S2K and AEAD (OCB), with the Argon2 parameters calibrated on the current device to unlock in about this time. Default 0, the iterated and salted S2K with CFB.
+@property (nonatomic) NSTimeInterval argon2UnlockDuration;
 
 - (PGPKey *)generateFor:(NSString *)userID passphrase:(nullable NSString *)passphrase;
 
@@ -35,6 +35,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface PGPKeyGenerator ()
 
+// Argon2 parameters calibrated for the unlock duration
+@property (nonatomic, nullable) PGPS2K *calibratedArgon2S2K;
+@property (nonatomic) NSTimeInterval calibratedArgon2UnlockDuration;
+
 @end
 
 @implementation PGPKeyGenerator
@@ -58,6 +62,9 @@ NS_ASSUME_NONNULL_BEGIN
             case PGPPublicKeyAlgorithmECDH:
                 _curveKind = PGPCurve25519;
                 break;
+            case PGPPublicKeyAlgorithmECDSA:
+                _curveKind = PGPCurveP256;
+                break;
             default:
                 // TODO: check other algorithms
                 break;
@@ -66,6 +73,21 @@ NS_ASSUME_NONNULL_BEGIN
     return self;
 }
 
+// Argon2 S2K with the calibrated parameters and a new salt.
+- (PGPS2K *)argon2S2K {
+    if (!self.calibratedArgon2S2K || self.calibratedArgon2UnlockDuration != self.argon2UnlockDuration) {
+        self.calibratedArgon2S2K = [PGPS2K argon2S2KWithTargetDuration:self.argon2UnlockDuration];
+        self.calibratedArgon2UnlockDuration = self.argon2UnlockDuration;
+    }
+
+    let calibratedS2K = PGPNN(self.calibratedArgon2S2K);
+    let s2k = [[PGPS2K alloc] initWithSpecifier:PGPS2KSpecifierArgon2 hashAlgorithm:PGPHashUnknown];
+    s2k.argon2Passes = calibratedS2K.argon2Passes;
+    s2k.argon2Parallelism = calibratedS2K.argon2Parallelism;
+    s2k.argon2EncodedMemory = calibratedS2K.argon2EncodedMemory;
+    return s2k;
+}
+
 - (nullable PGPKeyMaterial *)fillMPIForPublic:(PGPPublicKeyPacket *)publicKeyPacket andSecret:(PGPSecretKeyPacket *)secretKeyPacket withKeyAlgorithm:(PGPPublicKeyAlgorithm)publicKeyAlgorithm bits:(int)bits {
     PGPKeyMaterial *keyMaterial = nil;
 
@@ -82,13 +104,17 @@ NS_ASSUME_NONNULL_BEGIN
             publicKeyPacket.publicMPIs = @[keyMaterial.p, keyMaterial.q, keyMaterial.g, keyMaterial.y];
             secretKeyPacket.secretMPIs = @[keyMaterial.x];
         } break;
-        case PGPPublicKeyAlgorithmElgamal:
-        case PGPPublicKeyAlgorithmECDH: {
+        case PGPPublicKeyAlgorithmElgamal: {
             keyMaterial = [PGPEC generateNewKeyMPIArray:PGPCurve25519];
             publicKeyPacket.publicMPIs = @[keyMaterial.q];
             secretKeyPacket.secretMPIs = @[keyMaterial.d];
         } break;
-        case PGPPublicKeyAlgorithmECDSA:
+        case PGPPublicKeyAlgorithmECDH:
+        case PGPPublicKeyAlgorithmECDSA: {
+            keyMaterial = [PGPEC generateNewKeyMPIArray:publicKeyPacket.curveOID.curveKind];
+            publicKeyPacket.publicMPIs = @[keyMaterial.q];
+            secretKeyPacket.secretMPIs = @[keyMaterial.d];
+        } break;
         case PGPPublicKeyAlgorithmElgamalEncryptorSign:
         case PGPPublicKeyAlgorithmDiffieHellman:
             PGPLogWarning(@"Not implemented");
@@ -143,6 +169,11 @@ NS_ASSUME_NONNULL_BEGIN
         secretKeyPacket.s2kUsage = PGPS2KUsageNonEncrypted;
         secretKeyPacket.s2k = [[PGPS2K alloc] initWithSpecifier:PGPS2KSpecifierSimple hashAlgorithm:self.hashAlgorithm];
         secretKeyPacket.ivData = [NSMutableData dataWithLength:blockSize];
+    } else if (self.argon2UnlockDuration > 0) {
+        NSError *encryptError = nil;
+        if (![secretKeyPacket encryptWithPassphrase:PGPNN(passphrase) s2k:[self argon2S2K] aeadAlgorithm:PGPAEADOCB error:&encryptError]) {
+            PGPLogWarning(@"Can't protect the secret key. %@", encryptError);
+        }
     } else {
         secretKeyPacket.ivData = [PGPCryptoUtils randomData:blockSize];
         secretKeyPacket.s2kUsage = PGPS2KUsageEncryptedAndHashed;
@@ -210,6 +241,11 @@ NS_ASSUME_NONNULL_BEGIN
         secretSubKeyPacket.s2kUsage = PGPS2KUsageNonEncrypted;
         secretSubKeyPacket.s2k = [[PGPS2K alloc] initWithSpecifier:PGPS2KSpecifierSimple hashAlgorithm:self.hashAlgorithm];
         secretSubKeyPacket.ivData = [NSMutableData dataWithLength:blockSize];
+    } else if (self.argon2UnlockDuration > 0) {
+        NSError *encryptError = nil;
+        if (![secretSubKeyPacket encryptWithPassphrase:PGPNN(passphrase) s2k:[self argon2S2K] aeadAlgorithm:PGPAEADOCB error:&encryptError]) {
+            PGPLogWarning(@"Can't protect the secret key. %@", encryptError);
+        }
     } else {
         secretSubKeyPacket.ivData = [PGPCryptoUtils randomData:blockSize];
         secretSubKeyPacket.s2kUsage = PGPS2KUsageEncryptedAndHashed;
@@ -392,9 +428,19 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (PGPKey *)generateFor:(NSString *)userID passphrase:(nullable NSString *)passphrase {
     let key = [self buildKeyWithPassphrase:passphrase];
-    let subKey = (self.keyAlgorithm == PGPPublicKeyAlgorithmEdDSA) ?
-        [self addSubKeyTo:key passphrase:passphrase spec:[[PGPKeySpec alloc] initWithKeyAlgorithm:PGPPublicKeyAlgorithmECDH withCurve:PGPCurve25519 withKdfParameters:[PGPCurveKDFParameters defaultParameters]]] :
-        [self addSubKeyTo:key passphrase:passphrase];
+    PGPKey *subKey = nil;
+    switch (self.keyAlgorithm) {
+        case PGPPublicKeyAlgorithmEdDSA:
+            subKey = [self addSubKeyTo:key passphrase:passphrase spec:[[PGPKeySpec alloc] initWithKeyAlgorithm:PGPPublicKeyAlgorithmECDH withCurve:PGPCurve25519 withKdfParameters:[PGPCurveKDFParameters defaultParameters]]];
+            break;
+        case PGPPublicKeyAlgorithmECDSA:
+            // ECDH subkey on the same curve
+            subKey = [self addSubKeyTo:key passphrase:passphrase spec:[[PGPKeySpec alloc] initWithKeyAlgorithm:PGPPublicKeyAlgorithmECDH withCurve:self.curveKind withKdfParameters:[PGPCurveKDFParameters defaultParametersForCurve:self.curveKind]]];
+            break;
+        default:
+            subKey = [self addSubKeyTo:key passphrase:passphrase];
+            break;
+    }
 
     let userPublic = [[PGPUser alloc] initWithUserIDPacket:[[PGPUserIDPacket alloc] initWithUserID:userID]];
     let userSecret = [[PGPUser alloc] initWithUserIDPacket:[[PGPUserIDPacket alloc] initWithUserID:userID]];
@@ -416,7 +462,10 @@ NS_ASSUME_NONNULL_BEGIN
 
     let secretSubKeySignaturePacket = [self buildSecretSignaturePacketForSubKey:subKey parentKey:key];
     key.secretKey.subKeys.firstObject.bindingSignature = secretSubKeySignaturePacket;
-    
+
+    // The profile computed to sign lacks the signatures added since.
+    [key.publicKey invalidateProfile];
+    [key.secretKey invalidateProfile];
     return key;
 }
 
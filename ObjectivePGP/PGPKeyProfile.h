@@ -0,0 +1,63 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMacros.h>
+#import <ObjectivePGP/PGPTypes.h>
+#import <ObjectivePGP/PGPKeyID.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class PGPPartialKey, PGPPacket;
+
+/// Capabilities and preferences of a key, computed once from its packets. The key packets are checked for expiration when accessed.
+NS_SWIFT_NAME(KeyProfile) @interface PGPKeyProfile : NSObject
+
+@property (nonatomic, readonly) PGPKeyID *keyID;
+
+/// Key packet to encrypt to. `nil` for a secret key, or if no key packet can be used to encrypt.
+@property (nonatomic, nullable, readonly) PGPPacket *encryptionKeyPacket;
+/// Subkeys, and the primary key, that the key flags allow to encrypt, and that are neither revoked nor expired. Only a subkey with a valid binding signature.
+@property (nonatomic, copy, readonly) NSArray<PGPPacket *> *encryptionKeyPackets;
+/// Subkeys, and the primary key, that the key flags allow to sign, and that are neither revoked nor expired. Only a subkey with a valid binding signature and a valid primary key binding signature.
+@property (nonatomic, copy, readonly) NSArray<PGPPacket *> *signingKeyPackets;
+
+@property (nonatomic, nullable, readonly) NSDate *expirationDate;
+@property (nonatomic, readonly, getter=isExpired) BOOL expired;
+@property (nonatomic, readonly, getter=isRevoked) BOOL revoked;
+
+/// Preferences of the primary user self-certificate.
+@property (nonatomic, copy, readonly) NSArray<NSNumber *> *preferredSymmetricAlgorithms;
+@property (nonatomic, copy, readonly) NSArray<NSNumber *> *preferredHashAlgorithms;
+@property (nonatomic, copy, readonly) NSArray<NSNumber *> *preferredCompressionAlgorithms;
+@property (nonatomic, copy, readonly) NSArray<NSNumber *> *features;
+/// First preferred hash algorithm of SHA-256 or stronger. SHA-512 if the key prefers none of them.
+@property (nonatomic, readonly) PGPHashAlgorithm preferredHashAlgorithm;
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+- (instancetype)initWithPartialKey:(PGPPartialKey *)partialKey NS_DESIGNATED_INITIALIZER;
+
+/// Key packet of the signing key packets with the key ID, expired or not. Signatures made before the key expired stay valid.
+- (nullable PGPPacket *)signingKeyPacketWithKeyID:(PGPKeyID *)keyID;
+
+/// YES if the Features subpacket advertise the feature.
+- (BOOL)supportsFeature:(PGPFeature)feature;
+
+/// Preferred symmetric algorithm common to the keys. TripleDES if the keys have no preferences in common.
++ (PGPSymmetricAlgorithm)preferredSymmetricAlgorithmForProfiles:(NSArray<PGPKeyProfile *> *)profiles;
+
+/// Preferred compression algorithm common to the keys. ZLIB if the keys have no supported preferences in common.
++ (PGPCompressionAlgorithm)preferredCompressionAlgorithmForProfiles:(NSArray<PGPKeyProfile *> *)profiles;
+
+/// YES if every key advertise the feature.
++ (BOOL)isFeature:(PGPFeature)feature supportedByProfiles:(NSArray<PGPKeyProfile *> *)profiles;
+
+@end
+
+NS_ASSUME_NONNULL_END
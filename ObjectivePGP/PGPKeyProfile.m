@@ -0,0 +1,242 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPKeyProfile.h"
+#import "PGPPartialKey.h"
+#import "PGPPartialKey+Private.h"
+#import "PGPPartialSubKey.h"
+#import "PGPPartialSubKey+Private.h"
+#import "PGPPublicKeyPacket.h"
+#import "PGPSignaturePacket.h"
+#import "PGPSignaturePacket+Private.h"
+#import "PGPMacros+Private.h"
+#import "PGPFoundation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Key packet, usable until the expiration date.
+@interface PGPKeyProfilePacket : NSObject
+
+@property (nonatomic, readonly) PGPPacket *packet;
+@property (nonatomic, nullable, readonly) NSDate *expirationDate;
+
+- (instancetype)initWithPacket:(PGPPacket *)packet expirationDate:(nullable NSDate *)expirationDate;
+
+@end
+
+@implementation PGPKeyProfilePacket
+
+- (instancetype)initWithPacket:(PGPPacket *)packet expirationDate:(nullable NSDate *)expirationDate {
+    if ((self = [super init])) {
+        _packet = packet;
+        _expirationDate = expirationDate;
+    }
+    return self;
+}
+
+@end
+
+static NSDate * _Nullable PGPEarlierDate(NSDate * _Nullable date, NSDate * _Nullable otherDate) {
+    if (!date || !otherDate) {
+        return date ?: otherDate;
+    }
+    return [PGPNN(date) earlierDate:PGPNN(otherDate)];
+}
+
+@implementation PGPKeyProfile {
+    BOOL _public;
+    NSArray<PGPKeyProfilePacket *> *_encryptionProfilePackets;
+    NSArray<PGPKeyProfilePacket *> *_signingProfilePackets;
+}
+
+- (instancetype)initWithPartialKey:(PGPPartialKey *)partialKey {
+    PGPAssertClass(partialKey, PGPPartialKey);
+
+    if ((self = [super init])) {
+        _keyID = partialKey.keyID;
+        _public = partialKey.type == PGPKeyTypePublic;
+        _expirationDate = partialKey.expirationDate;
+        _revoked = partialKey.revocationSignature && partialKey.revocationSignature.validity != PGPSignatureValidityInvalid;
+
+        let encryptionProfilePackets = [NSMutableArray<PGPKeyProfilePacket *> array];
+        let signingProfilePackets = [NSMutableArray<PGPKeyProfilePacket *> array];
+        let _Nullable primaryUserSelfCertificate = partialKey.primaryUserSelfCertificate;
+        if (!_revoked) {
+            for (PGPPartialSubKey *subKey in partialKey.subKeys) {
+                let _Nullable bindingSignature = subKey.bindingSignature;
+                let isRevoked = subKey.revocationSignature && subKey.revocationSignature.validity != PGPSignatureValidityInvalid;
+                if (!bindingSignature || isRevoked || ![partialKey isSubKeyBound:subKey]) {
+                    continue;
+                }
+
+                // The subkey expires with the primary key, the binding signature, or its own key expiration time.
+                let expirationDate = PGPEarlierDate(PGPEarlierDate(_expirationDate, bindingSignature.expirationDate), [self.class keyExpirationDateOfSubKey:subKey]);
+                let profilePacket = [[PGPKeyProfilePacket alloc] initWithPacket:subKey.primaryKeyPacket expirationDate:expirationDate];
+                if (bindingSignature.canBeUsedToEncrypt) {
+                    [encryptionProfilePackets addObject:profilePacket];
+                }
+                if ([partialKey canSubKeySign:subKey]) {
+                    [signingProfilePackets addObject:profilePacket];
+                }
+            }
+
+            let profilePacket = [[PGPKeyProfilePacket alloc] initWithPacket:partialKey.primaryKeyPacket expirationDate:PGPEarlierDate(_expirationDate, primaryUserSelfCertificate.expirationDate)];
+            if (primaryUserSelfCertificate.canBeUsedToEncrypt) {
+                [encryptionProfilePackets addObject:profilePacket];
+            }
+            if (primaryUserSelfCertificate.canBeUsedToSign) {
+                [signingProfilePackets addObject:profilePacket];
+            }
+        }
+        _encryptionProfilePackets = encryptionProfilePackets;
+        _signingProfilePackets = signingProfilePackets;
+
+        _preferredSymmetricAlgorithms = partialKey.primaryUser ? primaryUserSelfCertificate.preferredSymmetricAlgorithms ?: @[] : @[];
+        _preferredHashAlgorithms = PGPCast([primaryUserSelfCertificate subpacketsOfType:PGPSignatureSubpacketTypePreferredHashAlgorithm].firstObject.value, NSArray) ?: @[];
+        _preferredCompressionAlgorithms = PGPCast([primaryUserSelfCertificate subpacketsOfType:PGPSignatureSubpacketTypePreferredCompressionAlgorithm].firstObject.value, NSArray) ?: @[];
+        _features = PGPCast([primaryUserSelfCertificate subpacketsOfType:PGPSignatureSubpacketTypeFeatures].firstObject.value, NSArray) ?: @[];
+    }
+    return self;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"%@, keyID: %@, encryptionKeys: %@, signingKeys: %@, revoked: %@, expirationDate: %@", super.description, self.keyID, @(self.encryptionKeyPackets.count), @(self.signingKeyPackets.count), @(self.isRevoked), self.expirationDate];
+}
+
+- (nullable PGPPacket *)encryptionKeyPacket {
+    return _public ? self.encryptionKeyPackets.firstObject : nil;
+}
+
+- (NSArray<PGPPacket *> *)encryptionKeyPackets {
+    return [self.class packetsOfProfilePackets:_encryptionProfilePackets validAtDate:NSDate.date];
+}
+
+- (NSArray<PGPPacket *> *)signingKeyPackets {
+    return [self.class packetsOfProfilePackets:_signingProfilePackets validAtDate:NSDate.date];
+}
+
+- (nullable PGPPacket *)signingKeyPacketWithKeyID:(PGPKeyID *)keyID {
+    for (PGPKeyProfilePacket *profilePacket in _signingProfilePackets) {
+        if (PGPEqualObjects(PGPCast(profilePacket.packet, PGPPublicKeyPacket).keyID, keyID)) {
+            return profilePacket.packet;
+        }
+    }
+    return nil;
+}
+
+- (BOOL)isExpired {
+    let _Nullable expirationDate = self.expirationDate;
+    return expirationDate && [PGPNN(expirationDate) compare:NSDate.date] == NSOrderedAscending;
+}
+
++ (NSArray<PGPPacket *> *)packetsOfProfilePackets:(NSArray<PGPKeyProfilePacket *> *)profilePackets validAtDate:(NSDate *)date {
+    let packets = [NSMutableArray<PGPPacket *> arrayWithCapacity:profilePackets.count];
+    for (PGPKeyProfilePacket *profilePacket in profilePackets) {
+        let _Nullable expirationDate = profilePacket.expirationDate;
+        if (!expirationDate || [PGPNN(expirationDate) compare:date] == NSOrderedDescending) {
+            [packets addObject:profilePacket.packet];
+        }
+    }
+    return packets;
+}
+
+// Key expiration of the binding signature.
++ (nullable NSDate *)keyExpirationDateOfSubKey:(PGPPartialSubKey *)subKey {
+    let keyExpirationTimeInterval = subKey.bindingSignature.keyExpirationTimeInterval;
+    let _Nullable createDate = PGPCast(subKey.primaryKeyPacket, PGPPublicKeyPacket).createDate;
+    if (keyExpirationTimeInterval == NSNotFound || !createDate) {
+        return nil;
+    }
+    return [PGPNN(createDate) dateByAddingTimeInterval:keyExpirationTimeInterval];
+}
+
+- (PGPHashAlgorithm)preferredHashAlgorithm {
+    for (NSNumber *hashAlgorithm in self.preferredHashAlgorithms) {
+        switch ((PGPHashAlgorithm)hashAlgorithm.unsignedIntValue) {
+            case PGPHashSHA256:
+            case PGPHashSHA384:
+            case PGPHashSHA512:
+                return (PGPHashAlgorithm)hashAlgorithm.unsignedIntValue;
+            default:
+                break;
+        }
+    }
+    return PGPHashSHA512;
+}
+
+- (BOOL)supportsFeature:(PGPFeature)feature {
+    for (NSNumber *featureByte in self.features) {
+        if ((featureByte.unsignedIntValue & feature) == feature) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
++ (PGPSymmetricAlgorithm)preferredSymmetricAlgorithmForProfiles:(NSArray<PGPKeyProfile *> *)profiles {
+    // 13.2.  Symmetric Algorithm Preferences
+    // Since TripleDES is the MUST-implement algorithm, if it is not explicitly in the list, it is tacitly at the end.
+    NSMutableOrderedSet<NSNumber *> * _Nullable set = nil;
+    for (PGPKeyProfile *profile in profiles) {
+        if (profile.preferredSymmetricAlgorithms.count == 0) {
+            continue;
+        }
+
+        if (!set) {
+            set = [NSMutableOrderedSet<NSNumber *> orderedSetWithArray:profile.preferredSymmetricAlgorithms];
+        } else {
+            [set intersectSet:[NSSet setWithArray:profile.preferredSymmetricAlgorithms]];
+        }
+    }
+
+    if (set.count > 0) {
+        return (PGPSymmetricAlgorithm)[set[0] unsignedIntValue];
+    }
+    return PGPSymmetricTripleDES;
+}
+
++ (PGPCompressionAlgorithm)preferredCompressionAlgorithmForProfiles:(NSArray<PGPKeyProfile *> *)profiles {
+    // 13.3.  Other Algorithm Preferences
+    // The compression algorithm common to the keys, of the algorithms that compress.
+    let supportedAlgorithms = [NSSet setWithArray:@[@(PGPCompressionZIP), @(PGPCompressionZLIB), @(PGPCompressionBZIP2)]];
+    NSMutableOrderedSet<NSNumber *> * _Nullable set = nil;
+    for (PGPKeyProfile *profile in profiles) {
+        if (profile.preferredCompressionAlgorithms.count == 0) {
+            continue;
+        }
+
+        if (!set) {
+            set = [NSMutableOrderedSet<NSNumber *> orderedSetWithArray:profile.preferredCompressionAlgorithms];
+            [set intersectSet:supportedAlgorithms];
+        } else {
+            [set intersectSet:[NSSet setWithArray:profile.preferredCompressionAlgorithms]];
+        }
+    }
+
+    if (set.count > 0) {
+        return (PGPCompressionAlgorithm)[set[0] unsignedIntValue];
+    }
+    return PGPCompressionZLIB;
+}
+
++ (BOOL)isFeature:(PGPFeature)feature supportedByProfiles:(NSArray<PGPKeyProfile *> *)profiles {
+    if (profiles.count == 0) {
+        return NO;
+    }
+
+    for (PGPKeyProfile *profile in profiles) {
+        if (![profile supportsFeature:feature]) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
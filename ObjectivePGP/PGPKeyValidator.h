@@ -0,0 +1,64 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMacros.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class PGPPartialKey, PGPUser, PGPSignaturePacket, PGPPublicKeyPacket;
+
+/// A signature, the data it is made over, and the key to verify it with.
+@interface PGPSignatureCheck : NSObject
+
+@property (nonatomic, readonly) PGPSignaturePacket *signature;
+@property (nonatomic, copy, readonly) NSData *toSignData;
+@property (nonatomic, readonly) PGPPublicKeyPacket *signingKeyPacket;
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+- (instancetype)initWithSignature:(PGPSignaturePacket *)signature toSignData:(NSData *)toSignData signingKeyPacket:(PGPPublicKeyPacket *)signingKeyPacket NS_DESIGNATED_INITIALIZER;
+
+@end
+
+/**
+ Verifies the self-signatures of keys: user self-certifications, subkey bindings with
+ the embedded primary key binding (back-signature) of signing subkeys, direct key signatures and revocations.
+
+ The signatures are verified concurrently. The result is stored on each signature packet
+ (`PGPSignaturePacket.validity`), so a signature is verified once, and the signatures
+ found invalid are not used to select the keys to encrypt and sign with.
+
+ Signatures issued by other keys, signatures over user attributes, and signatures of
+ unsupported versions or algorithms are left unverified.
+ */
+@interface PGPKeyValidator : NSObject
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+/// Verify the signatures of the keys. The users not parsed yet are verified when parsed.
++ (void)validatePartialKeys:(NSArray<PGPPartialKey *> *)partialKeys;
+
+/// Verify the self-certifications and certification revocations of the users of the key.
++ (void)validateUsers:(NSArray<PGPUser *> *)users ofPartialKey:(PGPPartialKey *)partialKey;
+
+/// Check of a certification, or a certification revocation, of the user of the key by the other key. `nil` if the signature is verified already, or can't be verified.
++ (nullable PGPSignatureCheck *)checkForCertification:(PGPSignaturePacket *)certification user:(PGPUser *)user partialKey:(PGPPartialKey *)partialKey signingKeyPacket:(PGPPublicKeyPacket *)signingKeyPacket;
+
+/// Data a certification of the user of the key is made over: the primary key and the user ID. `nil` for a user attribute.
++ (nullable NSData *)toSignDataForUser:(PGPUser *)user ofPartialKey:(PGPPartialKey *)partialKey;
+
+/// Embedded primary key binding signature (0x19) of the subkey binding signature.
++ (nullable PGPSignaturePacket *)backSignatureOfBindingSignature:(PGPSignaturePacket *)bindingSignature;
+
+/// Verify the signatures of the checks concurrently, and store the results on the signatures.
++ (void)runChecks:(NSArray<PGPSignatureCheck *> *)checks;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,269 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPKeyValidator.h"
+#import "PGPPartialKey.h"
+#import "PGPPartialKey+Private.h"
+#import "PGPPartialSubKey.h"
+#import "PGPPartialSubKey+Private.h"
+#import "PGPPublicKeyPacket.h"
+#import "PGPSignaturePacket.h"
+#import "PGPSignaturePacket+Private.h"
+#import "PGPSignatureSubpacket.h"
+#import "PGPSignatureSubpacketEmbeddedSignature.h"
+#import "PGPUser.h"
+#import "PGPUser+Private.h"
+#import "PGPVerificationCache.h"
+#import "PGPFingerprint.h"
+#import "PGPLogging.h"
+#import "PGPMacros+Private.h"
+#import "PGPFoundation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation PGPSignatureCheck
+
+- (instancetype)initWithSignature:(PGPSignaturePacket *)signature toSignData:(NSData *)toSignData signingKeyPacket:(PGPPublicKeyPacket *)signingKeyPacket {
+    if ((self = [super init])) {
+        _signature = signature;
+        _toSignData = [toSignData copy];
+        _signingKeyPacket = signingKeyPacket;
+    }
+    return self;
+}
+
+@end
+
+@implementation PGPKeyValidator
+
++ (void)validatePartialKeys:(NSArray<PGPPartialKey *> *)partialKeys {
+    let checks = [NSMutableArray<PGPSignatureCheck *> array];
+    for (PGPPartialKey *partialKey in partialKeys) {
+        let _Nullable primaryKeyPacket = PGPCast(partialKey.primaryKeyPacket, PGPPublicKeyPacket);
+        if (!primaryKeyPacket) {
+            continue;
+        }
+        let primaryKeyData = [primaryKeyPacket exportKeyPacketOldStyle];
+
+        // 0x1F, 0x20: over the primary key
+        for (PGPSignaturePacket *signature in partialKey.directSignatures) {
+            if (signature.type == PGPSignatureDirectlyOnKey) {
+                [checks pgp_addObject:[self checkForSignature:signature toSignData:primaryKeyData signingKeyPacket:primaryKeyPacket]];
+            }
+        }
+        if (partialKey.revocationSignature) {
+            [checks pgp_addObject:[self checkForSignature:PGPNN(partialKey.revocationSignature) toSignData:primaryKeyData signingKeyPacket:primaryKeyPacket]];
+        }
+
+        // 0x18, 0x28: over the primary key and the subkey. 0x19: the same data, made by the subkey.
+        for (PGPPartialSubKey *subKey in partialKey.subKeys) {
+            let _Nullable subKeyPacket = PGPCast(subKey.primaryKeyPacket, PGPPublicKeyPacket);
+            if (!subKeyPacket) {
+                continue;
+            }
+            let subKeyToSignData = [NSMutableData dataWithData:primaryKeyData];
+            [subKeyToSignData appendData:[subKeyPacket exportKeyPacketOldStyle]];
+
+            if (subKey.bindingSignature) {
+                let bindingSignature = PGPNN(subKey.bindingSignature);
+                [checks pgp_addObject:[self checkForSignature:bindingSignature toSignData:subKeyToSignData signingKeyPacket:primaryKeyPacket]];
+                if (bindingSignature.canBeUsedToSign) {
+                    let _Nullable backSignature = [self backSignatureOfBindingSignature:bindingSignature];
+                    if (backSignature) {
+                        [checks pgp_addObject:[self checkForSignature:PGPNN(backSignature) toSignData:subKeyToSignData signingKeyPacket:subKeyPacket]];
+                    }
+                }
+            }
+            if (subKey.revocationSignature) {
+                [checks pgp_addObject:[self checkForSignature:PGPNN(subKey.revocationSignature) toSignData:subKeyToSignData signingKeyPacket:primaryKeyPacket]];
+            }
+        }
+
+        // Don't parse the users here, these are verified when parsed.
+        if (!partialKey.hasUnparsedUsers) {
+            [checks addObjectsFromArray:[self checksForUsers:partialKey.users primaryKeyPacket:primaryKeyPacket]];
+        }
+    }
+
+    [self runChecks:checks];
+
+    // Self-signatures that can't be verified (made by another key, of version 3, of an unsupported algorithm) are invalid.
+    for (PGPPartialKey *partialKey in partialKeys) {
+        if (!PGPCast(partialKey.primaryKeyPacket, PGPPublicKeyPacket)) {
+            continue;
+        }
+        for (PGPSignaturePacket *signature in partialKey.directSignatures) {
+            if (signature.type == PGPSignatureDirectlyOnKey) {
+                [self invalidateUnverifiedSignature:signature];
+            }
+        }
+        for (PGPPartialSubKey *subKey in partialKey.subKeys) {
+            let _Nullable bindingSignature = subKey.bindingSignature;
+            if (!bindingSignature) {
+                continue;
+            }
+            [self invalidateUnverifiedSignature:PGPNN(bindingSignature)];
+            let _Nullable backSignature = [self backSignatureOfBindingSignature:PGPNN(bindingSignature)];
+            if (backSignature) {
+                [self invalidateUnverifiedSignature:PGPNN(backSignature)];
+            }
+        }
+    }
+
+    // A signing subkey is bound by both signatures. Without a back-signature the subkey is not used to sign, see -[PGPPartialKey canSubKeySign:].
+    for (PGPPartialKey *partialKey in partialKeys) {
+        for (PGPPartialSubKey *subKey in partialKey.subKeys) {
+            let _Nullable bindingSignature = subKey.bindingSignature;
+            if (!bindingSignature.canBeUsedToSign) {
+                continue;
+            }
+            let _Nullable backSignature = [self backSignatureOfBindingSignature:PGPNN(bindingSignature)];
+            if (backSignature.validity == PGPSignatureValidityInvalid) {
+                PGPLogWarning(@"Invalid primary key binding signature of the subkey %@", subKey.keyID);
+                bindingSignature.validity = PGPSignatureValidityInvalid;
+            }
+        }
+    }
+
+    // Signatures by the revoked keys are verified again.
+    let verificationCache = PGPVerificationCache.sharedCache;
+    for (PGPPartialKey *partialKey in partialKeys) {
+        if (partialKey.revocationSignature.validity == PGPSignatureValidityValid) {
+            [verificationCache removeKeysOfSigningKeyFingerprint:partialKey.fingerprint.hashedData];
+            for (PGPPartialSubKey *subKey in partialKey.subKeys) {
+                [verificationCache removeKeysOfSigningKeyFingerprint:subKey.fingerprint.hashedData];
+            }
+            continue;
+        }
+        for (PGPPartialSubKey *subKey in partialKey.subKeys) {
+            if (subKey.revocationSignature.validity == PGPSignatureValidityValid) {
+                [verificationCache removeKeysOfSigningKeyFingerprint:subKey.fingerprint.hashedData];
+            }
+        }
+    }
+}
+
++ (void)validateUsers:(NSArray<PGPUser *> *)users ofPartialKey:(PGPPartialKey *)partialKey {
+    let _Nullable primaryKeyPacket = PGPCast(partialKey.primaryKeyPacket, PGPPublicKeyPacket);
+    if (!primaryKeyPacket) {
+        return;
+    }
+    [self runChecks:[self checksForUsers:users primaryKeyPacket:PGPNN(primaryKeyPacket)]];
+}
+
++ (nullable PGPSignatureCheck *)checkForCertification:(PGPSignaturePacket *)certification user:(PGPUser *)user partialKey:(PGPPartialKey *)partialKey signingKeyPacket:(PGPPublicKeyPacket *)signingKeyPacket {
+    let _Nullable toSignData = [self toSignDataForUser:user ofPartialKey:partialKey];
+    if (!toSignData) {
+        return nil;
+    }
+    return [self checkForSignature:certification toSignData:PGPNN(toSignData) signingKeyPacket:signingKeyPacket];
+}
+
++ (nullable NSData *)toSignDataForUser:(PGPUser *)user ofPartialKey:(PGPPartialKey *)partialKey {
+    let _Nullable primaryKeyPacket = PGPCast(partialKey.primaryKeyPacket, PGPPublicKeyPacket);
+    if (!primaryKeyPacket) {
+        return nil;
+    }
+    return [self toSignDataForUser:user primaryKeyData:[PGPNN(primaryKeyPacket) exportKeyPacketOldStyle]];
+}
+
++ (void)runChecks:(NSArray<PGPSignatureCheck *> *)checks {
+    if (checks.count == 0) {
+        return;
+    }
+
+    dispatch_apply(checks.count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        @autoreleasepool {
+            let check = checks[i];
+            let isValid = [check.signature verifyToSignData:check.toSignData signingKeyPacket:check.signingKeyPacket error:nil];
+            check.signature.validity = isValid ? PGPSignatureValidityValid : PGPSignatureValidityInvalid;
+        }
+    });
+}
+
++ (nullable PGPSignaturePacket *)backSignatureOfBindingSignature:(PGPSignaturePacket *)bindingSignature {
+    for (PGPSignatureSubpacket *subpacket in [bindingSignature subpacketsOfType:PGPSignatureSubpacketTypeEmbeddedSignature]) {
+        let _Nullable backSignature = PGPCast(subpacket.value, PGPSignatureSubpacketEmbeddedSignature).signaturePacket;
+        if (backSignature.type == PGPSignaturePrimaryKeyBinding) {
+            return backSignature;
+        }
+    }
+    return nil;
+}
+
+#pragma mark - Private
+
++ (void)invalidateUnverifiedSignature:(PGPSignaturePacket *)signature {
+    if (signature.validity == PGPSignatureValidityUnknown) {
+        PGPLogWarning(@"Unverifiable self-signature of type %@", @(signature.type));
+        signature.validity = PGPSignatureValidityInvalid;
+    }
+}
+
+// 0x10 - 0x13, 0x30: over the primary key and the user ID
++ (NSArray<PGPSignatureCheck *> *)checksForUsers:(NSArray<PGPUser *> *)users primaryKeyPacket:(PGPPublicKeyPacket *)primaryKeyPacket {
+    let checks = [NSMutableArray<PGPSignatureCheck *> array];
+    let primaryKeyData = [primaryKeyPacket exportKeyPacketOldStyle];
+    for (PGPUser *user in users) {
+        let _Nullable toSignData = [self toSignDataForUser:user primaryKeyData:primaryKeyData];
+        if (!toSignData) {
+            continue;
+        }
+
+        for (PGPSignaturePacket *signature in user.selfCertifications) {
+            [checks pgp_addObject:[self checkForSignature:signature toSignData:PGPNN(toSignData) signingKeyPacket:primaryKeyPacket]];
+        }
+        for (PGPSignaturePacket *signature in user.revocationSignatures) {
+            [checks pgp_addObject:[self checkForSignature:signature toSignData:PGPNN(toSignData) signingKeyPacket:primaryKeyPacket]];
+        }
+    }
+    return checks;
+}
+
++ (nullable NSData *)toSignDataForUser:(PGPUser *)user primaryKeyData:(NSData *)primaryKeyData {
+    // Signatures over a user attribute are kept with the signatures of the user ID, and not verified.
+    let _Nullable userIDData = [user.userID dataUsingEncoding:NSUTF8StringEncoding];
+    if (user.userAttribute || !userIDData) {
+        return nil;
+    }
+
+    let toSignData = [NSMutableData dataWithData:primaryKeyData];
+    UInt8 userIDConstant = 0xB4;
+    [toSignData appendBytes:&userIDConstant length:1];
+    UInt32 userIDLength = CFSwapInt32HostToBig((UInt32)userIDData.length);
+    [toSignData appendBytes:&userIDLength length:4];
+    [toSignData appendData:PGPNN(userIDData)];
+    return toSignData;
+}
+
+// Check of the signature made by the key, if it wasn't verified yet and can be verified.
++ (nullable PGPSignatureCheck *)checkForSignature:(PGPSignaturePacket *)signature toSignData:(NSData *)toSignData signingKeyPacket:(PGPPublicKeyPacket *)signingKeyPacket {
+    if (signature.validity != PGPSignatureValidityUnknown || signature.version != 0x04) {
+        return nil;
+    }
+
+    let _Nullable issuerKeyID = signature.issuerKeyID;
+    if (issuerKeyID && !PGPEqualObjects(issuerKeyID, signingKeyPacket.keyID)) {
+        return nil;
+    }
+
+    switch (signingKeyPacket.publicKeyAlgorithm) {
+        case PGPPublicKeyAlgorithmRSA:
+        case PGPPublicKeyAlgorithmRSASignOnly:
+        case PGPPublicKeyAlgorithmDSA:
+        case PGPPublicKeyAlgorithmECDSA:
+        case PGPPublicKeyAlgorithmEdDSA:
+            return [[PGPSignatureCheck alloc] initWithSignature:signature toSignData:toSignData signingKeyPacket:signingKeyPacket];
+        default:
+            return nil;
+    }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -17,6 +17,8 @@ NS_ASSUME_NONNULL_BEGIN
 // Private
 + (nullable PGPKey *)findKeyWithKeyID:(PGPKeyID *)searchKeyID type:(PGPKeyType)type in:(NSArray<PGPKey *> *)keys;
 + (NSArray<PGPKey *> *)addOrUpdatePartialKey:(nullable PGPPartialKey *)key inContainer:(NSArray<PGPKey *> *)keys;
++ (NSArray<PGPKey *> *)keysByMergingPartialKeys:(NSArray<PGPPartialKey *> *)partialKeys;
++ (NSArray<PGPKey *> *)keysByMergingPartialKeys:(NSArray<PGPPartialKey *> *)partialKeys intoKeys:(NSArray<PGPKey *> *)keys;
 
 @end
 
@@ -33,6 +33,16 @@ NS_SWIFT_NAME(Keyring) @interface PGPKeyring : NSObject <PGPExportable>
  */
 - (BOOL)importKey:(NSString *)identifier fromPath:(NSString *)path error:(NSError * __autoreleasing _Nullable *)error NS_SWIFT_NAME(import(keyIdentifier:fromPath:));
 
+/**
+ Import keys of the keyring file. The following imports of the same file read only the bytes
+ appended since the previous import, unless the previously read bytes changed and the whole file is read again.
+ The armored file is read again as a whole whenever it changed.
+
+ @param path Path to the file with the keys.
+ @return YES on success. NO if the file can't be read, or no key can be read from the new bytes.
+ */
+- (BOOL)importKeysFromPath:(NSString *)path error:(NSError * __autoreleasing _Nullable *)error NS_SWIFT_NAME(import(keysFromPath:));
+
 /**
  Delete keys
 
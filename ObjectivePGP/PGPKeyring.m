@@ -6,25 +6,54 @@
 //
 
 #import "PGPKeyring.h"
+#import "PGPKeyring+Private.h"
 
 #import "PGPUser.h"
 #import "PGPKey.h"
 #import "PGPKey+Private.h"
 #import "PGPPartialKey.h"
 #import "PGPPartialSubKey.h"
+#import "PGPFingerprint.h"
 #import "PGPArmor.h"
 
 #import "PGPFoundation.h"
 #import "PGPLogging.h"
 #import "NSMutableData+PGPUtils.h"
+#import "NSData+PGPUtils.h"
 #import "NSArray+PGPUtils.h"
 #import "PGPMacros+Private.h"
+#import "ObjectivePGPObject+Private.h"
 
 #import <ObjectivePGP/ObjectivePGPObject.h>
+#import <CommonCrypto/CommonDigest.h>
+
+// Read part of the imported keyring file.
+@interface PGPKeyringFile : NSObject
+
+// Length and SHA-256 hash of the bytes read so far.
+@property (nonatomic) NSUInteger offset;
+@property (nonatomic, copy) NSData *digest;
+// Fingerprints of the keys read from the file.
+@property (nonatomic, readonly) NSMutableSet<NSData *> *fingerprints;
+
+@end
+
+@implementation PGPKeyringFile
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        _digest = [NSData data];
+        _fingerprints = [NSMutableSet<NSData *> set];
+    }
+    return self;
+}
+
+@end
 
 @interface PGPKeyring ()
 
 @property (strong, nonatomic, readwrite) NSArray<PGPKey *> *keys;
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, PGPKeyringFile *> *files;
 
 @end
 
@@ -33,6 +62,7 @@
 - (instancetype)init {
     if ((self = [super init])) {
         _keys = [NSMutableArray<PGPKey *> array];
+        _files = [NSMutableDictionary<NSString *, PGPKeyringFile *> dictionary];
     }
     return self;
 }
@@ -40,10 +70,12 @@
 - (void)importKeys:(NSArray<PGPKey *> *)keys {
     PGPAssertClass(keys, NSArray);
 
+    let partialKeys = [NSMutableArray<PGPPartialKey *> arrayWithCapacity:keys.count * 2];
     for (PGPKey *key in keys) {
-        self.keys = [self.class addOrUpdatePartialKey:key.secretKey inContainer:self.keys];
-        self.keys = [self.class addOrUpdatePartialKey:key.publicKey inContainer:self.keys];
+        [partialKeys pgp_addObject:key.secretKey];
+        [partialKeys pgp_addObject:key.publicKey];
     }
+    self.keys = [self.class keysByMergingPartialKeys:partialKeys intoKeys:self.keys];
 }
 
 - (BOOL)importKey:(NSString *)keyIdentifier fromPath:(NSString *)path error:(NSError * __autoreleasing _Nullable *)error {
@@ -72,6 +104,112 @@
     return YES;
 }
 
+- (BOOL)importKeysFromPath:(NSString *)path error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(path, NSString);
+
+    let fullPath = [path stringByExpandingTildeInPath];
+    let fileData = [NSData dataWithContentsOfFile:fullPath options:NSDataReadingMappedIfSafe error:error];
+    if (!fileData) {
+        return NO;
+    }
+
+    // The armored file can't be read in parts, and is read again whenever it changed.
+    let isArmored = [PGPArmor isArmoredData:fileData];
+
+    // Hash of the previously read bytes, continued with the bytes read now.
+    CC_SHA256_CTX digestContext;
+    CC_SHA256_Init(&digestContext);
+
+    var file = self.files[fullPath];
+    if (file) {
+        BOOL changed = file.offset > fileData.length;
+        if (!changed) {
+            CC_SHA256_Update(&digestContext, fileData.bytes, (CC_LONG)file.offset);
+            var readDataContext = digestContext;
+            UInt8 readDigest[CC_SHA256_DIGEST_LENGTH];
+            CC_SHA256_Final(readDigest, &readDataContext);
+            changed = !PGPEqualObjects([NSData dataWithBytes:readDigest length:CC_SHA256_DIGEST_LENGTH], file.digest);
+        }
+
+        if (!changed && isArmored && file.offset == fileData.length) {
+            return YES;
+        }
+
+        if (changed || isArmored) {
+            // The file was rewritten. Replace the keys read from it, but not the keys read from the other files too.
+            PGPLogDebug(@"Keyring file changed, reading again: %@", fullPath);
+            let removedFingerprints = [NSMutableSet<NSData *> setWithSet:file.fingerprints];
+            for (NSString *filePath in self.files) {
+                if (!PGPEqualObjects(filePath, fullPath)) {
+                    [removedFingerprints minusSet:self.files[filePath].fingerprints];
+                }
+            }
+            self.keys = [self.keys pgp_objectsPassingTest:^BOOL(PGPKey *key, BOOL *stop) {
+                return ![removedFingerprints containsObject:[PGPKeyring fingerprintDataOfKey:key]];
+            }];
+            [self.files removeObjectForKey:fullPath];
+            file = nil;
+            CC_SHA256_Init(&digestContext);
+        }
+    }
+
+    if (!file) {
+        file = [[PGPKeyringFile alloc] init];
+    }
+
+    NSArray<PGPPartialKey *> *partialKeys = nil;
+    NSUInteger readLength = 0;
+    BOOL isIncomplete = NO;
+    if (isArmored) {
+        let keys = [ObjectivePGP readKeysFromData:fileData error:error];
+        if (!keys) {
+            return NO;
+        }
+
+        let armoredPartialKeys = [NSMutableArray<PGPPartialKey *> arrayWithCapacity:keys.count * 2];
+        for (PGPKey *key in keys) {
+            [armoredPartialKeys pgp_addObject:key.secretKey];
+            [armoredPartialKeys pgp_addObject:key.publicKey];
+        }
+        partialKeys = armoredPartialKeys;
+        readLength = fileData.length;
+    } else {
+        // Keys of the appended bytes. The last key may be still being written, and is read again on the next import.
+        let appendedData = [NSData dataWithBytesNoCopy:(void *)((const UInt8 *)fileData.bytes + file.offset) length:fileData.length - file.offset freeWhenDone:NO];
+        NSMutableArray<NSValue *> *keyRanges = [[ObjectivePGP keyRangesInData:appendedData resyncPolicy:PGPPacketResyncPolicyStop error:nil] mutableCopy] ?: [NSMutableArray<NSValue *> array];
+        readLength = keyRanges.count > 0 ? keyRanges.lastObject.rangeValue.location : 0;
+        if (keyRanges.count > 0 && NSMaxRange(keyRanges.lastObject.rangeValue) < appendedData.length) {
+            // Ends with an incomplete packet
+            [keyRanges removeLastObject];
+            isIncomplete = YES;
+        }
+
+        partialKeys = [[ObjectivePGP readPartialKeysFromData:appendedData ranges:keyRanges] pgp_objectsPassingTest:^BOOL(id partialKey, BOOL *stop) {
+            return [partialKey isKindOfClass:PGPPartialKey.class];
+        }];
+
+        if (appendedData.length > 0 && partialKeys.count == 0 && !isIncomplete) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{NSLocalizedDescriptionKey: @"Can't read keys. Invalid input."}];
+            }
+            return NO;
+        }
+    }
+
+    for (PGPPartialKey *partialKey in partialKeys) {
+        [file.fingerprints addObject:partialKey.fingerprint.hashedData];
+    }
+    self.keys = [self.class keysByMergingPartialKeys:partialKeys intoKeys:self.keys];
+
+    CC_SHA256_Update(&digestContext, (const UInt8 *)fileData.bytes + file.offset, (CC_LONG)readLength);
+    UInt8 digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(digest, &digestContext);
+    file.offset += readLength;
+    file.digest = [NSData dataWithBytes:digest length:CC_SHA256_DIGEST_LENGTH];
+    self.files[fullPath] = file;
+    return YES;
+}
+
 - (void)deleteKeys:(NSArray<PGPKey *> *)keys {
     PGPAssertClass(keys, NSArray);
 
@@ -279,6 +417,38 @@
     return updatedContainer;
 }
 
+// Compound keys of the partial keys with the same fingerprint, in order of the first partial key. The later partial key of the same type wins.
++ (NSArray<PGPKey *> *)keysByMergingPartialKeys:(NSArray<PGPPartialKey *> *)partialKeys {
+    return [self keysByMergingPartialKeys:partialKeys intoKeys:@[]];
+}
+
+// Keys, with the partial keys merged into the keys of the same fingerprint, or appended. Updates the existing compound keys.
++ (NSArray<PGPKey *> *)keysByMergingPartialKeys:(NSArray<PGPPartialKey *> *)partialKeys intoKeys:(NSArray<PGPKey *> *)existingKeys {
+    let keys = [NSMutableArray<PGPKey *> arrayWithArray:existingKeys];
+    let keysByFingerprint = [NSMutableDictionary<NSData *, PGPKey *> dictionaryWithCapacity:existingKeys.count + partialKeys.count];
+    for (PGPKey *key in existingKeys) {
+        keysByFingerprint[[self fingerprintDataOfKey:key]] = key;
+    }
+    for (PGPPartialKey *partialKey in partialKeys) {
+        let fingerprintData = partialKey.fingerprint.hashedData;
+        let _Nullable foundCompoundKey = keysByFingerprint[fingerprintData];
+        if (!foundCompoundKey) {
+            let compoundKey = [[PGPKey alloc] initWithSecretKey:(partialKey.type == PGPKeyTypeSecret ? partialKey : nil) publicKey:(partialKey.type == PGPKeyTypePublic ? partialKey : nil)];
+            keysByFingerprint[fingerprintData] = compoundKey;
+            [keys addObject:compoundKey];
+        } else if (partialKey.type == PGPKeyTypePublic) {
+            foundCompoundKey.publicKey = partialKey;
+        } else if (partialKey.type == PGPKeyTypeSecret) {
+            foundCompoundKey.secretKey = partialKey;
+        }
+    }
+    return keys;
+}
+
++ (NSData *)fingerprintDataOfKey:(PGPKey *)key {
+    return PGPNN(key.publicKey ?: key.secretKey).fingerprint.hashedData;
+}
+
 #pragma mark - PGPExportable
 
 - (NSData *)export:(NSError * _Nullable __autoreleasing *)error {
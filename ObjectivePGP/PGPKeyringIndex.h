@@ -0,0 +1,92 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMacros.h>
+#import <ObjectivePGP/PGPTypes.h>
+#import <ObjectivePGP/PGPKey.h>
+#import <ObjectivePGP/PGPKeyID.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_OPTIONS(NSUInteger, PGPKeyringIndexCapability) {
+    PGPKeyringIndexCapabilityNone = 0,
+    /// The key or a subkey can encrypt.
+    PGPKeyringIndexCapabilityEncrypt = 1 << 0,
+    /// The key flags of the key or a subkey allow signing.
+    PGPKeyringIndexCapabilitySign = 1 << 1
+};
+
+/// Indexed key of a keyring file. A public and a secret key with the same fingerprint are separate entries.
+NS_SWIFT_NAME(KeyringIndexEntry) @interface PGPKeyringIndexEntry : NSObject
+
+/// Byte range of the key in the keyring file.
+@property (readonly, nonatomic) NSRange range;
+@property (readonly, nonatomic) PGPKeyType type;
+/// Fingerprint hash of the primary key.
+@property (readonly, copy, nonatomic) NSData *fingerprint;
+/// Key identifiers of the primary key and the subkeys.
+@property (readonly, copy, nonatomic) NSArray<PGPKeyID *> *keyIDs;
+@property (readonly, copy, nonatomic) NSArray<NSString *> *userIDs;
+@property (readonly, nonatomic) PGPKeyringIndexCapability capabilities;
+@property (readonly, nonatomic, nullable) NSDate *expirationDate;
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+@end
+
+/**
+ Index of a keyring file, kept in a sidecar file next to it (the keyring path with the `idx` extension).
+
+ The sidecar index is trusted as long as the size and the modification date of the keyring file match.
+ With a different modification date, or when verifying, the SHA-256 hash of the keyring file is checked.
+ Otherwise the keyring is read and the sidecar index is written again. Keys are read from the mapped
+ keyring file on demand.
+ */
+NS_SWIFT_NAME(KeyringIndex) @interface PGPKeyringIndex : NSObject
+
+/// Path of the keyring file.
+@property (readonly, copy, nonatomic) NSString *path;
+
+/// Indexed keys, in order of the keyring file.
+@property (readonly, copy, nonatomic) NSArray<PGPKeyringIndexEntry *> *entries;
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+/// Path of the sidecar index file of the keyring.
++ (NSString *)indexPathForKeyringAtPath:(NSString *)path;
+
+/**
+ Open the keyring file with its sidecar index. The index is built and written if it is missing or out of date.
+
+ @param path Path of the binary keyring file.
+ @param error Optional. Error.
+ */
+- (nullable instancetype)initWithKeyringAtPath:(NSString *)path error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ Open the keyring file with its sidecar index. The index is built and written if it is missing or out of date.
+
+ @param path Path of the binary keyring file.
+ @param verify Whether to check the hash of the keyring file even if its size and modification date match the index.
+ @param error Optional. Error.
+ */
+- (nullable instancetype)initWithKeyringAtPath:(NSString *)path verify:(BOOL)verify error:(NSError * __autoreleasing _Nullable *)error NS_DESIGNATED_INITIALIZER;
+
+/// Key with the primary key or subkey identifier.
+- (nullable PGPKey *)keyWithKeyID:(PGPKeyID *)keyID;
+
+/// Keys with the user identifier.
+- (NSArray<PGPKey *> *)keysForUserID:(NSString *)userID;
+
+/// Key of the entry, merged with the other entries of the same fingerprint.
+- (nullable PGPKey *)keyForEntry:(PGPKeyringIndexEntry *)entry;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,361 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPKeyringIndex.h"
+#import "ObjectivePGPObject+Private.h"
+#import "PGPKeyring+Private.h"
+#import "PGPPartialKey+Private.h"
+#import "PGPPartialSubKey.h"
+#import "PGPPartialSubKey+Private.h"
+#import "PGPSignaturePacket.h"
+#import "PGPSignaturePacket+Private.h"
+#import "PGPFingerprint.h"
+#import "PGPUser.h"
+#import "NSData+PGPUtils.h"
+#import "NSArray+PGPUtils.h"
+#import "PGPLogging.h"
+#import "PGPMacros+Private.h"
+#import "PGPFoundation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+static const NSUInteger PGPKeyringIndexVersion = 1;
+
+@interface PGPKeyringIndexEntry ()
+
+- (instancetype)initWithRange:(NSRange)range type:(PGPKeyType)type fingerprint:(NSData *)fingerprint keyIDs:(NSArray<PGPKeyID *> *)keyIDs userIDs:(NSArray<NSString *> *)userIDs capabilities:(PGPKeyringIndexCapability)capabilities expirationDate:(nullable NSDate *)expirationDate NS_DESIGNATED_INITIALIZER;
+
++ (instancetype)entryWithPartialKey:(PGPPartialKey *)partialKey range:(NSRange)range;
++ (nullable instancetype)entryWithPropertyList:(NSDictionary<NSString *, id> *)propertyList;
+- (NSDictionary<NSString *, id> *)propertyList;
+
+@end
+
+@implementation PGPKeyringIndexEntry
+
+- (instancetype)initWithRange:(NSRange)range type:(PGPKeyType)type fingerprint:(NSData *)fingerprint keyIDs:(NSArray<PGPKeyID *> *)keyIDs userIDs:(NSArray<NSString *> *)userIDs capabilities:(PGPKeyringIndexCapability)capabilities expirationDate:(nullable NSDate *)expirationDate {
+    if ((self = [super init])) {
+        _range = range;
+        _type = type;
+        _fingerprint = [fingerprint copy];
+        _keyIDs = [keyIDs copy];
+        _userIDs = [userIDs copy];
+        _capabilities = capabilities;
+        _expirationDate = expirationDate;
+    }
+    return self;
+}
+
++ (instancetype)entryWithPartialKey:(PGPPartialKey *)partialKey range:(NSRange)range {
+    let keyIDs = [NSMutableArray<PGPKeyID *> arrayWithObject:partialKey.keyID];
+    PGPKeyringIndexCapability capabilities = PGPKeyringIndexCapabilityNone;
+    for (PGPPartialSubKey *subKey in partialKey.subKeys) {
+        [keyIDs addObject:subKey.keyID];
+        if (![partialKey isSubKeyBound:subKey]) {
+            continue;
+        }
+        if ([partialKey canSubKeySign:subKey]) {
+            capabilities |= PGPKeyringIndexCapabilitySign;
+        }
+        if (subKey.bindingSignature.canBeUsedToEncrypt) {
+            capabilities |= PGPKeyringIndexCapabilityEncrypt;
+        }
+    }
+
+    let _Nullable primaryUserSelfCertificate = partialKey.primaryUserSelfCertificate;
+    if (primaryUserSelfCertificate.canBeUsedToSign) {
+        capabilities |= PGPKeyringIndexCapabilitySign;
+    }
+    if (primaryUserSelfCertificate.canBeUsedToEncrypt) {
+        capabilities |= PGPKeyringIndexCapabilityEncrypt;
+    }
+
+    let userIDs = [NSMutableArray<NSString *> arrayWithCapacity:partialKey.users.count];
+    for (PGPUser *user in partialKey.users) {
+        [userIDs pgp_addObject:user.userID];
+    }
+
+    return [[self alloc] initWithRange:range type:partialKey.type fingerprint:partialKey.fingerprint.hashedData keyIDs:keyIDs userIDs:userIDs capabilities:capabilities expirationDate:partialKey.expirationDate];
+}
+
+#pragma mark - Property list
+
++ (nullable instancetype)entryWithPropertyList:(NSDictionary<NSString *, id> *)propertyList {
+    let location = PGPCast(propertyList[@"location"], NSNumber);
+    let length = PGPCast(propertyList[@"length"], NSNumber);
+    let type = PGPCast(propertyList[@"type"], NSNumber);
+    let fingerprint = PGPCast(propertyList[@"fingerprint"], NSData);
+    let keyIDsData = PGPCast(propertyList[@"keyIDs"], NSArray);
+    let userIDs = PGPCast(propertyList[@"userIDs"], NSArray);
+    let capabilities = PGPCast(propertyList[@"capabilities"], NSNumber);
+    if (!location || !length || !type || !fingerprint || !keyIDsData || !userIDs || !capabilities) {
+        return nil;
+    }
+
+    let keyIDs = [NSMutableArray<PGPKeyID *> arrayWithCapacity:keyIDsData.count];
+    for (id keyIDData in keyIDsData) {
+        let keyID = PGPCast(keyIDData, NSData) ? [[PGPKeyID alloc] initWithLongKey:keyIDData] : nil;
+        if (!keyID) {
+            return nil;
+        }
+        [keyIDs addObject:PGPNN(keyID)];
+    }
+
+    let range = (NSRange){location.unsignedIntegerValue, length.unsignedIntegerValue};
+    return [[self alloc] initWithRange:range type:(PGPKeyType)type.unsignedIntegerValue fingerprint:PGPNN(fingerprint) keyIDs:keyIDs userIDs:PGPNN(userIDs) capabilities:capabilities.unsignedIntegerValue expirationDate:PGPCast(propertyList[@"expirationDate"], NSDate)];
+}
+
+- (NSDictionary<NSString *, id> *)propertyList {
+    let keyIDsData = [NSMutableArray<NSData *> arrayWithCapacity:self.keyIDs.count];
+    for (PGPKeyID *keyID in self.keyIDs) {
+        [keyIDsData pgp_addObject:[keyID export:nil]];
+    }
+
+    let propertyList = [NSMutableDictionary<NSString *, id> dictionary];
+    propertyList[@"location"] = @(self.range.location);
+    propertyList[@"length"] = @(self.range.length);
+    propertyList[@"type"] = @(self.type);
+    propertyList[@"fingerprint"] = self.fingerprint;
+    propertyList[@"keyIDs"] = keyIDsData;
+    propertyList[@"userIDs"] = self.userIDs;
+    propertyList[@"capabilities"] = @(self.capabilities);
+    propertyList[@"expirationDate"] = self.expirationDate;
+    return propertyList;
+}
+
+@end
+
+@interface PGPKeyringIndex ()
+
+@property (readwrite, copy, nonatomic) NSArray<PGPKeyringIndexEntry *> *entries;
+
+@end
+
+@implementation PGPKeyringIndex {
+    NSData *_keyringData;
+    NSDictionary<PGPKeyID *, NSNumber *> *_entryIndexByKeyID;
+    NSDictionary<NSData *, NSArray<PGPKeyringIndexEntry *> *> *_entriesByFingerprint;
+    NSDictionary<NSString *, NSArray<PGPKeyringIndexEntry *> *> *_entriesByUserID;
+    NSCache<NSData *, PGPKey *> *_keysCache;
+}
+
++ (NSString *)indexPathForKeyringAtPath:(NSString *)path {
+    return [[path stringByExpandingTildeInPath] stringByAppendingPathExtension:@"idx"];
+}
+
+- (nullable instancetype)initWithKeyringAtPath:(NSString *)path error:(NSError * __autoreleasing _Nullable *)error {
+    return [self initWithKeyringAtPath:path verify:NO error:error];
+}
+
+- (nullable instancetype)initWithKeyringAtPath:(NSString *)path verify:(BOOL)verify error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(path, NSString);
+
+    let fullPath = [path stringByExpandingTildeInPath];
+    let attributes = [NSFileManager.defaultManager attributesOfItemAtPath:fullPath error:error];
+    let keyringData = [NSData dataWithContentsOfFile:fullPath options:NSDataReadingMappedIfSafe error:error];
+    if (!attributes || !keyringData) {
+        return nil;
+    }
+
+    if ((self = [super init])) {
+        _path = [fullPath copy];
+        _keyringData = keyringData;
+        _keysCache = [[NSCache alloc] init];
+
+        // The keyring is hashed at most once: to check the index, then reused to write it.
+        let indexPath = [self.class indexPathForKeyringAtPath:fullPath];
+        NSData * _Nullable keyringDigest = nil;
+        BOOL indexNeedsWrite = NO;
+        let _Nullable entries = [self.class entriesFromIndexAtPath:indexPath keyringData:keyringData attributes:attributes verify:verify keyringDigest:&keyringDigest needsWrite:&indexNeedsWrite];
+        if (entries) {
+            _entries = PGPNN(entries);
+        } else {
+            let builtEntries = [self.class entriesOfKeyringData:keyringData error:error];
+            if (!builtEntries) {
+                return nil;
+            }
+            _entries = builtEntries;
+            indexNeedsWrite = YES;
+        }
+
+        NSError *writeError = nil;
+        if (indexNeedsWrite && ![self.class writeEntries:self.entries toIndexAtPath:indexPath keyringDigest:keyringDigest ?: [keyringData pgp_SHA256] attributes:attributes error:&writeError]) {
+            PGPLogWarning(@"Can't write the keyring index. %@", writeError);
+        }
+
+        [self buildLookupTables];
+    }
+    return self;
+}
+
+- (void)buildLookupTables {
+    let entryIndexByKeyID = [NSMutableDictionary<PGPKeyID *, NSNumber *> dictionaryWithCapacity:self.entries.count];
+    let entriesByFingerprint = [NSMutableDictionary<NSData *, NSMutableArray<PGPKeyringIndexEntry *> *> dictionaryWithCapacity:self.entries.count];
+    let entriesByUserID = [NSMutableDictionary<NSString *, NSMutableArray<PGPKeyringIndexEntry *> *> dictionaryWithCapacity:self.entries.count];
+    [self.entries enumerateObjectsUsingBlock:^(PGPKeyringIndexEntry *entry, NSUInteger idx, BOOL *stop) {
+        for (PGPKeyID *keyID in entry.keyIDs) {
+            if (!entryIndexByKeyID[keyID]) {
+                entryIndexByKeyID[keyID] = @(idx);
+            }
+        }
+
+        var fingerprintEntries = entriesByFingerprint[entry.fingerprint];
+        if (!fingerprintEntries) {
+            fingerprintEntries = [NSMutableArray<PGPKeyringIndexEntry *> array];
+            entriesByFingerprint[entry.fingerprint] = fingerprintEntries;
+        }
+        [fingerprintEntries addObject:entry];
+
+        for (NSString *userID in entry.userIDs) {
+            var userIDEntries = entriesByUserID[userID];
+            if (!userIDEntries) {
+                userIDEntries = [NSMutableArray<PGPKeyringIndexEntry *> array];
+                entriesByUserID[userID] = userIDEntries;
+            }
+            [userIDEntries addObject:entry];
+        }
+    }];
+    _entryIndexByKeyID = entryIndexByKeyID;
+    _entriesByFingerprint = entriesByFingerprint;
+    _entriesByUserID = entriesByUserID;
+}
+
+#pragma mark - Lookup
+
+- (nullable PGPKey *)keyWithKeyID:(PGPKeyID *)keyID {
+    PGPAssertClass(keyID, PGPKeyID);
+
+    let entryIndex = _entryIndexByKeyID[keyID];
+    if (!entryIndex) {
+        return nil;
+    }
+    return [self keyForEntry:self.entries[entryIndex.unsignedIntegerValue]];
+}
+
+- (NSArray<PGPKey *> *)keysForUserID:(NSString *)userID {
+    PGPAssertClass(userID, NSString);
+
+    let keys = [NSMutableArray<PGPKey *> array];
+    let fingerprints = [NSMutableSet<NSData *> set];
+    for (PGPKeyringIndexEntry *entry in _entriesByUserID[userID]) {
+        if ([fingerprints containsObject:entry.fingerprint]) {
+            continue;
+        }
+        [fingerprints addObject:entry.fingerprint];
+        [keys pgp_addObject:[self keyForEntry:entry]];
+    }
+    return keys;
+}
+
+- (nullable PGPKey *)keyForEntry:(PGPKeyringIndexEntry *)entry {
+    PGPAssertClass(entry, PGPKeyringIndexEntry);
+
+    let cachedKey = [_keysCache objectForKey:entry.fingerprint];
+    if (cachedKey) {
+        return cachedKey;
+    }
+
+    let partialKeys = [NSMutableArray<PGPPartialKey *> array];
+    for (PGPKeyringIndexEntry *fingerprintEntry in _entriesByFingerprint[entry.fingerprint]) {
+        if (NSMaxRange(fingerprintEntry.range) > _keyringData.length) {
+            continue;
+        }
+        [partialKeys pgp_addObject:[ObjectivePGP readPartialKeyFromData:_keyringData range:fingerprintEntry.range]];
+    }
+
+    let key = [PGPKeyring keysByMergingPartialKeys:partialKeys].firstObject;
+    if (key) {
+        [_keysCache setObject:PGPNN(key) forKey:entry.fingerprint];
+    }
+    return key;
+}
+
+#pragma mark - Index file
+
++ (nullable NSArray<PGPKeyringIndexEntry *> *)entriesOfKeyringData:(NSData *)keyringData error:(NSError * __autoreleasing _Nullable *)error {
+    let keyRanges = [ObjectivePGP keyRangesInData:keyringData resyncPolicy:PGPPacketResyncPolicySkip error:error];
+    if (!keyRanges) {
+        return nil;
+    }
+
+    let partialKeys = [ObjectivePGP readPartialKeysFromData:keyringData ranges:keyRanges];
+    let entries = [NSMutableArray<PGPKeyringIndexEntry *> arrayWithCapacity:partialKeys.count];
+    [partialKeys enumerateObjectsUsingBlock:^(id partialKey, NSUInteger idx, BOOL *stop) {
+        if ([partialKey isKindOfClass:PGPPartialKey.class]) {
+            [entries addObject:[PGPKeyringIndexEntry entryWithPartialKey:partialKey range:keyRanges[idx].rangeValue]];
+        }
+    }];
+    return entries;
+}
+
+// The keyring digest is set if the keyring was hashed. The index needs to be written again if only the modification date changed.
++ (nullable NSArray<PGPKeyringIndexEntry *> *)entriesFromIndexAtPath:(NSString *)indexPath keyringData:(NSData *)keyringData attributes:(NSDictionary<NSFileAttributeKey, id> *)attributes verify:(BOOL)verify keyringDigest:(NSData * _Nullable __autoreleasing *)keyringDigest needsWrite:(BOOL *)needsWrite {
+    let indexData = [NSData dataWithContentsOfFile:indexPath options:NSDataReadingMappedIfSafe error:nil];
+    if (!indexData) {
+        return nil;
+    }
+
+    let propertyList = PGPCast([NSPropertyListSerialization propertyListWithData:indexData options:NSPropertyListImmutable format:nil error:nil], NSDictionary);
+    let version = PGPCast(propertyList[@"version"], NSNumber);
+    let size = PGPCast(propertyList[@"size"], NSNumber);
+    let modificationDate = PGPCast(propertyList[@"modificationDate"], NSDate);
+    let digest = PGPCast(propertyList[@"digest"], NSData);
+    let entriesPropertyList = PGPCast(propertyList[@"entries"], NSArray);
+    if (version.unsignedIntegerValue != PGPKeyringIndexVersion || !entriesPropertyList) {
+        return nil;
+    }
+
+    // The same size and modification date are trusted. Otherwise the keyring may be the same file touched
+    // or copied, then its hash decides.
+    if (size.unsignedLongLongValue != attributes.fileSize) {
+        PGPLogDebug(@"Keyring index is out of date: %@", indexPath);
+        return nil;
+    }
+
+    let sameModificationDate = PGPEqualObjects(modificationDate, attributes.fileModificationDate);
+    if (!sameModificationDate || verify) {
+        *keyringDigest = [keyringData pgp_SHA256];
+        if (!PGPEqualObjects(digest, *keyringDigest)) {
+            PGPLogDebug(@"Keyring index is out of date: %@", indexPath);
+            return nil;
+        }
+    }
+
+    let entries = [NSMutableArray<PGPKeyringIndexEntry *> arrayWithCapacity:entriesPropertyList.count];
+    for (id entryPropertyList in entriesPropertyList) {
+        let _Nullable entry = PGPCast(entryPropertyList, NSDictionary) ? [PGPKeyringIndexEntry entryWithPropertyList:entryPropertyList] : nil;
+        if (!entry) {
+            return nil;
+        }
+        [entries addObject:PGPNN(entry)];
+    }
+    *needsWrite = !sameModificationDate;
+    return entries;
+}
+
++ (BOOL)writeEntries:(NSArray<PGPKeyringIndexEntry *> *)entries toIndexAtPath:(NSString *)indexPath keyringDigest:(NSData *)keyringDigest attributes:(NSDictionary<NSFileAttributeKey, id> *)attributes error:(NSError * __autoreleasing _Nullable *)error {
+    let entriesPropertyList = [NSMutableArray<NSDictionary *> arrayWithCapacity:entries.count];
+    for (PGPKeyringIndexEntry *entry in entries) {
+        [entriesPropertyList addObject:entry.propertyList];
+    }
+
+    let propertyList = @{
+        @"version": @(PGPKeyringIndexVersion),
+        @"size": @(attributes.fileSize),
+        @"modificationDate": attributes.fileModificationDate ?: NSDate.distantPast,
+        @"digest": keyringDigest,
+        @"entries": entriesPropertyList
+    };
+
+    let indexData = [NSPropertyListSerialization dataWithPropertyList:propertyList format:NSPropertyListBinaryFormat_v1_0 options:0 error:error];
+    return indexData && [indexData writeToFile:indexPath options:NSDataWritingAtomic error:error];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,71 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMacros.h>
+#import <ObjectivePGP/PGPKey.h>
+#import <ObjectivePGP/PGPKeyID.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Keyring file with an append-only log of changes, for frequent updates.
+
+ The keyring file is a clean OpenPGP keyring. Updated keys and deletions are appended to
+ the log file next to it (the keyring path with the `log` extension) and applied on top of the
+ keyring when the store is opened. Compaction writes the current keys to the keyring file
+ and starts a new log.
+
+ A log record torn by a crash is detected by its checksum and truncated when the store is opened.
+ */
+NS_SWIFT_NAME(KeyringStore) @interface PGPKeyringStore : NSObject
+
+/// Path of the keyring file.
+@property (readonly, copy, nonatomic) NSString *path;
+
+/// Path of the log file.
+@property (readonly, copy, nonatomic) NSString *logPath;
+
+/// Keys of the store, in order of the first import.
+@property (readonly, copy) NSArray<PGPKey *> *keys;
+
+/// Length of the log file.
+@property (readonly) unsigned long long logLength;
+
+/// Bytes of the exported keys that were added, and bytes written to the log and the keyring files for them. The ratio is the write amplification.
+@property (readonly) unsigned long long bytesAdded;
+@property (readonly) unsigned long long bytesWritten;
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+/**
+ Open the store. The keyring and the log are created if they don't exist.
+
+ @param path Path of the keyring file.
+ @param error Optional. Error.
+ */
+- (nullable instancetype)initWithKeyringAtPath:(NSString *)path error:(NSError * __autoreleasing _Nullable *)error NS_DESIGNATED_INITIALIZER;
+
+/// Add new keys, or replace the public or the secret part of the keys with the same fingerprint.
+- (BOOL)addKeys:(NSArray<PGPKey *> *)keys error:(NSError * __autoreleasing _Nullable *)error NS_SWIFT_NAME(add(keys:));
+
+/// Delete the keys with the same fingerprints.
+- (BOOL)deleteKeys:(NSArray<PGPKey *> *)keys error:(NSError * __autoreleasing _Nullable *)error NS_SWIFT_NAME(delete(keys:));
+
+/// Key with the primary key or subkey identifier.
+- (nullable PGPKey *)findKeyWithKeyID:(PGPKeyID *)keyID NS_SWIFT_NAME(findKey(_:));
+
+/// Write the keys to the keyring file and truncate the log. Changes added during the compaction are kept in the log.
+- (BOOL)compact:(NSError * __autoreleasing _Nullable *)error;
+
+/// Compact on a background queue.
+- (void)compactWithCompletion:(nullable void (^)(BOOL success, NSError * _Nullable error))completion;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,523 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPKeyringStore.h"
+#import "PGPKey+Private.h"
+#import "PGPPartialKey.h"
+#import "PGPPartialSubKey.h"
+#import "PGPFingerprint.h"
+#import "ObjectivePGPObject.h"
+#import "NSMutableData+PGPUtils.h"
+#import "NSArray+PGPUtils.h"
+#import "PGPLogging.h"
+#import "PGPMacros+Private.h"
+#import "PGPFoundation.h"
+
+#import <zlib.h>
+#import <stdio.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(UInt8, PGPKeyringStoreRecordType) {
+    PGPKeyringStoreRecordTypeKey = 1,       // exported partial key
+    PGPKeyringStoreRecordTypeTombstone = 2  // fingerprint of the deleted key
+};
+
+// "PGPKLOG" and the format version
+static const UInt8 PGPKeyringStoreLogMagic[8] = { 'P', 'G', 'P', 'K', 'L', 'O', 'G', 0x01 };
+
+// Record: type (1), payload length (4), CRC-32 of the type, the length and the payload (4), payload.
+static const NSUInteger PGPKeyringStoreRecordHeaderLength = 9;
+
+@implementation PGPKeyringStore {
+    // State, accessed on the queue.
+    dispatch_queue_t _queue;
+    NSMutableOrderedSet<NSData *> *_fingerprints;
+    NSMutableDictionary<NSData *, PGPKey *> *_keysByFingerprint;
+    NSMutableDictionary<PGPKeyID *, NSData *> *_fingerprintsByKeyID;
+    // Nil if the log couldn't be opened again after the compaction.
+    NSFileHandle * _Nullable _logHandle;
+    unsigned long long _logLength;
+    unsigned long long _bytesAdded;
+    unsigned long long _bytesWritten;
+    // One compaction at a time.
+    dispatch_queue_t _compactionQueue;
+}
+
+- (nullable instancetype)initWithKeyringAtPath:(NSString *)path error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(path, NSString);
+
+    if ((self = [super init])) {
+        _path = [[path stringByExpandingTildeInPath] copy];
+        _logPath = [[_path stringByAppendingPathExtension:@"log"] copy];
+        _queue = dispatch_queue_create("com.objectivepgp.keyringstore", DISPATCH_QUEUE_SERIAL);
+        _compactionQueue = dispatch_queue_create("com.objectivepgp.keyringstore.compaction", DISPATCH_QUEUE_SERIAL);
+        _fingerprints = [NSMutableOrderedSet<NSData *> orderedSet];
+        _keysByFingerprint = [NSMutableDictionary<NSData *, PGPKey *> dictionary];
+        _fingerprintsByKeyID = [NSMutableDictionary<PGPKeyID *, NSData *> dictionary];
+
+        if (![self loadKeyring:error] || ![self recoverLog:error]) {
+            return nil;
+        }
+
+        _logHandle = [NSFileHandle fileHandleForUpdatingAtPath:_logPath];
+        if (!_logHandle) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Can't open the keyring log." }];
+            }
+            return nil;
+        }
+        [_logHandle seekToFileOffset:_logLength];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [_logHandle closeFile];
+}
+
+#pragma mark - Keys
+
+- (NSArray<PGPKey *> *)keys {
+    __block NSArray<PGPKey *> *keys = nil;
+    dispatch_sync(_queue, ^{
+        keys = [self keysOfFingerprints];
+    });
+    return keys;
+}
+
+- (unsigned long long)logLength {
+    __block unsigned long long logLength = 0;
+    dispatch_sync(_queue, ^{
+        logLength = self->_logLength;
+    });
+    return logLength;
+}
+
+- (unsigned long long)bytesAdded {
+    __block unsigned long long bytesAdded = 0;
+    dispatch_sync(_queue, ^{
+        bytesAdded = self->_bytesAdded;
+    });
+    return bytesAdded;
+}
+
+- (unsigned long long)bytesWritten {
+    __block unsigned long long bytesWritten = 0;
+    dispatch_sync(_queue, ^{
+        bytesWritten = self->_bytesWritten;
+    });
+    return bytesWritten;
+}
+
+- (nullable PGPKey *)findKeyWithKeyID:(PGPKeyID *)keyID {
+    PGPAssertClass(keyID, PGPKeyID);
+
+    __block PGPKey * _Nullable key = nil;
+    dispatch_sync(_queue, ^{
+        let fingerprint = self->_fingerprintsByKeyID[keyID];
+        key = fingerprint ? self->_keysByFingerprint[PGPNN(fingerprint)] : nil;
+    });
+    return key;
+}
+
+- (BOOL)addKeys:(NSArray<PGPKey *> *)keys error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(keys, NSArray);
+
+    let records = [NSMutableData data];
+    let partialKeys = [NSMutableArray<PGPPartialKey *> array];
+    unsigned long long bytesAdded = 0;
+    for (PGPKey *key in keys) {
+        for (PGPPartialKey *partialKey in [self.class partialKeysOfKey:key]) {
+            let keyData = [partialKey export:error];
+            if (!keyData) {
+                return NO;
+            }
+            [self.class appendRecordOfType:PGPKeyringStoreRecordTypeKey payload:keyData toData:records];
+            [partialKeys addObject:partialKey];
+            bytesAdded += keyData.length;
+        }
+    }
+
+    __block BOOL result = NO;
+    __block NSError * _Nullable appendError = nil;
+    dispatch_sync(_queue, ^{
+        NSError *recordsError = nil;
+        result = [self appendRecords:records error:&recordsError];
+        appendError = recordsError;
+        if (result) {
+            for (PGPPartialKey *partialKey in partialKeys) {
+                [self applyPartialKey:partialKey];
+            }
+            self->_bytesAdded += bytesAdded;
+        }
+    });
+
+    if (appendError && error) {
+        *error = appendError;
+    }
+    return result;
+}
+
+- (BOOL)deleteKeys:(NSArray<PGPKey *> *)keys error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(keys, NSArray);
+
+    let records = [NSMutableData data];
+    let fingerprints = [NSMutableArray<NSData *> array];
+    for (PGPKey *key in keys) {
+        let fingerprint = [self.class fingerprintOfKey:key];
+        [self.class appendRecordOfType:PGPKeyringStoreRecordTypeTombstone payload:fingerprint toData:records];
+        [fingerprints addObject:fingerprint];
+    }
+
+    __block BOOL result = NO;
+    __block NSError * _Nullable appendError = nil;
+    dispatch_sync(_queue, ^{
+        NSError *recordsError = nil;
+        result = [self appendRecords:records error:&recordsError];
+        appendError = recordsError;
+        if (result) {
+            for (NSData *fingerprint in fingerprints) {
+                [self removeKeyWithFingerprint:fingerprint];
+            }
+        }
+    });
+
+    if (appendError && error) {
+        *error = appendError;
+    }
+    return result;
+}
+
+#pragma mark - Compaction
+
+- (BOOL)compact:(NSError * __autoreleasing _Nullable *)error {
+    __block BOOL result = NO;
+    __block NSError * _Nullable compactionError = nil;
+    dispatch_sync(_compactionQueue, ^{
+        // Snapshot of the keys and the log length they include.
+        __block NSArray<PGPKey *> *keys = nil;
+        __block unsigned long long snapshotLogLength = 0;
+        dispatch_sync(self->_queue, ^{
+            keys = [self keysOfFingerprints];
+            snapshotLogLength = self->_logLength;
+        });
+
+        // Writing the keyring doesn't block the writers.
+        NSError *exportError = nil;
+        let keyringData = [NSMutableData data];
+        for (PGPKey *key in keys) {
+            [keyringData pgp_appendData:[key.publicKey export:&exportError]];
+            [keyringData pgp_appendData:[key.secretKey export:&exportError]];
+        }
+        if (exportError || ![self.class replaceFileAtPath:self.path withData:keyringData]) {
+            compactionError = exportError ?: [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Can't write the keyring." }];
+            return;
+        }
+
+        // The records appended during the compaction start the new log. The new keyring is durable
+        // at this point: a crash before the log is replaced replays the old log on top of the new
+        // keyring, which leads to the same keys.
+        dispatch_sync(self->_queue, ^{
+            [self->_logHandle seekToFileOffset:snapshotLogLength];
+            let logData = [NSMutableData dataWithBytes:PGPKeyringStoreLogMagic length:sizeof(PGPKeyringStoreLogMagic)];
+            [logData appendData:[self->_logHandle readDataToEndOfFile]];
+            if (![self.class replaceFileAtPath:self.logPath withData:logData]) {
+                compactionError = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Can't write the keyring log." }];
+                [self->_logHandle seekToEndOfFile];
+                return;
+            }
+
+            self->_bytesWritten += keyringData.length + logData.length;
+            NSError *reopenError = nil;
+            if (![self reopenLog:&reopenError]) {
+                compactionError = reopenError;
+                return;
+            }
+            result = YES;
+        });
+    });
+
+    if (compactionError && error) {
+        *error = compactionError;
+    }
+    return result;
+}
+
+- (void)compactWithCompletion:(nullable void (^)(BOOL success, NSError * _Nullable error))completion {
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        NSError *error = nil;
+        let result = [self compact:&error];
+        if (completion) {
+            completion(result, error);
+        }
+    });
+}
+
+#pragma mark - State
+
+// Call on the queue.
+- (NSArray<PGPKey *> *)keysOfFingerprints {
+    let keys = [NSMutableArray<PGPKey *> arrayWithCapacity:_fingerprints.count];
+    for (NSData *fingerprint in _fingerprints) {
+        [keys addObject:PGPNN(_keysByFingerprint[fingerprint])];
+    }
+    return keys;
+}
+
+// Call on the queue. Replaces the part of the key of the same type.
+- (void)applyPartialKey:(PGPPartialKey *)partialKey {
+    let fingerprint = partialKey.fingerprint.hashedData;
+    let _Nullable foundKey = _keysByFingerprint[fingerprint];
+    let secretKey = partialKey.type == PGPKeyTypeSecret ? partialKey : foundKey.secretKey;
+    let publicKey = partialKey.type == PGPKeyTypePublic ? partialKey : foundKey.publicKey;
+    _keysByFingerprint[fingerprint] = [[PGPKey alloc] initWithSecretKey:secretKey publicKey:publicKey];
+    [_fingerprints addObject:fingerprint];
+
+    _fingerprintsByKeyID[partialKey.keyID] = fingerprint;
+    for (PGPPartialSubKey *subKey in partialKey.subKeys) {
+        _fingerprintsByKeyID[subKey.keyID] = fingerprint;
+    }
+}
+
+// Call on the queue.
+- (void)removeKeyWithFingerprint:(NSData *)fingerprint {
+    let _Nullable key = _keysByFingerprint[fingerprint];
+    if (!key) {
+        return;
+    }
+
+    for (PGPPartialKey *partialKey in [self.class partialKeysOfKey:key]) {
+        if (PGPEqualObjects(_fingerprintsByKeyID[partialKey.keyID], fingerprint)) {
+            [_fingerprintsByKeyID removeObjectForKey:partialKey.keyID];
+        }
+        for (PGPPartialSubKey *subKey in partialKey.subKeys) {
+            if (PGPEqualObjects(_fingerprintsByKeyID[subKey.keyID], fingerprint)) {
+                [_fingerprintsByKeyID removeObjectForKey:subKey.keyID];
+            }
+        }
+    }
+
+    [_keysByFingerprint removeObjectForKey:fingerprint];
+    [_fingerprints removeObject:fingerprint];
+}
+
+#pragma mark - Files
+
+- (BOOL)loadKeyring:(NSError * __autoreleasing _Nullable *)error {
+    if (![NSFileManager.defaultManager fileExistsAtPath:self.path]) {
+        return YES;
+    }
+
+    let keyringData = [NSData dataWithContentsOfFile:self.path options:NSDataReadingMappedIfSafe error:error];
+    if (!keyringData) {
+        return NO;
+    }
+
+    if (keyringData.length > 0) {
+        let keys = [ObjectivePGP readKeysFromData:keyringData error:error];
+        if (!keys) {
+            return NO;
+        }
+        for (PGPKey *key in keys) {
+            for (PGPPartialKey *partialKey in [self.class partialKeysOfKey:key]) {
+                [self applyPartialKey:partialKey];
+            }
+        }
+    }
+    return YES;
+}
+
+// Replay the log. The log is truncated at the first incomplete or damaged record.
+- (BOOL)recoverLog:(NSError * __autoreleasing _Nullable *)error {
+    let magicLength = sizeof(PGPKeyringStoreLogMagic);
+    var logData = [NSData dataWithContentsOfFile:self.logPath options:NSDataReadingMappedIfSafe error:nil];
+    if (logData.length < magicLength) {
+        // Missing, or the crash happened right after the log was created.
+        let magicData = [NSData dataWithBytes:PGPKeyringStoreLogMagic length:magicLength];
+        if (logData.length > 0 && memcmp(logData.bytes, magicData.bytes, logData.length) != 0) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Invalid keyring log." }];
+            }
+            return NO;
+        }
+
+        if (![self.class replaceFileAtPath:self.logPath withData:magicData]) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Can't create the keyring log." }];
+            }
+            return NO;
+        }
+        _logLength = magicLength;
+        return YES;
+    }
+
+    if (memcmp(logData.bytes, PGPKeyringStoreLogMagic, magicLength) != 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Invalid keyring log." }];
+        }
+        return NO;
+    }
+
+    let bytes = (const UInt8 *)logData.bytes;
+    NSUInteger offset = magicLength;
+    while (offset + PGPKeyringStoreRecordHeaderLength <= logData.length) {
+        let type = bytes[offset];
+        let payloadLength = ((UInt32)bytes[offset + 1] << 24) | ((UInt32)bytes[offset + 2] << 16) | ((UInt32)bytes[offset + 3] << 8) | (UInt32)bytes[offset + 4];
+        let checksum = ((UInt32)bytes[offset + 5] << 24) | ((UInt32)bytes[offset + 6] << 16) | ((UInt32)bytes[offset + 7] << 8) | (UInt32)bytes[offset + 8];
+        let payloadOffset = offset + PGPKeyringStoreRecordHeaderLength;
+        if (payloadLength > logData.length - payloadOffset) {
+            break;
+        }
+
+        var calculatedChecksum = crc32(0L, bytes + offset, 5);
+        calculatedChecksum = crc32(calculatedChecksum, bytes + payloadOffset, (uInt)payloadLength);
+        if (calculatedChecksum != checksum) {
+            break;
+        }
+
+        let payload = [logData subdataWithRange:(NSRange){payloadOffset, payloadLength}];
+        switch (type) {
+            case PGPKeyringStoreRecordTypeKey:
+                for (PGPKey *key in [ObjectivePGP readKeysFromData:payload error:nil]) {
+                    for (PGPPartialKey *partialKey in [self.class partialKeysOfKey:key]) {
+                        [self applyPartialKey:partialKey];
+                    }
+                }
+                break;
+            case PGPKeyringStoreRecordTypeTombstone:
+                [self removeKeyWithFingerprint:payload];
+                break;
+            default:
+                PGPLogWarning(@"Unknown keyring log record type %@", @(type));
+                break;
+        }
+        offset = payloadOffset + payloadLength;
+    }
+
+    if (offset < logData.length) {
+        PGPLogWarning(@"Keyring log truncated at %@ of %@ bytes.", @(offset), @(logData.length));
+        logData = nil;
+        let fileHandle = [NSFileHandle fileHandleForUpdatingAtPath:self.logPath];
+        [fileHandle truncateFileAtOffset:offset];
+        [fileHandle synchronizeFile];
+        [fileHandle closeFile];
+    }
+
+    _logLength = offset;
+    return YES;
+}
+
+// Call on the queue. The records are written, and synchronized with the disk, at once.
+- (BOOL)appendRecords:(NSData *)records error:(NSError * __autoreleasing _Nullable *)error {
+    if (records.length == 0) {
+        return YES;
+    }
+
+    if (!_logHandle && ![self reopenLog:error]) {
+        return NO;
+    }
+
+    @try {
+        [_logHandle writeData:records];
+        [_logHandle synchronizeFile];
+    } @catch (NSException *exception) {
+        // Drop the partially written records, if any.
+        [_logHandle truncateFileAtOffset:_logLength];
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Can't write the keyring log." }];
+        }
+        return NO;
+    }
+
+    _logLength += records.length;
+    _bytesWritten += records.length;
+    return YES;
+}
+
+// Call on the queue. The log is opened at its end.
+- (BOOL)reopenLog:(NSError * __autoreleasing _Nullable *)error {
+    [_logHandle closeFile];
+    _logHandle = [NSFileHandle fileHandleForUpdatingAtPath:self.logPath];
+    if (!_logHandle) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Can't open the keyring log." }];
+        }
+        return NO;
+    }
+    _logLength = [_logHandle seekToEndOfFile];
+    return YES;
+}
+
++ (void)appendRecordOfType:(PGPKeyringStoreRecordType)type payload:(NSData *)payload toData:(NSMutableData *)data {
+    let payloadLength = (UInt32)payload.length;
+    UInt8 header[5] = { type, (UInt8)(payloadLength >> 24), (UInt8)(payloadLength >> 16), (UInt8)(payloadLength >> 8), (UInt8)payloadLength };
+    var checksum = crc32(0L, header, sizeof(header));
+    checksum = crc32(checksum, payload.bytes, (uInt)payload.length);
+    UInt8 checksumBytes[4] = { (UInt8)(checksum >> 24), (UInt8)(checksum >> 16), (UInt8)(checksum >> 8), (UInt8)checksum };
+
+    [data appendBytes:header length:sizeof(header)];
+    [data appendBytes:checksumBytes length:sizeof(checksumBytes)];
+    [data appendData:payload];
+}
+
++ (NSArray<PGPPartialKey *> *)partialKeysOfKey:(PGPKey *)key {
+    let partialKeys = [NSMutableArray<PGPPartialKey *> arrayWithCapacity:2];
+    [partialKeys pgp_addObject:key.publicKey];
+    [partialKeys pgp_addObject:key.secretKey];
+    return partialKeys;
+}
+
++ (NSData *)fingerprintOfKey:(PGPKey *)key {
+    return PGPNN(key.publicKey ?: key.secretKey).fingerprint.hashedData;
+}
+
+// Write a temporary file and rename it over the file, so the file is either old or new after a crash.
+// The file is synchronized with the disk before the rename, and the directory after, so the new file
+// is durable when this returns.
++ (BOOL)replaceFileAtPath:(NSString *)path withData:(NSData *)data {
+    let temporaryPath = [path stringByAppendingPathExtension:@"tmp"];
+    NSDictionary *attributes = nil;
+#ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
+    attributes = @{ NSFileProtectionKey: NSFileProtectionComplete, NSFilePosixPermissions: @(0600) };
+#else
+    attributes = @{ NSFilePosixPermissions: @(0600) };
+#endif
+    if (![NSFileManager.defaultManager createFileAtPath:temporaryPath contents:data attributes:attributes]) {
+        return NO;
+    }
+    if (![self synchronizeFileAtPath:temporaryPath flags:O_WRONLY]) {
+        unlink(temporaryPath.fileSystemRepresentation);
+        return NO;
+    }
+    if (rename(temporaryPath.fileSystemRepresentation, path.fileSystemRepresentation) != 0) {
+        return NO;
+    }
+    return [self synchronizeFileAtPath:path.stringByDeletingLastPathComponent flags:O_RDONLY];
+}
+
+// fsync doesn't flush the drive cache on Darwin, F_FULLFSYNC does. Not every file system supports it.
++ (BOOL)synchronizeFileAtPath:(NSString *)path flags:(int)flags {
+    let fd = open(path.length > 0 ? path.fileSystemRepresentation : ".", flags);
+    if (fd < 0) {
+        return NO;
+    }
+#ifdef F_FULLFSYNC
+    BOOL synchronized = fcntl(fd, F_FULLFSYNC) == 0 || fsync(fd) == 0;
+#else
+    BOOL synchronized = fsync(fd) == 0;
+#endif
+    close(fd);
+    return synchronized;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
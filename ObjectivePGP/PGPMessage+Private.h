@@ -0,0 +1,22 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMessage.h>
+#import <ObjectivePGP/PGPPacket.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface PGPMessage ()
+
+/// Packets of the message. Compressed packets are followed by the decompressed packets.
+@property (readonly, copy, nonatomic) NSArray<PGPPacket *> *packets;
+
+@end
+
+NS_ASSUME_NONNULL_END
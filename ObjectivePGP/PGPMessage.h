@@ -0,0 +1,84 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMacros.h>
+#import <ObjectivePGP/PGPKey.h>
+#import <ObjectivePGP/PGPKeyID.h>
+#import <ObjectivePGP/PGPSessionKey.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A PGP message, dearmored once and processed in stages: packets, session key, plaintext
+ and signature verification. Each stage runs on first use and the result is kept, so a message
+ can be inspected, decrypted and verified without parsing or decrypting it again.
+
+ @note The plaintext is kept for its session key. The session key is decrypted with the given keys
+ every time, and the kept plaintext is returned only if it is the same session key.
+ */
+NS_SWIFT_NAME(Message) @interface PGPMessage : NSObject
+
+/// Binary message data.
+@property (readonly, copy, nonatomic) NSData *data;
+
+/// Whether the message is encrypted.
+@property (readonly, nonatomic, getter=isEncrypted) BOOL encrypted;
+
+/// Key identifiers of the recipients of an encrypted message.
+@property (readonly, copy, nonatomic) NSArray<PGPKeyID *> *recipientKeyIDs;
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+/**
+ Initialize with a binary or armored (ASCII) message.
+
+ @param data Message data. Only the first armored message is used.
+ @param error Optional. Error.
+ */
+- (nullable instancetype)initWithData:(NSData *)data error:(NSError * __autoreleasing _Nullable *)error NS_DESIGNATED_INITIALIZER;
+
+/// Initialize with a message file. The file is mapped.
+- (nullable instancetype)initWithURL:(NSURL *)url error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ Session key of the encrypted message.
+
+ @param keys Keys to decrypt the session key with.
+ @param passphraseBlock Optional. Passphrase for the key, or for the message if the key is `nil`.
+ @param error Optional. Error.
+ */
+- (nullable PGPSessionKey *)sessionKeyUsingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ Plaintext of the message. An encrypted message is decrypted with the session key.
+
+ @param keys Keys to decrypt the session key with. Not used by a message that is not encrypted.
+ @param passphraseBlock Optional. Passphrase for the key, or for the message if the key is `nil`.
+ @param error Optional. Error.
+ */
+- (nullable NSData *)decryptUsingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error;
+
+/// Plaintext of the message encrypted with the given session key.
+- (nullable NSData *)decryptWithSessionKey:(PGPSessionKey *)sessionKey error:(NSError * __autoreleasing _Nullable *)error;
+
+/**
+ Verify the message signatures. An encrypted message is decrypted first.
+ The result is kept for the same keys.
+
+ @param keys Keys to verify the signatures with, and to decrypt the session key with.
+ @param certifyWithRootKey Whether to check that the signing key is certified by a root key from the keys.
+ @param passphraseBlock Optional. Passphrase for the key, or for the message if the key is `nil`.
+ @param error Optional. Error.
+ @return Whether the message signatures are valid.
+ */
+- (BOOL)verifyUsingKeys:(NSArray<PGPKey *> *)keys certifyWithRootKey:(BOOL)certifyWithRootKey passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,253 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPMessage.h"
+#import "PGPMessage+Private.h"
+#import "ObjectivePGPObject+Private.h"
+#import "PGPArmor.h"
+#import "PGPPartialKey.h"
+#import "PGPFingerprint.h"
+#import "PGPLiteralPacket.h"
+#import "PGPPublicKeyEncryptedSessionKeyPacket.h"
+#import "NSArray+PGPUtils.h"
+#import "PGPMacros+Private.h"
+#import "PGPFoundation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation PGPMessage {
+    NSArray<PGPPacket *> * _Nullable _packets;
+    // Session key of the decrypted packets and the plaintext
+    PGPSessionKey * _Nullable _sessionKey;
+    NSArray<PGPPacket *> * _Nullable _decryptedPackets;
+    NSData * _Nullable _plaintextData;
+    // Session keys decrypted with the public key operation, and the decrypting keys, by the key fingerprint
+    NSMutableDictionary<NSData *, PGPSessionKey *> *_decryptedSessionKeys;
+    NSMutableDictionary<NSData *, PGPKey *> *_sessionKeyDecryptingKeys;
+    // Verification result of the keys
+    NSArray<PGPKey *> * _Nullable _verificationKeys;
+    BOOL _verificationCertifyWithRootKey;
+    NSError * _Nullable _verificationError;
+}
+
+- (nullable instancetype)initWithData:(NSData *)data error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(data, NSData);
+
+    let binaryMessage = [PGPArmor convertArmoredMessage2BinaryBlocksWhenNecessary:data error:error].firstObject;
+    if (!binaryMessage) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Invalid message." }];
+        }
+        return nil;
+    }
+
+    if ((self = [super init])) {
+        _data = binaryMessage;
+        _decryptedSessionKeys = [NSMutableDictionary dictionary];
+        _sessionKeyDecryptingKeys = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (nullable instancetype)initWithURL:(NSURL *)url error:(NSError * __autoreleasing _Nullable *)error {
+    let data = [NSData dataWithContentsOfURL:url options:NSDataReadingMappedIfSafe error:error];
+    if (!data) {
+        return nil;
+    }
+    return [self initWithData:data error:error];
+}
+
+#pragma mark - Packets
+
+- (NSArray<PGPPacket *> *)packets {
+    @synchronized (self) {
+        if (!_packets) {
+            _packets = [ObjectivePGP readPacketsFromData:self.data];
+        }
+        return PGPNN(_packets);
+    }
+}
+
+- (BOOL)isEncrypted {
+    return [self.packets indexOfObjectPassingTest:^BOOL(PGPPacket *packet, NSUInteger idx, BOOL *stop) {
+        return packet.tag == PGPPublicKeyEncryptedSessionKeyPacketTag || packet.tag == PGPSymetricKeyEncryptedSessionKeyPacketTag || packet.tag == PGPSymmetricallyEncryptedDataPacketTag || packet.tag == PGPSymmetricallyEncryptedIntegrityProtectedDataPacketTag;
+    }] != NSNotFound;
+}
+
+- (NSArray<PGPKeyID *> *)recipientKeyIDs {
+    let keyIDs = [NSMutableOrderedSet<PGPKeyID *> orderedSet];
+    for (PGPPacket *packet in self.packets) {
+        let sessionKeyPacket = PGPCast(packet, PGPPublicKeyEncryptedSessionKeyPacket);
+        if (sessionKeyPacket.keyID) {
+            [keyIDs addObject:PGPNN(sessionKeyPacket.keyID)];
+        }
+    }
+    return keyIDs.array;
+}
+
+#pragma mark - Decrypt
+
+- (nullable PGPSessionKey *)sessionKeyUsingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(keys, NSArray);
+
+    // The kept session key goes only to the same unencrypted secret key that decrypted it. A passphrase
+    // protected key is decrypted again, so a wrong passphrase doesn't get it.
+    @synchronized (self) {
+        for (PGPKey *key in keys) {
+            let fingerprintData = key.secretKey.fingerprint.hashedData;
+            if (!fingerprintData || key.isEncryptedWithPassword) {
+                continue;
+            }
+
+            let _Nullable decryptedSessionKey = _decryptedSessionKeys[PGPNN(fingerprintData)];
+            if (decryptedSessionKey && PGPEqualObjects(_sessionKeyDecryptingKeys[PGPNN(fingerprintData)].secretKey, key.secretKey)) {
+                return decryptedSessionKey;
+            }
+        }
+    }
+
+    PGPSymmetricAlgorithm sessionKeyAlgorithm = PGPSymmetricPlaintext;
+    PGPKey * _Nullable decryptingKey = nil;
+    let sessionKeyData = [ObjectivePGP decryptSessionKeyFromPackets:self.packets usingKeys:keys passphrase:passphraseBlock sessionKeyAlgorithm:&sessionKeyAlgorithm decryptingKey:&decryptingKey error:error];
+    let sessionKey = sessionKeyData ? [[PGPSessionKey alloc] initWithAlgorithm:sessionKeyAlgorithm keyData:PGPNN(sessionKeyData)] : nil;
+    if (!sessionKey && error && !*error) {
+        *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Nothing to decrypt or missing private key." }];
+    }
+
+    let decryptingFingerprintData = decryptingKey.secretKey.fingerprint.hashedData;
+    if (sessionKey && decryptingFingerprintData && !decryptingKey.isEncryptedWithPassword) {
+        @synchronized (self) {
+            _decryptedSessionKeys[PGPNN(decryptingFingerprintData)] = sessionKey;
+            _sessionKeyDecryptingKeys[PGPNN(decryptingFingerprintData)] = decryptingKey;
+        }
+    }
+    return sessionKey;
+}
+
+- (nullable NSData *)decryptUsingKeys:(NSArray<PGPKey *> *)keys passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error {
+    PGPSessionKey * _Nullable sessionKey = nil;
+    if (self.isEncrypted) {
+        sessionKey = [self sessionKeyUsingKeys:keys passphraseForKey:passphraseBlock error:error];
+        if (!sessionKey) {
+            return nil;
+        }
+    }
+
+    @synchronized (self) {
+        return [self plaintextDecryptedWithSessionKey:sessionKey error:error];
+    }
+}
+
+- (nullable NSData *)decryptWithSessionKey:(PGPSessionKey *)sessionKey error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(sessionKey, PGPSessionKey);
+
+    @synchronized (self) {
+        return [self plaintextDecryptedWithSessionKey:sessionKey error:error];
+    }
+}
+
+// Whether the decrypted packets and the plaintext are kept for the session key.
+- (BOOL)isDecryptedWithSessionKey:(nullable PGPSessionKey *)sessionKey {
+    return _decryptedPackets && (!self.isEncrypted || PGPEqualObjects(_sessionKey, sessionKey));
+}
+
+// The first literal packet of the decrypted packets.
+- (nullable NSData *)plaintextDecryptedWithSessionKey:(nullable PGPSessionKey *)sessionKey error:(NSError * __autoreleasing _Nullable *)error {
+    if (_plaintextData && [self isDecryptedWithSessionKey:sessionKey]) {
+        return _plaintextData;
+    }
+
+    let decryptedPackets = [self decryptedPacketsWithSessionKey:sessionKey error:error];
+    if (!decryptedPackets) {
+        return nil;
+    }
+
+    let literalPacket = PGPCast([[decryptedPackets pgp_objectsPassingTest:^BOOL(PGPPacket *packet, BOOL *stop) {
+        *stop = packet.tag == PGPLiteralDataPacketTag;
+        return *stop;
+    }] firstObject], PGPLiteralPacket);
+
+    _plaintextData = literalPacket.literalRawData;
+    if (!_plaintextData && error) {
+        *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Missing literal data." }];
+    }
+    return _plaintextData;
+}
+
+- (nullable NSArray<PGPPacket *> *)decryptedPacketsWithSessionKey:(nullable PGPSessionKey *)sessionKey error:(NSError * __autoreleasing _Nullable *)error {
+    if ([self isDecryptedWithSessionKey:sessionKey]) {
+        return _decryptedPackets;
+    }
+
+    if (!self.isEncrypted) {
+        _decryptedPackets = self.packets;
+        return _decryptedPackets;
+    }
+
+    if (!sessionKey) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Missing session key." }];
+        }
+        return nil;
+    }
+
+    NSError *decryptError = nil;
+    let decryptedPackets = [ObjectivePGP decryptPacketsIfNeeded:self.packets usingKeys:@[] passphrase:nil sessionKey:sessionKey decryptedSessionKey:nil error:&decryptError];
+    if (!decryptedPackets || decryptError) {
+        if (error) {
+            *error = decryptError ?: [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt." }];
+        }
+        return nil;
+    }
+
+    _sessionKey = sessionKey;
+    _decryptedPackets = decryptedPackets;
+    _plaintextData = nil;
+    return _decryptedPackets;
+}
+
+#pragma mark - Verify
+
+- (BOOL)verifyUsingKeys:(NSArray<PGPKey *> *)keys certifyWithRootKey:(BOOL)certifyWithRootKey passphraseForKey:(nullable NSString * _Nullable(^NS_NOESCAPE)(PGPKey * _Nullable key))passphraseBlock error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(keys, NSArray);
+
+    @synchronized (self) {
+        if (!_verificationKeys || ![_verificationKeys isEqualToArray:keys] || _verificationCertifyWithRootKey != certifyWithRootKey) {
+            PGPSessionKey * _Nullable sessionKey = nil;
+            if (self.isEncrypted) {
+                sessionKey = [self sessionKeyUsingKeys:keys passphraseForKey:passphraseBlock error:error];
+                if (!sessionKey) {
+                    return NO;
+                }
+            }
+
+            let decryptedPackets = [self decryptedPacketsWithSessionKey:sessionKey error:error];
+            if (!decryptedPackets) {
+                return NO;
+            }
+
+            NSError *verificationError = nil;
+            if (![ObjectivePGP verifyPackets:decryptedPackets usingKeys:keys certifyWithRootKey:certifyWithRootKey passphraseForKey:passphraseBlock error:&verificationError]) {
+                _verificationError = verificationError ?: [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidSignature userInfo:@{ NSLocalizedDescriptionKey: @"Invalid signature." }];
+            } else {
+                _verificationError = nil;
+            }
+            _verificationKeys = [keys copy];
+            _verificationCertifyWithRootKey = certifyWithRootKey;
+        }
+
+        if (_verificationError && error) {
+            *error = [_verificationError copy];
+        }
+        return _verificationError == nil;
+    }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
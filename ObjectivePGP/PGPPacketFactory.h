@@ -15,6 +15,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (nullable PGPPacket *)packetWithData:(NSData *)packetsData offset:(NSUInteger)offset consumedBytes:(nullable NSUInteger *)consumedBytes;
 
+/// Length of the packet at the offset, header included, read from the packet header without copying the body.
+/// Zero if there is no valid packet at the offset.
++ (NSUInteger)lengthOfPacketInData:(NSData *)data offset:(NSUInteger)offset packetTag:(nullable PGPPacketTag *)tag;
+
+/// Offset of the next plausible packet at or after the offset, NSNotFound if there is none.
+/// Candidate headers are validated in place with a bounded lookahead, the scan is linear in the data length.
++ (NSUInteger)offsetOfNextPacketInData:(NSData *)data fromOffset:(NSUInteger)offset;
+
 @end
 
 NS_ASSUME_NONNULL_END
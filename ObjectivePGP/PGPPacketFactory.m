@@ -7,6 +7,7 @@
 //
 
 #import "PGPPacketFactory.h"
+#import "PGPPacketHeader.h"
 #import "PGPPacket+Private.h"
 #import "PGPCompressedPacket.h"
 #import "PGPLiteralPacket.h"
@@ -46,8 +47,7 @@ NS_ASSUME_NONNULL_BEGIN
     PGPPacketTag packetTag = 0;
     UInt32 headerLength = 0;
     BOOL indeterminateLength = NO;
-    let data = [packetData subdataWithRange:(NSRange){offset, packetData.length - offset}];
-    let _Nullable packetBodyData = [PGPPacket readPacketBody:data headerLength:&headerLength consumedBytes:consumedBytes packetTag:&packetTag indeterminateLength:&indeterminateLength];
+    let _Nullable packetBodyData = [PGPPacket readPacketBody:packetData offset:offset headerLength:&headerLength consumedBytes:consumedBytes packetTag:&packetTag indeterminateLength:&indeterminateLength];
     if (!packetBodyData) {
       return nil;
     }
@@ -136,6 +136,152 @@ NS_ASSUME_NONNULL_BEGIN
     return nil;
 }
 
++ (NSUInteger)lengthOfPacketInData:(NSData *)data offset:(NSUInteger)offset packetTag:(nullable PGPPacketTag *)tag {
+    let header = [PGPPacketHeader headerFromData:data offset:offset];
+    let availableLength = data.length - offset;
+    if (!header || (!header.isIndeterminateLength && header.headerLength + header.bodyLength > availableLength)) {
+        return 0;
+    }
+
+    if (tag) {
+        *tag = header.packetTag;
+    }
+
+    if (header.isIndeterminateLength) {
+        return availableLength;
+    }
+
+    if (!header.isPartialLength) {
+        return header.headerLength + header.bodyLength;
+    }
+
+    // Walk the partial body length chunks, as -[PGPPacket readPartialData:offset:consumedBytes:] does
+    NSUInteger position = offset + header.headerLength - 1;
+    BOOL isPartial = YES;
+    while (isPartial && position < data.length) {
+        NSUInteger partBodyLength = 0;
+        UInt8 partLengthOctets = 0;
+        UInt8 lengthOctets[5] = {0, 0, 0, 0, 0};
+        [data getBytes:lengthOctets range:(NSRange){position, MIN(sizeof(lengthOctets), data.length - position)}];
+        [PGPPacketHeader getLengthFromNewFormatOctets:[NSData dataWithBytesNoCopy:lengthOctets length:sizeof(lengthOctets) freeWhenDone:NO] bodyLength:&partBodyLength bytesCount:&partLengthOctets isPartial:&isPartial];
+        partLengthOctets = (UInt8)MIN(partLengthOctets, data.length - position);
+        position = position + partLengthOctets + MIN(partBodyLength, data.length - position - partLengthOctets);
+    }
+    return position - offset;
+}
+
+#pragma mark - Resynchronization
+
+static BOOL PGPPacketFactoryIsKnownTag(UInt8 tag) {
+    return (tag >= PGPPublicKeyEncryptedSessionKeyPacketTag && tag <= PGPPublicSubkeyPacketTag) || (tag >= PGPUserAttributePacketTag && tag <= PGPModificationDetectionCodePacketTag) || (tag >= PGPExperimentalPacketTag1 && tag <= PGPExperimentalPacketTag4);
+}
+
+// Check the packet header at the offset, without copying. Packet length is the length of the whole packet
+// if it's known upfront (not partial and not indeterminate).
+static BOOL PGPPacketFactoryCheckHeader(const UInt8 *bytes, NSUInteger length, NSUInteger offset, NSUInteger *packetLength, BOOL *isDefinite) {
+    *packetLength = 0;
+    *isDefinite = NO;
+
+    let available = length - offset;
+    let headerByte = bytes[offset];
+    if (!(headerByte & PGPHeaderPacketTagAllwaysSet)) {
+        return NO;
+    }
+
+    if (headerByte & PGPHeaderPacketTagNewFormat) {
+        if (!PGPPacketFactoryIsKnownTag(headerByte & 0x3F) || available < 2) {
+            return NO;
+        }
+
+        let firstOctet = bytes[offset + 1];
+        NSUInteger headerLength = 0;
+        NSUInteger bodyLength = 0;
+        if (firstOctet < 192) {
+            headerLength = 2;
+            bodyLength = firstOctet;
+        } else if (firstOctet < 224) {
+            headerLength = 3;
+            if (available < headerLength) {
+                return NO;
+            }
+            bodyLength = ((NSUInteger)(firstOctet - 192) << 8) + bytes[offset + 2] + 192;
+        } else if (firstOctet == 255) {
+            headerLength = 6;
+            if (available < headerLength) {
+                return NO;
+            }
+            bodyLength = ((NSUInteger)bytes[offset + 2] << 24) | ((NSUInteger)bytes[offset + 3] << 16) | ((NSUInteger)bytes[offset + 4] << 8) | (NSUInteger)bytes[offset + 5];
+        } else {
+            // Partial length. The first partial length MUST be at least 512 octets long.
+            bodyLength = (NSUInteger)1 << (firstOctet & 0x1F);
+            return bodyLength >= 512 && 2 + bodyLength <= available;
+        }
+
+        *packetLength = headerLength + bodyLength;
+        *isDefinite = YES;
+        return *packetLength <= available;
+    }
+
+    // Old format
+    if (!PGPPacketFactoryIsKnownTag((headerByte >> 2) & 0x0F)) {
+        return NO;
+    }
+
+    switch (headerByte & 0x03) {
+        case 0:
+            if (available < 2) {
+                return NO;
+            }
+            *packetLength = 2 + (NSUInteger)bytes[offset + 1];
+            break;
+        case 1:
+            if (available < 3) {
+                return NO;
+            }
+            *packetLength = 3 + (((NSUInteger)bytes[offset + 1] << 8) | (NSUInteger)bytes[offset + 2]);
+            break;
+        case 2:
+            if (available < 5) {
+                return NO;
+            }
+            *packetLength = 5 + (((NSUInteger)bytes[offset + 1] << 24) | ((NSUInteger)bytes[offset + 2] << 16) | ((NSUInteger)bytes[offset + 3] << 8) | (NSUInteger)bytes[offset + 4]);
+            break;
+        default:
+            // Indeterminate length, up to the end of data
+            return available > 1;
+    }
+
+    *isDefinite = YES;
+    return *packetLength <= available;
+}
+
++ (NSUInteger)offsetOfNextPacketInData:(NSData *)data fromOffset:(NSUInteger)offset {
+    let bytes = (const UInt8 *)data.bytes;
+    let length = data.length;
+
+    for (NSUInteger position = offset; position < length; position++) {
+        NSUInteger packetLength = 0;
+        BOOL isDefinite = NO;
+        if (!PGPPacketFactoryCheckHeader(bytes, length, position, &packetLength, &isDefinite)) {
+            continue;
+        }
+
+        if (!isDefinite) {
+            return position;
+        }
+
+        // Lookahead one packet: the candidate ends with the data or is followed by a valid header.
+        let nextPosition = position + packetLength;
+        NSUInteger nextPacketLength = 0;
+        BOOL isNextDefinite = NO;
+        if (nextPosition == length || PGPPacketFactoryCheckHeader(bytes, length, nextPosition, &nextPacketLength, &isNextDefinite)) {
+            return position;
+        }
+    }
+
+    return NSNotFound;
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
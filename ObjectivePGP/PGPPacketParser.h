@@ -0,0 +1,75 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMacros.h>
+#import <ObjectivePGP/PGPTypes.h>
+#import <ObjectivePGP/PGPSessionKey.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSUInteger, PGPPacketParserEvent) {
+    /// A packet starts
+    PGPPacketParserEventHeader,
+    /// A chunk of the packet body
+    PGPPacketParserEventBody,
+    /// The packet ends
+    PGPPacketParserEventEnd
+};
+
+/**
+ The packet handler.
+
+ @param event The event.
+ @param tag Tag of the packet.
+ @param depth Nesting level. Packets of a compressed or decrypted packet are one level deeper.
+ @param bodyData Body chunk of `PGPPacketParserEventBody`, `nil` otherwise.
+ */
+typedef void (^PGPPacketParserHandler)(PGPPacketParserEvent event, PGPPacketTag tag, NSUInteger depth, NSData * _Nullable bodyData);
+
+/**
+ Incremental parser of binary OpenPGP data. The data can be fed in chunks of any size.
+
+ The parser keeps the current packet header only: a body chunk is passed to the handler
+ as it arrives. Compressed packets are decompressed, and version 1 encrypted data packets are
+ decrypted if the session key is set; their packets are reported one level deeper instead of the body.
+
+ @note The encrypted data integrity (MDC) is checked at the end of the encrypted data packet. By default the decrypted
+       packets are held back until then, up to `maximumUnverifiedPlaintextLength` octets, and are reported only if
+       the check succeeds. Set `releasesUnverifiedPlaintext` to parse larger encrypted data in bounded memory.
+ */
+NS_SWIFT_NAME(PacketParser) @interface PGPPacketParser : NSObject
+
+/// Optional. Session key to decrypt the encrypted data packets.
+@property (nonatomic, nullable) PGPSessionKey *sessionKey;
+
+/// Decrypted octets held back until the integrity check of an encrypted data packet. Larger encrypted data
+/// fails to parse, unless `releasesUnverifiedPlaintext` is set. Default 16 MiB.
+@property (nonatomic) NSUInteger maximumUnverifiedPlaintextLength;
+
+/**
+ Report the decrypted packets as these are decrypted, before the integrity check. Default NO.
+
+ If the check fails at the end of the encrypted data packet, the parser fails, and the packets
+ reported since the start of the encrypted data packet must be discarded.
+ */
+@property (nonatomic) BOOL releasesUnverifiedPlaintext;
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+- (instancetype)initWithHandler:(PGPPacketParserHandler)handler;
+
+/// Parse the next chunk of data.
+- (BOOL)feedData:(NSData *)data error:(NSError * __autoreleasing _Nullable *)error;
+
+/// End of data. Fails if a packet is incomplete.
+- (BOOL)finish:(NSError * __autoreleasing _Nullable *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,599 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPPacketParser.h"
+#import "PGPPacketHeader.h"
+#import "PGPCryptoCFB.h"
+#import "PGPCryptoUtils.h"
+#import "PGPMacros+Private.h"
+#import "PGPFoundation.h"
+
+#import <openssl/crypto.h>
+#import <openssl/sha.h>
+#import <bzlib.h>
+#import <zlib.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Modification Detection Code packet: header octets 0xD3, 0x14 and the SHA-1 hash
+static const NSUInteger PGPParserMDCPacketLength = 22;
+// Decompression output chunk
+static const NSUInteger PGPParserInflateChunkSize = 64 * 1024;
+// Decrypted data held back until the MDC is verified
+static const NSUInteger PGPParserUnverifiedPlaintextLimit = 16 * 1024 * 1024;
+
+typedef NS_ENUM(NSUInteger, PGPPacketParserState) {
+    PGPPacketParserStateHeader,
+    // Length octets of the next partial body chunk
+    PGPPacketParserStateLength,
+    PGPPacketParserStateBody,
+    PGPPacketParserStateFailed
+};
+
+@interface PGPPacketParser ()
+
+- (instancetype)initWithHandler:(PGPPacketParserHandler)handler depth:(NSUInteger)depth NS_DESIGNATED_INITIALIZER;
+
+@end
+
+static NSError *PGPPacketParserError(NSString *description) {
+    return [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: description }];
+}
+
+// Turns the body of a container packet into the input of the nested packets parser.
+@protocol PGPPacketParserFilter <NSObject>
+
+- (BOOL)processData:(NSData *)data error:(NSError * __autoreleasing _Nullable *)error;
+- (BOOL)finish:(NSError * __autoreleasing _Nullable *)error;
+
+@end
+
+#pragma mark - Compressed Data
+
+// Compressed Data Packet body: algorithm octet, compressed data.
+@interface PGPPacketParserInflater : NSObject <PGPPacketParserFilter>
+
+- (instancetype)initWithParser:(PGPPacketParser *)parser;
+
+@end
+
+@implementation PGPPacketParserInflater {
+    PGPPacketParser *_parser;
+    BOOL _hasAlgorithm;
+    BOOL _initialized;
+    BOOL _streamEnd;
+    PGPCompressionAlgorithm _algorithm;
+    z_stream _zstream;
+    bz_stream _bzstream;
+    NSMutableData *_outputBuffer;
+}
+
+- (instancetype)initWithParser:(PGPPacketParser *)parser {
+    if ((self = [super init])) {
+        _parser = parser;
+        _outputBuffer = [NSMutableData dataWithLength:PGPParserInflateChunkSize];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (!_initialized) {
+        return;
+    }
+
+    switch (_algorithm) {
+        case PGPCompressionZIP:
+        case PGPCompressionZLIB:
+            inflateEnd(&_zstream);
+            break;
+        case PGPCompressionBZIP2:
+            BZ2_bzDecompressEnd(&_bzstream);
+            break;
+        default:
+            break;
+    }
+}
+
+- (BOOL)setUpWithAlgorithm:(PGPCompressionAlgorithm)algorithm error:(NSError * __autoreleasing _Nullable *)error {
+    _algorithm = algorithm;
+    _hasAlgorithm = YES;
+
+    int status = Z_OK;
+    switch (algorithm) {
+        case PGPCompressionUncompressed:
+            return YES;
+        case PGPCompressionZIP:
+            status = inflateInit2(&_zstream, -15);
+            break;
+        case PGPCompressionZLIB:
+            status = inflateInit(&_zstream);
+            break;
+        case PGPCompressionBZIP2:
+            status = BZ2_bzDecompressInit(&_bzstream, 0, 0) == BZ_OK ? Z_OK : Z_STREAM_ERROR;
+            break;
+        default:
+            status = Z_STREAM_ERROR;
+            break;
+    }
+
+    _initialized = status == Z_OK;
+    if (!_initialized) {
+        if (error) {
+            *error = PGPPacketParserError(@"Unable to decompress. Unsupported compression.");
+        }
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL)processData:(NSData *)data error:(NSError * __autoreleasing _Nullable *)error {
+    const UInt8 *bytes = data.bytes;
+    NSUInteger length = data.length;
+    if (!_hasAlgorithm && length > 0) {
+        if (![self setUpWithAlgorithm:bytes[0] error:error]) {
+            return NO;
+        }
+        bytes += 1;
+        length -= 1;
+    }
+    return [self inflateBytes:bytes length:length finish:NO error:error];
+}
+
+- (BOOL)finish:(NSError * __autoreleasing _Nullable *)error {
+    if (!_hasAlgorithm || ![self inflateBytes:NULL length:0 finish:YES error:error]) {
+        if (error && !*error) {
+            *error = PGPPacketParserError(@"Unable to decompress. Unexpected end of data.");
+        }
+        return NO;
+    }
+    return [_parser finish:error];
+}
+
+// Data after the end of the compressed stream is ignored.
+- (BOOL)inflateBytes:(const UInt8 * _Nullable)bytes length:(NSUInteger)length finish:(BOOL)finish error:(NSError * __autoreleasing _Nullable *)error {
+    if (_streamEnd) {
+        return YES;
+    }
+
+    if (_algorithm == PGPCompressionUncompressed) {
+        return length == 0 || [_parser feedData:[NSData dataWithBytes:bytes length:length] error:error];
+    }
+
+    let outputBytes = (UInt8 *)_outputBuffer.mutableBytes;
+    let outputLength = _outputBuffer.length;
+    BOOL isBZIP2 = _algorithm == PGPCompressionBZIP2;
+    if (isBZIP2) {
+        _bzstream.next_in = (char *)bytes;
+        _bzstream.avail_in = (unsigned int)length;
+    } else {
+        _zstream.next_in = (Bytef *)bytes;
+        _zstream.avail_in = (uInt)length;
+    }
+
+    while (YES) {
+        NSUInteger produced = 0;
+        BOOL failed = NO;
+        BOOL progress = YES;
+        if (isBZIP2) {
+            _bzstream.next_out = (char *)outputBytes;
+            _bzstream.avail_out = (unsigned int)outputLength;
+            int status = BZ2_bzDecompress(&_bzstream);
+            produced = outputLength - _bzstream.avail_out;
+            _streamEnd = status == BZ_STREAM_END;
+            failed = status != BZ_OK && status != BZ_STREAM_END;
+            progress = _bzstream.avail_in > 0;
+        } else {
+            _zstream.next_out = outputBytes;
+            _zstream.avail_out = (uInt)outputLength;
+            int status = inflate(&_zstream, finish ? Z_FINISH : Z_NO_FLUSH);
+            produced = outputLength - _zstream.avail_out;
+            _streamEnd = status == Z_STREAM_END;
+            failed = status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR;
+            progress = _zstream.avail_in > 0 && status != Z_BUF_ERROR;
+        }
+
+        if (failed) {
+            if (error) {
+                *error = PGPPacketParserError(@"Unable to decompress. Invalid compressed data.");
+            }
+            return NO;
+        }
+
+        if (produced > 0 && ![_parser feedData:[NSData dataWithBytes:outputBytes length:produced] error:error]) {
+            return NO;
+        }
+
+        // More output may be pending while the output buffer fills up.
+        if (_streamEnd || (produced < outputLength && !progress)) {
+            break;
+        }
+    }
+
+    return !finish || _streamEnd;
+}
+
+@end
+
+#pragma mark - Encrypted Data
+
+// Symmetrically Encrypted Integrity Protected Data Packet, version 1: version octet, CFB encrypted
+// prefix, packets and the MDC packet. The packets are held back until the MDC is verified, up to the
+// plaintext limit, or passed on as decrypted if the plaintext is released.
+@interface PGPPacketParserDecryptor : NSObject <PGPPacketParserFilter>
+
+- (instancetype)initWithParser:(PGPPacketParser *)parser sessionKey:(PGPSessionKey *)sessionKey plaintextLimit:(NSUInteger)plaintextLimit releasesPlaintext:(BOOL)releasesPlaintext;
+
+@end
+
+@implementation PGPPacketParserDecryptor {
+    PGPPacketParser *_parser;
+    PGPSessionKey *_sessionKey;
+    NSUInteger _blockSize;
+    NSUInteger _plaintextLimit;
+    BOOL _releasesPlaintext;
+    BOOL _hasVersion;
+    // Previous ciphertext block
+    NSData *_ivData;
+    // Ciphertext shorter than a block
+    NSMutableData *_pendingCiphertext;
+    NSMutableData *_prefixData;
+    // Decrypted packets, not verified yet
+    NSMutableData *_plaintextData;
+    // Last plaintext octets, the MDC packet at the end of data
+    NSMutableData *_trailerData;
+    SHA_CTX _sha;
+}
+
+- (instancetype)initWithParser:(PGPPacketParser *)parser sessionKey:(PGPSessionKey *)sessionKey plaintextLimit:(NSUInteger)plaintextLimit releasesPlaintext:(BOOL)releasesPlaintext {
+    if ((self = [super init])) {
+        _parser = parser;
+        _sessionKey = sessionKey;
+        _plaintextLimit = plaintextLimit;
+        _releasesPlaintext = releasesPlaintext;
+        _blockSize = [PGPCryptoUtils blockSizeOfSymmetricAlhorithm:sessionKey.algorithm];
+        // The Initial Vector (IV) is specified as all zeros.
+        _ivData = [NSMutableData dataWithLength:_blockSize];
+        _pendingCiphertext = [NSMutableData data];
+        _prefixData = [NSMutableData data];
+        _plaintextData = [NSMutableData data];
+        _trailerData = [NSMutableData data];
+        SHA1_Init(&_sha);
+    }
+    return self;
+}
+
+- (BOOL)processData:(NSData *)data error:(NSError * __autoreleasing _Nullable *)error {
+    const UInt8 *bytes = data.bytes;
+    NSUInteger length = data.length;
+    if (!_hasVersion && length > 0) {
+        if (bytes[0] != 1) {
+            if (error) {
+                *error = PGPPacketParserError(@"Unable to decrypt. Only version 1 encrypted data can be parsed incrementally.");
+            }
+            return NO;
+        }
+        _hasVersion = YES;
+        bytes += 1;
+        length -= 1;
+    }
+
+    // Whole blocks only, the next block decrypts with the last ciphertext block.
+    [_pendingCiphertext appendBytes:bytes length:length];
+    let blocksLength = _pendingCiphertext.length - _pendingCiphertext.length % _blockSize;
+    if (blocksLength == 0) {
+        return YES;
+    }
+
+    let ciphertext = [_pendingCiphertext subdataWithRange:(NSRange){0, blocksLength}];
+    [_pendingCiphertext replaceBytesInRange:(NSRange){0, blocksLength} withBytes:NULL length:0];
+    return [self decryptCiphertext:ciphertext error:error];
+}
+
+- (BOOL)finish:(NSError * __autoreleasing _Nullable *)error {
+    if (_pendingCiphertext.length > 0 && ![self decryptCiphertext:_pendingCiphertext error:error]) {
+        return NO;
+    }
+
+    // The hash covers the prefix, the packets and the two octets of the MDC packet header.
+    UInt8 hash[SHA_DIGEST_LENGTH];
+    let trailerBytes = (const UInt8 *)_trailerData.bytes;
+    BOOL isValid = _prefixData.length == _blockSize + 2 && _trailerData.length == PGPParserMDCPacketLength && trailerBytes[0] == 0xD3 && trailerBytes[1] == 0x14;
+    if (isValid) {
+        SHA1_Update(&_sha, trailerBytes, 2);
+        SHA1_Final(hash, &_sha);
+        isValid = CRYPTO_memcmp(hash, trailerBytes + 2, SHA_DIGEST_LENGTH) == 0;
+    }
+
+    if (!isValid) {
+        if (error) {
+            *error = PGPPacketParserError(@"Unable to decrypt. Validation failed. Content modification detected.");
+        }
+        return NO;
+    }
+
+    if (_plaintextData.length > 0 && ![_parser feedData:_plaintextData error:error]) {
+        return NO;
+    }
+    return [_parser finish:error];
+}
+
+- (BOOL)decryptCiphertext:(NSData *)ciphertext error:(NSError * __autoreleasing _Nullable *)error {
+    let plaintext = [PGPCryptoCFB decryptData:ciphertext sessionKeyData:_sessionKey.keyData symmetricAlgorithm:_sessionKey.algorithm iv:_ivData syncCFB:NO];
+    if (plaintext.length != ciphertext.length) {
+        if (error) {
+            *error = PGPPacketParserError(@"Unable to decrypt.");
+        }
+        return NO;
+    }
+    if (ciphertext.length >= _blockSize) {
+        _ivData = [ciphertext subdataWithRange:(NSRange){ciphertext.length - _blockSize, _blockSize}];
+    }
+
+    // Hold back the octets that may be the MDC packet
+    let data = [NSMutableData dataWithData:_trailerData];
+    [data appendData:PGPNN(plaintext)];
+    let availableLength = data.length > PGPParserMDCPacketLength ? data.length - PGPParserMDCPacketLength : 0;
+    _trailerData = [[data subdataWithRange:(NSRange){availableLength, data.length - availableLength}] mutableCopy];
+    if (availableLength == 0) {
+        return YES;
+    }
+
+    let bytes = (const UInt8 *)data.bytes;
+    SHA1_Update(&_sha, bytes, availableLength);
+
+    // The prefix is random block followed by a copy of its last two octets.
+    NSUInteger position = 0;
+    if (_prefixData.length < _blockSize + 2) {
+        position = MIN(_blockSize + 2 - _prefixData.length, availableLength);
+        [_prefixData appendBytes:bytes length:position];
+        let prefixBytes = (const UInt8 *)_prefixData.bytes;
+        if (_prefixData.length == _blockSize + 2 && memcmp(prefixBytes + _blockSize - 2, prefixBytes + _blockSize, 2) != 0) {
+            if (error) {
+                *error = PGPPacketParserError(@"Unable to decrypt. Validation failed. Random suffix mismatch.");
+            }
+            return NO;
+        }
+    }
+
+    let plaintextLength = availableLength - position;
+    if (_releasesPlaintext) {
+        return plaintextLength == 0 || [_parser feedData:[NSData dataWithBytes:bytes + position length:plaintextLength] error:error];
+    }
+
+    if (_plaintextData.length + plaintextLength > _plaintextLimit) {
+        if (error) {
+            *error = PGPPacketParserError(@"Unable to decrypt. Encrypted data too large to verify before parsing.");
+        }
+        return NO;
+    }
+    [_plaintextData appendBytes:bytes + position length:plaintextLength];
+    return YES;
+}
+
+@end
+
+#pragma mark - Parser
+
+@implementation PGPPacketParser {
+    PGPPacketParserHandler _handler;
+    NSUInteger _depth;
+    PGPPacketParserState _state;
+    // Header octets, or the partial body length octets
+    UInt8 _headerBytes[6];
+    NSUInteger _headerCount;
+    PGPPacketTag _tag;
+    NSUInteger _bodyRemaining;
+    BOOL _partialLength;
+    BOOL _indeterminateLength;
+    id<PGPPacketParserFilter> _Nullable _filter;
+}
+
+- (instancetype)initWithHandler:(PGPPacketParserHandler)handler {
+    return [self initWithHandler:handler depth:0];
+}
+
+- (instancetype)initWithHandler:(PGPPacketParserHandler)handler depth:(NSUInteger)depth {
+    NSParameterAssert(handler);
+
+    if ((self = [super init])) {
+        _handler = [handler copy];
+        _depth = depth;
+        _state = PGPPacketParserStateHeader;
+        _maximumUnverifiedPlaintextLength = PGPParserUnverifiedPlaintextLimit;
+    }
+    return self;
+}
+
+- (BOOL)feedData:(NSData *)data error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(data, NSData);
+
+    let bytes = (const UInt8 *)data.bytes;
+    NSUInteger position = 0;
+    while (position < data.length) {
+        switch (_state) {
+            case PGPPacketParserStateHeader: {
+                _headerBytes[_headerCount++] = bytes[position++];
+                let headerLength = [self headerLength];
+                if (headerLength == 0) {
+                    return [self failWithError:PGPPacketParserError(@"Invalid packet header.") error:error];
+                }
+                if (_headerCount == headerLength && ![self startPacket:error]) {
+                    return [self failWithError:nil error:error];
+                }
+            } break;
+            case PGPPacketParserStateLength: {
+                _headerBytes[_headerCount++] = bytes[position++];
+                if (_headerCount == [self lengthOctetsCount]) {
+                    let lengthOctets = [NSData dataWithBytes:_headerBytes length:sizeof(_headerBytes)];
+                    UInt8 bytesCount = 0;
+                    _partialLength = NO;
+                    [PGPPacketHeader getLengthFromNewFormatOctets:lengthOctets bodyLength:&_bodyRemaining bytesCount:&bytesCount isPartial:&_partialLength];
+                    _headerCount = 0;
+                    _state = PGPPacketParserStateBody;
+                    if (_bodyRemaining == 0 && ![self endChunk:error]) {
+                        return [self failWithError:nil error:error];
+                    }
+                }
+            } break;
+            case PGPPacketParserStateBody: {
+                let length = _indeterminateLength ? data.length - position : MIN(_bodyRemaining, data.length - position);
+                let bodyData = [data subdataWithRange:(NSRange){position, length}];
+                position += length;
+                if (!_indeterminateLength) {
+                    _bodyRemaining -= length;
+                }
+
+                if (!_filter) {
+                    _handler(PGPPacketParserEventBody, _tag, _depth, bodyData);
+                } else if (![_filter processData:bodyData error:error]) {
+                    return [self failWithError:nil error:error];
+                }
+
+                if (!_indeterminateLength && _bodyRemaining == 0 && ![self endChunk:error]) {
+                    return [self failWithError:nil error:error];
+                }
+            } break;
+            case PGPPacketParserStateFailed:
+                return [self failWithError:PGPPacketParserError(@"Unable to parse. The parser failed earlier.") error:error];
+        }
+    }
+    return YES;
+}
+
+- (BOOL)finish:(NSError * __autoreleasing _Nullable *)error {
+    if (_state == PGPPacketParserStateHeader && _headerCount == 0) {
+        return YES;
+    }
+
+    // Indeterminate length packet ends with the data
+    if (_state == PGPPacketParserStateBody && _indeterminateLength) {
+        return [self endPacket:error] || [self failWithError:nil error:error];
+    }
+
+    return [self failWithError:PGPPacketParserError(@"Unexpected end of data. Incomplete packet.") error:error];
+}
+
+#pragma mark - Private
+
+- (BOOL)failWithError:(nullable NSError *)failError error:(NSError * __autoreleasing _Nullable *)error {
+    _state = PGPPacketParserStateFailed;
+    _filter = nil;
+    if (failError && error) {
+        *error = failError;
+    }
+    return NO;
+}
+
+// Length of the header, known from the first octets. 0 if invalid.
+- (NSUInteger)headerLength {
+    let headerByte = _headerBytes[0];
+    if (!(headerByte & PGPHeaderPacketTagAllwaysSet)) {
+        return 0;
+    }
+
+    if (headerByte & PGPHeaderPacketTagNewFormat) {
+        if (_headerCount < 2) {
+            return 2;
+        }
+        return 1 + [self lengthOctetsCountForFirstOctet:_headerBytes[1]];
+    }
+
+    //  Bits 1-0 -- length-type
+    switch (headerByte & 0x03) {
+        case 0:
+            return 2;
+        case 1:
+            return 3;
+        case 2:
+            return 5;
+        default:
+            return 1;
+    }
+}
+
+- (NSUInteger)lengthOctetsCount {
+    return [self lengthOctetsCountForFirstOctet:_headerBytes[0]];
+}
+
+// 4.2.2. New Format Packet Lengths
+- (NSUInteger)lengthOctetsCountForFirstOctet:(UInt8)octet {
+    if (octet < 192) {
+        return 1;
+    } else if (octet < 224) {
+        return 2;
+    } else if (octet < 255) {
+        return 1;
+    }
+    return 5;
+}
+
+- (BOOL)startPacket:(NSError * __autoreleasing _Nullable *)error {
+    let headerData = [NSMutableData dataWithLength:sizeof(_headerBytes)];
+    [headerData replaceBytesInRange:(NSRange){0, _headerCount} withBytes:_headerBytes];
+    let header = (_headerBytes[0] & PGPHeaderPacketTagNewFormat) ? [PGPPacketHeader newFormatHeaderFromData:headerData] : [PGPPacketHeader oldFormatHeaderFromData:headerData];
+    if (!header) {
+        if (error) {
+            *error = PGPPacketParserError(@"Invalid packet header.");
+        }
+        return NO;
+    }
+
+    _tag = header.packetTag;
+    _bodyRemaining = header.isIndeterminateLength ? 0 : header.bodyLength;
+    _partialLength = header.isPartialLength;
+    _indeterminateLength = header.isIndeterminateLength;
+    _headerCount = 0;
+    _state = PGPPacketParserStateBody;
+    _handler(PGPPacketParserEventHeader, _tag, _depth, nil);
+
+    // Nested packets of the container packets
+    if (_tag == PGPCompressedDataPacketTag) {
+        _filter = [[PGPPacketParserInflater alloc] initWithParser:[self nestedParser]];
+    } else if (_tag == PGPSymmetricallyEncryptedIntegrityProtectedDataPacketTag && self.sessionKey) {
+        _filter = [[PGPPacketParserDecryptor alloc] initWithParser:[self nestedParser] sessionKey:PGPNN(self.sessionKey) plaintextLimit:self.maximumUnverifiedPlaintextLength releasesPlaintext:self.releasesUnverifiedPlaintext];
+    }
+
+    if (!_indeterminateLength && _bodyRemaining == 0) {
+        return [self endChunk:error];
+    }
+    return YES;
+}
+
+- (PGPPacketParser *)nestedParser {
+    let parser = [[PGPPacketParser alloc] initWithHandler:_handler depth:_depth + 1];
+    parser.sessionKey = self.sessionKey;
+    parser.maximumUnverifiedPlaintextLength = self.maximumUnverifiedPlaintextLength;
+    parser.releasesUnverifiedPlaintext = self.releasesUnverifiedPlaintext;
+    return parser;
+}
+
+- (BOOL)endChunk:(NSError * __autoreleasing _Nullable *)error {
+    if (_partialLength) {
+        _headerCount = 0;
+        _state = PGPPacketParserStateLength;
+        return YES;
+    }
+    return [self endPacket:error];
+}
+
+- (BOOL)endPacket:(NSError * __autoreleasing _Nullable *)error {
+    let filter = _filter;
+    _filter = nil;
+    if (filter && ![filter finish:error]) {
+        return NO;
+    }
+
+    _headerCount = 0;
+    _state = PGPPacketParserStateHeader;
+    _handler(PGPPacketParserEventEnd, _tag, _depth, nil);
+    return YES;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
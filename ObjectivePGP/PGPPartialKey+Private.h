@@ -10,6 +10,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class PGPKeyProfile;
+
 @interface PGPPartialKey ()
 
 @property (nonatomic, readwrite) PGPKeyType type;
@@ -17,10 +19,27 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, copy, readwrite) NSArray<PGPSignaturePacket *> *directSignatures;
 @property (nonatomic, nullable, copy, readwrite) PGPSignaturePacket *revocationSignature;
 
+/// Capabilities and preferences of the key, computed on first access, and again after the packets of the key changed.
+@property (nonatomic, readonly) PGPKeyProfile *profile;
+
+/// YES until the user packets are parsed on first access of `users`.
+@property (nonatomic, readonly) BOOL hasUnparsedUsers;
+
+/// Key of the packets. The user packets, at the ranges of the data, are parsed and their signatures verified on first access of `users`.
+- (instancetype)initWithPackets:(NSArray<PGPPacket *> *)packets userPacketsData:(NSData *)userPacketsData ranges:(NSArray<NSValue *> *)userPacketRanges;
+
 - (void)loadPackets:(NSArray<PGPPacket *> *)packets NS_REQUIRES_SUPER;
 
 - (nullable PGPSignaturePacket *)primaryUserSelfCertificate;
 
+/// Compute the profile again on next access. Call after the signatures of the key changed in place.
+- (void)invalidateProfile;
+
+/// YES if the binding signature of the subkey is valid.
+- (BOOL)isSubKeyBound:(PGPPartialSubKey *)subKey;
+/// YES if the subkey is bound, allowed to sign, and has a valid primary key binding signature.
+- (BOOL)canSubKeySign:(PGPPartialSubKey *)subKey;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -66,6 +66,8 @@ PGP_EMPTY_INIT_UNAVAILABLE;
 - (NSArray<PGPPacket *> *)allKeyPackets;
 - (PGPSymmetricAlgorithm)preferredSymmetricAlgorithm;
 + (PGPSymmetricAlgorithm)preferredSymmetricAlgorithmForKeys:(NSArray<PGPPartialKey *> *)keys;
+/// YES if every key advertise the feature (Features subpacket of the primary user self-certificate).
++ (BOOL)isFeature:(PGPFeature)feature supportedByKeys:(NSArray<PGPPartialKey *> *)keys;
 
 -(instancetype)copyWithZone:(nullable NSZone *)zone NS_REQUIRES_SUPER;
 
@@ -14,13 +14,17 @@
 #import "PGPSecretKeyPacket.h"
 #import "PGPSecretSubKeyPacket.h"
 #import "PGPSignaturePacket.h"
+#import "PGPSignaturePacket+Private.h"
 #import "PGPSignatureSubpacket.h"
 #import "PGPPartialSubKey.h"
 #import "PGPPartialSubKey+Private.h"
+#import "PGPKeyProfile.h"
+#import "PGPKeyValidator.h"
 #import "PGPUser.h"
 #import "PGPUser+Private.h"
 #import "PGPUserAttributePacket.h"
 #import "PGPUserAttributeSubpacket.h"
+#import "PGPPacketFactory.h"
 #import "PGPMacros+Private.h"
 #import "PGPFoundation.h"
 #import "NSMutableData+PGPUtils.h"
@@ -29,7 +33,14 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@implementation PGPPartialKey
+@implementation PGPPartialKey {
+    // Packets of the users, parsed on first access.
+    NSData * _Nullable _userPacketsData;
+    NSArray<NSValue *> * _Nullable _userPacketRanges;
+    PGPKeyProfile * _Nullable _profile;
+}
+
+@synthesize users = _users;
 
 - (instancetype)initWithPackets:(NSArray<PGPPacket *> *)packets {
     if ((self = [super init])) {
@@ -41,12 +52,101 @@ NS_ASSUME_NONNULL_BEGIN
     return self;
 }
 
+- (instancetype)initWithPackets:(NSArray<PGPPacket *> *)packets userPacketsData:(NSData *)userPacketsData ranges:(NSArray<NSValue *> *)userPacketRanges {
+    if ((self = [self initWithPackets:packets])) {
+        if (userPacketRanges.count > 0) {
+            _userPacketsData = [userPacketsData copy];
+            _userPacketRanges = [userPacketRanges copy];
+        }
+    }
+    return self;
+}
+
 - (NSString *)description {
     return [NSString stringWithFormat:@"%@, primaryKeyPacket: %@", [super description], self.primaryKeyPacket];
 }
 
 #pragma mark - Properties
 
+- (NSArray<PGPUser *> *)users {
+    @synchronized (self) {
+        if (_userPacketRanges) {
+            // Parse the user packets on first access.
+            let userPacketsData = PGPNN(_userPacketsData);
+            let userPacketRanges = PGPNN(_userPacketRanges);
+            _userPacketsData = nil;
+            _userPacketRanges = nil;
+
+            let userPackets = [NSMutableArray<PGPPacket *> arrayWithCapacity:userPacketRanges.count];
+            for (NSValue *rangeValue in userPacketRanges) {
+                NSUInteger consumedBytes = 0;
+                [userPackets pgp_addObject:[PGPPacketFactory packetWithData:userPacketsData offset:rangeValue.rangeValue.location consumedBytes:&consumedBytes]];
+            }
+            [self loadPackets:userPackets];
+            [PGPKeyValidator validateUsers:_users ofPartialKey:self];
+        }
+        return _users;
+    }
+}
+
+- (BOOL)hasUnparsedUsers {
+    @synchronized (self) {
+        return _userPacketRanges != nil;
+    }
+}
+
+- (void)setUsers:(NSArray<PGPUser *> *)users {
+    @synchronized (self) {
+        _userPacketsData = nil;
+        _userPacketRanges = nil;
+        _users = [users copy];
+        _profile = nil;
+    }
+}
+
+- (void)setPrimaryKeyPacket:(PGPPacket *)primaryKeyPacket {
+    @synchronized (self) {
+        _primaryKeyPacket = [primaryKeyPacket copy];
+        _profile = nil;
+    }
+}
+
+- (void)setSubKeys:(NSArray<PGPPartialSubKey *> *)subKeys {
+    @synchronized (self) {
+        _subKeys = [subKeys copy];
+        _profile = nil;
+    }
+}
+
+- (void)setDirectSignatures:(NSArray<PGPSignaturePacket *> *)directSignatures {
+    @synchronized (self) {
+        _directSignatures = [directSignatures copy];
+        _profile = nil;
+    }
+}
+
+- (void)setRevocationSignature:(nullable PGPSignaturePacket *)revocationSignature {
+    @synchronized (self) {
+        _revocationSignature = [revocationSignature copy];
+        _profile = nil;
+    }
+}
+
+- (PGPKeyProfile *)profile {
+    @synchronized (self) {
+        if (!_profile) {
+            _profile = [[PGPKeyProfile alloc] initWithPartialKey:self];
+        }
+        return PGPNN(_profile);
+    }
+}
+
+- (void)invalidateProfile {
+    @synchronized (self) {
+        _profile = nil;
+    }
+}
+
 - (PGPKeyID *)keyID {
     let primaryKeyPacket = PGPCast(self.primaryKeyPacket, PGPPublicKeyPacket);
     NSParameterAssert(primaryKeyPacket);
@@ -78,7 +178,7 @@ NS_ASSUME_NONNULL_BEGIN
 
     for (PGPPartialSubKey *subKey in self.subKeys) {
         let _Nullable bindingSignaturePacket = subKey.bindingSignature;
-        if (!bindingSignaturePacket.isExpired && bindingSignaturePacket && PGPEqualObjects(bindingSignaturePacket.issuerKeyID,self.keyID)) {
+        if (!bindingSignaturePacket.isExpired && [self isSubKeyBound:subKey] && PGPEqualObjects(bindingSignaturePacket.issuerKeyID,self.keyID)) {
             // key expiration
             // PGPSignatureSubpacketTypeKeyExpirationTime - This can be found on a self-signature.
             // A self-signature is a binding signature made by the key to which the signature refers.
@@ -119,11 +219,29 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (void)loadPackets:(NSArray<PGPPacket *> *)packets {
-    PGPKeyID *primaryKeyID;
+    PGPKeyID * _Nullable primaryKeyID = PGPCast(self.primaryKeyPacket, PGPPublicKeyPacket).keyID;
     PGPPartialSubKey *subKey;
 
+    // Collected, then set at once.
+    let users = [NSMutableArray<PGPUser *> arrayWithArray:_users];
+    let subKeys = [NSMutableArray<PGPPartialSubKey *> arrayWithArray:self.subKeys];
+    let directSignatures = [NSMutableArray<PGPSignaturePacket *> arrayWithArray:self.directSignatures];
+
     // Current "context" user. The last parsed user packet.
-    PGPUser *user;
+    __block PGPUser *user;
+    let selfCertifications = [NSMutableArray<PGPSignaturePacket *> array];
+    let otherSignatures = [NSMutableArray<PGPSignaturePacket *> array];
+    let revocationSignatures = [NSMutableArray<PGPSignaturePacket *> array];
+    let finishUser = ^{
+        if (user) {
+            user.selfCertifications = [user.selfCertifications arrayByAddingObjectsFromArray:selfCertifications];
+            user.otherSignatures = [user.otherSignatures arrayByAddingObjectsFromArray:otherSignatures];
+            user.revocationSignatures = [user.revocationSignatures arrayByAddingObjectsFromArray:revocationSignatures];
+        }
+        [selfCertifications removeAllObjects];
+        [otherSignatures removeAllObjects];
+        [revocationSignatures removeAllObjects];
+    };
 
     for (PGPPacket *packet in packets) {
         switch (packet.tag) {
@@ -144,19 +262,17 @@ NS_ASSUME_NONNULL_BEGIN
                 user.userAttribute = PGPCast(packet, PGPUserAttributePacket);
                 break;
             case PGPUserIDPacketTag: {
+                finishUser();
                 let parsedUser = [[PGPUser alloc] initWithUserIDPacket:PGPCast(packet, PGPUserIDPacket)];
                 user = parsedUser;
-                self.users = [self.users arrayByAddingObject:parsedUser];
+                [users addObject:parsedUser];
             } break;
             case PGPPublicSubkeyPacketTag:
-                user = nil;
-                subKey = [[PGPPartialSubKey alloc] initWithPacket:packet];
-                self.subKeys = [self.subKeys arrayByAddingObject:subKey];
-                break;
             case PGPSecretSubkeyPacketTag:
+                finishUser();
                 user = nil;
                 subKey = [[PGPPartialSubKey alloc] initWithPacket:packet];
-                self.subKeys = [self.subKeys arrayByAddingObject:subKey];
+                [subKeys addObject:subKey];
                 break;
             case PGPSignaturePacketTag: {
                 let signaturePacket = PGPCast(packet, PGPSignaturePacket);
@@ -170,31 +286,30 @@ NS_ASSUME_NONNULL_BEGIN
                             continue;
                         }
                         if (PGPEqualObjects(signaturePacket.issuerKeyID,primaryKeyID)) {
-                            user.selfCertifications = [user.selfCertifications arrayByAddingObject:signaturePacket];
+                            [selfCertifications addObject:signaturePacket];
                         } else {
-                            user.otherSignatures = [user.otherSignatures arrayByAddingObject:signaturePacket];
+                            [otherSignatures addObject:signaturePacket];
                         }
                         break;
                     case PGPSignatureCertificationRevocation:
                         if (user) {
-                            user.revocationSignatures = [user.revocationSignatures arrayByAddingObject:signaturePacket];
+                            [revocationSignatures addObject:signaturePacket];
                         } else {
-                            self.directSignatures = [self.directSignatures arrayByAddingObject:signaturePacket];
+                            [directSignatures addObject:signaturePacket];
                         }
                         break;
                     case PGPSignatureDirectlyOnKey:
-                        self.directSignatures = [self.directSignatures arrayByAddingObject:signaturePacket];
+                        [directSignatures addObject:signaturePacket];
                         break;
                     case PGPSignatureSubkeyBinding:
                         if (!subKey) {
                             continue;
                         }
 
-                        // TODO: check embedded signature "PGPSignaturePrimaryKeyBinding"
                         // A signature that binds a signing subkey MUST have
                         // an Embedded Signature subpacket in this binding signature that
                         // contains a 0x19 signature made by the signing subkey on the
-                        // primary key and subkey.
+                        // primary key and subkey. Verified by PGPKeyValidator, see canSubKeySign:.
 
                         subKey.bindingSignature = PGPCast(packet, PGPSignaturePacket);
                         break;
@@ -215,6 +330,11 @@ NS_ASSUME_NONNULL_BEGIN
                 break;
         }
     }
+    finishUser();
+
+    _users = users;
+    self.subKeys = subKeys;
+    self.directSignatures = directSignatures;
 }
 
 // signature packet that is available for signing data
@@ -227,19 +347,11 @@ NS_ASSUME_NONNULL_BEGIN
         return nil;
     }
 
-    // Favor subkey over primary key.
-    // check subkeys, by default first check the subkeys
-    for (PGPPartialSubKey *subKey in self.subKeys) {
-        PGPSignaturePacket *signaturePacket = subKey.bindingSignature;
-        if (signaturePacket.canBeUsedToSign) {
-            return subKey.primaryKeyPacket;
-        }
-    }
-
-    // check primary user self certificates
-    let _Nullable primaryUserSelfCertificate = self.primaryUserSelfCertificate;
-    if (primaryUserSelfCertificate && primaryUserSelfCertificate.canBeUsedToSign) {
-        return self.primaryKeyPacket;
+    // Favor subkey over primary key. Not a revoked or expired key.
+    let profile = self.profile;
+    let _Nullable signingKeyPacket = profile.signingKeyPackets.firstObject;
+    if (signingKeyPacket || profile.isRevoked || profile.isExpired) {
+        return signingKeyPacket;
     }
 
     // By convention, the top-level key provides signature services
@@ -248,21 +360,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 // signature packet that is available for verifying signature with a keyID
 - (nullable PGPPacket *)signingKeyPacketWithKeyID:(PGPKeyID *)keyID {
-    for (PGPPartialSubKey *subKey in self.subKeys) {
-        if (PGPEqualObjects(subKey.keyID,keyID)) {
-            PGPSignaturePacket *signaturePacket = subKey.bindingSignature;
-            if (signaturePacket.canBeUsedToSign) {
-                return subKey.primaryKeyPacket;
-            }
-        }
-    }
-
-    // check primary user self certificates
-    let _Nullable primaryUserSelfCertificate = self.primaryUserSelfCertificate;
-    if (primaryUserSelfCertificate && PGPEqualObjects(self.keyID,keyID)) {
-        if (primaryUserSelfCertificate.canBeUsedToSign) {
-            return self.primaryKeyPacket;
-        }
+    // The signature may be made before the key expired.
+    let _Nullable signingKeyPacket = [self.profile signingKeyPacketWithKeyID:keyID];
+    if (signingKeyPacket) {
+        return signingKeyPacket;
     }
 
     // By convention, the top-level key provides signature services
@@ -282,7 +383,7 @@ NS_ASSUME_NONNULL_BEGIN
 
     for (PGPPartialSubKey *subKey in self.subKeys) {
         let bindingSignature = subKey.bindingSignature;
-        if (bindingSignature.canBeUsedToEncrypt) {
+        if (bindingSignature.canBeUsedToEncrypt && [self isSubKeyBound:subKey]) {
             return subKey.primaryKeyPacket;
         }
     }
@@ -296,8 +397,11 @@ NS_ASSUME_NONNULL_BEGIN
     // v3 keys MUST NOT have subkeys
     if (PGPCast(self.primaryKeyPacket, PGPPublicKeyPacket).version >= 0x04) {
         // 5.5.1.2. If not specified otherwise,
-        // By convention, the subkeys provide encryption services.
-        return PGPCast(self.subKeys.firstObject.primaryKeyPacket, PGPPublicSubKeyPacket);;
+        // By convention, the subkeys provide encryption services. Only a subkey with a valid binding signature.
+        let _Nullable subKey = [[self.subKeys pgp_objectsPassingTest:^BOOL(PGPPartialSubKey *candidate, BOOL *stop) {
+            return [self isSubKeyBound:candidate];
+        }] firstObject];
+        return PGPCast(subKey.primaryKeyPacket, PGPPublicSubKeyPacket);
     }
 
     if (error) {
@@ -307,6 +411,28 @@ NS_ASSUME_NONNULL_BEGIN
     return nil;
 }
 
+// The binding signature is verified with the key, if it wasn't verified on import.
+- (BOOL)isSubKeyBound:(PGPPartialSubKey *)subKey {
+    let _Nullable bindingSignature = subKey.bindingSignature;
+    if (!bindingSignature) {
+        return NO;
+    }
+    if (bindingSignature.validity == PGPSignatureValidityUnknown) {
+        [PGPKeyValidator validatePartialKeys:@[self]];
+    }
+    return bindingSignature.validity == PGPSignatureValidityValid;
+}
+
+// 5.2.1. A signing subkey is bound by the primary key binding signature (0x19) made by the subkey, too.
+- (BOOL)canSubKeySign:(PGPPartialSubKey *)subKey {
+    let _Nullable bindingSignature = subKey.bindingSignature;
+    if (!bindingSignature.canBeUsedToSign || ![self isSubKeyBound:subKey]) {
+        return NO;
+    }
+    let _Nullable backSignature = [PGPKeyValidator backSignatureOfBindingSignature:PGPNN(bindingSignature)];
+    return backSignature.validity == PGPSignatureValidityValid;
+}
+
 - (nullable PGPSecretKeyPacket *)decryptionPacketForKeyID:(PGPKeyID *)keyID error:(NSError * __autoreleasing _Nullable *)error {
     NSAssert(self.type == PGPKeyTypeSecret, @"Need secret key to encrypt");
     if (self.type != PGPKeyTypeSecret) {
@@ -389,19 +515,35 @@ NS_ASSUME_NONNULL_BEGIN
 - (BOOL)isEqualToPartialKey:(PGPPartialKey *)other {
     return self.type == other.type &&
            PGPEqualObjects(self.primaryKeyPacket, other.primaryKeyPacket) &&
-           PGPEqualObjects(self.users, other.users) &&
+           [self isEqualUsersOfPartialKey:other] &&
            PGPEqualObjects(self.subKeys, other.subKeys) &&
            PGPEqualObjects(self.directSignatures, other.directSignatures) &&
            PGPEqualObjects(self.revocationSignature, other.revocationSignature);
 }
 
+// Unparsed users are compared by the data of their packets, so these are not parsed.
+- (BOOL)isEqualUsersOfPartialKey:(PGPPartialKey *)other {
+    NSData *userPacketsData;
+    NSData *otherUserPacketsData;
+    @synchronized (self) {
+        userPacketsData = _userPacketsData;
+    }
+    @synchronized (other) {
+        otherUserPacketsData = other->_userPacketsData;
+    }
+    if (userPacketsData && otherUserPacketsData) {
+        return PGPEqualObjects(userPacketsData, otherUserPacketsData);
+    }
+    return PGPEqualObjects(self.users, other.users);
+}
+
+// Not the users, so these are not parsed.
 - (NSUInteger)hash {
     NSUInteger prime = 31;
     NSUInteger result = 1;
 
     result = prime * result + self.type;
     result = prime * result + self.primaryKeyPacket.hash;
-    result = prime * result + self.users.hash;
     result = prime * result + self.subKeys.hash;
     result = prime * result + self.directSignatures.hash;
     result = prime * result + self.revocationSignature.hash;
@@ -417,7 +559,12 @@ NS_ASSUME_NONNULL_BEGIN
 
     partialKey.type = self.type;
     partialKey.primaryKeyPacket = self.primaryKeyPacket;
-    partialKey.users = [[NSArray alloc] initWithArray:self.users copyItems:YES];
+    // Unparsed users stay unparsed in the copy.
+    @synchronized (self) {
+        partialKey->_users = [[NSArray alloc] initWithArray:_users copyItems:YES];
+        partialKey->_userPacketsData = _userPacketsData;
+        partialKey->_userPacketRanges = _userPacketRanges;
+    }
     partialKey.subKeys = [[NSArray alloc] initWithArray:self.subKeys copyItems:YES];
     partialKey.directSignatures = [[NSArray alloc] initWithArray:self.directSignatures copyItems:YES];
     partialKey.revocationSignature = self.revocationSignature;
@@ -490,37 +637,19 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 + (PGPSymmetricAlgorithm)preferredSymmetricAlgorithmForKeys:(NSArray<PGPPartialKey *> *)keys {
-    // 13.2.  Symmetric Algorithm Preferences
-    // Since TripleDES is the MUST-implement algorithm, if it is not explicitly in the list, it is tacitly at the end.
-
-    let preferecesArray = [NSMutableArray<NSArray<NSNumber *> *> array];
-    for (PGPPartialKey *key in keys) {
-        let keyAlgorithms = [NSMutableArray<NSNumber *> array];
-
-        let _Nullable primaryUserSelfCertificate = key.primaryUserSelfCertificate;
-        if (key.primaryUser && primaryUserSelfCertificate) {
-            let signatureSubpacket = [[primaryUserSelfCertificate subpacketsOfType:PGPSignatureSubpacketTypePreferredSymetricAlgorithm] firstObject];
-            NSArray<NSNumber *> * _Nullable preferredSymetricAlgorithms = PGPCast(signatureSubpacket.value, NSArray);
-            if (preferredSymetricAlgorithms) {
-                [keyAlgorithms addObjectsFromArray:PGPNN(preferredSymetricAlgorithms)];
-            }
-        }
+    return [PGPKeyProfile preferredSymmetricAlgorithmForProfiles:[self profilesForKeys:keys]];
+}
 
-        if (keyAlgorithms.count > 0) {
-            [preferecesArray addObject:keyAlgorithms];
-        }
-    }
++ (BOOL)isFeature:(PGPFeature)feature supportedByKeys:(NSArray<PGPPartialKey *> *)keys {
+    return [PGPKeyProfile isFeature:feature supportedByProfiles:[self profilesForKeys:keys]];
+}
 
-    // intersect
-    if (preferecesArray.count > 0) {
-        let set = [NSMutableOrderedSet<NSNumber *> orderedSetWithArray:preferecesArray[0]];
-        for (NSArray<NSNumber *> *prefArray in preferecesArray) {
-            [set intersectSet:[NSSet setWithArray:prefArray]];
-        }
-        return (PGPSymmetricAlgorithm)[set[0] unsignedIntValue];
++ (NSArray<PGPKeyProfile *> *)profilesForKeys:(NSArray<PGPPartialKey *> *)keys {
+    let profiles = [NSMutableArray<PGPKeyProfile *> arrayWithCapacity:keys.count];
+    for (PGPPartialKey *key in keys) {
+        [profiles addObject:key.profile];
     }
-
-    return PGPSymmetricTripleDES;
+    return profiles;
 }
 
 #pragma mark - Private
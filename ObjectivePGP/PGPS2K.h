@@ -21,6 +21,12 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, copy, readonly) NSData *salt;
 // Iteration count.
 @property (nonatomic) UInt32 iterationsCount;
+// Argon2 number of passes (t).
+@property (nonatomic) UInt8 argon2Passes;
+// Argon2 degree of parallelism (p).
+@property (nonatomic) UInt8 argon2Parallelism;
+// Argon2 encoded memory size (m). The memory size is 2^m KiB.
+@property (nonatomic) UInt8 argon2EncodedMemory;
 
 PGP_EMPTY_INIT_UNAVAILABLE
 
@@ -28,6 +34,22 @@ PGP_EMPTY_INIT_UNAVAILABLE
 
 + (PGPS2K *)S2KFromData:(NSData *)data atPosition:(NSUInteger)position length:(nullable NSUInteger *)length;
 
+/**
+ *  Argon2 S2K with parameters calibrated on the current device.
+ *  Parallelism follows the number of cores, memory is raised first, then the number of passes, until
+ *  deriving the key takes about the target duration. Secret key packets accept Argon2 only with
+ *  AEAD protection (S2K usage 253).
+ *
+ *  @param targetDuration Target time of the key derivation, eg. unlock latency.
+ */
++ (PGPS2K *)argon2S2KWithTargetDuration:(NSTimeInterval)targetDuration;
+
+/**
+ *  Count octet (`iterationsCount`) of the iterated and salted S2K that takes about 100 ms on the current device.
+ *  Measured the first time it's requested for the hash algorithm, then cached.
+ */
++ (UInt8)calibratedIterationsCountForHashAlgorithm:(PGPHashAlgorithm)hashAlgorithm;
+
 - (nullable NSData *)buildKeyDataForPassphrase:(NSData *)passphrase prefix:(nullable NSData *)prefix salt:(NSData *)salt codedCount:(UInt32)codedCount;
 - (nullable NSData *)produceSessionKeyWithPassphrase:(NSString *)passphrase symmetricAlgorithm:(PGPSymmetricAlgorithm)symmetricAlgorithm;
 - (nullable NSData *)export:(NSError * __autoreleasing _Nullable *)error;
@@ -20,12 +20,26 @@
 #import "NSMutableData+PGPUtils.h"
 #import "PGPCryptoHash.h"
 #import "PGPCryptoUtils.h"
+#import "PGPArgon2.h"
 #import "PGPFoundation.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 static const unsigned int PGP_SALT_SIZE = 8;
 static const unsigned int PGP_DEFAULT_ITERATIONS_COUNT = 215;
+static const unsigned int PGP_ARGON2_SALT_SIZE = 16;
+// RFC 9580 4.  Argon2 second recommended option: t = 3, p = 4, m = 2^16 KiB (64 MiB)
+static const UInt8 PGP_ARGON2_DEFAULT_PASSES = 3;
+static const UInt8 PGP_ARGON2_DEFAULT_PARALLELISM = 4;
+static const UInt8 PGP_ARGON2_DEFAULT_ENCODED_MEMORY = 16;
+// Calibration range: 8 MiB ... 2 GiB
+static const UInt8 PGP_ARGON2_MIN_ENCODED_MEMORY = 13;
+static const UInt8 PGP_ARGON2_MAX_ENCODED_MEMORY = 21;
+// Iterated and salted S2K calibration target, and the lowest count it may pick (65536 octets)
+static const NSTimeInterval PGP_S2K_CALIBRATION_TARGET_DURATION = 0.1;
+static const UInt8 PGP_S2K_MIN_CALIBRATED_ITERATIONS_COUNT = 96;
+// Octets of repeated (salt + passphrase) hashed by a single update
+static const NSUInteger PGP_S2K_ITERATION_BUFFER_SIZE = 64 * 1024;
 
 @interface PGPS2K ()
 
@@ -39,12 +53,101 @@ static const unsigned int PGP_DEFAULT_ITERATIONS_COUNT = 215;
     if ((self = [super init])) {
         _specifier = specifier;
         _hashAlgorithm = hashAlgorithm;
-        _salt = [PGPCryptoUtils randomData:PGP_SALT_SIZE];
+        _salt = [PGPCryptoUtils randomData:specifier == PGPS2KSpecifierArgon2 ? PGP_ARGON2_SALT_SIZE : PGP_SALT_SIZE];
         _iterationsCount = PGP_DEFAULT_ITERATIONS_COUNT;
+        _argon2Passes = PGP_ARGON2_DEFAULT_PASSES;
+        _argon2Parallelism = PGP_ARGON2_DEFAULT_PARALLELISM;
+        _argon2EncodedMemory = PGP_ARGON2_DEFAULT_ENCODED_MEMORY;
     }
     return self;
 }
 
++ (PGPS2K *)argon2S2KWithTargetDuration:(NSTimeInterval)targetDuration {
+    let s2k = [[PGPS2K alloc] initWithSpecifier:PGPS2KSpecifierArgon2 hashAlgorithm:PGPHashUnknown];
+    s2k.argon2Parallelism = (UInt8)MAX((NSUInteger)1, MIN(NSProcessInfo.processInfo.activeProcessorCount, (NSUInteger)PGP_ARGON2_DEFAULT_PARALLELISM));
+    s2k.argon2Passes = 1;
+    s2k.argon2EncodedMemory = PGP_ARGON2_DEFAULT_ENCODED_MEMORY;
+
+    let passphraseData = [PGPCryptoUtils randomData:16];
+    NSTimeInterval (^measure)(void) = ^NSTimeInterval {
+        let start = CFAbsoluteTimeGetCurrent();
+        [s2k argon2KeyDataForPassphrase:passphraseData length:32];
+        return CFAbsoluteTimeGetCurrent() - start;
+    };
+
+    // Too slow for a single pass: decrease memory
+    NSTimeInterval duration = measure();
+    while (duration > targetDuration && s2k.argon2EncodedMemory > PGP_ARGON2_MIN_ENCODED_MEMORY) {
+        s2k.argon2EncodedMemory = s2k.argon2EncodedMemory - 1;
+        duration = measure();
+    }
+
+    // Raise memory first, it's what makes the attack expensive. Keep at most a quarter of the physical memory.
+    unsigned long long memoryLimit = NSProcessInfo.processInfo.physicalMemory / 4;
+    while (duration * 2 <= targetDuration && s2k.argon2EncodedMemory < PGP_ARGON2_MAX_ENCODED_MEMORY && ((1ULL << (s2k.argon2EncodedMemory + 1)) * 1024) <= memoryLimit) {
+        s2k.argon2EncodedMemory = s2k.argon2EncodedMemory + 1;
+        duration = measure();
+    }
+
+    // Then the number of passes, the time is linear in passes
+    s2k.argon2Passes = (UInt8)MAX(1.0, MIN(255.0, floor(targetDuration / MAX(duration, DBL_EPSILON))));
+    PGPLogDebug(@"Argon2 calibrated t=%@ p=%@ m=%@ (%.3fs per pass)", @(s2k.argon2Passes), @(s2k.argon2Parallelism), @(s2k.argon2EncodedMemory), duration);
+    return s2k;
+}
+
++ (UInt8)calibratedIterationsCountForHashAlgorithm:(PGPHashAlgorithm)hashAlgorithm {
+    static NSMutableDictionary<NSNumber *, NSNumber *> *calibratedCounts;
+    static dispatch_queue_t calibrationQueue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        calibratedCounts = [NSMutableDictionary dictionary];
+        calibrationQueue = dispatch_queue_create("com.objectivepgp.s2k.calibration", DISPATCH_QUEUE_SERIAL);
+    });
+
+    __block UInt8 iterationsCount = PGP_DEFAULT_ITERATIONS_COUNT;
+    dispatch_sync(calibrationQueue, ^{
+        let cachedCount = calibratedCounts[@(hashAlgorithm)];
+        if (cachedCount) {
+            iterationsCount = cachedCount.unsignedCharValue;
+            return;
+        }
+
+        iterationsCount = [self measureIterationsCountForHashAlgorithm:hashAlgorithm targetDuration:PGP_S2K_CALIBRATION_TARGET_DURATION];
+        calibratedCounts[@(hashAlgorithm)] = @(iterationsCount);
+    });
+    return iterationsCount;
+}
+
++ (UInt8)measureIterationsCountForHashAlgorithm:(PGPHashAlgorithm)hashAlgorithm targetDuration:(NSTimeInterval)targetDuration {
+    let s2k = [[PGPS2K alloc] initWithSpecifier:PGPS2KSpecifierIteratedAndSalted hashAlgorithm:hashAlgorithm];
+    let passphraseData = [PGPCryptoUtils randomData:16];
+
+    // Time the kernel on 1 MiB, the best of a few runs
+    const UInt32 sampleCount = 1 << 20;
+    NSTimeInterval duration = DBL_MAX;
+    for (int run = 0; run < 3; run++) {
+        let start = CFAbsoluteTimeGetCurrent();
+        if (![s2k buildKeyDataForPassphrase:passphraseData prefix:nil salt:s2k.salt codedCount:sampleCount]) {
+            return PGP_DEFAULT_ITERATIONS_COUNT;
+        }
+        duration = MIN(duration, CFAbsoluteTimeGetCurrent() - start);
+    }
+
+    // The smallest count octet that hashes at least the target number of octets
+    let targetCount = (double)sampleCount / MAX(duration, DBL_EPSILON) * targetDuration;
+    UInt8 iterationsCount = PGP_S2K_MIN_CALIBRATED_ITERATIONS_COUNT;
+    while (iterationsCount < 255) {
+        s2k.iterationsCount = iterationsCount;
+        if (s2k.codedIterationsCount >= targetCount) {
+            break;
+        }
+        iterationsCount++;
+    }
+
+    PGPLogDebug(@"S2K calibrated count octet %@ for hash algorithm %@", @(iterationsCount), @(hashAlgorithm));
+    return iterationsCount;
+}
+
 + (PGPS2K *)S2KFromData:(NSData *)data atPosition:(NSUInteger)position length:(nullable NSUInteger *)length {
     PGPAssertClass(data, NSData);
 
@@ -64,6 +167,26 @@ static const unsigned int PGP_DEFAULT_ITERATIONS_COUNT = 215;
     [data getBytes:&_specifier range:(NSRange){position, 1}];
     position = position + 1;
 
+    // 3.7.1.4.  Argon2
+    if (self.specifier == PGPS2KSpecifierArgon2) {
+        // Octets 1-16:  16-octet salt value
+        self.salt = [data subdataWithRange:(NSRange){position, PGP_ARGON2_SALT_SIZE}];
+        position = position + self.salt.length;
+
+        // Octet  17:    one-octet number of passes t
+        [data getBytes:&_argon2Passes range:(NSRange){position, 1}];
+        position = position + 1;
+
+        // Octet  18:    one-octet degree of parallelism p
+        [data getBytes:&_argon2Parallelism range:(NSRange){position, 1}];
+        position = position + 1;
+
+        // Octet  19:    one-octet encoded_m, specifying the exponent of the memory size
+        [data getBytes:&_argon2EncodedMemory range:(NSRange){position, 1}];
+        position = position + 1;
+        return position;
+    }
+
     // this is not documented, but now I need to read S2K key specified by s2kSpecifier
     // 3.7.1.1.  Simple S2K
 
@@ -106,6 +229,15 @@ static const unsigned int PGP_DEFAULT_ITERATIONS_COUNT = 215;
     return ((UInt32)16 + (self.iterationsCount & 15)) << ((self.iterationsCount >> 4) + 6);
 }
 
+- (nullable NSData *)argon2KeyDataForPassphrase:(NSData *)passphrase length:(NSUInteger)length {
+    // The memory size must be at least 8 * p KiB
+    if (self.argon2EncodedMemory > 31 || (1UL << self.argon2EncodedMemory) < 8UL * self.argon2Parallelism) {
+        PGPLogWarning(@"Invalid Argon2 memory size.");
+        return nil;
+    }
+    return [PGPArgon2 deriveKeyFromPassword:passphrase salt:self.salt passes:self.argon2Passes parallelism:self.argon2Parallelism memorySize:(UInt32)(1UL << self.argon2EncodedMemory) length:length];
+}
+
 - (nullable NSData *)buildKeyDataForPassphrase:(NSData *)passphrase prefix:(nullable NSData *)prefix salt:(NSData *)salt codedCount:(UInt32)codedCount {
     PGPUpdateBlock updateBlock = nil;
     switch (self.specifier) {
@@ -143,20 +275,19 @@ static const unsigned int PGP_DEFAULT_ITERATIONS_COUNT = 215;
                 // prefix first
                 update(prefix.bytes, (int)prefix.length);
 
-                // then iterate
-                int iterations = 0;
-                while (iterations * data.length < codedCount) {
-                    @autoreleasepool {
-                        let nextTotalLength = (iterations + 1) * data.length;
-                        if (nextTotalLength > codedCount) {
-                            let totalLength = iterations * data.length;
-                            let remainder = [data subdataWithRange:(NSRange){0, codedCount - totalLength}];
-                            update(remainder.bytes, (int)remainder.length);
-                        } else {
-                            update(data.bytes, (int)data.length);
-                        }
-                        iterations++;
-                    }
+                // then iterate, hashing a buffer of repeated (salt + passphrase) at once.
+                // The buffer length is a multiple of (salt + passphrase), so the sequence stays the same.
+                let repeats = MAX((NSUInteger)1, PGP_S2K_ITERATION_BUFFER_SIZE / data.length);
+                let buffer = [NSMutableData dataWithCapacity:repeats * data.length];
+                for (NSUInteger i = 0; i < repeats; i++) {
+                    [buffer appendData:data];
+                }
+
+                NSUInteger remaining = codedCount;
+                while (remaining > 0) {
+                    let length = MIN(remaining, buffer.length);
+                    update(buffer.bytes, (int)length);
+                    remaining = remaining - length;
                 }
             };
         } break;
@@ -187,6 +318,11 @@ static const unsigned int PGP_DEFAULT_ITERATIONS_COUNT = 215;
     PGPAssertClass(passphrase, NSString);
 
     let passphraseData = [passphrase dataUsingEncoding:NSUTF8StringEncoding];
+    if (self.specifier == PGPS2KSpecifierArgon2) {
+        // The Argon2 output length is the key size
+        return [self argon2KeyDataForPassphrase:passphraseData length:[PGPCryptoUtils keySizeOfSymmetricAlgorithm:symmetricAlgorithm]];
+    }
+
     var hashData = [self buildKeyDataForPassphrase:passphraseData prefix:nil salt:self.salt codedCount:self.codedIterationsCount];
     if (!hashData) {
         return nil;
@@ -231,6 +367,15 @@ static const unsigned int PGP_DEFAULT_ITERATIONS_COUNT = 215;
 - (nullable NSData *)export:(NSError * __autoreleasing _Nullable *)error {
     NSMutableData *data = [NSMutableData data];
     [data appendBytes:&_specifier length:1];
+
+    if (self.specifier == PGPS2KSpecifierArgon2) {
+        [data appendData:self.salt];
+        [data appendBytes:&_argon2Passes length:1];
+        [data appendBytes:&_argon2Parallelism length:1];
+        [data appendBytes:&_argon2EncodedMemory length:1];
+        return data;
+    }
+
     [data appendBytes:&_hashAlgorithm length:1];
 
     if (self.specifier == PGPS2KSpecifierSalted || self.specifier == PGPS2KSpecifierIteratedAndSalted) {
@@ -257,6 +402,9 @@ static const unsigned int PGP_DEFAULT_ITERATIONS_COUNT = 215;
     let duplicate = PGPCast([[self.class allocWithZone:zone] initWithSpecifier:self.specifier hashAlgorithm:self.hashAlgorithm], PGPS2K);
     duplicate.salt = [self.salt copyWithZone:zone];
     duplicate.iterationsCount = self.iterationsCount;
+    duplicate.argon2Passes = self.argon2Passes;
+    duplicate.argon2Parallelism = self.argon2Parallelism;
+    duplicate.argon2EncodedMemory = self.argon2EncodedMemory;
     return duplicate;
 }
 
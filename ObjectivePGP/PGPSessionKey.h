@@ -0,0 +1,32 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMacros.h>
+#import <ObjectivePGP/PGPTypes.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// The symmetric session key of an encrypted message.
+/// @note Anyone with the session key can decrypt the message. Store it as securely as the plaintext.
+NS_SWIFT_NAME(SessionKey) @interface PGPSessionKey : NSObject <NSCopying>
+
+/// Symmetric algorithm of the encrypted data
+@property (readonly, nonatomic) PGPSymmetricAlgorithm algorithm;
+
+/// The key
+@property (readonly, copy, nonatomic) NSData *keyData;
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+/// Initialize with the algorithm and the key. The key length must match the algorithm key size.
+- (nullable instancetype)initWithAlgorithm:(PGPSymmetricAlgorithm)algorithm keyData:(NSData *)keyData NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,58 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPSessionKey.h"
+#import "PGPCryptoUtils.h"
+#import "PGPMacros+Private.h"
+#import "PGPFoundation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation PGPSessionKey
+
+- (nullable instancetype)initWithAlgorithm:(PGPSymmetricAlgorithm)algorithm keyData:(NSData *)keyData {
+    PGPAssertClass(keyData, NSData);
+
+    if (algorithm == PGPSymmetricPlaintext || algorithm >= PGPSymmetricMax || keyData.length != [PGPCryptoUtils keySizeOfSymmetricAlgorithm:algorithm]) {
+        return nil;
+    }
+
+    if ((self = [super init])) {
+        _algorithm = algorithm;
+        _keyData = [keyData copy];
+    }
+    return self;
+}
+
+#pragma mark - isEqual
+
+- (BOOL)isEqual:(id)other {
+    if (self == other) { return YES; }
+    if ([other isKindOfClass:self.class]) {
+        let otherSessionKey = PGPCast(other, PGPSessionKey);
+        return self.algorithm == otherSessionKey.algorithm && [self.keyData isEqualToData:otherSessionKey.keyData];
+    }
+    return NO;
+}
+
+- (NSUInteger)hash {
+    NSUInteger result = 1;
+    result = 31 * result + self.algorithm;
+    result = 31 * result + self.keyData.hash;
+    return result;
+}
+
+#pragma mark - NSCopying
+
+- (instancetype)copyWithZone:(nullable NSZone *)zone {
+    return PGPCast([[self.class allocWithZone:zone] initWithAlgorithm:self.algorithm keyData:self.keyData], PGPSessionKey);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,79 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMacros.h>
+#import <ObjectivePGP/PGPKey.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_CLOSED_ENUM(NSUInteger, PGPKeyValidity) {
+    /// Not certified by a trusted introducer, revoked, expired, or not in the graph.
+    PGPKeyValidityUnknown = 0,
+    /// Certified by introducers with a trust amount below the full trust.
+    PGPKeyValidityMarginal = 1,
+    /// Certified by introducers with the full trust amount together.
+    PGPKeyValidityFull = 2,
+    /// Trust root.
+    PGPKeyValidityUltimate = 3
+} NS_SWIFT_NAME(KeyValidity);
+
+/**
+ Web of trust over the keys: the certifications of the user IDs of the keys by the other keys.
+
+ A trust root is fully trusted to certify keys, up to `maximumDepth` levels of introducers.
+ A certification makes the key valid if the issuer is valid and trusted as an introducer.
+ A trust signature (level 1 and more) makes the certified key an introducer itself,
+ with the depth and the trust amount limited by the issuer's, unless it is limited by a
+ Regular Expression, which is not supported. Trust amounts of the
+ issuers add up: 120 is the full trust, less is marginal.
+
+ Certifications are verified once, with the issuer key in the graph. Expired, revoked and invalid
+ certifications are ignored, and so are revoked and expired keys, trust roots too.
+
+ The validity is computed when the graph changes, and only for the keys certified, directly or through
+ introducers, by the added or removed keys. The graph is safe to use from multiple threads.
+
+ The validity is computed at the time of the change and kept. A key or certification that expires later
+ stays valid until it is computed again: add the expired keys again to refresh the validity of the keys
+ they certify.
+ */
+NS_SWIFT_NAME(TrustGraph) @interface PGPTrustGraph : NSObject
+
+/// Introducer levels below a trust root. Default 5.
+@property (nonatomic, readonly) NSUInteger maximumDepth;
+
+/// Keys in the graph.
+@property (nonatomic, copy, readonly) NSArray<PGPKey *> *keys;
+
+- (instancetype)init;
+- (instancetype)initWithMaximumDepth:(NSUInteger)maximumDepth NS_DESIGNATED_INITIALIZER;
+
+/**
+ Add keys, or replace the keys with the same fingerprint. Import the certified key again to
+ add new certifications or certification revocations.
+
+ @param keys Public keys.
+ */
+- (void)addKeys:(NSArray<PGPKey *> *)keys;
+
+/// Remove the keys, and the certifications they issued, from the graph. Trust roots stay configured.
+- (void)removeKeys:(NSArray<PGPKey *> *)keys;
+
+/// Add the keys to the graph, as the trust roots.
+- (void)addTrustRoots:(NSArray<PGPKey *> *)keys;
+
+/// Stop to trust the keys as trust roots. The keys stay in the graph.
+- (void)removeTrustRoots:(NSArray<PGPKey *> *)keys;
+
+/// Validity of the key, as computed on the last change of the graph.
+- (PGPKeyValidity)validityOfKey:(PGPKey *)key;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,394 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPTrustGraph.h"
+#import "PGPKey.h"
+#import "PGPKeyProfile.h"
+#import "PGPKeyValidator.h"
+#import "PGPPartialKey.h"
+#import "PGPFingerprint.h"
+#import "PGPPublicKeyPacket.h"
+#import "PGPSignaturePacket.h"
+#import "PGPSignaturePacket+Private.h"
+#import "PGPUser.h"
+#import "PGPUser+Private.h"
+#import "PGPMacros+Private.h"
+#import "PGPFoundation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// 5.2.3.13.  Trust Signature: "a value of 120 indicates complete trust"
+static const NSUInteger PGPTrustAmountFull = 120;
+
+/// Certification of the user ID of the target key by the issuer key.
+@interface PGPTrustEdge : NSObject
+
+@property (nonatomic, readonly) PGPKeyID *issuerKeyID;
+@property (nonatomic, copy, readonly) NSData *targetFingerprint;
+@property (nonatomic, readonly) PGPUser *user;
+@property (nonatomic, readonly) PGPSignaturePacket *certification;
+
+@end
+
+@implementation PGPTrustEdge
+
+- (instancetype)initWithIssuerKeyID:(PGPKeyID *)issuerKeyID targetFingerprint:(NSData *)targetFingerprint user:(PGPUser *)user certification:(PGPSignaturePacket *)certification {
+    if ((self = [super init])) {
+        _issuerKeyID = issuerKeyID;
+        _targetFingerprint = [targetFingerprint copy];
+        _user = user;
+        _certification = certification;
+    }
+    return self;
+}
+
+@end
+
+/// Key in the graph, with the certifications of its user IDs, and its computed validity.
+@interface PGPTrustNode : NSObject
+
+@property (nonatomic, readonly) PGPKey *key;
+@property (nonatomic, readonly) PGPKeyID *keyID;
+@property (nonatomic, copy, readonly) NSData *fingerprint;
+@property (nonatomic, copy, readonly) NSArray<PGPTrustEdge *> *edges;
+
+@property (nonatomic) PGPKeyValidity validity;
+/// Introducer levels the key is trusted for. 0 if the key is not an introducer.
+@property (nonatomic) NSUInteger depth;
+/// Trust amount of the certifications of the key.
+@property (nonatomic) NSUInteger amount;
+
+@end
+
+@implementation PGPTrustNode
+
+- (instancetype)initWithKey:(PGPKey *)key partialKey:(PGPPartialKey *)partialKey {
+    if ((self = [super init])) {
+        _key = key;
+        _keyID = partialKey.keyID;
+        _fingerprint = [partialKey.fingerprint.hashedData copy];
+
+        let edges = [NSMutableArray<PGPTrustEdge *> array];
+        for (PGPUser *user in partialKey.users) {
+            if (user.userAttribute) {
+                continue;
+            }
+            for (PGPSignaturePacket *certification in user.otherSignatures) {
+                let _Nullable issuerKeyID = certification.issuerKeyID;
+                if (!issuerKeyID || PGPEqualObjects(issuerKeyID, _keyID)) {
+                    continue;
+                }
+                [edges addObject:[[PGPTrustEdge alloc] initWithIssuerKeyID:PGPNN(issuerKeyID) targetFingerprint:_fingerprint user:user certification:certification]];
+            }
+        }
+        _edges = edges;
+    }
+    return self;
+}
+
+@end
+
+@implementation PGPTrustGraph {
+    dispatch_queue_t _queue;
+    // Keys by the fingerprint hash of the primary key.
+    NSMutableDictionary<NSData *, PGPTrustNode *> *_nodes;
+    NSMutableDictionary<PGPKeyID *, NSData *> *_fingerprintsByKeyID;
+    // Certifications issued by the key ID, also of the keys not in the graph yet.
+    NSMutableDictionary<PGPKeyID *, NSMutableArray<PGPTrustEdge *> *> *_edgesByIssuerKeyID;
+    NSMutableSet<NSData *> *_rootFingerprints;
+}
+
+- (instancetype)init {
+    return [self initWithMaximumDepth:5];
+}
+
+- (instancetype)initWithMaximumDepth:(NSUInteger)maximumDepth {
+    if ((self = [super init])) {
+        _maximumDepth = maximumDepth;
+        _queue = dispatch_queue_create("com.objectivepgp.trustgraph", DISPATCH_QUEUE_SERIAL);
+        _nodes = [NSMutableDictionary dictionary];
+        _fingerprintsByKeyID = [NSMutableDictionary dictionary];
+        _edgesByIssuerKeyID = [NSMutableDictionary dictionary];
+        _rootFingerprints = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (NSArray<PGPKey *> *)keys {
+    __block NSArray<PGPKey *> *keys = @[];
+    dispatch_sync(_queue, ^{
+        keys = [self->_nodes.allValues valueForKey:@"key"];
+    });
+    return keys;
+}
+
+- (void)addKeys:(NSArray<PGPKey *> *)keys {
+    PGPAssertClass(keys, NSArray);
+
+    dispatch_sync(_queue, ^{
+        [self updateFromFingerprints:[self insertKeys:keys]];
+    });
+}
+
+- (void)removeKeys:(NSArray<PGPKey *> *)keys {
+    PGPAssertClass(keys, NSArray);
+
+    dispatch_sync(_queue, ^{
+        let changedFingerprints = [NSMutableSet<NSData *> set];
+        for (PGPKey *key in keys) {
+            let _Nullable node = self->_nodes[key.publicKey.fingerprint.hashedData ?: NSData.data];
+            if (!node) {
+                continue;
+            }
+            for (PGPTrustEdge *edge in self->_edgesByIssuerKeyID[node.keyID]) {
+                [changedFingerprints addObject:edge.targetFingerprint];
+            }
+            [self detachNode:PGPNN(node)];
+        }
+        [self updateFromFingerprints:changedFingerprints];
+    });
+}
+
+- (void)addTrustRoots:(NSArray<PGPKey *> *)keys {
+    PGPAssertClass(keys, NSArray);
+
+    dispatch_sync(_queue, ^{
+        let changedFingerprints = [self insertKeys:keys];
+        [self->_rootFingerprints unionSet:changedFingerprints];
+        [self updateFromFingerprints:changedFingerprints];
+    });
+}
+
+- (void)removeTrustRoots:(NSArray<PGPKey *> *)keys {
+    PGPAssertClass(keys, NSArray);
+
+    dispatch_sync(_queue, ^{
+        let changedFingerprints = [NSMutableSet<NSData *> set];
+        for (PGPKey *key in keys) {
+            let _Nullable fingerprint = key.publicKey.fingerprint.hashedData;
+            if (fingerprint && [self->_rootFingerprints containsObject:PGPNN(fingerprint)]) {
+                [self->_rootFingerprints removeObject:PGPNN(fingerprint)];
+                [changedFingerprints addObject:PGPNN(fingerprint)];
+            }
+        }
+        [self updateFromFingerprints:changedFingerprints];
+    });
+}
+
+- (PGPKeyValidity)validityOfKey:(PGPKey *)key {
+    PGPAssertClass(key, PGPKey);
+
+    let _Nullable fingerprint = key.publicKey.fingerprint.hashedData;
+    if (!fingerprint) {
+        return PGPKeyValidityUnknown;
+    }
+
+    __block PGPKeyValidity validity = PGPKeyValidityUnknown;
+    dispatch_sync(_queue, ^{
+        validity = self->_nodes[PGPNN(fingerprint)].validity;
+    });
+    return validity;
+}
+
+#pragma mark - Private
+
+// Add or replace the nodes of the public keys. Returns the fingerprints of the nodes.
+- (NSMutableSet<NSData *> *)insertKeys:(NSArray<PGPKey *> *)keys {
+    let fingerprints = [NSMutableSet<NSData *> set];
+    for (PGPKey *key in keys) {
+        let _Nullable publicKey = key.publicKey;
+        if (!publicKey) {
+            continue;
+        }
+
+        let node = [[PGPTrustNode alloc] initWithKey:key partialKey:PGPNN(publicKey)];
+        let _Nullable previousNode = _nodes[node.fingerprint];
+        if (previousNode) {
+            [self detachNode:PGPNN(previousNode)];
+        }
+
+        _nodes[node.fingerprint] = node;
+        _fingerprintsByKeyID[node.keyID] = node.fingerprint;
+        for (PGPTrustEdge *edge in node.edges) {
+            let issuerEdges = _edgesByIssuerKeyID[edge.issuerKeyID] ?: [NSMutableArray<PGPTrustEdge *> array];
+            [issuerEdges addObject:edge];
+            _edgesByIssuerKeyID[edge.issuerKeyID] = issuerEdges;
+        }
+        [fingerprints addObject:node.fingerprint];
+    }
+    return fingerprints;
+}
+
+// Remove the node and its certifications. The certifications issued by the key stay with the certified keys.
+- (void)detachNode:(PGPTrustNode *)node {
+    for (PGPTrustEdge *edge in node.edges) {
+        let _Nullable issuerEdges = _edgesByIssuerKeyID[edge.issuerKeyID];
+        [issuerEdges removeObjectIdenticalTo:edge];
+        if (issuerEdges && issuerEdges.count == 0) {
+            [_edgesByIssuerKeyID removeObjectForKey:edge.issuerKeyID];
+        }
+    }
+    [_nodes removeObjectForKey:node.fingerprint];
+    if (PGPEqualObjects(_fingerprintsByKeyID[node.keyID], node.fingerprint)) {
+        [_fingerprintsByKeyID removeObjectForKey:node.keyID];
+    }
+}
+
+- (nullable PGPTrustNode *)nodeWithKeyID:(PGPKeyID *)keyID {
+    let _Nullable fingerprint = _fingerprintsByKeyID[keyID];
+    return fingerprint ? _nodes[PGPNN(fingerprint)] : nil;
+}
+
+// Compute the validity again for the changed keys, and the keys these certify, directly or through introducers.
+// The validity of the other keys doesn't depend on the change.
+- (void)updateFromFingerprints:(NSSet<NSData *> *)changedFingerprints {
+    let affectedNodes = [NSMutableOrderedSet<PGPTrustNode *> orderedSet];
+    let pendingFingerprints = [NSMutableArray<NSData *> arrayWithArray:changedFingerprints.allObjects];
+    while (pendingFingerprints.count > 0) {
+        let fingerprint = PGPNN(pendingFingerprints.lastObject);
+        [pendingFingerprints removeLastObject];
+        let _Nullable node = _nodes[fingerprint];
+        if (!node || [affectedNodes containsObject:PGPNN(node)]) {
+            continue;
+        }
+        [affectedNodes addObject:PGPNN(node)];
+        for (PGPTrustEdge *edge in _edgesByIssuerKeyID[node.keyID]) {
+            [pendingFingerprints addObject:edge.targetFingerprint];
+        }
+    }
+
+    if (affectedNodes.count == 0) {
+        return;
+    }
+
+    [self verifyCertificationsOfNodes:affectedNodes.array];
+
+    for (PGPTrustNode *node in affectedNodes) {
+        // A revoked or expired trust root is not valid, and introduces no key.
+        let profile = node.key.profile;
+        let isRoot = [_rootFingerprints containsObject:node.fingerprint] && !profile.isRevoked && !profile.isExpired;
+        node.validity = isRoot ? PGPKeyValidityUltimate : PGPKeyValidityUnknown;
+        node.depth = isRoot ? self.maximumDepth : 0;
+        node.amount = isRoot ? PGPTrustAmountFull : 0;
+    }
+
+    // The validity only grows from the reset state, until nothing changes.
+    let pendingNodes = [NSMutableOrderedSet<PGPTrustNode *> orderedSetWithOrderedSet:affectedNodes];
+    while (pendingNodes.count > 0) {
+        let node = PGPNN(pendingNodes.firstObject);
+        [pendingNodes removeObjectAtIndex:0];
+        if (![self evaluateNode:node]) {
+            continue;
+        }
+        for (PGPTrustEdge *edge in _edgesByIssuerKeyID[node.keyID]) {
+            let _Nullable targetNode = _nodes[edge.targetFingerprint];
+            if (targetNode && [affectedNodes containsObject:PGPNN(targetNode)]) {
+                [pendingNodes addObject:PGPNN(targetNode)];
+            }
+        }
+    }
+}
+
+// Verify the certifications, and the certification revocations by the same issuers, the issuer keys of which are in the graph.
+- (void)verifyCertificationsOfNodes:(NSArray<PGPTrustNode *> *)nodes {
+    let checks = [NSMutableArray<PGPSignatureCheck *> array];
+    for (PGPTrustNode *node in nodes) {
+        let _Nullable partialKey = node.key.publicKey;
+        for (PGPTrustEdge *edge in node.edges) {
+            let _Nullable issuerKeyPacket = PGPCast([self nodeWithKeyID:edge.issuerKeyID].key.publicKey.primaryKeyPacket, PGPPublicKeyPacket);
+            if (!issuerKeyPacket || !partialKey) {
+                continue;
+            }
+            [checks pgp_addObject:[PGPKeyValidator checkForCertification:edge.certification user:edge.user partialKey:PGPNN(partialKey) signingKeyPacket:PGPNN(issuerKeyPacket)]];
+            for (PGPSignaturePacket *revocation in edge.user.revocationSignatures) {
+                if (PGPEqualObjects(revocation.issuerKeyID, edge.issuerKeyID)) {
+                    [checks pgp_addObject:[PGPKeyValidator checkForCertification:revocation user:edge.user partialKey:PGPNN(partialKey) signingKeyPacket:PGPNN(issuerKeyPacket)]];
+                }
+            }
+        }
+    }
+    [PGPKeyValidator runChecks:checks];
+}
+
+// Compute the validity of the key from the certifications by the valid introducers. YES if it changed.
+- (BOOL)evaluateNode:(PGPTrustNode *)node {
+    if ([_rootFingerprints containsObject:node.fingerprint]) {
+        return NO;
+    }
+
+    let profile = node.key.profile;
+    if (profile.isRevoked || profile.isExpired) {
+        return NO;
+    }
+
+    // The trust amount of an issuer counts once, for all user IDs it certified.
+    let amountByIssuer = [NSMutableDictionary<PGPKeyID *, NSNumber *> dictionary];
+    NSUInteger depth = 0;
+    NSUInteger amount = 0;
+    for (PGPTrustEdge *edge in node.edges) {
+        let _Nullable issuerNode = [self nodeWithKeyID:edge.issuerKeyID];
+        if (!issuerNode || issuerNode == node || issuerNode.validity < PGPKeyValidityFull || issuerNode.depth == 0 || ![self isCertificationValid:edge ofNode:node]) {
+            continue;
+        }
+
+        let issuerAmount = PGPNN(issuerNode).amount;
+        amountByIssuer[edge.issuerKeyID] = @(MAX(amountByIssuer[edge.issuerKeyID].unsignedIntegerValue, issuerAmount));
+
+        // The user IDs the introducer is limited to by a Regular Expression are not checked, such a trust signature is a certification only.
+        let trustLevel = edge.certification.trustLevel;
+        if (trustLevel > 0 && [edge.certification hashedSubpacketsOfType:PGPSignatureSubpacketTypeRegularExpression].count == 0) {
+            depth = MAX(depth, MIN((NSUInteger)trustLevel, PGPNN(issuerNode).depth - 1));
+            amount = MAX(amount, MIN((NSUInteger)edge.certification.trustAmount, issuerAmount));
+        }
+    }
+
+    NSUInteger validityAmount = 0;
+    for (NSNumber *issuerAmount in amountByIssuer.allValues) {
+        validityAmount += issuerAmount.unsignedIntegerValue;
+    }
+
+    let validity = validityAmount >= PGPTrustAmountFull ? PGPKeyValidityFull : validityAmount > 0 ? PGPKeyValidityMarginal : PGPKeyValidityUnknown;
+    // Only a fully valid key is an introducer.
+    if (validity != PGPKeyValidityFull || depth == 0 || amount == 0) {
+        depth = 0;
+        amount = 0;
+    }
+
+    if (node.validity == validity && node.depth == depth && node.amount == amount) {
+        return NO;
+    }
+    node.validity = validity;
+    node.depth = depth;
+    node.amount = amount;
+    return YES;
+}
+
+- (BOOL)isCertificationValid:(PGPTrustEdge *)edge ofNode:(PGPTrustNode *)node {
+    let certification = edge.certification;
+    if (certification.validity != PGPSignatureValidityValid || certification.isExpired) {
+        return NO;
+    }
+
+    for (PGPSignaturePacket *revocation in edge.user.revocationSignatures) {
+        if (revocation.validity != PGPSignatureValidityValid) {
+            continue;
+        }
+        // Revoked user ID, or the certification revoked by the issuer.
+        if (PGPEqualObjects(revocation.issuerKeyID, node.keyID)) {
+            return NO;
+        }
+        if (PGPEqualObjects(revocation.issuerKeyID, edge.issuerKeyID) && [revocation.creationDate compare:certification.creationDate ?: NSDate.distantPast] != NSOrderedAscending) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
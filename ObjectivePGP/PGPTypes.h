@@ -79,6 +79,13 @@ typedef NS_CLOSED_ENUM(UInt8, PGPPacketTag) {
     PGPExperimentalPacketTag4 = 63
 };
 
+// Reading packets, what to do with invalid data between packets
+typedef NS_CLOSED_ENUM(NSUInteger, PGPPacketResyncPolicy) {
+    PGPPacketResyncPolicySkip = 0, // Skip to the next valid packet header
+    PGPPacketResyncPolicyStop = 1, // Stop reading, keep packets read so far
+    PGPPacketResyncPolicyReport = 2 // Stop reading with an error
+};
+
 typedef NS_CLOSED_ENUM(UInt8, PGPUserAttributeSubpacketType) {
     PGPUserAttributeSubpacketUnknown = 0x00,
     PGPUserAttributeSubpacketImage = 0x01 // The only currently defined subpacket type is 1, signifying an image.
@@ -219,7 +226,16 @@ typedef NS_CLOSED_ENUM(UInt8, PGPKeyServerPreferenceFlags) {
 // 5.2.3.24.  Features
 typedef NS_CLOSED_ENUM(UInt8, PGPFeature) {
     PGPFeatureModificationUnknown   = 0x00,
-    PGPFeatureModificationDetection = 0x01 // Modification Detection (packets 18 and 19)
+    PGPFeatureModificationDetection = 0x01, // Modification Detection (packets 18 and 19)
+    PGPFeatureSEIPDv2 = 0x08 // Version 2 Symmetrically Encrypted and Integrity Protected Data packet (AEAD)
+};
+
+// RFC 9580 9.6.  AEAD Algorithms
+typedef NS_CLOSED_ENUM(UInt8, PGPAEADAlgorithm) {
+    PGPAEADUnknown = 0,
+    PGPAEADEAX = 1, // nonce 16 bytes, tag 16 bytes
+    PGPAEADOCB = 2, // nonce 15 bytes, tag 16 bytes
+    PGPAEADGCM = 3  // nonce 12 bytes, tag 16 bytes
 };
 
 // 3.7.1.  String-to-Key (S2K) Specifier Types
@@ -227,6 +243,7 @@ typedef NS_CLOSED_ENUM(UInt8, PGPS2KSpecifier) {
     PGPS2KSpecifierSimple = 0,
     PGPS2KSpecifierSalted = 1,
     PGPS2KSpecifierIteratedAndSalted = 3,
+    PGPS2KSpecifierArgon2 = 4, // RFC 9580 3.7.1.4.  Argon2
     // GNU extensions to the S2K algorithm.
     // see: https://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob;f=doc/DETAILS;h=8ead6a8f5250656f72aea99042f392cb6749b8ff;hb=refs/heads/master#l1309
     // The "gnu-dummy S2K" is the marker which will tell that this file does *not* actually contain the secret key.
@@ -237,6 +254,7 @@ typedef NS_CLOSED_ENUM(UInt8, PGPS2KSpecifier) {
 
 typedef NS_CLOSED_ENUM(UInt8, PGPS2KUsage) {
     PGPS2KUsageNonEncrypted = 0, // no passphrase
+    PGPS2KUsageEncryptedAEAD = 253, // RFC 9580 5.5.3
     PGPS2KUsageEncryptedAndHashed = 254,
     PGPS2KUsageEncrypted = 255
 };
@@ -11,6 +11,7 @@
 #import "PGPPartialKey.h"
 #import "PGPPublicKeyPacket.h"
 #import "PGPSignaturePacket.h"
+#import "PGPSignaturePacket+Private.h"
 #import "PGPUserAttributePacket.h"
 #import "PGPUserAttributeImageSubpacket.h"
 #import "PGPUserIDPacket.h"
@@ -108,38 +109,26 @@ NS_ASSUME_NONNULL_BEGIN
         return nil;
     }
 
+    // Certificates found invalid by `PGPKeyValidator` are skipped.
     NSMutableArray *certs = [NSMutableArray array];
     for (PGPSignaturePacket *signature in self.selfCertifications) {
         // TODO: check for revocation
-
-        [certs addObject:signature];
-        // This only worked as verify wasn't implemented correctly
-        // TODO: find a better solution
-        //
-        //        // (this is the craziest thing I ever seen today)
-        //        NSError *error;
-        //        [signature verifyData:nil withKey:key signingKeyPacket:(PGPPublicKeyPacket *)key.primaryKeyPacket userID:self.userID error:&error];
-        //        //BOOL status = [signature verifyData:nil withKey:key signingKeyPacket:(PGPPublicKeyPacket *)key.primaryKeyPacket userID:self.userID error:&error];
-        //        //if (!status) {
-        //        //    NSLog(@"ObjectivePGP: %@",error);
-        //        //}
-        //        //NSAssert(status == YES,@"not verified");
-        //
-        //        if (status == YES) {
-        //            [certs addObject:signature];
-        //        }
+        if (signature.validity != PGPSignatureValidityInvalid) {
+            [certs addObject:signature];
+        }
     }
 
-    [certs sortUsingComparator:^NSComparisonResult(id obj1, id obj2) {
-        let sig1 = PGPCast(obj1, PGPSignaturePacket);
-        let sig2 = PGPCast(obj2, PGPSignaturePacket);
-        if (sig1.creationDate && sig2.creationDate) {
-            return [PGPNN(sig1.creationDate) compare:PGPNN(sig2.creationDate)];
+    // The most recent one. The later certificate wins if the dates are equal or missing.
+    PGPSignaturePacket *latestCertificate = nil;
+    NSDate *latestCreationDate = nil;
+    for (PGPSignaturePacket *signature in certs) {
+        let _Nullable creationDate = signature.creationDate;
+        if (!latestCreationDate || !creationDate || [PGPNN(creationDate) compare:PGPNN(latestCreationDate)] != NSOrderedAscending) {
+            latestCertificate = signature;
+            latestCreationDate = creationDate;
         }
-        return NSOrderedSame;
-    }];
-
-    return certs.lastObject;
+    }
+    return latestCertificate;
 }
 
 #pragma mark - isEqual
@@ -0,0 +1,49 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/PGPMacros.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class PGPSignaturePacket;
+
+/**
+ Signatures verified successfully, so the same signature of the same data by the same key
+ is not verified again with the public key. Holds at most `capacity` results, and drops the
+ least recently used first. Safe to use from multiple threads.
+ */
+@interface PGPVerificationCache : NSObject
+
+@property (nonatomic, readonly) NSUInteger capacity;
+@property (nonatomic, readonly) NSUInteger count;
+
+PGP_EMPTY_INIT_UNAVAILABLE
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+/// Cache of the signature verification.
++ (PGPVerificationCache *)sharedCache;
+
+/// Key of the verification: the signature MPIs, the hash value of the signed data with the signed part of the signature, and the signing key fingerprint.
++ (NSData *)keyForSignature:(PGPSignaturePacket *)signature hashValue:(NSData *)hashValue signingKeyFingerprint:(NSData *)signingKeyFingerprint;
+
+/// YES if the verification was cached. Marks the result as recently used.
+- (BOOL)containsKey:(NSData *)key;
+
+/// Cache the successful verification by the signing key.
+- (void)addKey:(NSData *)key signingKeyFingerprint:(NSData *)signingKeyFingerprint;
+
+/// Drop the results of the signing key, eg. a revoked key.
+- (void)removeKeysOfSigningKeyFingerprint:(NSData *)signingKeyFingerprint;
+
+- (void)removeAllKeys;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,145 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import "PGPVerificationCache.h"
+#import "PGPSignaturePacket.h"
+#import "PGPMPI.h"
+#import "NSData+PGPUtils.h"
+#import "NSMutableData+PGPUtils.h"
+#import "PGPMacros+Private.h"
+#import "PGPFoundation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Number of verifications kept by the shared cache
+#define PGP_VERIFICATION_CACHE_LIMIT 1024
+
+@implementation PGPVerificationCache {
+    dispatch_queue_t _queue;
+    // Least recently used first.
+    NSMutableOrderedSet<NSData *> *_keys;
+    NSMutableDictionary<NSData *, NSData *> *_fingerprintsByKey;
+    NSMutableDictionary<NSData *, NSMutableSet<NSData *> *> *_keysByFingerprint;
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    if ((self = [super init])) {
+        _capacity = capacity;
+        _queue = dispatch_queue_create("com.objectivepgp.verificationcache", DISPATCH_QUEUE_SERIAL);
+        _keys = [NSMutableOrderedSet orderedSet];
+        _fingerprintsByKey = [NSMutableDictionary dictionary];
+        _keysByFingerprint = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
++ (PGPVerificationCache *)sharedCache {
+    static PGPVerificationCache *sharedCache;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedCache = [[PGPVerificationCache alloc] initWithCapacity:PGP_VERIFICATION_CACHE_LIMIT];
+    });
+    return sharedCache;
+}
+
++ (NSData *)keyForSignature:(PGPSignaturePacket *)signature hashValue:(NSData *)hashValue signingKeyFingerprint:(NSData *)signingKeyFingerprint {
+    let keyData = [NSMutableData data];
+    UInt8 hashAlgorithm = signature.hashAlgoritm;
+    [keyData appendBytes:&hashAlgorithm length:1];
+    [keyData appendData:hashValue];
+    [keyData appendData:signingKeyFingerprint];
+    for (PGPMPI *mpi in signature.signatureMPIs) {
+        [keyData pgp_appendData:[mpi exportMPI]];
+    }
+    return [keyData pgp_SHA256];
+}
+
+- (NSUInteger)count {
+    __block NSUInteger count = 0;
+    dispatch_sync(_queue, ^{
+        count = self->_keys.count;
+    });
+    return count;
+}
+
+- (BOOL)containsKey:(NSData *)key {
+    PGPAssertClass(key, NSData);
+
+    __block BOOL contains = NO;
+    dispatch_sync(_queue, ^{
+        contains = [self->_keys containsObject:key];
+        if (contains) {
+            [self->_keys removeObject:key];
+            [self->_keys addObject:key];
+        }
+    });
+    return contains;
+}
+
+- (void)addKey:(NSData *)key signingKeyFingerprint:(NSData *)signingKeyFingerprint {
+    PGPAssertClass(key, NSData);
+    PGPAssertClass(signingKeyFingerprint, NSData);
+
+    if (self.capacity == 0) {
+        return;
+    }
+
+    dispatch_sync(_queue, ^{
+        if ([self->_keys containsObject:key]) {
+            [self->_keys removeObject:key];
+        } else {
+            while (self->_keys.count >= self.capacity) {
+                [self removeKey:PGPNN(self->_keys.firstObject)];
+            }
+            self->_fingerprintsByKey[key] = signingKeyFingerprint;
+            let fingerprintKeys = self->_keysByFingerprint[signingKeyFingerprint] ?: [NSMutableSet<NSData *> set];
+            [fingerprintKeys addObject:key];
+            self->_keysByFingerprint[signingKeyFingerprint] = fingerprintKeys;
+        }
+        [self->_keys addObject:key];
+    });
+}
+
+- (void)removeKeysOfSigningKeyFingerprint:(NSData *)signingKeyFingerprint {
+    PGPAssertClass(signingKeyFingerprint, NSData);
+
+    dispatch_sync(_queue, ^{
+        for (NSData *key in [self->_keysByFingerprint[signingKeyFingerprint] copy]) {
+            [self removeKey:key];
+        }
+    });
+}
+
+- (void)removeAllKeys {
+    dispatch_sync(_queue, ^{
+        [self->_keys removeAllObjects];
+        [self->_fingerprintsByKey removeAllObjects];
+        [self->_keysByFingerprint removeAllObjects];
+    });
+}
+
+#pragma mark - Private
+
+// On the queue.
+- (void)removeKey:(NSData *)key {
+    [_keys removeObject:key];
+    let _Nullable signingKeyFingerprint = _fingerprintsByKey[key];
+    if (!signingKeyFingerprint) {
+        return;
+    }
+    [_fingerprintsByKey removeObjectForKey:key];
+    let _Nullable fingerprintKeys = _keysByFingerprint[PGPNN(signingKeyFingerprint)];
+    [fingerprintKeys removeObject:key];
+    if (fingerprintKeys && fingerprintKeys.count == 0) {
+        [_keysByFingerprint removeObjectForKey:PGPNN(signingKeyFingerprint)];
+    }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
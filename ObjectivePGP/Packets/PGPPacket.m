@@ -81,41 +81,32 @@ NS_ASSUME_NONNULL_BEGIN
 // 4.2.  Packet Headers
 /// Parse packet header and body, and return body. Parse packet header and read the followed data (packet body)
 + (nullable NSData *)readPacketBody:(NSData *)data headerLength:(UInt32 *)headerLength consumedBytes:(nullable NSUInteger *)consumedBytes packetTag:(nullable PGPPacketTag *)tag indeterminateLength:(nullable BOOL *)indeterminateLength {
-    NSParameterAssert(headerLength);
-
-    UInt8 headerByte = 0;
-    [data getBytes:&headerByte range:(NSRange){0, 1}];
+    return [self readPacketBody:data offset:0 headerLength:headerLength consumedBytes:consumedBytes packetTag:tag indeterminateLength:indeterminateLength];
+}
 
-    BOOL isPGPHeader = !!(headerByte & PGPHeaderPacketTagAllwaysSet);
-    BOOL isNewFormat = !!(headerByte & PGPHeaderPacketTagNewFormat);
+// Reads the packet in place, only the packet body is copied. Nothing is consumed if there is no valid packet at the offset.
++ (nullable NSData *)readPacketBody:(NSData *)data offset:(NSUInteger)offset headerLength:(UInt32 *)headerLength consumedBytes:(nullable NSUInteger *)consumedBytes packetTag:(nullable PGPPacketTag *)tag indeterminateLength:(nullable BOOL *)indeterminateLength {
+    NSParameterAssert(headerLength);
 
-    if (!isPGPHeader) {
-        // not a valida data, skip the whole data.
-        if (consumedBytes) {
-            *consumedBytes = data.length;
-        }
-        return nil;
+    if (consumedBytes) {
+        *consumedBytes = 0;
     }
 
-    PGPPacketHeader *header = nil;
-    if (isNewFormat) {
-        header = [PGPPacketHeader newFormatHeaderFromData:data];
-    } else {
-        header = [PGPPacketHeader oldFormatHeaderFromData:data];
+    let header = [PGPPacketHeader headerFromData:data offset:offset];
+    if (!header) {
+        // not a valid data
+        return nil;
     }
 
+    let availableLength = data.length - offset;
     if (header.isIndeterminateLength) {
         // overwrite header body length
-        header.bodyLength = (UInt32)data.length - header.headerLength;
+        header.bodyLength = availableLength - header.headerLength;
     }
 
-    if (header.bodyLength + header.headerLength > data.length) {
-      PGPLogWarning(@"Invalid packet header.");
-      // not a valida data, skip the whole data.
-      if (consumedBytes) {
-        *consumedBytes = data.length;
-      }
-      return nil;
+    if (header.bodyLength + header.headerLength > availableLength) {
+        PGPLogWarning(@"Invalid packet header.");
+        return nil;
     }
 
     *headerLength = header.headerLength;
@@ -124,9 +115,8 @@ NS_ASSUME_NONNULL_BEGIN
 
     if (header.isPartialLength && !header.isIndeterminateLength) {
         // Partial data starts with length octets offset (right after the packet header byte)
-        let partialData = [data subdataWithRange:(NSRange){header.headerLength - 1, data.length - (header.headerLength - 1)}];
         NSUInteger partialConsumedBytes = 0;
-        let concatenatedData = [PGPPacket readPartialData:partialData consumedBytes:&partialConsumedBytes];
+        let concatenatedData = [PGPPacket readPartialData:data offset:offset + header.headerLength - 1 consumedBytes:&partialConsumedBytes];
         if (consumedBytes) {
             *consumedBytes = partialConsumedBytes + 1;
         }
@@ -136,32 +126,33 @@ NS_ASSUME_NONNULL_BEGIN
     if (consumedBytes) {
         *consumedBytes = header.bodyLength + header.headerLength;
     }
-    return [data subdataWithRange:(NSRange){header.headerLength, header.bodyLength}];
+    return [data subdataWithRange:(NSRange){offset + header.headerLength, header.bodyLength}];
 }
 
 // Read partial data. Part by part and return concatenated body data
-+ (NSData *)readPartialData:(NSData *)data consumedBytes:(NSUInteger *)consumedBytes {
++ (NSData *)readPartialData:(NSData *)data offset:(NSUInteger)partialOffset consumedBytes:(NSUInteger *)consumedBytes {
     BOOL hasMoreData = YES;
-    NSUInteger offset = 0;
-    let accumulatedData = [NSMutableData dataWithCapacity:data.length];
+    NSUInteger offset = partialOffset;
+    let accumulatedData = [NSMutableData dataWithCapacity:data.length - partialOffset];
 
-    while (hasMoreData) {
+    while (hasMoreData && offset < data.length) {
         BOOL isPartial = NO;
         NSUInteger partBodyLength = 0;
         UInt8  partLengthOctets = 0;
 
-        // length + body
-        let partData = [data subdataWithRange:(NSRange){offset, data.length - offset}];
-        [PGPPacketHeader getLengthFromNewFormatOctets:partData bodyLength:&partBodyLength bytesCount:&partLengthOctets isPartial:&isPartial];
+        // up to 5 length octets, zero padded at the end of data
+        UInt8 lengthOctets[5] = {0, 0, 0, 0, 0};
+        [data getBytes:lengthOctets range:(NSRange){offset, MIN(sizeof(lengthOctets), data.length - offset)}];
+        [PGPPacketHeader getLengthFromNewFormatOctets:[NSData dataWithBytesNoCopy:lengthOctets length:sizeof(lengthOctets) freeWhenDone:NO] bodyLength:&partBodyLength bytesCount:&partLengthOctets isPartial:&isPartial];
+        partLengthOctets = (UInt8)MIN(partLengthOctets, data.length - offset);
 
         // the last Body Length header can be a zero-length header.
         // in that case just skip it.
         if (partBodyLength > 0) {
-            partBodyLength = MIN(partBodyLength, data.length - offset);
+            partBodyLength = MIN(partBodyLength, data.length - offset - partLengthOctets);
 
             // Append just body. Skip the length bytes.
-            let partBodyData = [data subdataWithRange:(NSRange){offset + partLengthOctets, partBodyLength}];
-            [accumulatedData appendData:partBodyData];
+            [accumulatedData appendBytes:(const UInt8 *)data.bytes + offset + partLengthOctets length:partBodyLength];
         }
 
         // move to next part
@@ -169,7 +160,7 @@ NS_ASSUME_NONNULL_BEGIN
         hasMoreData = isPartial;
     }
 
-    *consumedBytes = offset;
+    *consumedBytes = offset - partialOffset;
     return accumulatedData;
 }
 
@@ -24,6 +24,8 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (nullable PGPPacketHeader *)newFormatHeaderFromData:(NSData *)data;
 + (nullable PGPPacketHeader *)oldFormatHeaderFromData:(NSData *)data;
+// Header of the packet at the offset. Reads the header octets only, nil if there is no valid header.
++ (nullable PGPPacketHeader *)headerFromData:(NSData *)data offset:(NSUInteger)offset;
 + (NSData *)buildNewFormatLengthDataForData:(NSData *)bodyData;
 + (NSData *)buildOldFormatLengthDataForData:(NSData *)bodyData;
 
@@ -156,6 +156,30 @@ NS_ASSUME_NONNULL_BEGIN
     return header;
 }
 
++ (nullable PGPPacketHeader *)headerFromData:(NSData *)data offset:(NSUInteger)offset {
+    NSParameterAssert(data);
+
+    if (offset >= data.length) {
+        return nil;
+    }
+
+    UInt8 headerByte = 0;
+    [data getBytes:&headerByte range:(NSRange){offset, 1}];
+    if (!(headerByte & PGPHeaderPacketTagAllwaysSet)) {
+        return nil;
+    }
+
+    // Header octet and up to 5 length octets, zero padded at the end of data
+    let availableLength = MIN((NSUInteger)6, data.length - offset);
+    let headerData = [NSMutableData dataWithLength:6];
+    [data getBytes:headerData.mutableBytes range:(NSRange){offset, availableLength}];
+    let header = (headerByte & PGPHeaderPacketTagNewFormat) ? [PGPPacketHeader newFormatHeaderFromData:headerData] : [PGPPacketHeader oldFormatHeaderFromData:headerData];
+    if (!header || header.headerLength > availableLength) {
+        return nil;
+    }
+    return header;
+}
+
 + (NSData *)buildNewFormatLengthDataForData:(NSData *)bodyData {
     let data = [NSMutableData data];
     // write length octets
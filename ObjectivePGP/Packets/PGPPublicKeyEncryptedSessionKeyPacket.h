@@ -18,9 +18,13 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic) UInt8 version;
 @property (nonatomic) PGPPublicKeyAlgorithm publicKeyAlgorithm;
 @property (nonatomic, copy) PGPKeyID *keyID;
+// Version 6. Recipient key version and fingerprint, nil for an anonymous recipient. keyID is derived from the fingerprint.
+@property (nonatomic) UInt8 keyVersion;
+@property (nonatomic, copy, nullable) NSData *keyFingerprint;
 
 - (BOOL)encrypt:(PGPPublicKeyPacket *)publicKeyPacket sessionKeyData:(NSData *)sessionKeyData sessionKeyAlgorithm:(PGPSymmetricAlgorithm)sessionKeyAlgorithm error:(NSError * __autoreleasing _Nullable *)error;
 
+/// Version 6 packet does not carry the session key algorithm, sessionKeyAlgorithm is set to PGPSymmetricPlaintext.
 - (nullable NSData *)decryptSessionKeyData:(PGPSecretKeyPacket *)secretKeyPacket sessionKeyAlgorithm:(PGPSymmetricAlgorithm *)sessionKeyAlgorithm error:(NSError * __autoreleasing _Nullable *)error;
 
 @end
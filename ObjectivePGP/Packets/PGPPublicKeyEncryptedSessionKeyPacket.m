@@ -64,15 +64,41 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSUInteger)parsePacketBody:(NSData *)packetBody error:(NSError * __autoreleasing _Nullable *)error {
     NSUInteger position = [super parsePacketBody:packetBody error:error];
 
-    // - A one-octet number giving the version number of the packet type. The currently defined value for packet version is 3.
+    // - A one-octet number giving the version number of the packet type. The currently defined values for packet version are 3 and 6.
     [packetBody getBytes:&_version range:(NSRange){position, 1}];
-    NSAssert(self.version == 3, @"The currently defined value for packet version is 3");
+    NSAssert(self.version == 3 || self.version == 6, @"The currently defined values for packet version are 3 and 6");
     position = position + 1;
 
-    // - An eight-octet number that gives the Key ID of the public key
-    self.keyID = [[PGPKeyID alloc] initWithLongKey:[packetBody subdataWithRange:(NSRange){position, 8}]];
+    if (self.version == 6) {
+        // - A one-octet size of the following two fields. The size may be zero for an anonymous recipient.
+        UInt8 fieldsLength = 0;
+        [packetBody getBytes:&fieldsLength range:(NSRange){position, 1}];
+        position = position + 1;
+
+        if (fieldsLength > 0) {
+            // - A one octet key version number.
+            [packetBody getBytes:&_keyVersion range:(NSRange){position, 1}];
+            position = position + 1;
+
+            // - The fingerprint of the public key or subkey to which the session key is encrypted.
+            self.keyFingerprint = [packetBody subdataWithRange:(NSRange){position, fieldsLength - 1}];
+            position = position + fieldsLength - 1;
+        }
+
+        // Key ID is the low-order 64 bits of the v4 fingerprint, or the high-order 64 bits of the v6 fingerprint.
+        let fingerprint = self.keyFingerprint;
+        if (fingerprint.length >= 8) {
+            NSRange keyIDRange = self.keyVersion == 6 ? (NSRange){0, 8} : (NSRange){fingerprint.length - 8, 8};
+            self.keyID = [[PGPKeyID alloc] initWithLongKey:[fingerprint subdataWithRange:keyIDRange]];
+        } else {
+            self.keyID = [[PGPKeyID alloc] initWithLongKey:[NSMutableData dataWithLength:8]];
+        }
+    } else {
+        // - An eight-octet number that gives the Key ID of the public key
+        self.keyID = [[PGPKeyID alloc] initWithLongKey:[packetBody subdataWithRange:(NSRange){position, 8}]];
+        position = position + 8;
+    }
     NSAssert(self.keyID, @"Missing KeyID");
-    position = position + 8;
 
     // - A one-octet number giving the public-key algorithm used.
     [packetBody getBytes:&_publicKeyAlgorithm range:(NSRange){position, 1}];
@@ -196,7 +222,13 @@ NS_ASSUME_NONNULL_BEGIN
 // encryption update self.encryptedMPIs
 - (BOOL)encrypt:(PGPPublicKeyPacket *)publicKeyPacket sessionKeyData:(NSData *)sessionKeyData sessionKeyAlgorithm:(PGPSymmetricAlgorithm)sessionKeyAlgorithm error:(NSError * __autoreleasing _Nullable *)error {
     let data = [NSMutableData data];
-    [data appendBytes:&sessionKeyAlgorithm length:1];
+    if (self.version == 6) {
+        // Version 6 does not include the symmetric algorithm, it is stored in the v2 encrypted data packet
+        self.keyVersion = publicKeyPacket.version;
+        self.keyFingerprint = publicKeyPacket.fingerprint.hashedData;
+    } else {
+        [data appendBytes:&sessionKeyAlgorithm length:1];
+    }
     [data appendData:sessionKeyData]; // keySize
 
     UInt16 checksum = [sessionKeyData pgp_Checksum];
@@ -267,8 +299,13 @@ NS_ASSUME_NONNULL_BEGIN
     let V = [[self parameterMPI:PGPMPIdentifierV] bodyData]; // V aka public encrypted
 
     // - Generate ECDHE secret from private key and public part of ephemeral key
-    let D = [[secretKeyPacket secretMPI: PGPMPIdentifierD] bodyData]; // private key
-    let sharedKey = [PGPEC generate25519PrivateEphemeralKeyWith:V curveKind:secretKeyPacket.curveOID.curveKind privateKey:D];
+    let sharedKey = V ? [PGPEC ECDHSharedKeyWithEphemeralPublicKey:PGPNN(V) secretKeyPacket:secretKeyPacket] : nil;
+    if (!sharedKey) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{NSLocalizedDescriptionKey: @"Cannot decrypt. Unable to compute the ECDH shared secret."}];
+        }
+        return nil;
+    }
 
     // - The KDF parameters https://datatracker.ietf.org/doc/html/rfc6637#section-8
     let kdfParam = [NSMutableData data];
@@ -363,17 +400,28 @@ NS_ASSUME_NONNULL_BEGIN
         return nil;
     }
 
+    if (!decoded) {
+        return nil;
+    }
+
     NSUInteger position = 0;
     PGPSymmetricAlgorithm sessionKeyAlgorithmRead = PGPSymmetricPlaintext;
-    [decoded getBytes:&sessionKeyAlgorithmRead range:(NSRange){position, 1}];
-    NSAssert(sessionKeyAlgorithmRead < PGPSymmetricMax, @"Invalid algorithm");
+    NSUInteger sessionKeySize = NSNotFound;
+    if (self.version == 6) {
+        // session key followed by the two-octet checksum
+        sessionKeySize = decoded.length > 2 ? decoded.length - 2 : NSNotFound;
+    } else {
+        [decoded getBytes:&sessionKeyAlgorithmRead range:(NSRange){position, 1}];
+        NSAssert(sessionKeyAlgorithmRead < PGPSymmetricMax, @"Invalid algorithm");
+        position = position + 1;
+        sessionKeySize = [PGPCryptoUtils keySizeOfSymmetricAlgorithm:sessionKeyAlgorithmRead];
+    }
+
     if (sessionKeyAlgorithm) {
         *sessionKeyAlgorithm = sessionKeyAlgorithmRead;
     }
-    position = position + 1;
 
-    NSUInteger sessionKeySize = [PGPCryptoUtils keySizeOfSymmetricAlgorithm:sessionKeyAlgorithmRead];
-    if (sessionKeySize == NSNotFound) {
+    if (sessionKeySize == NSNotFound || decoded.length < position + sessionKeySize + 2) {
         if (error) {
             *error = [NSError errorWithDomain:PGPErrorDomain code:0 userInfo:@{ NSLocalizedDescriptionKey: @"Invalid session key size" }];
         }
@@ -404,7 +452,16 @@ NS_ASSUME_NONNULL_BEGIN
     let bodyData = [NSMutableData data];
 
     [bodyData appendBytes:&_version length:1]; // 1
-    [bodyData appendData:[self.keyID export:nil]]; // 8
+    if (self.version == 6) {
+        UInt8 fieldsLength = self.keyFingerprint ? (UInt8)(1 + self.keyFingerprint.length) : 0;
+        [bodyData appendBytes:&fieldsLength length:1]; // 1
+        if (self.keyFingerprint) {
+            [bodyData appendBytes:&_keyVersion length:1]; // 1
+            [bodyData pgp_appendData:self.keyFingerprint]; // 20 or 32
+        }
+    } else {
+        [bodyData appendData:[self.keyID export:nil]]; // 8
+    }
     [bodyData appendBytes:&_publicKeyAlgorithm length:1]; // 1
 
     switch (self.publicKeyAlgorithm) {
@@ -483,6 +540,8 @@ NS_ASSUME_NONNULL_BEGIN
     return self.version == packet.version &&
            self.publicKeyAlgorithm == packet.publicKeyAlgorithm &&
            PGPEqualObjects(self.keyID, packet.keyID) &&
+           self.keyVersion == packet.keyVersion &&
+           PGPEqualObjects(self.keyFingerprint, packet.keyFingerprint) &&
            PGPEqualObjects(self.parameters, packet.parameters);
 }
 
@@ -492,6 +551,7 @@ NS_ASSUME_NONNULL_BEGIN
     result = prime * result + self.version;
     result = prime * result + self.publicKeyAlgorithm;
     result = prime * result + self.keyID.hash;
+    result = prime * result + self.keyFingerprint.hash;
     result = prime * result + self.parameters.hash;
     return result;
 }
@@ -504,6 +564,8 @@ NS_ASSUME_NONNULL_BEGIN
     duplicate.version = self.version;
     duplicate.publicKeyAlgorithm = self.publicKeyAlgorithm;
     duplicate.keyID = self.keyID;
+    duplicate.keyVersion = self.keyVersion;
+    duplicate.keyFingerprint = self.keyFingerprint;
     duplicate.parameters = self.parameters;
     return duplicate;
 }
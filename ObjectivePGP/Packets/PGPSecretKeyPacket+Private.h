@@ -17,10 +17,17 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, readwrite) PGPS2KUsage s2kUsage;
 @property (nonatomic, copy, readwrite) PGPS2K *s2k;
 @property (nonatomic, readwrite) PGPSymmetricAlgorithm symmetricAlgorithm;
+@property (nonatomic, readwrite) PGPAEADAlgorithm aeadAlgorithm;
 @property (nonatomic, copy, nullable, readwrite) NSData *ivData;
 @property (nonatomic, copy) NSArray<PGPMPI *> *secretMPIs; // decrypted MPI
 @property (nonatomic, nullable, copy) NSData *encryptedMPIPartData; // after decrypt -> secretMPIs
 
+/**
+ Protect the secret MPIs with the passphrase and the AEAD algorithm (S2K usage 253).
+ The key of the AEAD algorithm is derived with HKDF from the S2K key, eg. Argon2.
+ */
+- (BOOL)encryptWithPassphrase:(NSString *)passphrase s2k:(PGPS2K *)s2k aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm error:(NSError * __autoreleasing _Nullable *)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -17,6 +17,8 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, readonly) PGPS2KUsage s2kUsage;
 @property (nonatomic, copy, readonly) PGPS2K *s2k;
 @property (nonatomic, readonly) PGPSymmetricAlgorithm symmetricAlgorithm;
+/// AEAD algorithm of the secret key material, S2K usage 253 only.
+@property (nonatomic, readonly) PGPAEADAlgorithm aeadAlgorithm;
 @property (nonatomic, nullable, copy, readonly) NSData *ivData;
 @property (nonatomic, getter=isEncryptedWithPassphrase, readonly) BOOL encryptedWithPassphrase;
 
@@ -23,6 +23,7 @@
 
 #import "NSData+PGPUtils.h"
 #import "PGPCryptoCFB.h"
+#import "PGPCryptoAEAD.h"
 #import "PGPCryptoUtils.h"
 #import "PGPRSA.h"
 
@@ -51,7 +52,16 @@ NS_ASSUME_NONNULL_BEGIN
         return NO;
     }
 
-    return (self.s2kUsage == PGPS2KUsageEncrypted || self.s2kUsage == PGPS2KUsageEncryptedAndHashed);
+    return (self.s2kUsage == PGPS2KUsageEncrypted || self.s2kUsage == PGPS2KUsageEncryptedAndHashed || self.s2kUsage == PGPS2KUsageEncryptedAEAD);
+}
+
+// RFC 9580 3.7.2.1: Argon2 MUST be used only with AEAD (S2K usage octet 253), not with the CFB protection (254, 255).
+- (BOOL)isArgon2WithoutAEAD {
+    return (self.s2kUsage == PGPS2KUsageEncrypted || self.s2kUsage == PGPS2KUsageEncryptedAndHashed) && self.s2k.specifier == PGPS2KSpecifierArgon2;
+}
+
++ (NSError *)argon2WithoutAEADError {
+    return [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{NSLocalizedDescriptionKey: @"Argon2 S2K is allowed only with AEAD secret key protection."}];
 }
 
 - (nullable PGPMPI *)secretMPI:(NSString *)identifier {
@@ -80,7 +90,7 @@ NS_ASSUME_NONNULL_BEGIN
     [packetBody getBytes:&_s2kUsage range:(NSRange){position, 1}];
     position = position + 1;
 
-    if (self.s2kUsage == PGPS2KUsageEncrypted || self.s2kUsage == PGPS2KUsageEncryptedAndHashed) {
+    if (self.s2kUsage == PGPS2KUsageEncrypted || self.s2kUsage == PGPS2KUsageEncryptedAndHashed || self.s2kUsage == PGPS2KUsageEncryptedAEAD) {
         // moved to parseEncryptedPart:error
     } else if (self.s2kUsage != PGPS2KUsageNonEncrypted) {
         // this is version 3, looks just like a V4 simple hash
@@ -92,8 +102,10 @@ NS_ASSUME_NONNULL_BEGIN
 
     let encryptedData = [packetBody subdataWithRange:(NSRange){position, packetBody.length - position}];
     NSUInteger length = 0;
-    if (self.isEncryptedWithPassphrase && [self parseEncryptedPart:encryptedData length:&length error:error]) {
-        position = position + length;
+    if (self.isEncryptedWithPassphrase) {
+        if ([self parseEncryptedPart:encryptedData length:&length error:error]) {
+            position = position + length;
+        }
     } else if ([self parseUnencryptedPart:encryptedData length:&length error:error]) {
         position = position + length;
     }
@@ -113,21 +125,47 @@ NS_ASSUME_NONNULL_BEGIN
 - (BOOL)parseEncryptedPart:(NSData *)data length:(NSUInteger *)length error:(NSError * __autoreleasing _Nullable *)error {
     NSUInteger position = 0;
 
-    if (self.s2kUsage == PGPS2KUsageEncrypted || self.s2kUsage == PGPS2KUsageEncryptedAndHashed) {
-        // If string-to-key usage octet was 255 or 254, a one-octet symmetric encryption algorithm
+    if (self.s2kUsage == PGPS2KUsageEncrypted || self.s2kUsage == PGPS2KUsageEncryptedAndHashed || self.s2kUsage == PGPS2KUsageEncryptedAEAD) {
+        // If string-to-key usage octet was 255, 254, or 253, a one-octet symmetric encryption algorithm
         [data getBytes:&_symmetricAlgorithm range:(NSRange){position, 1}];
         position = position + 1;
 
+        // If string-to-key usage octet was 253, a one-octet AEAD algorithm
+        if (self.s2kUsage == PGPS2KUsageEncryptedAEAD) {
+            [data getBytes:&_aeadAlgorithm range:(NSRange){position, 1}];
+            position = position + 1;
+        }
+
         // S2K
         NSUInteger s2kParsedLength = 0;
         self.s2k = [PGPS2K S2KFromData:data atPosition:position length:&s2kParsedLength];
         position = position + s2kParsedLength;
+
+        if (self.isArgon2WithoutAEAD) {
+            if (error) {
+                *error = [PGPSecretKeyPacket argon2WithoutAEADError];
+            }
+            *length = data.length;
+            return NO;
+        }
     }
 
     if (self.s2k.specifier == PGPS2KSpecifierGnuDummy) {
         self.ivData = nil;
     } else if (self.s2k.specifier == PGPS2KSpecifierDivertToCard) {
         self.ivData = NSData.data;
+    } else if (self.s2kUsage == PGPS2KUsageEncryptedAEAD) {
+        // Nonce of the size of the AEAD algorithm
+        NSUInteger nonceSize = [PGPCryptoAEAD nonceSizeOfAEADAlgorithm:self.aeadAlgorithm];
+        if (nonceSize == 0 || position + nonceSize > data.length) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{NSLocalizedDescriptionKey: @"Unsupported AEAD algorithm of the secret key."}];
+            }
+            *length = data.length;
+            return NO;
+        }
+        self.ivData = [data subdataWithRange:(NSRange){position, nonceSize}];
+        position = position + nonceSize;
     } else if (self.s2kUsage != PGPS2KUsageNonEncrypted) {
         // Initial Vector (IV) of the same length as the cipher's block size
         NSUInteger blockSize = [PGPCryptoUtils blockSizeOfSymmetricAlhorithm:self.symmetricAlgorithm];
@@ -166,6 +204,9 @@ NS_ASSUME_NONNULL_BEGIN
     // check hash before read actual data
     // hash is physically located at the end of dataBody
     switch (self.s2kUsage) {
+        case PGPS2KUsageEncryptedAEAD:
+            // authenticated by the AEAD algorithm, no checksum
+            break;
         case PGPS2KUsageEncryptedAndHashed: {
             // a 20-octet SHA-1 hash of the plaintext of the algorithm-specific portion.
             NSUInteger hashSize = [PGPCryptoUtils hashSizeOfHashAlhorithm:PGPHashSHA1];
@@ -305,6 +346,13 @@ NS_ASSUME_NONNULL_BEGIN
         return self;
     }
 
+    if (self.isArgon2WithoutAEAD) {
+        if (error) {
+            *error = [PGPSecretKeyPacket argon2WithoutAEADError];
+        }
+        return nil;
+    }
+
     if (!self.ivData) {
         PGPLogError(@"IV is missing...");
         if (error) { *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{NSLocalizedDescriptionKey: @"IV is missing" } ]; };
@@ -325,7 +373,19 @@ NS_ASSUME_NONNULL_BEGIN
     }
 
     // Decrypted MPIArray
-    let decryptedData = [PGPCryptoCFB decryptData:decryptedKeyPacket.encryptedMPIPartData sessionKeyData:sessionKeyData symmetricAlgorithm:encryptionSymmetricAlgorithm iv:decryptedKeyPacket.ivData syncCFB:NO];
+    NSData * _Nullable decryptedData = nil;
+    if (decryptedKeyPacket.s2kUsage == PGPS2KUsageEncryptedAEAD) {
+        let aeadKeyData = [decryptedKeyPacket AEADKeyWithS2KKey:sessionKeyData];
+        decryptedData = aeadKeyData && decryptedKeyPacket.encryptedMPIPartData ? [PGPCryptoAEAD decryptData:PGPNN(decryptedKeyPacket.encryptedMPIPartData) key:PGPNN(aeadKeyData) nonce:PGPNN(decryptedKeyPacket.ivData) associatedData:[decryptedKeyPacket AEADAssociatedData] symmetricAlgorithm:encryptionSymmetricAlgorithm aeadAlgorithm:decryptedKeyPacket.aeadAlgorithm error:nil] : nil;
+        if (!decryptedData) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorPassphraseInvalid userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt the secret key. Invalid passphrase or modified key." }];
+            }
+            return nil;
+        }
+    } else {
+        decryptedData = [PGPCryptoCFB decryptData:decryptedKeyPacket.encryptedMPIPartData sessionKeyData:sessionKeyData symmetricAlgorithm:encryptionSymmetricAlgorithm iv:decryptedKeyPacket.ivData syncCFB:NO];
+    }
 
     // now read mpis
     if (decryptedData) {
@@ -339,6 +399,63 @@ NS_ASSUME_NONNULL_BEGIN
     return decryptedKeyPacket;
 }
 
+#pragma mark - AEAD
+
+- (BOOL)encryptWithPassphrase:(NSString *)passphrase s2k:(PGPS2K *)s2k aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(passphrase, NSString);
+    PGPAssertClass(s2k, PGPS2K);
+
+    let s2kKeyData = [s2k produceSessionKeyWithPassphrase:passphrase symmetricAlgorithm:self.symmetricAlgorithm];
+    if (!s2kKeyData || ![PGPCryptoAEAD isSupportedAEADAlgorithm:aeadAlgorithm symmetricAlgorithm:self.symmetricAlgorithm]) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unsupported secret key protection." }];
+        }
+        return NO;
+    }
+
+    let plaintextMPIPartData = [NSMutableData data];
+    for (PGPMPI *mpi in self.secretMPIs) {
+        [plaintextMPIPartData pgp_appendData:[mpi exportMPI]];
+    }
+
+    let encryptedPacket = PGPCast(self.copy, PGPSecretKeyPacket);
+    encryptedPacket.s2kUsage = PGPS2KUsageEncryptedAEAD;
+    encryptedPacket.aeadAlgorithm = aeadAlgorithm;
+    let aeadKeyData = [encryptedPacket AEADKeyWithS2KKey:PGPNN(s2kKeyData)];
+    let nonce = [PGPCryptoUtils randomData:[PGPCryptoAEAD nonceSizeOfAEADAlgorithm:aeadAlgorithm]];
+    let encryptedData = aeadKeyData ? [PGPCryptoAEAD encryptData:plaintextMPIPartData key:PGPNN(aeadKeyData) nonce:nonce associatedData:[encryptedPacket AEADAssociatedData] symmetricAlgorithm:self.symmetricAlgorithm aeadAlgorithm:aeadAlgorithm error:error] : nil;
+    if (!encryptedData) {
+        return NO;
+    }
+
+    self.s2kUsage = PGPS2KUsageEncryptedAEAD;
+    self.aeadAlgorithm = aeadAlgorithm;
+    self.s2k = s2k;
+    self.ivData = nonce;
+    self.encryptedMPIPartData = encryptedData;
+    return YES;
+}
+
+// Packet type octet in the new format: the first octet of the HKDF info and of the associated data.
+- (UInt8)AEADPacketTypeOctet {
+    return 0xC0 | (UInt8)self.tag;
+}
+
+// RFC 9580 5.5.3. HKDF-SHA256 of the S2K key, info: packet type, version, symmetric and AEAD algorithm.
+- (nullable NSData *)AEADKeyWithS2KKey:(NSData *)s2kKeyData {
+    UInt8 info[4] = {[self AEADPacketTypeOctet], self.version, self.symmetricAlgorithm, self.aeadAlgorithm};
+    return [PGPCryptoAEAD HKDFSHA256WithKey:s2kKeyData salt:nil info:[NSData dataWithBytes:info length:sizeof(info)] length:[PGPCryptoUtils keySizeOfSymmetricAlgorithm:self.symmetricAlgorithm]];
+}
+
+// Packet type octet followed by the public key packet fields.
+- (NSData *)AEADAssociatedData {
+    let associatedData = [NSMutableData data];
+    UInt8 packetTypeOctet = [self AEADPacketTypeOctet];
+    [associatedData appendBytes:&packetTypeOctet length:1];
+    [associatedData appendData:[self buildKeyBodyDataAndForceV4:YES]];
+    return associatedData;
+}
+
 #pragma mark - Private
 
 /**
@@ -352,10 +469,15 @@ NS_ASSUME_NONNULL_BEGIN
     let data = [NSMutableData data];
     [data appendBytes:&self->_s2kUsage length:1];
 
-    if (self.s2kUsage == PGPS2KUsageEncrypted || self.s2kUsage == PGPS2KUsageEncryptedAndHashed) {
-        // If string-to-key usage octet was 255 or 254, a one-octet symmetric encryption algorithm
+    if (self.s2kUsage == PGPS2KUsageEncrypted || self.s2kUsage == PGPS2KUsageEncryptedAndHashed || self.s2kUsage == PGPS2KUsageEncryptedAEAD) {
+        // If string-to-key usage octet was 255, 254, or 253, a one-octet symmetric encryption algorithm
         [data appendBytes:&self->_symmetricAlgorithm length:1];
 
+        // If string-to-key usage octet was 253, a one-octet AEAD algorithm
+        if (self.s2kUsage == PGPS2KUsageEncryptedAEAD) {
+            [data appendBytes:&self->_aeadAlgorithm length:1];
+        }
+
         // If string-to-key usage octet was 255 or 254, a string-to-key specifier.
         NSError *exportError = nil;
         let exportS2K = [self.s2k export:&exportError];
@@ -365,7 +487,8 @@ NS_ASSUME_NONNULL_BEGIN
 
     if (self.s2kUsage != PGPS2KUsageNonEncrypted) {
         NSAssert(self.ivData, @"Require IV");
-        // If secret data is encrypted (string-to-key usage octet not zero), an Initial Vector (IV) of the same length as the cipher's block size.
+        // If secret data is encrypted (string-to-key usage octet not zero), an Initial Vector (IV) of the same length as the cipher's block size,
+        // or the nonce of the AEAD algorithm (usage 253).
         // Initial Vector (IV) of the same length as the cipher's block size
         [data pgp_appendData:self.ivData];
     }
@@ -392,6 +515,13 @@ NS_ASSUME_NONNULL_BEGIN
 #pragma mark - PGPExportable
 
 - (nullable NSData *)export:(NSError * __autoreleasing _Nullable *)error {
+    if (self.isArgon2WithoutAEAD) {
+        if (error) {
+            *error = [PGPSecretKeyPacket argon2WithoutAEADError];
+        }
+        return nil;
+    }
+
     return [PGPPacket buildPacketOfType:self.tag withBody:^NSData * {
         let secretKeyPacketData = [NSMutableData data];
         [secretKeyPacketData appendData:[self buildKeyBodyDataAndForceV4:YES]];
@@ -413,6 +543,7 @@ NS_ASSUME_NONNULL_BEGIN
 - (BOOL)isEqualToKeyPacket:(PGPSecretKeyPacket *)packet {
     return self.version == packet.version &&
         self.s2kUsage == packet.s2kUsage &&
+        self.aeadAlgorithm == packet.aeadAlgorithm &&
         self.publicKeyAlgorithm == packet.publicKeyAlgorithm &&
         self.V3validityPeriod == packet.V3validityPeriod &&
         PGPEqualObjects(self.createDate, packet.createDate) &&
@@ -441,6 +572,7 @@ NS_ASSUME_NONNULL_BEGIN
     duplicate.s2kUsage = self.s2kUsage;
     duplicate.s2k = self.s2k;
     duplicate.symmetricAlgorithm = self.symmetricAlgorithm;
+    duplicate.aeadAlgorithm = self.aeadAlgorithm;
     duplicate.ivData = self.ivData;
     duplicate.secretMPIs = [[NSArray alloc] initWithArray:self.secretMPIs copyItems:YES];
     duplicate.encryptedMPIPartData = self.encryptedMPIPartData;;
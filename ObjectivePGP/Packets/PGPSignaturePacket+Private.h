@@ -10,11 +10,20 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/// Result of the verification of a key signature, cached on the packet.
+typedef NS_ENUM(UInt8, PGPSignatureValidity) {
+    PGPSignatureValidityUnknown = 0, // not verified, or not verifiable
+    PGPSignatureValidityValid = 1,
+    PGPSignatureValidityInvalid = 2
+};
+
 @interface PGPSignaturePacket ()
 
 @property (nonatomic, copy, readwrite) NSArray<PGPSignatureSubpacket *> *hashedSubpackets;
 @property (nonatomic, copy, readwrite) NSArray<PGPSignatureSubpacket *> *unhashedSubpackets;
 @property (nonatomic, readwrite) PGPSignatureType type;
+/// Set by `PGPKeyValidator`. Reset when the signature changes.
+@property (nonatomic) PGPSignatureValidity validity;
 
 PGP_EMPTY_INIT_UNAVAILABLE
 
@@ -23,6 +32,8 @@ PGP_EMPTY_INIT_UNAVAILABLE
 - (nullable NSData *)buildDataToSignForType:(PGPSignatureType)type inputData:(nullable NSData *)inputData key:(nullable PGPKey *)key subKey:(nullable PGPKey *)subKey userID:(nullable NSString *)userID error:(NSError * __autoreleasing _Nullable *)error;
 - (nullable NSData *)buildFullSignatureBodyData;
 - (nullable PGPMPI *)signatureMPI:(NSString *)identifier;
+- (BOOL)signToSignData:(NSData *)toSignData withKey:(PGPKey *)key error:(NSError * __autoreleasing _Nullable *)error;
+- (BOOL)verifyToSignData:(NSData *)toSignData signingKeyPacket:(PGPPublicKeyPacket *)signingKeyPacket error:(NSError * __autoreleasing _Nullable *)error;
 
 @end
 
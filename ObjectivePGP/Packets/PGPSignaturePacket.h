@@ -41,6 +41,14 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, readonly, readonly, getter=isExpired) BOOL expired; // computed
 @property (nonatomic, nullable, readonly) NSDate *creationDate; // computed
 @property (nonatomic, readonly, readonly, getter=isPrimaryUserID) BOOL primaryUserID; // computed
+/// Flags of the Key Flags subpacket (`PGPSignatureFlags`).
+@property (nonatomic, copy, readonly) NSArray<NSNumber *> *keyFlags; // computed
+/// Algorithms of the Preferred Symmetric Algorithms subpacket (`PGPSymmetricAlgorithm`).
+@property (nonatomic, copy, readonly) NSArray<NSNumber *> *preferredSymmetricAlgorithms; // computed
+/// Level (depth) of the hashed Trust Signature subpacket. 0 for a plain certification.
+@property (nonatomic, readonly) UInt8 trustLevel; // computed
+/// Amount of the hashed Trust Signature subpacket. 0 for a plain certification.
+@property (nonatomic, readonly) UInt8 trustAmount; // computed
 
 /**
  *  Create signature packet for signing. This is convienience constructor.
@@ -52,7 +60,10 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (PGPSignaturePacket *)signaturePacket:(PGPSignatureType)type hashAlgorithm:(PGPHashAlgorithm)hashAlgorithm;
 
+/// Hashed, then unhashed subpackets of the type. Looked up in a table built when the subpackets are set.
 - (NSArray<PGPSignatureSubpacket *> *)subpacketsOfType:(PGPSignatureSubpacketType)type;
+/// Subpackets of the type in the hashed area only, covered by the signature.
+- (NSArray<PGPSignatureSubpacket *> *)hashedSubpacketsOfType:(PGPSignatureSubpacketType)type;
 - (NSData *)calculateSignedHashForDataToSign:(NSData *)dataToSign;
 
 /**
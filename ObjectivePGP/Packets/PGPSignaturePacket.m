@@ -22,6 +22,7 @@
 #import "PGPSignatureSubpacketHeader.h"
 #import "PGPUser.h"
 #import "PGPUserIDPacket.h"
+#import "PGPVerificationCache.h"
 #import "PGPS2K.h"
 #import "PGPFoundation.h"
 #import "NSMutableData+PGPUtils.h"
@@ -45,7 +46,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
-@implementation PGPSignaturePacket
+@implementation PGPSignaturePacket {
+    // Hashed, then unhashed subpackets by type (without the critical bit).
+    NSDictionary<NSNumber *, NSArray<PGPSignatureSubpacket *> *> *_subpacketsByType;
+    // Signed part as parsed, from the version through the hashed subpackets. Dropped when any of its fields change.
+    NSData * _Nullable _signedPartData;
+}
+
+@synthesize validity = _validity;
 
 - (instancetype)init {
     if (self = [super init]) {
@@ -55,6 +63,7 @@ NS_ASSUME_NONNULL_BEGIN
         _hashedSubpackets = [NSArray<PGPSignatureSubpacket *> array];
         _unhashedSubpackets = [NSArray<PGPSignatureSubpacket *> array];
         _signatureMPIs = [NSArray<PGPMPI *> array];
+        _subpacketsByType = [NSDictionary<NSNumber *, NSArray<PGPSignatureSubpacket *> *> dictionary];
     }
     return self;
 }
@@ -117,9 +126,86 @@ NS_ASSUME_NONNULL_BEGIN
     duplicate.signatureMPIs = [[NSArray alloc] initWithArray:self.signatureMPIs copyItems:YES];
     duplicate.hashedSubpackets = [[NSArray alloc] initWithArray:self.hashedSubpackets copyItems:YES];
     duplicate.unhashedSubpackets = [[NSArray alloc] initWithArray:self.unhashedSubpackets copyItems:YES];
+    duplicate->_signedPartData = _signedPartData;
+    duplicate.validity = self.validity;
     return duplicate;
 }
 
+#pragma mark - Properties
+
+- (void)setVersion:(UInt8)version {
+    _version = version;
+    _signedPartData = nil;
+    self.validity = PGPSignatureValidityUnknown;
+}
+
+- (void)setType:(PGPSignatureType)type {
+    _type = type;
+    _signedPartData = nil;
+    self.validity = PGPSignatureValidityUnknown;
+}
+
+- (void)setPublicKeyAlgorithm:(PGPPublicKeyAlgorithm)publicKeyAlgorithm {
+    _publicKeyAlgorithm = publicKeyAlgorithm;
+    _signedPartData = nil;
+    self.validity = PGPSignatureValidityUnknown;
+}
+
+- (void)setHashAlgoritm:(PGPHashAlgorithm)hashAlgoritm {
+    _hashAlgoritm = hashAlgoritm;
+    _signedPartData = nil;
+    self.validity = PGPSignatureValidityUnknown;
+}
+
+- (void)setHashedSubpackets:(NSArray<PGPSignatureSubpacket *> *)hashedSubpackets {
+    _hashedSubpackets = [hashedSubpackets copy];
+    _signedPartData = nil;
+    self.validity = PGPSignatureValidityUnknown;
+    [self indexSubpackets];
+}
+
+- (void)setSignedHashValueData:(nullable NSData *)signedHashValueData {
+    _signedHashValueData = [signedHashValueData copy];
+    self.validity = PGPSignatureValidityUnknown;
+}
+
+- (void)setSignatureMPIs:(NSArray<PGPMPI *> *)signatureMPIs {
+    _signatureMPIs = [signatureMPIs copy];
+    self.validity = PGPSignatureValidityUnknown;
+}
+
+// Verified concurrently, read and written under the lock.
+- (PGPSignatureValidity)validity {
+    @synchronized(self) {
+        return _validity;
+    }
+}
+
+- (void)setValidity:(PGPSignatureValidity)validity {
+    @synchronized(self) {
+        _validity = validity;
+    }
+}
+
+- (void)setUnhashedSubpackets:(NSArray<PGPSignatureSubpacket *> *)unhashedSubpackets {
+    _unhashedSubpackets = [unhashedSubpackets copy];
+    [self indexSubpackets];
+}
+
+- (void)indexSubpackets {
+    let subpacketsByType = [NSMutableDictionary<NSNumber *, NSMutableArray<PGPSignatureSubpacket *> *> dictionary];
+    for (PGPSignatureSubpacket *subpacket in self.subpackets) {
+        let type = @(subpacket.type & 0x7F);
+        var subpacketsOfType = subpacketsByType[type];
+        if (!subpacketsOfType) {
+            subpacketsOfType = [NSMutableArray<PGPSignatureSubpacket *> arrayWithCapacity:1];
+            subpacketsByType[type] = subpacketsOfType;
+        }
+        [subpacketsOfType addObject:subpacket];
+    }
+    _subpacketsByType = subpacketsByType;
+}
+
 #pragma mark - Helper properties
 
 - (nullable PGPKeyID *)issuerKeyID {
@@ -132,13 +218,34 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (NSArray<PGPSignatureSubpacket *> *)subpacketsOfType:(PGPSignatureSubpacketType)type {
-    let filteredSubpackets = [NSMutableArray<PGPSignatureSubpacket *> array];
-    for (PGPSignatureSubpacket *subPacket in self.subpackets) {
-        if ((subPacket.type & 0x7F) == type) {
-            [filteredSubpackets addObject:subPacket];
-        }
-    }
-    return filteredSubpackets;
+    return _subpacketsByType[@(type & 0x7F)] ?: @[];
+}
+
+- (NSArray<PGPSignatureSubpacket *> *)hashedSubpacketsOfType:(PGPSignatureSubpacketType)type {
+    return [self.hashedSubpackets pgp_objectsPassingTest:^BOOL(PGPSignatureSubpacket *subpacket, BOOL *stop) {
+        return (subpacket.type & 0x7F) == (type & 0x7F);
+    }];
+}
+
+- (NSArray<NSNumber *> *)keyFlags {
+    let subpacket = [[self subpacketsOfType:PGPSignatureSubpacketTypeKeyFlags] firstObject];
+    return PGPCast(subpacket.value, NSArray) ?: @[];
+}
+
+- (NSArray<NSNumber *> *)preferredSymmetricAlgorithms {
+    let subpacket = [[self subpacketsOfType:PGPSignatureSubpacketTypePreferredSymetricAlgorithm] firstObject];
+    return PGPCast(subpacket.value, NSArray) ?: @[];
+}
+
+// Only the hashed subpacket: the unhashed area is not signed.
+- (UInt8)trustLevel {
+    let subpacket = [[self hashedSubpacketsOfType:PGPSignatureSubpacketTypeTrustSignature] firstObject];
+    return (UInt8)[[PGPCast(subpacket.value, NSArray) firstObject] unsignedIntValue];
+}
+
+- (UInt8)trustAmount {
+    let subpacket = [[self hashedSubpacketsOfType:PGPSignatureSubpacketTypeTrustSignature] firstObject];
+    return (UInt8)[[PGPCast(subpacket.value, NSArray) lastObject] unsignedIntValue];
 }
 
 // Signature expiration date.
@@ -197,12 +304,8 @@ NS_ASSUME_NONNULL_BEGIN
                && self.publicKeyAlgorithm != PGPPublicKeyAlgorithmElgamal
                && self.publicKeyAlgorithm != PGPPublicKeyAlgorithmECDH;
 
-    if (result) {
-        PGPSignatureSubpacket *subpacket = [[self subpacketsOfType:PGPSignatureSubpacketTypeKeyFlags] firstObject];
-        NSArray<NSNumber *> * _Nullable flags = PGPCast(subpacket.value, NSArray);
-        if ([flags containsObject:@(PGPSignatureFlagAllowSignData)]) {
-            return YES;
-        }
+    if (result && [self.keyFlags containsObject:@(PGPSignatureFlagAllowSignData)]) {
+        return YES;
     }
     return NO;
 }
@@ -252,6 +355,11 @@ NS_ASSUME_NONNULL_BEGIN
     }];
 }
 
+// Signed part as parsed, or built from the fields.
+- (NSData *)signedPartData {
+    return _signedPartData ?: [self buildSignedPart:self.hashedSubpackets];
+}
+
 - (NSData *)buildSignedPart:(NSArray *)hashedSubpackets {
     let data = [NSMutableData data];
 
@@ -278,7 +386,7 @@ NS_ASSUME_NONNULL_BEGIN
     let data = [NSMutableData data];
 
     // hashed Subpackets
-    let signedPartData = [self buildSignedPart:self.hashedSubpackets];
+    let signedPartData = [self signedPartData];
     [data appendData:signedPartData];
 
     // unhashed Subpackets
@@ -312,7 +420,7 @@ NS_ASSUME_NONNULL_BEGIN
     // toHash = toSignData + signedPartData + trailerData;
     let finalToHashData = [NSMutableData dataWithData:dataToSign];
 
-    let signedPartData = [self buildSignedPart:self.hashedSubpackets];
+    let signedPartData = [self signedPartData];
     [finalToHashData appendData:signedPartData];
 
     let _Nullable trailerData = [self calculateTrailerFor:signedPartData];
@@ -357,9 +465,17 @@ NS_ASSUME_NONNULL_BEGIN
         return NO;
     }
 
+    return [self verifyToSignData:toSignData signingKeyPacket:signingKeyPacket error:error];
+}
+
+// Verify the signature of the data hashed before the signed part: the document, or the key and user packets.
+- (BOOL)verifyToSignData:(NSData *)toSignData signingKeyPacket:(PGPPublicKeyPacket *)signingKeyPacket error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(toSignData, NSData);
+    PGPAssertClass(signingKeyPacket, PGPPublicKeyPacket);
+
     /// Calculate hash to compare
     // signedPartData
-    let signedPartData = [self buildSignedPart:self.hashedSubpackets];
+    let signedPartData = [self signedPartData];
     // calculate trailer
     let trailerData = [self calculateTrailerFor:signedPartData];
 
@@ -368,11 +484,13 @@ NS_ASSUME_NONNULL_BEGIN
     [toHashData appendData:signedPartData];
     [toHashData appendData:trailerData];
 
+    // Calculate hash value
+    let hashValueData = [toHashData pgp_HashedWithAlgorithm:self.hashAlgoritm];
+
     // TODO: Investigate how to handle V3 scenario here
     // check signed hash value, should match
     if (self.version == 0x04) {
-        // Calculate hash value
-        let calculatedHashValueData = [[toHashData pgp_HashedWithAlgorithm:self.hashAlgoritm] subdataWithRange:(NSRange){0, 2}];
+        let calculatedHashValueData = [hashValueData subdataWithRange:(NSRange){0, 2}];
 
         if (!PGPEqualObjects(self.signedHashValueData, calculatedHashValueData)) {
             if (error) {
@@ -382,6 +500,23 @@ NS_ASSUME_NONNULL_BEGIN
         }
     }
 
+    // The same signature of the same data was verified with the key already.
+    let verificationCache = PGPVerificationCache.sharedCache;
+    let signingKeyFingerprint = signingKeyPacket.fingerprint.hashedData;
+    let verificationKey = [PGPVerificationCache keyForSignature:self hashValue:hashValueData signingKeyFingerprint:signingKeyFingerprint];
+    if ([verificationCache containsKey:verificationKey]) {
+        return YES;
+    }
+
+    let isValid = [self verifyToHashData:toHashData signingKeyPacket:signingKeyPacket error:error];
+    if (isValid) {
+        [verificationCache addKey:verificationKey signingKeyFingerprint:signingKeyFingerprint];
+    }
+    return isValid;
+}
+
+// Public key operation of the verification.
+- (BOOL)verifyToHashData:(NSData *)toHashData signingKeyPacket:(PGPPublicKeyPacket *)signingKeyPacket error:(NSError * __autoreleasing _Nullable *)error {
     switch (signingKeyPacket.publicKeyAlgorithm) {
         case PGPPublicKeyAlgorithmRSA:
         case PGPPublicKeyAlgorithmRSASignOnly:
@@ -407,12 +542,12 @@ NS_ASSUME_NONNULL_BEGIN
         case PGPPublicKeyAlgorithmDSA:{
             return [PGPDSA verify:toHashData signature:self withPublicKeyPacket:signingKeyPacket];
         } break;
-        case PGPPublicKeyAlgorithmEdDSA: {
+        case PGPPublicKeyAlgorithmEdDSA:
+        case PGPPublicKeyAlgorithmECDSA: {
             return [PGPEC verify:toHashData signature:self withPublicKeyPacket:signingKeyPacket withHashAlgorithm:self.hashAlgoritm];
         } break;
         case PGPPublicKeyAlgorithmECDH:
         case PGPPublicKeyAlgorithmElgamal:
-        case PGPPublicKeyAlgorithmECDSA:
         case PGPPublicKeyAlgorithmElgamalEncryptorSign:
         case PGPPublicKeyAlgorithmDiffieHellman:
         case PGPPublicKeyAlgorithmPrivate1:
@@ -449,84 +584,14 @@ NS_ASSUME_NONNULL_BEGIN
         return NO;
     }
     
-    /// Calculate hash to compare
-    // signedPartData
-    let signedPartData = [self buildSignedPart:self.hashedSubpackets];
-    // calculate trailer
-    let trailerData = [self calculateTrailerFor:signedPartData];
-    
-    // toHash = toSignData + signedPartData + trailerData;
-    let toHashData = [NSMutableData dataWithData:toSignData];
-    [toHashData appendData:signedPartData];
-    [toHashData appendData:trailerData];
-    
-    // TODO: Investigate how to handle V3 scenario here
-    // check signed hash value, should match
-    if (self.version == 0x04) {
-        // Calculate hash value
-        let calculatedHashValueData = [[toHashData pgp_HashedWithAlgorithm:self.hashAlgoritm] subdataWithRange:(NSRange){0, 2}];
-        
-        if (!PGPEqualObjects(self.signedHashValueData, calculatedHashValueData)) {
-            if (error) {
-                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidSignature userInfo:@{ NSLocalizedDescriptionKey: @"Verification failed. Signature hash validation failed." }];
-            }
-            return NO;
+    if (!signingKeyPacket) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorMissingRootPublicKey userInfo:@{ NSLocalizedDescriptionKey: @"Unable to check signature. Root CA is not found or invalid." }];
         }
+        return NO;
     }
-    
-    switch (signingKeyPacket.publicKeyAlgorithm) {
-        case PGPPublicKeyAlgorithmRSA:
-        case PGPPublicKeyAlgorithmRSASignOnly:
-        case PGPPublicKeyAlgorithmRSAEncryptOnly: {
-            // convert mpi data to binary signature_bn_bin
-            let signatureMPI = [self signatureMPI:PGPMPIdentifierN];
-            //let signatureMPI = self.signatureMPIs[0];
-            
-            // encoded m value
-            let _Nullable encryptedEmData = [signatureMPI bodyData];
-            // decrypted encoded m value
-            let _Nullable decryptedEmData = [PGPRSA publicDecrypt:encryptedEmData withPublicKeyPacket:signingKeyPacket];
-            
-            // calculate EM and compare with decrypted EM. PKCS-emsa Encoded M.
-            let keySize = ([signingKeyPacket publicMPI:PGPMPIdentifierN].bigNum.bitsCount + 7) / 8; // ks;
-            let emData = [PGPPKCSEmsa encode:self.hashAlgoritm message:toHashData encodedMessageLength:keySize error:error];
-            if (!PGPEqualObjects(emData, decryptedEmData)) {
-                if (error) {
-                    *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidSignature userInfo:@{ NSLocalizedDescriptionKey: @"em hash dont match" }];
-                }
-                return NO;
-            }
-        } break;
-        case PGPPublicKeyAlgorithmDSA:{
-            return [PGPDSA verify:toHashData signature:self withPublicKeyPacket:signingKeyPacket];
-        } break;
-        case PGPPublicKeyAlgorithmECDSA:
-        case PGPPublicKeyAlgorithmEdDSA:
-            return [PGPEC verify:toHashData signature:self withPublicKeyPacket:signingKeyPacket withHashAlgorithm:self.hashAlgoritm];
-        case PGPPublicKeyAlgorithmElgamal:
-        case PGPPublicKeyAlgorithmECDH:
-        case PGPPublicKeyAlgorithmElgamalEncryptorSign:
-        case PGPPublicKeyAlgorithmDiffieHellman:
-        case PGPPublicKeyAlgorithmPrivate1:
-        case PGPPublicKeyAlgorithmPrivate2:
-        case PGPPublicKeyAlgorithmPrivate3:
-        case PGPPublicKeyAlgorithmPrivate4:
-        case PGPPublicKeyAlgorithmPrivate5:
-        case PGPPublicKeyAlgorithmPrivate6:
-        case PGPPublicKeyAlgorithmPrivate7:
-        case PGPPublicKeyAlgorithmPrivate8:
-        case PGPPublicKeyAlgorithmPrivate9:
-        case PGPPublicKeyAlgorithmPrivate10:
-        case PGPPublicKeyAlgorithmPrivate11:
-            PGPLogWarning(@"Algorithm %@ is not supported.", @(signingKeyPacket.publicKeyAlgorithm));
-            return NO;
-            break;
-    }
-    
-    
-    
-    return YES;
-    
+
+    return [self verifyToSignData:PGPNN(toSignData) signingKeyPacket:signingKeyPacket error:error];
 }
 
 
@@ -562,9 +627,6 @@ NS_ASSUME_NONNULL_BEGIN
         return NO;
     }
 
-    // it this is right? set public key algorithm from secret key packet
-    self.publicKeyAlgorithm = key.signingSecretKey.publicKeyAlgorithm;
-
     if (key.signingSecretKey.isEncryptedWithPassphrase && passphrase && passphrase.length > 0) {
         NSError *decryptError;
         // Copy secret key instance, then decrypt on copy, not on the original (do not leave unencrypted instance around)
@@ -581,6 +643,32 @@ NS_ASSUME_NONNULL_BEGIN
         NSAssert(key.signingSecretKey && !decryptError, @"decrypt error %@", decryptError);
     }
 
+    let _Nullable toSignData = [self buildDataToSignForType:self.type inputData:inputData key:key subKey:subKey userID:userID error:error];
+    if (!toSignData) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Can't sign" }];
+        }
+        return NO;
+    }
+
+    return [self signToSignData:PGPNN(toSignData) withKey:key error:error];
+}
+
+// Sign the data hashed before the signed part: the document, or the key and user packets.
+- (BOOL)signToSignData:(NSData *)toSignData withKey:(PGPKey *)key error:(NSError * __autoreleasing _Nullable *)error {
+    PGPAssertClass(toSignData, NSData);
+    PGPAssertClass(key, PGPKey);
+
+    if (!key.signingSecretKey) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorMissingSignature userInfo:@{ NSLocalizedDescriptionKey: @"Missing signature for the secret key." }];
+        }
+        return NO;
+    }
+
+    // it this is right? set public key algorithm from secret key packet
+    self.publicKeyAlgorithm = key.signingSecretKey.publicKeyAlgorithm;
+
     // signed part data
     if (self.hashedSubpackets.count == 0) {
         // add hashed subpacket - REQUIRED
@@ -589,18 +677,10 @@ NS_ASSUME_NONNULL_BEGIN
         PGPLogDebug(@"Signature without subpackets. Adding minimal set of subpackets.");
     }
 
-    let signedPartData = [self buildSignedPart:self.hashedSubpackets];
+    let signedPartData = [self signedPartData];
     // calculate trailer
     let _Nullable trailerData = [self calculateTrailerFor:signedPartData];
 
-    // build toSignData, toSign
-    let _Nullable toSignData = [self buildDataToSignForType:self.type inputData:inputData key:key subKey:subKey userID:userID error:error];
-    if (!toSignData) {
-        if (error) {
-            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Can't sign" }];
-        }
-        return NO;
-    }
     // toHash = toSignData + signedPartData + trailerData;
     let toHashData = [NSMutableData dataWithData:toSignData];
     [toHashData appendData:signedPartData];
@@ -652,9 +732,18 @@ NS_ASSUME_NONNULL_BEGIN
             }
             self.signatureMPIs = mpis;
         } break;
+        case PGPPublicKeyAlgorithmECDSA: {
+            let mpis = [PGPEC sign:toHashData key:key withHashAlgorithm:self.hashAlgoritm];
+            if (mpis.count == 0) {
+                if (error) {
+                    *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Sign Encryption failed" }];
+                }
+                return NO;
+            }
+            self.signatureMPIs = mpis;
+        } break;
         case PGPPublicKeyAlgorithmECDH:
         case PGPPublicKeyAlgorithmElgamal:
-        case PGPPublicKeyAlgorithmECDSA:
         case PGPPublicKeyAlgorithmElgamalEncryptorSign:
         case PGPPublicKeyAlgorithmDiffieHellman:
         case PGPPublicKeyAlgorithmPrivate1:
@@ -1059,6 +1148,7 @@ NS_ASSUME_NONNULL_BEGIN
     // hash algorithm, the hashed subpacket length, and the hashed
     // subpacket body.
 
+    let signedPartPosition = position;
     UInt8 parsedVersion = 0;
     // V4
     // One-octet version number (4).
@@ -1112,6 +1202,9 @@ NS_ASSUME_NONNULL_BEGIN
         self.hashedSubpackets = hashedSubpackets;
     }
 
+    // Verification hashes the signed part as parsed, not as built again.
+    _signedPartData = [packetBody subdataWithRange:(NSRange){signedPartPosition, position - signedPartPosition}];
+
     // Two-octet scalar octet count for the following unhashed subpacket
     UInt16 unhashedOctetCount = 0;
     [packetBody getBytes:&unhashedOctetCount range:(NSRange){position, 2}];
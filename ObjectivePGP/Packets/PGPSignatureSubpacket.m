@@ -85,9 +85,13 @@ NS_ASSUME_NONNULL_BEGIN
             validityPeriodTime = CFSwapInt32BigToHost(validityPeriodTime);
             self.value = @(validityPeriodTime);
         } break;
-        case PGPSignatureSubpacketTypeTrustSignature: {
+        case PGPSignatureSubpacketTypeTrustSignature: // NSArray of NSNumber, level and amount
+        {
+            // 5.2.3.13.  Trust Signature
             // (1 octet "level" (depth), 1 octet of trust amount)
-            // TODO trust subpacket
+            UInt8 trust[2] = {0, 0};
+            [packetBodyData getBytes:&trust length:MIN((NSUInteger)2, packetBodyData.length)];
+            self.value = @[@(trust[0]), @(trust[1])];
         } break;
         case PGPSignatureSubpacketTypeIssuerKeyID: // PGPKeyID
         {
@@ -297,6 +301,15 @@ NS_ASSUME_NONNULL_BEGIN
             let validityPeriodInt = CFSwapInt32HostToBig((UInt32)validityPeriod.unsignedIntegerValue);
             [data appendBytes:&validityPeriodInt length:4];
         } break;
+        case PGPSignatureSubpacketTypeTrustSignature: // NSArray of NSNumber, level and amount
+        {
+            let trustArray = PGPCast(self.value, NSArray);
+            if (trustArray.count != 2) {
+                break;
+            }
+            UInt8 trust[2] = {(UInt8)[trustArray[0] unsignedIntValue], (UInt8)[trustArray[1] unsignedIntValue]};
+            [data appendBytes:&trust length:2];
+        } break;
         case PGPSignatureSubpacketTypeIssuerKeyID: // PGPKeyID
         {
             let _Nullable keyID = PGPCast(self.value, PGPKeyID);
@@ -18,6 +18,8 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface PGPSignatureSubpacketEmbeddedSignature : NSObject <NSCopying, PGPExportable>
 
+@property (nonatomic, copy, readonly) PGPSignaturePacket *signaturePacket;
+
 PGP_EMPTY_INIT_UNAVAILABLE
 
 - (instancetype)initWithSignature:(PGPSignaturePacket *)signature NS_DESIGNATED_INITIALIZER;
@@ -17,12 +17,6 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@interface PGPSignatureSubpacketEmbeddedSignature ()
-
-@property (nonatomic, copy, readonly) PGPSignaturePacket *signaturePacket;
-
-@end
-
 @implementation PGPSignatureSubpacketEmbeddedSignature
 
 - (instancetype)initWithSignature:(PGPSignaturePacket *)signature {
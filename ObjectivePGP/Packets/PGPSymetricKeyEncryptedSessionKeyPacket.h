@@ -20,6 +20,16 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic) PGPSymmetricAlgorithm symmetricAlgorithm;
 @property (nonatomic, copy) PGPS2K *s2k;
 @property (nonatomic, copy, nullable) NSData *encryptedSessionKey;
+// Version 6
+@property (nonatomic) PGPAEADAlgorithm aeadAlgorithm;
+@property (nonatomic, copy, nullable) NSData *iv;
+
+/// Encrypt the session key with the key derived from the passphrase. Version 6 packet use AEAD, version 4 use CFB.
+- (BOOL)encryptSessionKeyData:(NSData *)sessionKeyData sessionKeyAlgorithm:(PGPSymmetricAlgorithm)sessionKeyAlgorithm passphrase:(NSString *)passphrase error:(NSError * __autoreleasing _Nullable *)error;
+
+/// Session key. For version 4 packet without encrypted session key, the key derived from the passphrase is the session key.
+/// Version 6 packet does not carry the session key algorithm, sessionKeyAlgorithm is set to PGPSymmetricPlaintext.
+- (nullable NSData *)decryptSessionKeyWithPassphrase:(NSString *)passphrase sessionKeyAlgorithm:(PGPSymmetricAlgorithm *)sessionKeyAlgorithm error:(NSError * __autoreleasing _Nullable *)error;
 
 @end
 
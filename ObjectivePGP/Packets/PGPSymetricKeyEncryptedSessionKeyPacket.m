@@ -12,6 +12,8 @@
 #import "NSData+PGPUtils.h"
 #import "NSMutableData+PGPUtils.h"
 #import "PGPCryptoUtils.h"
+#import "PGPCryptoCFB.h"
+#import "PGPCryptoAEAD.h"
 #import "PGPFingerprint.h"
 #import "PGPKeyID.h"
 #import "PGPS2K.h"
@@ -31,6 +33,7 @@ NS_ASSUME_NONNULL_BEGIN
     if (self = [super init]) {
         _version = 4;
         _symmetricAlgorithm = PGPSymmetricPlaintext;
+        _aeadAlgorithm = PGPAEADUnknown;
     }
     return self;
 }
@@ -42,20 +45,47 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSUInteger)parsePacketBody:(NSData *)packetBody error:(NSError * __autoreleasing _Nullable *)error {
     NSUInteger position = [super parsePacketBody:packetBody error:error];
 
-    // A one-octet number giving the version number of the packet type. The currently defined value for packet version is 3.
+    // A one-octet number giving the version number of the packet type. The currently defined values for packet version are 4 and 6.
     [packetBody getBytes:&_version range:(NSRange){position, 1}];
-    NSAssert(self.version == 4, @"The currently defined value for packet version is 4");
+    NSAssert(self.version == 4 || self.version == 6, @"The currently defined values for packet version are 4 and 6");
     position = position + 1;
 
+    if (self.version == 6) {
+        // A one-octet scalar octet count of the following 5 fields.
+        position = position + 1;
+    }
+
     // A one-octet number describing the symmetric algorithm used.
     [packetBody getBytes:&_symmetricAlgorithm range:(NSRange){position, 1}];
     position = position + 1;
 
+    if (self.version == 6) {
+        // A one-octet AEAD algorithm identifier.
+        [packetBody getBytes:&_aeadAlgorithm range:(NSRange){position, 1}];
+        position = position + 1;
+
+        // A one-octet scalar octet count of the following field.
+        position = position + 1;
+    }
+
     // A string-to-key (S2K) specifier, length as defined above.
     NSUInteger s2kParsedLength = 0;
     self.s2k = [PGPS2K S2KFromData:packetBody atPosition:position length:&s2kParsedLength];
     position = position + s2kParsedLength;
 
+    if (self.version == 6) {
+        // A starting initialization vector of size specified by the AEAD algorithm.
+        NSUInteger ivSize = [PGPCryptoAEAD nonceSizeOfAEADAlgorithm:self.aeadAlgorithm];
+        if (ivSize == NSNotFound || packetBody.length < position + ivSize) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Invalid symmetric-key encrypted session key packet." }];
+            }
+            return packetBody.length;
+        }
+        self.iv = [packetBody subdataWithRange:(NSRange){position, ivSize}];
+        position = position + ivSize;
+    }
+
     if (packetBody.length > position) {
         // Optionally, the encrypted session key itself, which is decrypted with the string-to-key object.
         self.encryptedSessionKey = [packetBody subdataWithRange:(NSRange){position, packetBody.length - position}];
@@ -64,12 +94,126 @@ NS_ASSUME_NONNULL_BEGIN
     return position;
 }
 
+#pragma mark - Session Key
+
+// HKDF info and AEAD associated data: packet tag in new format encoding, version, cipher, AEAD algorithm.
+- (NSData *)aeadAssociatedData {
+    UInt8 bytes[4] = {0xC0 | PGPSymetricKeyEncryptedSessionKeyPacketTag, self.version, self.symmetricAlgorithm, self.aeadAlgorithm};
+    return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+}
+
+- (nullable NSData *)keyEncryptionKeyWithPassphrase:(NSString *)passphrase {
+    let s2kKey = [self.s2k produceSessionKeyWithPassphrase:passphrase symmetricAlgorithm:self.symmetricAlgorithm];
+    if (!s2kKey || self.version != 6) {
+        return s2kKey;
+    }
+    return [PGPCryptoAEAD HKDFSHA256WithKey:PGPNN(s2kKey) salt:nil info:self.aeadAssociatedData length:[PGPCryptoUtils keySizeOfSymmetricAlgorithm:self.symmetricAlgorithm]];
+}
+
+- (BOOL)encryptSessionKeyData:(NSData *)sessionKeyData sessionKeyAlgorithm:(PGPSymmetricAlgorithm)sessionKeyAlgorithm passphrase:(NSString *)passphrase error:(NSError * __autoreleasing _Nullable *)error {
+    let keyEncryptionKey = [self keyEncryptionKeyWithPassphrase:passphrase];
+    if (!keyEncryptionKey) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unable to derive key from the passphrase." }];
+        }
+        return NO;
+    }
+
+    if (self.version == 6) {
+        self.iv = [PGPCryptoUtils randomData:[PGPCryptoAEAD nonceSizeOfAEADAlgorithm:self.aeadAlgorithm]];
+        self.encryptedSessionKey = [PGPCryptoAEAD encryptData:sessionKeyData key:PGPNN(keyEncryptionKey) nonce:PGPNN(self.iv) associatedData:self.aeadAssociatedData symmetricAlgorithm:self.symmetricAlgorithm aeadAlgorithm:self.aeadAlgorithm error:error];
+        return self.encryptedSessionKey != nil;
+    }
+
+    // Version 4: the algorithm octet followed by the session key, encrypted in CFB mode with IV of all zeros
+    let toEncrypt = [NSMutableData dataWithBytes:&sessionKeyAlgorithm length:1];
+    [toEncrypt appendData:sessionKeyData];
+    let ivData = [NSMutableData dataWithLength:[PGPCryptoUtils blockSizeOfSymmetricAlhorithm:self.symmetricAlgorithm]];
+    self.encryptedSessionKey = [PGPCryptoCFB encryptData:toEncrypt sessionKeyData:PGPNN(keyEncryptionKey) symmetricAlgorithm:self.symmetricAlgorithm iv:ivData syncCFB:NO];
+    return self.encryptedSessionKey != nil;
+}
+
+- (nullable NSData *)decryptSessionKeyWithPassphrase:(NSString *)passphrase sessionKeyAlgorithm:(PGPSymmetricAlgorithm *)sessionKeyAlgorithm error:(NSError * __autoreleasing _Nullable *)error {
+    let keyEncryptionKey = [self keyEncryptionKeyWithPassphrase:passphrase];
+    if (!keyEncryptionKey) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unable to derive key from the passphrase." }];
+        }
+        return nil;
+    }
+
+    if (self.version == 6) {
+        if (!self.encryptedSessionKey || !self.iv) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Missing encrypted session key." }];
+            }
+            return nil;
+        }
+
+        let sessionKeyData = [PGPCryptoAEAD decryptData:PGPNN(self.encryptedSessionKey) key:PGPNN(keyEncryptionKey) nonce:PGPNN(self.iv) associatedData:self.aeadAssociatedData symmetricAlgorithm:self.symmetricAlgorithm aeadAlgorithm:self.aeadAlgorithm error:nil];
+        if (!sessionKeyData) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorPassphraseInvalid userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt session key. Invalid passphrase." }];
+            }
+            return nil;
+        }
+        if (sessionKeyAlgorithm) {
+            *sessionKeyAlgorithm = PGPSymmetricPlaintext;
+        }
+        return sessionKeyData;
+    }
+
+    // Version 4: if the encrypted session key is not present, the S2K derived key is used as the session key
+    if (!self.encryptedSessionKey) {
+        if (sessionKeyAlgorithm) {
+            *sessionKeyAlgorithm = self.symmetricAlgorithm;
+        }
+        return keyEncryptionKey;
+    }
+
+    let ivData = [NSMutableData dataWithLength:[PGPCryptoUtils blockSizeOfSymmetricAlhorithm:self.symmetricAlgorithm]];
+    let decrypted = [PGPCryptoCFB decryptData:PGPNN(self.encryptedSessionKey) sessionKeyData:PGPNN(keyEncryptionKey) symmetricAlgorithm:self.symmetricAlgorithm iv:ivData syncCFB:NO];
+    PGPSymmetricAlgorithm sessionKeyAlgorithmRead = PGPSymmetricPlaintext;
+    [decrypted getBytes:&sessionKeyAlgorithmRead length:1];
+    NSUInteger sessionKeySize = [PGPCryptoUtils keySizeOfSymmetricAlgorithm:sessionKeyAlgorithmRead];
+    if (!decrypted || sessionKeySize == NSNotFound || decrypted.length != sessionKeySize + 1) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorPassphraseInvalid userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt session key. Invalid passphrase." }];
+        }
+        return nil;
+    }
+
+    if (sessionKeyAlgorithm) {
+        *sessionKeyAlgorithm = sessionKeyAlgorithmRead;
+    }
+    return [decrypted subdataWithRange:(NSRange){1, sessionKeySize}];
+}
+
 #pragma mark - PGPExportable
 
 - (nullable NSData *)export:(NSError * __autoreleasing _Nullable *)error {
     let bodyData = [NSMutableData data];
 
     [bodyData appendBytes:&_version length:1]; // 1
+    if (self.version == 6) {
+        let s2kData = [self.s2k export:error];
+        if (!s2kData) {
+            return nil;
+        }
+        UInt8 s2kLength = (UInt8)s2kData.length;
+        UInt8 fieldsLength = (UInt8)(3 + s2kData.length + self.iv.length);
+        [bodyData appendBytes:&fieldsLength length:1];
+        [bodyData appendBytes:&_symmetricAlgorithm length:1];
+        [bodyData appendBytes:&_aeadAlgorithm length:1];
+        [bodyData appendBytes:&s2kLength length:1];
+        [bodyData appendData:s2kData];
+        [bodyData pgp_appendData:self.iv];
+        [bodyData pgp_appendData:self.encryptedSessionKey];
+        return [PGPPacket buildPacketOfType:self.tag withBody:^NSData * {
+            return bodyData;
+        }];
+    }
+
     [bodyData appendBytes:&_symmetricAlgorithm length:1]; // 1
     [bodyData pgp_appendData:[self.s2k export:error]];
     [bodyData pgp_appendData:self.encryptedSessionKey];
@@ -91,8 +235,10 @@ NS_ASSUME_NONNULL_BEGIN
 - (BOOL)isEqualToSessionKeyPacket:(PGPSymetricKeyEncryptedSessionKeyPacket *)packet {
     return self.version == packet.version &&
            self.symmetricAlgorithm == packet.symmetricAlgorithm &&
+           self.aeadAlgorithm == packet.aeadAlgorithm &&
            PGPEqualObjects(self.s2k, packet.s2k) &&
-           self.encryptedSessionKey == packet.encryptedSessionKey;
+           PGPEqualObjects(self.iv, packet.iv) &&
+           PGPEqualObjects(self.encryptedSessionKey, packet.encryptedSessionKey);
 }
 
 - (NSUInteger)hash {
@@ -100,7 +246,9 @@ NS_ASSUME_NONNULL_BEGIN
     NSUInteger result = [super hash];
     result = prime * result + self.version;
     result = prime * result + self.symmetricAlgorithm;
+    result = prime * result + self.aeadAlgorithm;
     result = prime * result + self.s2k.hash;
+    result = prime * result + self.iv.hash;
     result = prime * result + self.encryptedSessionKey.hash;
     return result;
 }
@@ -114,6 +262,8 @@ NS_ASSUME_NONNULL_BEGIN
     duplicate.symmetricAlgorithm = self.symmetricAlgorithm;
     duplicate.s2k = self.s2k;
     duplicate.encryptedSessionKey = self.encryptedSessionKey;
+    duplicate.aeadAlgorithm = self.aeadAlgorithm;
+    duplicate.iv = self.iv;
     return duplicate;
 }
 
@@ -74,9 +74,11 @@ NS_ASSUME_NONNULL_BEGIN
                 [accumulatedPackets addObjectsFromArray:uncompressedPackets ?: @[]];
             }
             
-            // corrupted data. Move by one byte in hope we find some packet there, or EOF.
+            // corrupted data. Skip to the next packet, or EOF.
             if (consumedBytes == 0) {
-                offset++;
+                let nextOffset = [PGPPacketFactory offsetOfNextPacketInData:data fromOffset:(NSUInteger)(offset + 1)];
+                offset = nextOffset == NSNotFound ? (NSInteger)data.length : (NSInteger)nextOffset;
+                continue;
             }
             offset += (NSInteger)consumedBytes;
         }
@@ -17,9 +17,23 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, readonly) NSUInteger version;
 
+// Version 2 (AEAD) only. Version 1 takes the symmetric algorithm from the session key packet.
+@property (nonatomic, readonly) PGPSymmetricAlgorithm symmetricAlgorithm;
+@property (nonatomic, readonly) PGPAEADAlgorithm aeadAlgorithm;
+@property (nonatomic, readonly) UInt8 chunkSizeOctet;
+@property (nonatomic, copy, readonly, nullable) NSData *salt;
+
+// Version 1, CFB with MDC
 - (BOOL)encrypt:(NSData *)literalPacketData symmetricAlgorithm:(PGPSymmetricAlgorithm)sessionKeyAlgorithm sessionKeyData:(NSData *)sessionKeyData error:(NSError * __autoreleasing *)error;
+// Version 2, AEAD. The chunk size is 2^(chunkSizeOctet + 6) octets.
+- (BOOL)encrypt:(NSData *)literalPacketData symmetricAlgorithm:(PGPSymmetricAlgorithm)sessionKeyAlgorithm aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm chunkSizeOctet:(UInt8)chunkSizeOctet sessionKeyData:(NSData *)sessionKeyData error:(NSError * __autoreleasing *)error;
+
+/// Decrypt. Version 2 packet ignores sessionKeyAlgorithm and use its own symmetric algorithm.
 - (NSArray<PGPPacket *> *)decryptWithSessionKeyAlgorithm:(PGPSymmetricAlgorithm)sessionKeyAlgorithm sessionKeyData:(NSData *)sessionKeyData error:(NSError * __autoreleasing _Nullable *)error;
 
+/// Version 2 only. Decrypt and pass authenticated plaintext chunks, in order, as they become available. Returns NO if the block stops the decryption, before the final tag is verified.
+- (BOOL)decryptChunksWithSessionKeyData:(NSData *)sessionKeyData error:(NSError * __autoreleasing _Nullable *)error usingBlock:(NS_NOESCAPE void (^)(NSData *plaintextChunk, BOOL *stop))block;
+
 @end
 
 NS_ASSUME_NONNULL_END
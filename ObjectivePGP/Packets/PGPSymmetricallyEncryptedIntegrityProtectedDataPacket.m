@@ -8,9 +8,11 @@
 
 #import "PGPSymmetricallyEncryptedIntegrityProtectedDataPacket.h"
 #import "NSData+PGPUtils.h"
+#import "NSMutableData+PGPUtils.h"
 #import "PGPPacket+Private.h"
 #import "PGPCompressedPacket.h"
 #import "PGPCryptoCFB.h"
+#import "PGPCryptoAEAD.h"
 #import "PGPCryptoUtils.h"
 #import "PGPLiteralPacket.h"
 #import "PGPModificationDetectionCodePacket.h"
@@ -38,15 +40,26 @@ NS_ASSUME_NONNULL_BEGIN
 @interface PGPSymmetricallyEncryptedIntegrityProtectedDataPacket ()
 
 @property (nonatomic, readwrite) NSUInteger version;
+@property (nonatomic, readwrite) PGPSymmetricAlgorithm symmetricAlgorithm;
+@property (nonatomic, readwrite) PGPAEADAlgorithm aeadAlgorithm;
+@property (nonatomic, readwrite) UInt8 chunkSizeOctet;
+@property (nonatomic, copy, readwrite, nullable) NSData *salt;
 
 @end
 
+// Version 2 salt size (octets)
+static const NSUInteger PGPSEIPDv2SaltSize = 32;
+// Version 2 maximum chunk size octet (chunk size 2^22)
+static const UInt8 PGPSEIPDv2MaxChunkSizeOctet = 16;
+
 
 @implementation PGPSymmetricallyEncryptedIntegrityProtectedDataPacket
 
 - (instancetype)init {
     if (self = [super init]) {
         _version = 1;
+        _symmetricAlgorithm = PGPSymmetricPlaintext;
+        _aeadAlgorithm = PGPAEADUnknown;
     }
     return self;
 }
@@ -55,41 +68,29 @@ NS_ASSUME_NONNULL_BEGIN
     return PGPSymmetricallyEncryptedIntegrityProtectedDataPacketTag; // 18
 }
 
-- (NSArray<PGPPacket *> *)readPacketsFromData:(NSData *)data offset:(NSUInteger)offsetPosition mdcLength:(nullable NSUInteger *)mdcLength {
+- (NSArray<PGPPacket *> *)readPacketsFromData:(NSData *)data offset:(NSUInteger)offsetPosition {
     let accumulatedPackets = [NSMutableArray<PGPPacket *> array];
-    if (mdcLength) { *mdcLength = 0; }
     NSInteger offset = offsetPosition;
     NSUInteger consumedBytes = 0;
     while (offset < (NSInteger)data.length) {
         let packet = [PGPPacketFactory packetWithData:data offset:offset consumedBytes:&consumedBytes];
         if (packet) {
             [accumulatedPackets addObject:packet];
-            if (packet.tag != PGPModificationDetectionCodePacketTag) {
-                if (mdcLength) {
-                    *mdcLength += consumedBytes;
-                }
-            }
 
             // A compressed Packet contains more packets
             let _Nullable compressedPacket = PGPCast(packet, PGPCompressedPacket);
             if (compressedPacket) {
                 // TODO: Compression should be moved outside, be more generic to handle compressed packet from anywhere
-                let uncompressedPackets = [self readPacketsFromData:compressedPacket.decompressedData offset:0 mdcLength:nil];
+                let uncompressedPackets = [self readPacketsFromData:compressedPacket.decompressedData offset:0];
                 [accumulatedPackets addObjectsFromArray:uncompressedPackets ?: @[]];
             }
-
-            if (packet.indeterminateLength && accumulatedPackets.count > 0 && PGPCast(accumulatedPackets.firstObject, PGPCompressedPacket)) {
-                // FIXME: substract size of PGPModificationDetectionCodePacket in this very special case - TODO: fix this
-                offset -= 22;
-                if (mdcLength) {
-                    *mdcLength -= 22;
-                }
-            }
         }
 
-        // corrupted data. Move by one byte in hope we find some packet there, or EOF.
+        // corrupted data. Skip to the next packet, or EOF.
         if (consumedBytes == 0) {
-            offset++;
+            let nextOffset = [PGPPacketFactory offsetOfNextPacketInData:data fromOffset:(NSUInteger)(offset + 1)];
+            offset = nextOffset == NSNotFound ? (NSInteger)data.length : (NSInteger)nextOffset;
+            continue;
         }
 
         offset += consumedBytes;
@@ -105,6 +106,30 @@ NS_ASSUME_NONNULL_BEGIN
     [packetBody getBytes:&_version range:(NSRange){position, 1}];
     position = position + 1;
 
+    if (self.version == 2) {
+        // - A one-octet cipher algorithm.
+        [packetBody getBytes:&_symmetricAlgorithm range:(NSRange){position, 1}];
+        position = position + 1;
+
+        // - A one-octet AEAD algorithm.
+        [packetBody getBytes:&_aeadAlgorithm range:(NSRange){position, 1}];
+        position = position + 1;
+
+        // - A one-octet chunk size.
+        [packetBody getBytes:&_chunkSizeOctet range:(NSRange){position, 1}];
+        position = position + 1;
+
+        // - Thirty-two octets of salt.
+        if (packetBody.length < position + PGPSEIPDv2SaltSize + PGPAEADTagSize || self.chunkSizeOctet > PGPSEIPDv2MaxChunkSizeOctet) {
+            if (error) {
+                *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Invalid encrypted data packet." }];
+            }
+            return packetBody.length;
+        }
+        self.salt = [packetBody subdataWithRange:(NSRange){position, PGPSEIPDv2SaltSize}];
+        position = position + PGPSEIPDv2SaltSize;
+    }
+
     // - Encrypted data, the output of the selected symmetric-key cipher
     // operating in OpenPGP's variant of Cipher Feedback (CFB) mode.
     self.encryptedData = [packetBody subdataWithRange:(NSRange){position, packetBody.length - position}];
@@ -114,7 +139,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (nullable NSData *)export:(NSError * __autoreleasing _Nullable *)error {
     NSAssert(self.encryptedData, @"No encrypted data?");
-    NSAssert(self.version == 1, @"Require version == 1");
+    NSAssert(self.version == 1 || self.version == 2, @"Require version 1 or 2");
 
     if (!self.encryptedData) {
         if (error) {
@@ -126,6 +151,12 @@ NS_ASSUME_NONNULL_BEGIN
     let bodyData = [NSMutableData data];
     // A one-octet version number.
     [bodyData appendBytes:&_version length:1];
+    if (self.version == 2) {
+        [bodyData appendBytes:&_symmetricAlgorithm length:1];
+        [bodyData appendBytes:&_aeadAlgorithm length:1];
+        [bodyData appendBytes:&_chunkSizeOctet length:1];
+        [bodyData pgp_appendData:self.salt];
+    }
     // Encrypted data
     [bodyData appendData:self.encryptedData];
 
@@ -145,6 +176,17 @@ NS_ASSUME_NONNULL_BEGIN
         return @[];
     }
 
+    if (self.version == 2) {
+        let plaintextData = [NSMutableData dataWithCapacity:self.encryptedData.length];
+        BOOL decrypted = [self decryptChunksWithSessionKeyData:sessionKeyData error:error usingBlock:^(NSData *plaintextChunk, BOOL *stop) {
+            [plaintextData appendData:plaintextChunk];
+        }];
+        if (!decrypted) {
+            return @[];
+        }
+        return [self readPacketsFromData:plaintextData offset:0];
+    }
+
     NSUInteger blockSize = [PGPCryptoUtils blockSizeOfSymmetricAlhorithm:sessionKeyAlgorithm];
 
     // The Initial Vector (IV) is specified as all zeros.
@@ -165,46 +207,29 @@ NS_ASSUME_NONNULL_BEGIN
         return @[];
     }
 
-    NSUInteger mdcLength = 0;
-    let packets = [self readPacketsFromData:decryptedData offset:position mdcLength:&mdcLength];
-
-    let _Nullable lastPacket = PGPCast(packets.lastObject, PGPPacket);
-    if (!lastPacket || lastPacket.tag != PGPModificationDetectionCodePacketTag) {
-        // No Integrity Protected found, can't verify. Guess it's modified.
-        // if (checkIsContentModified) { *checkIsContentModified = YES; }
-        if (error) {
-            *error = [NSError errorWithDomain:PGPErrorDomain code:0 userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Content modification detected." }];
-        }
-        return @[];
-    }
-
-    let _Nullable mdcPacket = PGPCast(lastPacket, PGPModificationDetectionCodePacket);
-    if (!mdcPacket) {
+    // The MDC packet is the last packet: two octets of values 0xD3, 0x14 (sha length) and the SHA-1 hash.
+    // Verify it before the packets are parsed and decompressed.
+    let mdcPacketLength = (NSUInteger)(2 + CC_SHA1_DIGEST_LENGTH);
+    const UInt8 *decryptedBytes = decryptedData.bytes;
+    if (decryptedData.length < position + mdcPacketLength || decryptedBytes[decryptedData.length - mdcPacketLength] != 0xD3 || decryptedBytes[decryptedData.length - mdcPacketLength + 1] != 0x14) {
         if (error) {
             *error = [NSError errorWithDomain:PGPErrorDomain code:0 userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Unexpected sequence of data (missing MDC)." }];
         }
         return @[];
     }
 
-    let toMDCData = [[NSMutableData alloc] init];
-    // preamble
-    [toMDCData appendData:prefixRandomFullData];
-    // validation: calculate MDC hash to check if literal data is modified
-    [toMDCData appendData:[decryptedData subdataWithRange:(NSRange){position, mdcLength}]];
-
-    // and then also includes two octets of values 0xD3, 0x14 (sha length)
-    UInt8 mdc_suffix[2] = {0xD3, 0x14};
-    [toMDCData appendBytes:&mdc_suffix length:2];
-
-    let mdcHash = [toMDCData pgp_SHA1];
-    if (!mdcPacket || !PGPEqualObjects(mdcHash,mdcPacket.hashData)) {
+    // The hash covers the prefix, the packets and the MDC packet header.
+    let toMDCData = [NSData dataWithBytesNoCopy:(void *)decryptedBytes length:decryptedData.length - CC_SHA1_DIGEST_LENGTH freeWhenDone:NO];
+    let mdcHashData = [NSData dataWithBytesNoCopy:(void *)(decryptedBytes + decryptedData.length - CC_SHA1_DIGEST_LENGTH) length:CC_SHA1_DIGEST_LENGTH freeWhenDone:NO];
+    if (!PGPEqualObjects([toMDCData pgp_SHA1], mdcHashData)) {
         if (error) {
             *error = [NSError errorWithDomain:PGPErrorDomain code:0 userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Validation failed. Content modification detected." }];
         }
         return @[];
     }
 
-    return [packets subarrayWithRange:(NSRange){0, packets.count - 1}];
+    let packetsData = [decryptedData subdataWithRange:(NSRange){position, decryptedData.length - mdcPacketLength - position}];
+    return [self readPacketsFromData:packetsData offset:0];
 }
 
 - (BOOL)encrypt:(NSData *)literalPacketData symmetricAlgorithm:(PGPSymmetricAlgorithm)sessionKeyAlgorithm sessionKeyData:(NSData *)sessionKeyData error:(NSError * __autoreleasing _Nullable *)error {
@@ -260,6 +285,79 @@ NS_ASSUME_NONNULL_BEGIN
     }
 }
 
+#pragma mark - AEAD
+
+// The five octets used as associated data and as the HKDF info: packet tag in new format encoding, version, cipher, AEAD algorithm, chunk size octet.
+- (NSData *)aeadAssociatedData {
+    UInt8 bytes[5] = {0xC0 | PGPSymmetricallyEncryptedIntegrityProtectedDataPacketTag, (UInt8)self.version, self.symmetricAlgorithm, self.aeadAlgorithm, self.chunkSizeOctet};
+    return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+}
+
+// HKDF-SHA256 derived message key followed by the IV of (nonce size - 8) octets.
+- (BOOL)deriveMessageKey:(NSData * __autoreleasing _Nullable * _Nonnull)messageKey iv:(NSData * __autoreleasing _Nullable * _Nonnull)iv sessionKeyData:(NSData *)sessionKeyData error:(NSError * __autoreleasing _Nullable *)error {
+    NSUInteger keySize = [PGPCryptoUtils keySizeOfSymmetricAlgorithm:self.symmetricAlgorithm];
+    NSUInteger nonceSize = [PGPCryptoAEAD nonceSizeOfAEADAlgorithm:self.aeadAlgorithm];
+    if (keySize == NSNotFound || nonceSize == NSNotFound || ![PGPCryptoAEAD isSupportedAEADAlgorithm:self.aeadAlgorithm symmetricAlgorithm:self.symmetricAlgorithm]) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Unsupported AEAD algorithm %@ with cipher %@.", @(self.aeadAlgorithm), @(self.symmetricAlgorithm)] }];
+        }
+        return NO;
+    }
+
+    let derived = [PGPCryptoAEAD HKDFSHA256WithKey:sessionKeyData salt:self.salt info:self.aeadAssociatedData length:keySize + nonceSize - 8];
+    if (!derived) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorGeneral userInfo:@{ NSLocalizedDescriptionKey: @"Unable to derive message key." }];
+        }
+        return NO;
+    }
+
+    *messageKey = [derived subdataWithRange:(NSRange){0, keySize}];
+    *iv = [derived subdataWithRange:(NSRange){keySize, derived.length - keySize}];
+    return YES;
+}
+
+- (BOOL)encrypt:(NSData *)literalPacketData symmetricAlgorithm:(PGPSymmetricAlgorithm)sessionKeyAlgorithm aeadAlgorithm:(PGPAEADAlgorithm)aeadAlgorithm chunkSizeOctet:(UInt8)chunkSizeOctet sessionKeyData:(NSData *)sessionKeyData error:(NSError * __autoreleasing _Nullable *)error {
+    @autoreleasepool {
+        self.version = 2;
+        self.symmetricAlgorithm = sessionKeyAlgorithm;
+        self.aeadAlgorithm = aeadAlgorithm;
+        self.chunkSizeOctet = MIN(chunkSizeOctet, PGPSEIPDv2MaxChunkSizeOctet);
+        self.salt = [PGPCryptoUtils randomData:PGPSEIPDv2SaltSize];
+
+        NSData *messageKey = nil;
+        NSData *iv = nil;
+        if (![self deriveMessageKey:&messageKey iv:&iv sessionKeyData:sessionKeyData error:error]) {
+            return NO;
+        }
+
+        let encrypted = [PGPCryptoAEAD encryptChunkedData:literalPacketData key:PGPNN(messageKey) iv:PGPNN(iv) associatedData:self.aeadAssociatedData chunkSize:(NSUInteger)1 << (self.chunkSizeOctet + 6) symmetricAlgorithm:self.symmetricAlgorithm aeadAlgorithm:self.aeadAlgorithm error:error];
+        if (!encrypted) {
+            return NO;
+        }
+
+        self.encryptedData = encrypted;
+        return YES;
+    }
+}
+
+- (BOOL)decryptChunksWithSessionKeyData:(NSData *)sessionKeyData error:(NSError * __autoreleasing _Nullable *)error usingBlock:(NS_NOESCAPE void (^)(NSData *plaintextChunk, BOOL *stop))block {
+    if (self.version != 2 || !self.encryptedData) {
+        if (error) {
+            *error = [NSError errorWithDomain:PGPErrorDomain code:PGPErrorInvalidMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to decrypt. Expected version 2 encrypted data packet." }];
+        }
+        return NO;
+    }
+
+    NSData *messageKey = nil;
+    NSData *iv = nil;
+    if (![self deriveMessageKey:&messageKey iv:&iv sessionKeyData:sessionKeyData error:error]) {
+        return NO;
+    }
+
+    return [PGPCryptoAEAD decryptChunkedData:self.encryptedData key:PGPNN(messageKey) iv:PGPNN(iv) associatedData:self.aeadAssociatedData chunkSize:(NSUInteger)1 << (self.chunkSizeOctet + 6) symmetricAlgorithm:self.symmetricAlgorithm aeadAlgorithm:self.aeadAlgorithm error:error usingBlock:block];
+}
+
 #pragma mark - isEqual
 
 - (BOOL)isEqual:(id)other {
@@ -271,13 +369,21 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (BOOL)isEqualToPGPSymmetricallyEncryptedIntegrityProtectedDataPacket:(PGPSymmetricallyEncryptedIntegrityProtectedDataPacket *)packet {
-    return self.version == packet.version;
+    return self.version == packet.version &&
+           self.symmetricAlgorithm == packet.symmetricAlgorithm &&
+           self.aeadAlgorithm == packet.aeadAlgorithm &&
+           self.chunkSizeOctet == packet.chunkSizeOctet &&
+           PGPEqualObjects(self.salt, packet.salt);
 }
 
 - (NSUInteger)hash {
     NSUInteger prime = 31;
     NSUInteger result = [super hash];
     result = prime * result + self.version;
+    result = prime * result + self.symmetricAlgorithm;
+    result = prime * result + self.aeadAlgorithm;
+    result = prime * result + self.chunkSizeOctet;
+    result = prime * result + self.salt.hash;
     return result;
 }
 
@@ -290,6 +396,10 @@ NS_ASSUME_NONNULL_BEGIN
     }
 
     duplicate.version = self.version;
+    duplicate.symmetricAlgorithm = self.symmetricAlgorithm;
+    duplicate.aeadAlgorithm = self.aeadAlgorithm;
+    duplicate.chunkSizeOctet = self.chunkSizeOctet;
+    duplicate.salt = self.salt;
     return duplicate;
 }
 
@@ -0,0 +1,253 @@
+//
+//  Copyright (c) Marcin Krzyżanowski. All rights reserved.
+//
+//  THIS SOURCE CODE AND ANY ACCOMPANYING DOCUMENTATION ARE PROTECTED BY
+//  INTERNATIONAL COPYRIGHT LAW. USAGE IS BOUND TO THE LICENSE AGREEMENT.
+//  This notice may not be removed from this file.
+//
+
+#import <ObjectivePGP/ObjectivePGP.h>
+#import "PGPMacros+Private.h"
+#import <XCTest/XCTest.h>
+
+// Keyring files: import from a path, the index sidecar, and the store with the log.
+@interface ObjectivePGPTestKeyringFiles : XCTestCase
+@end
+
+@implementation ObjectivePGPTestKeyringFiles
+
+- (void)testKeyringIndex {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let generatedKeys = [NSMutableArray<PGPKey *> array];
+    let keyringData = [NSMutableData data];
+    for (NSUInteger i = 0; i < 10; i++) {
+        let key = [generator generateFor:[NSString stringWithFormat:@"test+%@@example.com", @(i)] passphrase:nil];
+        [generatedKeys addObject:key];
+        [keyringData appendData:PGPNN([key export:PGPKeyTypePublic error:nil])];
+    }
+
+    let keyringPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    let indexPath = [PGPKeyringIndex indexPathForKeyringAtPath:keyringPath];
+    XCTAssertTrue([keyringData writeToFile:keyringPath atomically:YES]);
+
+    // Build the index, then open the keyring with the written index
+    let builtIndex = [[PGPKeyringIndex alloc] initWithKeyringAtPath:keyringPath error:nil];
+    XCTAssertEqual(builtIndex.entries.count, generatedKeys.count);
+    XCTAssertTrue([NSFileManager.defaultManager fileExistsAtPath:indexPath]);
+    let indexModificationDate = [NSFileManager.defaultManager attributesOfItemAtPath:indexPath error:nil].fileModificationDate;
+
+    let index = [[PGPKeyringIndex alloc] initWithKeyringAtPath:keyringPath error:nil];
+    XCTAssertEqual(index.entries.count, generatedKeys.count);
+    XCTAssertEqualObjects([NSFileManager.defaultManager attributesOfItemAtPath:indexPath error:nil].fileModificationDate, indexModificationDate);
+
+    let generatedKey = generatedKeys[3];
+    let entry = index.entries[3];
+    XCTAssertEqualObjects(entry.fingerprint, generatedKey.publicKey.fingerprint.hashedData);
+    XCTAssertEqualObjects(entry.userIDs, @[@"test+3@example.com"]);
+    XCTAssertTrue(entry.capabilities & PGPKeyringIndexCapabilityEncrypt);
+    XCTAssertEqualObjects([index keyWithKeyID:generatedKey.keyID].keyID, generatedKey.keyID);
+    XCTAssertEqualObjects([index keyWithKeyID:PGPNN(generatedKey.publicKey.subKeys.firstObject.keyID)].keyID, generatedKey.keyID);
+    XCTAssertEqualObjects([index keysForUserID:@"test+3@example.com"].firstObject.keyID, generatedKey.keyID);
+    XCTAssertEqual([index keysForUserID:@"unknown@example.com"].count, (NSUInteger)0);
+
+    // Touched keyring: the same hash keeps the index, written with the new modification date
+    let modificationDate = [NSDate dateWithTimeIntervalSinceNow:-3600];
+    XCTAssertTrue([NSFileManager.defaultManager setAttributes:@{NSFileModificationDate: modificationDate} ofItemAtPath:keyringPath error:nil]);
+    let touchedIndex = [[PGPKeyringIndex alloc] initWithKeyringAtPath:keyringPath error:nil];
+    XCTAssertEqual(touchedIndex.entries.count, generatedKeys.count);
+    let touchedIndexData = [NSData dataWithContentsOfFile:indexPath];
+    XCTAssertNotNil([[PGPKeyringIndex alloc] initWithKeyringAtPath:keyringPath error:nil]);
+    XCTAssertEqualObjects([NSData dataWithContentsOfFile:indexPath], touchedIndexData);
+
+    // Same size and modification date are trusted, verifying hashes the keyring
+    let changedKeyringData = [keyringData mutableCopy];
+    let userIDRange = [changedKeyringData rangeOfData:PGPNN([@"test+3@" dataUsingEncoding:NSUTF8StringEncoding]) options:0 range:(NSRange){0, changedKeyringData.length}];
+    [changedKeyringData replaceBytesInRange:userIDRange withBytes:"test+X@"];
+    XCTAssertTrue([changedKeyringData writeToFile:keyringPath atomically:YES]);
+    XCTAssertTrue([NSFileManager.defaultManager setAttributes:@{NSFileModificationDate: modificationDate} ofItemAtPath:keyringPath error:nil]);
+    XCTAssertNotNil([[PGPKeyringIndex alloc] initWithKeyringAtPath:keyringPath error:nil]);
+    XCTAssertEqualObjects([NSData dataWithContentsOfFile:indexPath], touchedIndexData);
+    XCTAssertNotNil([[PGPKeyringIndex alloc] initWithKeyringAtPath:keyringPath verify:YES error:nil]);
+    XCTAssertNotEqualObjects([NSData dataWithContentsOfFile:indexPath], touchedIndexData);
+
+    [NSFileManager.defaultManager removeItemAtPath:keyringPath error:nil];
+    [NSFileManager.defaultManager removeItemAtPath:indexPath error:nil];
+}
+
+- (void)testKeyringIndexRebuildsStaleSidecar {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key1 = [generator generateFor:@"test+1@example.com" passphrase:nil];
+    let key2 = [generator generateFor:@"test+2@example.com" passphrase:nil];
+    let otherKey2 = [generator generateFor:@"test+2@example.com" passphrase:nil];
+
+    let keyringPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    let indexPath = [PGPKeyringIndex indexPathForKeyringAtPath:keyringPath];
+    let keyringData = [NSMutableData dataWithData:PGPNN([key1 export:PGPKeyTypePublic error:nil])];
+    [keyringData appendData:PGPNN([key2 export:PGPKeyTypePublic error:nil])];
+    XCTAssertTrue([keyringData writeToFile:keyringPath atomically:YES]);
+    XCTAssertNotNil([[PGPKeyringIndex alloc] initWithKeyringAtPath:keyringPath error:nil]);
+    let staleIndexData = [NSData dataWithContentsOfFile:indexPath];
+    XCTAssertNotNil(staleIndexData);
+
+    // The keyring changed, the sidecar index describes the previous keys
+    let changedKeyringData = [NSMutableData dataWithData:PGPNN([otherKey2 export:PGPKeyTypePublic error:nil])];
+    [changedKeyringData appendData:PGPNN([key1 export:PGPKeyTypePublic error:nil])];
+    XCTAssertTrue([changedKeyringData writeToFile:keyringPath atomically:YES]);
+    XCTAssertTrue([NSFileManager.defaultManager setAttributes:@{NSFileModificationDate: [NSDate dateWithTimeIntervalSinceNow:60]} ofItemAtPath:keyringPath error:nil]);
+
+    let index = [[PGPKeyringIndex alloc] initWithKeyringAtPath:keyringPath error:nil];
+    XCTAssertNotEqualObjects([NSData dataWithContentsOfFile:indexPath], staleIndexData);
+    XCTAssertEqual(index.entries.count, (NSUInteger)2);
+    XCTAssertEqualObjects(index.entries.firstObject.fingerprint, otherKey2.publicKey.fingerprint.hashedData);
+    XCTAssertNil([index keyWithKeyID:key2.keyID]);
+    XCTAssertEqualObjects([index keyWithKeyID:key1.keyID].keyID, key1.keyID);
+    let keys = [index keysForUserID:@"test+2@example.com"];
+    XCTAssertEqual(keys.count, (NSUInteger)1);
+    XCTAssertEqualObjects(keys.firstObject.keyID, otherKey2.keyID);
+
+    [NSFileManager.defaultManager removeItemAtPath:keyringPath error:nil];
+    [NSFileManager.defaultManager removeItemAtPath:indexPath error:nil];
+}
+
+- (void)testKeyringStore {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key1 = [generator generateFor:@"test+1@example.com" passphrase:nil];
+    let key2 = [generator generateFor:@"test+2@example.com" passphrase:nil];
+    let key3 = [generator generateFor:@"test+3@example.com" passphrase:nil];
+
+    let keyringPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    var store = [[PGPKeyringStore alloc] initWithKeyringAtPath:keyringPath error:nil];
+    XCTAssertNotNil(store);
+    XCTAssertTrue([store addKeys:@[key1, key2] error:nil]);
+    XCTAssertTrue([store deleteKeys:@[key1] error:nil]);
+    XCTAssertEqualObjects([store findKeyWithKeyID:key2.keyID].keyID, key2.keyID);
+    XCTAssertNil([store findKeyWithKeyID:key1.keyID]);
+
+    // Crash in the middle of a record
+    UInt8 tornRecord[] = { 0x01, 0x00, 0x00, 0x00, 0x10 };
+    let fileHandle = [NSFileHandle fileHandleForUpdatingAtPath:store.logPath];
+    [fileHandle seekToEndOfFile];
+    [fileHandle writeData:[NSData dataWithBytes:tornRecord length:sizeof(tornRecord)]];
+    [fileHandle closeFile];
+    let logLength = store.logLength;
+
+    store = [[PGPKeyringStore alloc] initWithKeyringAtPath:keyringPath error:nil];
+    XCTAssertEqual(store.logLength, logLength);
+    XCTAssertEqual(store.keys.count, (NSUInteger)1);
+    XCTAssertEqualObjects(store.keys.firstObject.keyID, key2.keyID);
+    XCTAssertNotNil(store.keys.firstObject.secretKey);
+
+    // The compacted keyring is a regular keyring
+    XCTAssertTrue([store addKeys:@[key3] error:nil]);
+    XCTAssertTrue([store compact:nil]);
+    let keyringKeys = [ObjectivePGP readKeysFromPath:keyringPath error:nil];
+    XCTAssertEqual(keyringKeys.count, (NSUInteger)2);
+    XCTAssertEqualObjects(keyringKeys[0].keyID, key2.keyID);
+    XCTAssertEqualObjects(keyringKeys[1].keyID, key3.keyID);
+    XCTAssertLessThan(store.logLength, logLength);
+
+    store = [[PGPKeyringStore alloc] initWithKeyringAtPath:keyringPath error:nil];
+    XCTAssertEqual(store.keys.count, (NSUInteger)2);
+
+    [NSFileManager.defaultManager removeItemAtPath:keyringPath error:nil];
+    [NSFileManager.defaultManager removeItemAtPath:store.logPath error:nil];
+}
+
+- (void)testKeyringStorePerformance {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let keys = [NSMutableArray<PGPKey *> array];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [keys addObject:[generator generateFor:[NSString stringWithFormat:@"test+%@@example.com", @(i)] passphrase:nil]];
+    }
+
+    let keyringPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    let store = PGPNN([[PGPKeyringStore alloc] initWithKeyringAtPath:keyringPath error:nil]);
+
+    // Every key is updated once per iteration, one update per write.
+    __block NSUInteger iterations = 0;
+    [self measureBlock:^{
+        for (PGPKey *key in keys) {
+            XCTAssertTrue([store addKeys:@[key] error:nil]);
+        }
+        iterations += 1;
+    }];
+    XCTAssertTrue([store compact:nil]);
+    XCTAssertEqual(store.keys.count, keys.count);
+
+    // The log records, and the keys written once more by the compaction.
+    let writeAmplification = (double)store.bytesWritten / store.bytesAdded;
+    XCTAssertLessThan(writeAmplification, 1.1 + 1.0 / iterations);
+
+    [NSFileManager.defaultManager removeItemAtPath:keyringPath error:nil];
+    [NSFileManager.defaultManager removeItemAtPath:store.logPath error:nil];
+}
+
+- (void)testKeyringImportAppendedKeys {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key1 = [generator generateFor:@"test+1@example.com" passphrase:nil];
+    let key2 = [generator generateFor:@"test+2@example.com" passphrase:nil];
+    let key3 = [generator generateFor:@"test+3@example.com" passphrase:nil];
+    let key3Data = PGPNN([key3 export:PGPKeyTypePublic error:nil]);
+
+    let keyringPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    let fileData = [NSMutableData dataWithData:PGPNN([key1 export:PGPKeyTypePublic error:nil])];
+    XCTAssertTrue([fileData writeToFile:keyringPath atomically:NO]);
+
+    let keyring = [[PGPKeyring alloc] init];
+    XCTAssertTrue([keyring importKeysFromPath:keyringPath error:nil]);
+    XCTAssertEqual(keyring.keys.count, (NSUInteger)1);
+
+    // Appended key, and a key that is still being written
+    [fileData appendData:PGPNN([key2 export:PGPKeyTypePublic error:nil])];
+    [fileData appendData:[key3Data subdataWithRange:(NSRange){0, key3Data.length / 2}]];
+    XCTAssertTrue([fileData writeToFile:keyringPath atomically:NO]);
+    XCTAssertTrue([keyring importKeysFromPath:keyringPath error:nil]);
+    XCTAssertNotNil([keyring findKeyWithKeyID:key1.keyID]);
+    XCTAssertNotNil([keyring findKeyWithKeyID:key2.keyID]);
+
+    [fileData appendData:[key3Data subdataWithRange:(NSRange){key3Data.length / 2, key3Data.length - key3Data.length / 2}]];
+    XCTAssertTrue([fileData writeToFile:keyringPath atomically:NO]);
+    XCTAssertTrue([keyring importKeysFromPath:keyringPath error:nil]);
+    XCTAssertEqual(keyring.keys.count, (NSUInteger)3);
+    XCTAssertEqual([keyring findKeyWithKeyID:key3.keyID].publicKey.subKeys.count, key3.publicKey.subKeys.count);
+
+    // Rewritten file replaces the keys read before, but not the keys of the other file or the imported keys
+    let key4 = [generator generateFor:@"test+4@example.com" passphrase:nil];
+    [keyring importKeys:@[key4]];
+    let otherKeyringPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    XCTAssertTrue([PGPNN([key1 export:PGPKeyTypePublic error:nil]) writeToFile:otherKeyringPath atomically:NO]);
+    XCTAssertTrue([keyring importKeysFromPath:otherKeyringPath error:nil]);
+    XCTAssertEqual(keyring.keys.count, (NSUInteger)4);
+
+    XCTAssertTrue([key3Data writeToFile:keyringPath atomically:NO]);
+    XCTAssertTrue([keyring importKeysFromPath:keyringPath error:nil]);
+    XCTAssertEqual(keyring.keys.count, (NSUInteger)3);
+    XCTAssertNotNil([keyring findKeyWithKeyID:key1.keyID]);
+    XCTAssertNil([keyring findKeyWithKeyID:key2.keyID]);
+    XCTAssertNotNil([keyring findKeyWithKeyID:key3.keyID]);
+    XCTAssertNotNil([keyring findKeyWithKeyID:key4.keyID]);
+
+    // Armored file
+    let armoredKeyringPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    let armoredKeys = [PGPArmor armored:PGPNN([key2 export:PGPKeyTypePublic error:nil]) as:PGPArmorPublicKey];
+    XCTAssertTrue([armoredKeys writeToFile:armoredKeyringPath atomically:NO encoding:NSUTF8StringEncoding error:nil]);
+    XCTAssertTrue([keyring importKeysFromPath:armoredKeyringPath error:nil]);
+    XCTAssertNotNil([keyring findKeyWithKeyID:key2.keyID]);
+    XCTAssertTrue([keyring importKeysFromPath:armoredKeyringPath error:nil]);
+    XCTAssertEqual(keyring.keys.count, (NSUInteger)4);
+
+    // No keys
+    let invalidKeyringPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    XCTAssertTrue([[@"not a keyring" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:invalidKeyringPath atomically:NO]);
+    NSError *error = nil;
+    XCTAssertFalse([keyring importKeysFromPath:invalidKeyringPath error:&error]);
+    XCTAssertNotNil(error);
+    XCTAssertEqual(keyring.keys.count, (NSUInteger)4);
+
+    [NSFileManager.defaultManager removeItemAtPath:keyringPath error:nil];
+    [NSFileManager.defaultManager removeItemAtPath:otherKeyringPath error:nil];
+    [NSFileManager.defaultManager removeItemAtPath:armoredKeyringPath error:nil];
+    [NSFileManager.defaultManager removeItemAtPath:invalidKeyringPath error:nil];
+}
+
+@end
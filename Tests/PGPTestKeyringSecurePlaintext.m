@@ -239,7 +239,7 @@
     [keyring importKeys:keys2];
 
     // Public key
-    let keyToEncrypt2 = [keyring findKeyWithIdentifier:@"66753341"];
+    let keyToEncrypt2 = [keyring findKeyWithIdentifier:@"FF1F7A5C"];
     let keyToEncrypt1 = [keyring findKeyWithIdentifier:@"952E4E8B"];
 
     XCTAssertNotNil(keyToEncrypt1);
@@ -248,8 +248,15 @@
     NSData *plainData = [PLAINTEXT dataUsingEncoding:NSUTF8StringEncoding];
     [plainData writeToFile:[self.workingDirectory stringByAppendingPathComponent:@"plaintext.txt"] atomically:YES];
 
-    // encrypt PLAINTEXT
+    // The key expired in 2018
+    let expiredKey = [keyring findKeyWithIdentifier:@"66753341"];
+    XCTAssertNotNil(expiredKey);
     NSError *encryptError = nil;
+    XCTAssertNil([ObjectivePGP encrypt:plainData addSignature:NO usingKeys:@[keyToEncrypt1, expiredKey] passphraseForKey:nil error:&encryptError]);
+    XCTAssertNotNil(encryptError);
+
+    // encrypt PLAINTEXT
+    encryptError = nil;
     NSData *encryptedData = [ObjectivePGP encrypt:plainData addSignature:NO usingKeys:@[keyToEncrypt1, keyToEncrypt2] passphraseForKey:nil error:&encryptError];
     XCTAssertNil(encryptError);
     XCTAssertNotNil(encryptedData);
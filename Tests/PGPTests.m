@@ -11,8 +11,28 @@
 
 #import <ObjectivePGP/ObjectivePGP.h>
 #import "PGPMacros+Private.h"
+#import <ObjectivePGP/ObjectivePGPObject+Private.h>
 #import <ObjectivePGP/PGPPartialKey+Private.h>
 #import <ObjectivePGP/PGPSignaturePacket.h>
+#import <ObjectivePGP/PGPSignaturePacket+Private.h>
+#import <ObjectivePGP/PGPPartialSubKey+Private.h>
+#import <ObjectivePGP/PGPUser+Private.h>
+#import <ObjectivePGP/PGPSignatureSubpacket.h>
+#import <ObjectivePGP/PGPKeyValidator.h>
+#import <ObjectivePGP/PGPVerificationCache.h>
+#import <ObjectivePGP/PGPLiteralPacket.h>
+#import <ObjectivePGP/PGPSymetricKeyEncryptedSessionKeyPacket.h>
+#import <ObjectivePGP/PGPPublicKeyEncryptedSessionKeyPacket.h>
+#import <ObjectivePGP/PGPPublicKeyPacket.h>
+#import <ObjectivePGP/PGPSecretKeyPacket+Private.h>
+#import <ObjectivePGP/PGPSymmetricallyEncryptedIntegrityProtectedDataPacket.h>
+#import <ObjectivePGP/PGPPacketFactory.h>
+#import <ObjectivePGP/PGPPacketHeader.h>
+#import <ObjectivePGP/PGPEC.h>
+#import <ObjectivePGP/PGPElgamal.h>
+#import <ObjectivePGP/PGPMPI.h>
+#import <ObjectivePGP/PGPCryptoUtils.h>
+#import <ObjectivePGP/NSData+PGPUtils.h>
 #import "PGPTestUtils.h"
 #import <XCTest/XCTest.h>
 
@@ -541,6 +561,57 @@
     XCTAssertNil(decryptError, @"Decryption failed");
 }
 
+- (void)testElgamalRepeatedRecipient {
+    // Precomputation for the key is shared by concurrent encryptions
+    let publicKeys = [PGPTestUtils readKeysFromPath:@"elgamal/elgamal-key1.asc"];
+    let secretKeys = [PGPTestUtils readKeysFromPath:@"elgamal/elgamal-key1-secret.asc"];
+    let plaintextData = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+
+    let count = 16;
+    let encrypted = [NSMutableArray<NSData *> array];
+    let lock = [[NSLock alloc] init];
+    dispatch_apply(count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        let encData = [ObjectivePGP encrypt:plaintextData addSignature:NO usingKeys:publicKeys passphraseForKey:nil error:nil];
+        [lock lock];
+        [encrypted addObject:encData ?: [NSData data]];
+        [lock unlock];
+    });
+
+    XCTAssertEqual(encrypted.count, (NSUInteger)count);
+    for (NSData *encData in encrypted) {
+        NSError *decryptError;
+        let decData = [ObjectivePGP decrypt:encData andVerifySignature:NO usingKeys:secretKeys passphraseForKey:nil error:&decryptError];
+        XCTAssertNil(decryptError);
+        XCTAssertEqualObjects(decData, plaintextData);
+    }
+}
+
+- (void)testElgamalContextCache {
+    let plaintextData = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+    let keys1 = [PGPTestUtils readKeysFromPath:@"elgamal/elgamal-key1.asc"];
+    let keys2 = [PGPTestUtils readKeysFromPath:@"elgamal/elgamal-key2.asc"];
+    let keys3 = [PGPTestUtils readKeysFromPath:@"elgamal/E5ED9F41.asc"];
+    let capacity = PGPElgamal.contextCacheCapacity;
+    XCTAssertGreaterThan(capacity, (NSUInteger)16);
+
+    PGPElgamal.contextCacheCapacity = 0;
+    XCTAssertEqual(PGPElgamal.cachedContextsCount, (NSUInteger)0);
+    XCTAssertNotNil([ObjectivePGP encrypt:plaintextData addSignature:NO usingKeys:keys1 passphraseForKey:nil error:nil]);
+    XCTAssertEqual(PGPElgamal.cachedContextsCount, (NSUInteger)0);
+
+    // The least recently used key is dropped, not every key
+    PGPElgamal.contextCacheCapacity = 2;
+    for (NSArray<PGPKey *> *keys in @[keys1, keys2, keys1, keys3, keys1]) {
+        XCTAssertNotNil([ObjectivePGP encrypt:plaintextData addSignature:NO usingKeys:keys passphraseForKey:nil error:nil]);
+        XCTAssertLessThanOrEqual(PGPElgamal.cachedContextsCount, (NSUInteger)2);
+    }
+    XCTAssertEqual(PGPElgamal.cachedContextsCount, (NSUInteger)2);
+
+    PGPElgamal.contextCacheCapacity = 1;
+    XCTAssertEqual(PGPElgamal.cachedContextsCount, (NSUInteger)1);
+    PGPElgamal.contextCacheCapacity = capacity;
+}
+
 - (void)testElgamal3 {
     // Missing keys flags. Use conventions.
     let keys = [PGPTestUtils readKeysFromPath:@"elgamal/E5ED9F41.asc"];
@@ -736,6 +807,729 @@ Ie6jnY0zP2ldtS4JmhKBa43qmOHCxHc=\n\
     XCTAssertEqualObjects(plaintext, decrypted);
 }
 
+- (void)testEncryptManyRecipients {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let keys = @[[generator generateFor:@"test+1@example.com" passphrase:nil], [generator generateFor:@"test+2@example.com" passphrase:nil], [generator generateFor:@"test+3@example.com" passphrase:nil]];
+    let recipients = [NSMutableArray<PGPKey *> array];
+    for (NSUInteger i = 0; i < 64; i++) {
+        [recipients addObject:keys[i % keys.count]];
+    }
+
+    let plaintext = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+    NSError *encryptError;
+    let encryptedData = [ObjectivePGP encrypt:plaintext addSignature:NO usingKeys:recipients passphraseForKey:nil error:&encryptError];
+    XCTAssertNil(encryptError);
+    XCTAssertNotNil(encryptedData);
+
+    // Session key packets follow the order of the recipients
+    NSUInteger offset = 0;
+    for (PGPKey *recipient in recipients) {
+        NSUInteger consumedBytes = 0;
+        let packet = PGPCast([PGPPacketFactory packetWithData:PGPNN(encryptedData) offset:offset consumedBytes:&consumedBytes], PGPPublicKeyEncryptedSessionKeyPacket);
+        XCTAssertNotNil(packet);
+        XCTAssertEqualObjects(packet.keyID, PGPCast([recipient.publicKey encryptionKeyPacket:nil], PGPPublicKeyPacket).keyID);
+        offset += consumedBytes;
+    }
+
+    for (PGPKey *key in keys) {
+        NSError *decryptError;
+        let decrypted = [ObjectivePGP decrypt:PGPNN(encryptedData) andVerifySignature:NO usingKeys:@[key] passphraseForKey:nil error:&decryptError];
+        XCTAssertNil(decryptError);
+        XCTAssertEqualObjects(decrypted, plaintext);
+    }
+}
+
+- (void)testEncryptForRecipientGroups {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key1 = [generator generateFor:@"test+1@example.com" passphrase:nil];
+    let key2 = [generator generateFor:@"test+2@example.com" passphrase:nil];
+    let key3 = [generator generateFor:@"test+3@example.com" passphrase:nil];
+    let recipients = @[@[key1], @[key2, key3], @[key3]];
+
+    let plaintext = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+    NSError *encryptError;
+    let messages = [ObjectivePGP encrypt:plaintext forRecipients:recipients signUsingKeys:@[key1] passphraseForKey:nil error:&encryptError];
+    XCTAssertNil(encryptError);
+    XCTAssertEqual(messages.count, recipients.count);
+
+    for (NSUInteger i = 0; i < recipients.count; i++) {
+        for (PGPKey *key in recipients[i]) {
+            NSError *decryptError;
+            let decrypted = [ObjectivePGP decrypt:messages[i] andVerifySignature:YES usingKeys:@[key, key1] passphraseForKey:nil error:&decryptError];
+            XCTAssertNil(decryptError);
+            XCTAssertEqualObjects(decrypted, plaintext);
+        }
+    }
+
+    // Messages are encrypted to their group only
+    XCTAssertNil([ObjectivePGP decrypt:messages[2] andVerifySignature:NO usingKeys:@[key1] passphraseForKey:nil error:nil]);
+
+    // A group without keys
+    XCTAssertNil([ObjectivePGP encrypt:plaintext forRecipients:@[@[key1], @[]] signUsingKeys:nil passphraseForKey:nil error:&encryptError]);
+    XCTAssertNotNil(encryptError);
+}
+
+- (void)testRewrapSessionKey {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key1 = [generator generateFor:@"test+1@example.com" passphrase:nil];
+    let key2 = [generator generateFor:@"test+2@example.com" passphrase:nil];
+
+    let plaintext = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+    let encryptedData = [ObjectivePGP encrypt:plaintext addSignature:NO usingKeys:@[key1] passphraseForKey:nil error:nil];
+    XCTAssertNotNil(encryptedData);
+
+    NSError *rewrapError;
+    NSUInteger encryptedDataOffset = 0;
+    let sessionKeyPacketsData = [ObjectivePGP sessionKeyPacketsRewrappingMessage:encryptedData toRecipients:@[key2] keepExistingRecipients:NO usingKeys:@[key1] passphraseForKey:nil encryptedDataOffset:&encryptedDataOffset error:&rewrapError];
+    XCTAssertNil(rewrapError);
+    XCTAssertNotNil(sessionKeyPacketsData);
+    XCTAssertGreaterThan(encryptedDataOffset, 0);
+
+    let rewrappedData = [NSMutableData dataWithData:sessionKeyPacketsData];
+    [rewrappedData appendData:[encryptedData subdataWithRange:(NSRange){encryptedDataOffset, encryptedData.length - encryptedDataOffset}]];
+
+    NSError *decryptError;
+    XCTAssertEqualObjects([ObjectivePGP decrypt:rewrappedData andVerifySignature:NO usingKeys:@[key2] passphraseForKey:nil error:&decryptError], plaintext);
+    XCTAssertNil(decryptError);
+    XCTAssertNil([ObjectivePGP decrypt:rewrappedData andVerifySignature:NO usingKeys:@[key1] passphraseForKey:nil error:nil]);
+
+    // Rewrap the file, keeping the existing recipient
+    let sourceURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString]];
+    let destinationURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:NSUUID.UUID.UUIDString]];
+    [encryptedData writeToURL:sourceURL atomically:YES];
+    XCTAssertTrue([ObjectivePGP rewrapMessageAtURL:sourceURL toURL:destinationURL recipients:@[key2] keepExistingRecipients:YES usingKeys:@[key1] passphraseForKey:nil error:&rewrapError]);
+    XCTAssertNil(rewrapError);
+
+    let rewrappedFileData = [NSData dataWithContentsOfURL:destinationURL];
+    XCTAssertEqualObjects([ObjectivePGP decrypt:rewrappedFileData andVerifySignature:NO usingKeys:@[key1] passphraseForKey:nil error:nil], plaintext);
+    XCTAssertEqualObjects([ObjectivePGP decrypt:rewrappedFileData andVerifySignature:NO usingKeys:@[key2] passphraseForKey:nil error:nil], plaintext);
+    [NSFileManager.defaultManager removeItemAtURL:sourceURL error:nil];
+    [NSFileManager.defaultManager removeItemAtURL:destinationURL error:nil];
+}
+
+- (void)testDecryptWithSessionKey {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key = [generator generateFor:@"test+1@example.com" passphrase:nil];
+
+    let plaintext = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+    let encryptedData = [ObjectivePGP encrypt:plaintext addSignature:YES usingKeys:@[key] passphraseForKey:nil error:nil];
+    XCTAssertNotNil(encryptedData);
+
+    PGPSessionKey *sessionKey;
+    NSError *decryptError;
+    XCTAssertEqualObjects([ObjectivePGP decrypt:encryptedData andVerifySignature:YES usingKeys:@[key] passphraseForKey:nil sessionKey:&sessionKey error:&decryptError], plaintext);
+    XCTAssertNil(decryptError);
+    XCTAssertNotNil(sessionKey);
+
+    // No private key needed to decrypt with the session key
+    let decrypted = [ObjectivePGP decrypt:encryptedData withSessionKey:PGPNN(sessionKey) andVerifySignature:YES usingKeys:@[key] error:&decryptError];
+    XCTAssertNil(decryptError);
+    XCTAssertEqualObjects(decrypted, plaintext);
+
+    let wrongSessionKey = [[PGPSessionKey alloc] initWithAlgorithm:sessionKey.algorithm keyData:[PGPCryptoUtils randomData:sessionKey.keyData.length]];
+    XCTAssertNil([ObjectivePGP decrypt:encryptedData withSessionKey:PGPNN(wrongSessionKey) andVerifySignature:NO usingKeys:@[] error:nil]);
+
+    // Key length must match the algorithm
+    XCTAssertNil([[PGPSessionKey alloc] initWithAlgorithm:PGPSymmetricAES128 keyData:[PGPCryptoUtils randomData:32]]);
+}
+
+- (void)testDecryptAEADMessageWithSessionKey {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key = [generator generateFor:@"test+1@example.com" passphrase:nil];
+    let encryptionKeyPacket = PGPNN(PGPCast(key.publicKey.subKeys.firstObject.primaryKeyPacket, PGPPublicKeyPacket));
+    let plaintext = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+    let sessionKeyData = [PGPCryptoUtils randomData:16];
+
+    // Version 6 session key packets and version 2 encrypted data, AES-128
+    let pkesk = [[PGPPublicKeyEncryptedSessionKeyPacket alloc] init];
+    pkesk.version = 6;
+    pkesk.keyID = encryptionKeyPacket.keyID;
+    pkesk.publicKeyAlgorithm = encryptionKeyPacket.publicKeyAlgorithm;
+    XCTAssertTrue([pkesk encrypt:encryptionKeyPacket sessionKeyData:sessionKeyData sessionKeyAlgorithm:PGPSymmetricAES128 error:nil]);
+
+    let skesk = [[PGPSymetricKeyEncryptedSessionKeyPacket alloc] init];
+    skesk.version = 6;
+    skesk.symmetricAlgorithm = PGPSymmetricAES256;
+    skesk.aeadAlgorithm = PGPAEADOCB;
+    skesk.s2k = [[PGPS2K alloc] initWithSpecifier:PGPS2KSpecifierIteratedAndSalted hashAlgorithm:PGPHashSHA256];
+    XCTAssertTrue([skesk encryptSessionKeyData:sessionKeyData sessionKeyAlgorithm:PGPSymmetricAES128 passphrase:@"passphrase" error:nil]);
+
+    let literalPacket = [PGPLiteralPacket literalPacket:PGPLiteralPacketBinary withData:plaintext];
+    literalPacket.timestamp = NSDate.date;
+    let seipd = [[PGPSymmetricallyEncryptedIntegrityProtectedDataPacket alloc] init];
+    XCTAssertTrue([seipd encrypt:PGPNN([literalPacket export:nil]) symmetricAlgorithm:PGPSymmetricAES128 aeadAlgorithm:PGPAEADOCB chunkSizeOctet:0 sessionKeyData:sessionKeyData error:nil]);
+
+    for (PGPPacket *sessionKeyPacket in @[pkesk, skesk]) {
+        let encryptedData = [NSMutableData data];
+        [encryptedData appendData:PGPNN([sessionKeyPacket export:nil])];
+        [encryptedData appendData:PGPNN([seipd export:nil])];
+
+        PGPSessionKey *sessionKey;
+        NSError *decryptError;
+        XCTAssertEqualObjects([ObjectivePGP decrypt:encryptedData andVerifySignature:NO usingKeys:@[key] passphraseForKey:^NSString * _Nullable(PGPKey * _Nullable k) { return @"passphrase"; } sessionKey:&sessionKey error:&decryptError], plaintext);
+        XCTAssertNil(decryptError);
+        XCTAssertEqual(sessionKey.algorithm, PGPSymmetricAES128);
+        XCTAssertEqualObjects(sessionKey.keyData, sessionKeyData);
+
+        let decrypted = [ObjectivePGP decrypt:encryptedData withSessionKey:PGPNN(sessionKey) andVerifySignature:NO usingKeys:@[] error:&decryptError];
+        XCTAssertNil(decryptError);
+        XCTAssertEqualObjects(decrypted, plaintext);
+
+        let message = [[PGPMessage alloc] initWithData:encryptedData error:nil];
+        XCTAssertEqualObjects([message sessionKeyUsingKeys:@[key] passphraseForKey:^NSString * _Nullable(PGPKey * _Nullable k) { return @"passphrase"; } error:nil], sessionKey);
+        XCTAssertEqualObjects([message decryptUsingKeys:@[key] passphraseForKey:^NSString * _Nullable(PGPKey * _Nullable k) { return @"passphrase"; } error:nil], plaintext);
+    }
+}
+
+// Packet with 512 octets partial body length chunks
+- (NSData *)partialLengthPacketWithTag:(PGPPacketTag)tag body:(NSData *)body {
+    let packetData = [NSMutableData data];
+    UInt8 headerByte = PGPHeaderPacketTagAllwaysSet | PGPHeaderPacketTagNewFormat | tag;
+    [packetData appendBytes:&headerByte length:1];
+    NSUInteger position = 0;
+    for (; body.length - position > 512; position += 512) {
+        UInt8 partialLengthOctet = 224 + 9;
+        [packetData appendBytes:&partialLengthOctet length:1];
+        [packetData appendData:[body subdataWithRange:(NSRange){position, 512}]];
+    }
+    let lastChunk = [body subdataWithRange:(NSRange){position, body.length - position}];
+    [packetData appendData:[PGPPacketHeader buildNewFormatLengthDataForData:lastChunk]];
+    [packetData appendData:lastChunk];
+    return packetData;
+}
+
+- (void)testEncryptedLiteralReader {
+    let plaintext = [PGPCryptoUtils randomData:100000];
+    let sessionKey = [[PGPSessionKey alloc] initWithAlgorithm:PGPSymmetricAES256 keyData:[PGPCryptoUtils randomData:32]];
+
+    // Uncompressed literal data: format, filename, date, data
+    let literalBody = [NSMutableData data];
+    UInt8 literalHeader[] = {PGPLiteralPacketBinary, 4, 'f', 'i', 'l', 'e', 0, 0, 0, 0};
+    [literalBody appendBytes:literalHeader length:sizeof(literalHeader)];
+    [literalBody appendData:plaintext];
+    let literalPacketData = [self partialLengthPacketWithTag:PGPLiteralDataPacketTag body:literalBody];
+
+    let encryptedDataPacket = [[PGPSymmetricallyEncryptedIntegrityProtectedDataPacket alloc] init];
+    XCTAssertTrue([encryptedDataPacket encrypt:literalPacketData symmetricAlgorithm:sessionKey.algorithm sessionKeyData:sessionKey.keyData error:nil]);
+    let encryptedDataPacketData = [encryptedDataPacket export:nil];
+    let header = [PGPPacketHeader headerFromData:encryptedDataPacketData offset:0];
+    let encryptedData = [self partialLengthPacketWithTag:PGPSymmetricallyEncryptedIntegrityProtectedDataPacketTag body:[encryptedDataPacketData subdataWithRange:(NSRange){header.headerLength, header.bodyLength}]];
+    XCTAssertEqualObjects([ObjectivePGP decrypt:encryptedData withSessionKey:PGPNN(sessionKey) andVerifySignature:NO usingKeys:@[] error:nil], plaintext);
+
+    NSError *readError;
+    let reader = [[PGPEncryptedLiteralReader alloc] initWithData:encryptedData sessionKey:PGPNN(sessionKey) error:&readError];
+    XCTAssertNil(readError);
+    XCTAssertEqual(reader.length, plaintext.length);
+    XCTAssertEqualObjects(reader.filename, @"file");
+    XCTAssertTrue([reader verifyIntegrity:nil]);
+
+    NSRange ranges[] = {{0, 1}, {0, plaintext.length}, {511, 3}, {1000, 5000}, {99999, 1}, {plaintext.length, 0}};
+    for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+        XCTAssertEqualObjects([reader readRange:ranges[i] error:&readError], [plaintext subdataWithRange:ranges[i]]);
+        XCTAssertNil(readError);
+    }
+    XCTAssertNil([reader readRange:(NSRange){plaintext.length - 1, 2} error:&readError]);
+    XCTAssertNotNil(readError);
+
+    // Modified ciphertext reads, but fails the integrity check
+    let modifiedData = [encryptedData mutableCopy];
+    ((UInt8 *)modifiedData.mutableBytes)[modifiedData.length / 2] ^= 0x01;
+    let modifiedReader = [[PGPEncryptedLiteralReader alloc] initWithData:modifiedData sessionKey:PGPNN(sessionKey) error:nil];
+    XCTAssertNotNil([modifiedReader readRange:(NSRange){0, 100} error:nil]);
+    XCTAssertFalse([modifiedReader verifyIntegrity:nil]);
+
+    // Wrong session key
+    let wrongSessionKey = [[PGPSessionKey alloc] initWithAlgorithm:PGPSymmetricAES256 keyData:[PGPCryptoUtils randomData:32]];
+    XCTAssertNil([[PGPEncryptedLiteralReader alloc] initWithData:encryptedData sessionKey:PGPNN(wrongSessionKey) error:nil]);
+}
+
+- (void)testPacketParserChunks {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key = [generator generateFor:@"test+1@example.com" passphrase:nil];
+
+    let plaintext = [PGPCryptoUtils randomData:10000];
+    let encryptedData = [ObjectivePGP encrypt:plaintext addSignature:YES usingKeys:@[key] passphraseForKey:nil error:nil];
+    PGPSessionKey *sessionKey;
+    XCTAssertNotNil([ObjectivePGP decrypt:encryptedData andVerifySignature:NO usingKeys:@[key] passphraseForKey:nil sessionKey:&sessionKey error:nil]);
+
+    let literalData = [NSMutableData data];
+    let tags = [NSMutableArray<NSNumber *> array];
+    __block NSInteger openPackets = 0;
+    let parser = [[PGPPacketParser alloc] initWithHandler:^(PGPPacketParserEvent event, PGPPacketTag tag, NSUInteger depth, NSData * _Nullable bodyData) {
+        switch (event) {
+            case PGPPacketParserEventHeader:
+                [tags addObject:@(tag)];
+                openPackets += 1;
+                break;
+            case PGPPacketParserEventBody:
+                if (tag == PGPLiteralDataPacketTag) {
+                    [literalData appendData:PGPNN(bodyData)];
+                }
+                break;
+            case PGPPacketParserEventEnd:
+                openPackets -= 1;
+                break;
+        }
+    }];
+    parser.sessionKey = sessionKey;
+
+    // Feed in chunks of arbitrary size
+    NSError *parseError;
+    for (NSUInteger position = 0, chunkSize = 1; position < encryptedData.length; position += chunkSize, chunkSize = chunkSize % 97 + 1) {
+        XCTAssertTrue([parser feedData:[encryptedData subdataWithRange:(NSRange){position, MIN(chunkSize, encryptedData.length - position)}] error:&parseError]);
+    }
+    XCTAssertTrue([parser finish:&parseError]);
+    XCTAssertNil(parseError);
+    XCTAssertEqual(openPackets, 0);
+
+    // Session key, encrypted data, compressed data, one-pass signature, literal data, signature
+    let expectedTags = @[@(PGPPublicKeyEncryptedSessionKeyPacketTag), @(PGPSymmetricallyEncryptedIntegrityProtectedDataPacketTag), @(PGPCompressedDataPacketTag), @(PGPOnePassSignaturePacketTag), @(PGPLiteralDataPacketTag), @(PGPSignaturePacketTag)];
+    XCTAssertEqualObjects(tags, expectedTags);
+    // Literal packet body: format, filename length, date, data
+    XCTAssertEqualObjects([literalData subdataWithRange:(NSRange){6, literalData.length - 6}], plaintext);
+
+    // Incomplete packet
+    let incompleteParser = [[PGPPacketParser alloc] initWithHandler:^(PGPPacketParserEvent event, PGPPacketTag tag, NSUInteger depth, NSData * _Nullable bodyData) {}];
+    XCTAssertTrue([incompleteParser feedData:[encryptedData subdataWithRange:(NSRange){0, 100}] error:nil]);
+    XCTAssertFalse([incompleteParser finish:nil]);
+
+    // Not a packet header
+    UInt8 garbage[] = {0x01, 0x02};
+    let garbageParser = [[PGPPacketParser alloc] initWithHandler:^(PGPPacketParserEvent event, PGPPacketTag tag, NSUInteger depth, NSData * _Nullable bodyData) {}];
+    XCTAssertFalse([garbageParser feedData:[NSData dataWithBytes:garbage length:sizeof(garbage)] error:&parseError]);
+    XCTAssertNotNil(parseError);
+}
+
+- (void)testReadKeysMergesByFingerprint {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let generatedKeys = [NSMutableArray<PGPKey *> array];
+    let publicKeysData = [NSMutableData data];
+    let secretKeysData = [NSMutableData data];
+    for (NSUInteger i = 0; i < 100; i++) {
+        let key = [generator generateFor:[NSString stringWithFormat:@"test+%@@example.com", @(i)] passphrase:nil];
+        [generatedKeys addObject:key];
+        [publicKeysData appendData:PGPNN([key export:PGPKeyTypePublic error:nil])];
+        [secretKeysData appendData:PGPNN([key export:PGPKeyTypeSecret error:nil])];
+    }
+
+    // Public keys, then the secret keys of the same keys
+    let keyringData = [NSMutableData dataWithData:publicKeysData];
+    [keyringData appendData:secretKeysData];
+
+    let keys = [ObjectivePGP readKeysFromData:keyringData error:nil];
+    XCTAssertEqual(keys.count, generatedKeys.count);
+    for (NSUInteger i = 0; i < keys.count; i++) {
+        XCTAssertEqualObjects(keys[i].keyID, generatedKeys[i].keyID);
+        XCTAssertNotNil(keys[i].publicKey);
+        XCTAssertNotNil(keys[i].secretKey);
+    }
+}
+
+- (void)testPartialKeyLazyUsers {
+    let keyringData = PGPNN([NSData dataWithContentsOfFile:[PGPTestUtils pathToBundledFile:@"pubring-test-plaintext.gpg"]]);
+    let keyRanges = PGPNN([ObjectivePGP keyRangesInData:keyringData resyncPolicy:PGPPacketResyncPolicySkip error:nil]);
+    XCTAssertGreaterThan(keyRanges.count, (NSUInteger)0);
+
+    for (NSValue *rangeValue in keyRanges) {
+        let lazyKey = [ObjectivePGP readPartialKeyFromData:keyringData range:rangeValue.rangeValue];
+        let eagerKey = [[PGPPartialKey alloc] initWithPackets:[ObjectivePGP readPacketsFromData:[keyringData subdataWithRange:rangeValue.rangeValue]]];
+        XCTAssertNotNil(lazyKey);
+        XCTAssertEqualObjects(lazyKey.fingerprint, eagerKey.fingerprint);
+        XCTAssertEqualObjects(lazyKey.subKeys, eagerKey.subKeys);
+        XCTAssertEqualObjects(lazyKey.users, eagerKey.users);
+        XCTAssertEqualObjects([lazyKey export:nil], [eagerKey export:nil]);
+    }
+
+    // Reading, merging, copying and comparing the keys don't parse the users
+    let keys = PGPNN([ObjectivePGP readKeysFromData:keyringData error:nil]);
+    let otherKeys = PGPNN([ObjectivePGP readKeysFromData:keyringData error:nil]);
+    XCTAssertGreaterThan(keys.count, (NSUInteger)0);
+    for (PGPKey *key in keys) {
+        XCTAssertTrue(key.publicKey.hasUnparsedUsers);
+        XCTAssertTrue([key.publicKey copy].hasUnparsedUsers);
+    }
+    XCTAssertEqualObjects(keys, otherKeys);
+    XCTAssertEqual(keys.firstObject.hash, otherKeys.firstObject.hash);
+    XCTAssertTrue(keys.firstObject.publicKey.hasUnparsedUsers);
+
+    // Parsed users equal the unparsed ones
+    XCTAssertGreaterThan(otherKeys.firstObject.publicKey.users.count, (NSUInteger)0);
+    XCTAssertFalse(otherKeys.firstObject.publicKey.hasUnparsedUsers);
+    XCTAssertEqualObjects(keys.firstObject, otherKeys.firstObject);
+    XCTAssertEqual(keys.firstObject.hash, otherKeys.firstObject.hash);
+}
+
+- (void)testSignatureSubpacketsTable {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key = [generator generateFor:@"test+1@example.com" passphrase:nil];
+
+    let plaintext = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+    let signatureData = PGPNN([ObjectivePGP sign:plaintext detached:YES usingKeys:@[key] passphraseForKey:nil error:nil]);
+    let signaturePacket = PGPCast([PGPPacketFactory packetWithData:signatureData offset:0 consumedBytes:nil], PGPSignaturePacket);
+    XCTAssertNotNil(signaturePacket);
+    XCTAssertEqual([signaturePacket subpacketsOfType:PGPSignatureSubpacketTypeSignatureCreationTime].count, (NSUInteger)1);
+    XCTAssertEqual([signaturePacket subpacketsOfType:PGPSignatureSubpacketTypeRevocationKey].count, (NSUInteger)0);
+    XCTAssertNotNil(signaturePacket.creationDate);
+    XCTAssertEqual(signaturePacket.keyFlags.count, (NSUInteger)0);
+
+    // Parsed bytes are exported and verified as they are
+    XCTAssertEqualObjects([signaturePacket export:nil], signatureData);
+    XCTAssertTrue([ObjectivePGP verify:plaintext withSignature:signatureData usingKeys:@[key] passphraseForKey:nil error:nil]);
+
+    let selfCertificate = key.publicKey.primaryUserSelfCertificate;
+    XCTAssertTrue([selfCertificate.keyFlags containsObject:@(PGPSignatureFlagAllowSignData)]);
+    XCTAssertEqualObjects(selfCertificate.preferredSymmetricAlgorithms, PGPCast([selfCertificate subpacketsOfType:PGPSignatureSubpacketTypePreferredSymetricAlgorithm].firstObject.value, NSArray));
+}
+
+- (void)testKeyProfile {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key = [generator generateFor:@"test+1@example.com" passphrase:nil];
+
+    let profile = key.profile;
+    XCTAssertEqualObjects(profile.keyID, key.keyID);
+    XCTAssertFalse(profile.isRevoked);
+    XCTAssertFalse(profile.isExpired);
+    XCTAssertEqualObjects(profile.encryptionKeyPacket, [key.publicKey encryptionKeyPacket:nil]);
+    XCTAssertTrue([profile.encryptionKeyPackets containsObject:PGPNN(profile.encryptionKeyPacket)]);
+    XCTAssertTrue([profile.signingKeyPackets containsObject:key.publicKey.primaryKeyPacket]);
+    XCTAssertEqualObjects(profile.preferredSymmetricAlgorithms, key.publicKey.primaryUserSelfCertificate.preferredSymmetricAlgorithms);
+    XCTAssertEqual([PGPKeyProfile preferredSymmetricAlgorithmForProfiles:@[profile]], key.publicKey.preferredSymmetricAlgorithm);
+    XCTAssertTrue([PGPKeyProfile isFeature:PGPFeatureModificationDetection supportedByProfiles:@[profile]]);
+    XCTAssertFalse([PGPKeyProfile isFeature:PGPFeatureModificationDetection supportedByProfiles:@[]]);
+
+    // Signing key and preferences of the profile
+    XCTAssertEqualObjects(key.signingSecretKey.keyID, PGPCast(profile.signingKeyPackets.firstObject, PGPPublicKeyPacket).keyID);
+    XCTAssertEqualObjects([key.publicKey signingKeyPacketWithKeyID:key.keyID], key.publicKey.primaryKeyPacket);
+    XCTAssertEqual(profile.preferredHashAlgorithm, PGPHashSHA256);
+    XCTAssertEqual([PGPKeyProfile preferredCompressionAlgorithmForProfiles:@[profile]], PGPCompressionZLIB);
+    let signatureData = PGPNN([ObjectivePGP sign:[@"test" dataUsingEncoding:NSUTF8StringEncoding] detached:YES usingKeys:@[key] passphraseForKey:nil error:nil]);
+    let signature = PGPNN(PGPCast([ObjectivePGP readPacketsFromData:signatureData].firstObject, PGPSignaturePacket));
+    XCTAssertEqual(signature.hashAlgoritm, PGPHashSHA256);
+
+    // Computed once, and again after the key changed
+    XCTAssertTrue(key.profile == profile);
+    XCTAssertTrue(key.publicKey.profile == profile);
+    XCTAssertEqual([PGPPartialKey preferredSymmetricAlgorithmForKeys:@[key.publicKey]], PGPSymmetricAES256);
+    XCTAssertTrue(key.publicKey.profile == profile);
+    [key addUserId:@"test+2@example.com" passphraseForKey:nil];
+    XCTAssertTrue(key.profile != profile);
+    XCTAssertEqualObjects(key.profile.keyID, key.keyID);
+
+    // The subkey expires in 2 seconds, after the profile is computed
+    let expiringKey = [generator generateFor:@"test+3@example.com" passphrase:nil];
+    let subKey = PGPNN(expiringKey.publicKey.subKeys.firstObject);
+    let subKeyPacket = PGPNN(PGPCast(subKey.primaryKeyPacket, PGPPublicKeyPacket));
+    let bindingSignature = PGPNN(subKey.bindingSignature);
+    let keyExpirationTime = ceil([NSDate.date timeIntervalSinceDate:subKeyPacket.createDate]) + 2;
+    bindingSignature.hashedSubpackets = [bindingSignature.hashedSubpackets arrayByAddingObject:[[PGPSignatureSubpacket alloc] initWithType:PGPSignatureSubpacketTypeKeyExpirationTime andValue:@(keyExpirationTime)]];
+    let toSignData = [NSMutableData dataWithData:[PGPNN(PGPCast(expiringKey.publicKey.primaryKeyPacket, PGPPublicKeyPacket)) exportKeyPacketOldStyle]];
+    [toSignData appendData:[subKeyPacket exportKeyPacketOldStyle]];
+    XCTAssertTrue([bindingSignature signToSignData:toSignData withKey:expiringKey error:nil]);
+    // Signed in place, after the profile was computed to sign
+    [expiringKey.publicKey invalidateProfile];
+
+    let expiringProfile = expiringKey.profile;
+    XCTAssertEqualObjects(expiringProfile.encryptionKeyPacket, subKeyPacket);
+    [NSThread sleepForTimeInterval:3];
+    XCTAssertTrue(expiringKey.profile == expiringProfile);
+    XCTAssertEqual(expiringProfile.encryptionKeyPackets.count, (NSUInteger)0);
+    XCTAssertNil(expiringProfile.encryptionKeyPacket);
+
+    // No fallback to the expired subkey
+    NSError *encryptError;
+    XCTAssertNil([ObjectivePGP encrypt:[@"test message" dataUsingEncoding:NSUTF8StringEncoding] addSignature:NO usingKeys:@[expiringKey] passphraseForKey:nil error:&encryptError]);
+    XCTAssertNotNil(encryptError);
+}
+
+- (void)testKeySignaturesValidation {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key = [generator generateFor:@"test+1@example.com" passphrase:nil];
+
+    // Verified on import
+    let readKey = [ObjectivePGP readKeysFromData:PGPNN([key export:PGPKeyTypePublic error:nil]) error:nil].firstObject;
+    let publicKey = PGPNN(readKey.publicKey);
+    let selfCertificate = PGPNN(publicKey.users.firstObject.selfCertifications.firstObject);
+    let bindingSignature = PGPNN(publicKey.subKeys.firstObject.bindingSignature);
+    XCTAssertEqual(selfCertificate.validity, PGPSignatureValidityValid);
+    XCTAssertEqual(bindingSignature.validity, PGPSignatureValidityValid);
+    XCTAssertNotNil([publicKey encryptionKeyPacket:nil]);
+
+    // A subkey with an invalid binding signature is not used
+    bindingSignature.signatureMPIs = selfCertificate.signatureMPIs;
+    XCTAssertEqual(bindingSignature.validity, PGPSignatureValidityUnknown);
+    let tamperedKey = [ObjectivePGP readKeysFromData:PGPNN([readKey export:PGPKeyTypePublic error:nil]) error:nil].firstObject;
+    XCTAssertEqual(tamperedKey.publicKey.subKeys.firstObject.bindingSignature.validity, PGPSignatureValidityInvalid);
+    XCTAssertNil([tamperedKey.publicKey encryptionKeyPacket:nil]);
+    XCTAssertEqual(tamperedKey.profile.encryptionKeyPackets.count, (NSUInteger)0);
+    NSError *encryptError;
+    XCTAssertNil([ObjectivePGP encrypt:[@"test message" dataUsingEncoding:NSUTF8StringEncoding] addSignature:NO usingKeys:@[PGPNN(tamperedKey)] passphraseForKey:nil error:&encryptError]);
+    XCTAssertNotNil(encryptError);
+
+    // A subkey bound by another key can't be verified, and is not used
+    let otherKey = [ObjectivePGP readKeysFromData:PGPNN([[generator generateFor:@"test+2@example.com" passphrase:nil] export:PGPKeyTypePublic error:nil]) error:nil].firstObject;
+    let appendedKey = [ObjectivePGP readKeysFromData:PGPNN([key export:PGPKeyTypePublic error:nil]) error:nil].firstObject;
+    appendedKey.publicKey.subKeys.firstObject.bindingSignature = otherKey.publicKey.subKeys.firstObject.bindingSignature;
+    let foreignKey = [ObjectivePGP readKeysFromData:PGPNN([appendedKey export:PGPKeyTypePublic error:nil]) error:nil].firstObject;
+    XCTAssertEqual(foreignKey.publicKey.subKeys.firstObject.bindingSignature.validity, PGPSignatureValidityInvalid);
+    XCTAssertNil([foreignKey.publicKey encryptionKeyPacket:nil]);
+    XCTAssertEqual(foreignKey.profile.encryptionKeyPackets.count, (NSUInteger)0);
+}
+
+- (void)testTrustGraph {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let rootKey = [generator generateFor:@"root@example.com" passphrase:nil];
+    let caKey = [generator generateFor:@"ca@example.com" passphrase:nil];
+    let leafKey = [generator generateFor:@"leaf@example.com" passphrase:nil];
+    let otherKey = [generator generateFor:@"other@example.com" passphrase:nil];
+
+    // Signature of the user of the target key by the issuer key, with the trust level.
+    let certify = ^PGPSignaturePacket *(PGPKey *issuerKey, PGPKey *targetKey, PGPSignatureType type, UInt8 trustLevel) {
+        let user = PGPNN(targetKey.publicKey.users.firstObject);
+        let signature = [PGPSignaturePacket signaturePacket:type hashAlgorithm:PGPHashSHA256];
+        let hashedSubpackets = [NSMutableArray<PGPSignatureSubpacket *> arrayWithObject:[[PGPSignatureSubpacket alloc] initWithType:PGPSignatureSubpacketTypeSignatureCreationTime andValue:NSDate.date]];
+        if (trustLevel > 0) {
+            [hashedSubpackets addObject:[[PGPSignatureSubpacket alloc] initWithType:PGPSignatureSubpacketTypeTrustSignature andValue:@[@(trustLevel), @120]]];
+        }
+        signature.hashedSubpackets = hashedSubpackets;
+        XCTAssertTrue([signature signToSignData:PGPNN([PGPKeyValidator toSignDataForUser:user ofPartialKey:PGPNN(targetKey.publicKey)]) withKey:issuerKey error:nil]);
+        if (type == PGPSignatureCertificationRevocation) {
+            user.revocationSignatures = [user.revocationSignatures arrayByAddingObject:signature];
+        } else {
+            user.otherSignatures = [user.otherSignatures arrayByAddingObject:signature];
+        }
+        return signature;
+    };
+
+    // root -> ca (trusted introducer) -> leaf -> other
+    let caCertification = certify(rootKey, caKey, PGPSignatureGenericCertificationUserIDandPublicKey, 1);
+    XCTAssertEqual(caCertification.trustLevel, 1);
+    XCTAssertEqual(caCertification.trustAmount, 120);
+    let leafCertification = certify(caKey, leafKey, PGPSignatureGenericCertificationUserIDandPublicKey, 0);
+    certify(leafKey, otherKey, PGPSignatureGenericCertificationUserIDandPublicKey, 0);
+
+    // The trust signature survives the export
+    let readCAKey = [ObjectivePGP readKeysFromData:PGPNN([caKey export:PGPKeyTypePublic error:nil]) error:nil].firstObject;
+    XCTAssertEqual(readCAKey.publicKey.users.firstObject.otherSignatures.firstObject.trustLevel, 1);
+
+    let graph = [[PGPTrustGraph alloc] init];
+    [graph addKeys:@[caKey, leafKey, otherKey]];
+    XCTAssertEqual([graph validityOfKey:leafKey], PGPKeyValidityUnknown);
+
+    [graph addTrustRoots:@[rootKey]];
+    XCTAssertEqual([graph validityOfKey:rootKey], PGPKeyValidityUltimate);
+    XCTAssertEqual([graph validityOfKey:caKey], PGPKeyValidityFull);
+    XCTAssertEqual([graph validityOfKey:leafKey], PGPKeyValidityFull);
+    XCTAssertEqual(caCertification.validity, PGPSignatureValidityValid);
+    // Not an introducer
+    XCTAssertEqual([graph validityOfKey:otherKey], PGPKeyValidityUnknown);
+
+    // A trust signature in the unhashed area is not signed by the issuer
+    leafCertification.unhashedSubpackets = [leafCertification.unhashedSubpackets arrayByAddingObject:[[PGPSignatureSubpacket alloc] initWithType:PGPSignatureSubpacketTypeTrustSignature andValue:@[@255, @120]]];
+    XCTAssertEqual(leafCertification.trustLevel, 0);
+    [graph addKeys:@[leafKey]];
+    XCTAssertEqual([graph validityOfKey:leafKey], PGPKeyValidityFull);
+    XCTAssertEqual([graph validityOfKey:otherKey], PGPKeyValidityUnknown);
+    XCTAssertEqual(graph.keys.count, (NSUInteger)4);
+
+    [graph removeKeys:@[caKey]];
+    XCTAssertEqual([graph validityOfKey:caKey], PGPKeyValidityUnknown);
+    XCTAssertEqual([graph validityOfKey:leafKey], PGPKeyValidityUnknown);
+    XCTAssertEqual([graph validityOfKey:rootKey], PGPKeyValidityUltimate);
+    [graph addKeys:@[caKey]];
+    XCTAssertEqual([graph validityOfKey:leafKey], PGPKeyValidityFull);
+
+    // Certification revoked by the root
+    certify(rootKey, caKey, PGPSignatureCertificationRevocation, 0);
+    [graph addKeys:@[caKey]];
+    XCTAssertEqual([graph validityOfKey:caKey], PGPKeyValidityUnknown);
+    XCTAssertEqual([graph validityOfKey:leafKey], PGPKeyValidityUnknown);
+    XCTAssertEqual([graph validityOfKey:rootKey], PGPKeyValidityUltimate);
+
+    [graph removeTrustRoots:@[rootKey]];
+    XCTAssertEqual([graph validityOfKey:rootKey], PGPKeyValidityUnknown);
+
+    // A revoked trust root is not valid, and introduces no key
+    let revokedRootKey = [generator generateFor:@"revoked@example.com" passphrase:nil];
+    certify(revokedRootKey, otherKey, PGPSignatureGenericCertificationUserIDandPublicKey, 0);
+    let revocation = [PGPSignaturePacket signaturePacket:PGPSignatureKeyRevocation hashAlgorithm:PGPHashSHA256];
+    revocation.hashedSubpackets = @[[[PGPSignatureSubpacket alloc] initWithType:PGPSignatureSubpacketTypeSignatureCreationTime andValue:NSDate.date]];
+    XCTAssertTrue([revocation signToSignData:[PGPNN(PGPCast(revokedRootKey.publicKey.primaryKeyPacket, PGPPublicKeyPacket)) exportKeyPacketOldStyle] withKey:revokedRootKey error:nil]);
+    revokedRootKey.publicKey.revocationSignature = revocation;
+    XCTAssertTrue(revokedRootKey.profile.isRevoked);
+    [graph addKeys:@[otherKey]];
+    [graph addTrustRoots:@[revokedRootKey]];
+    XCTAssertEqual([graph validityOfKey:revokedRootKey], PGPKeyValidityUnknown);
+    XCTAssertEqual([graph validityOfKey:otherKey], PGPKeyValidityUnknown);
+}
+
+- (void)testVerificationCache {
+    let cache = [[PGPVerificationCache alloc] initWithCapacity:2];
+    let firstFingerprint = [@"first" dataUsingEncoding:NSUTF8StringEncoding];
+    let secondFingerprint = [@"second" dataUsingEncoding:NSUTF8StringEncoding];
+    let keyA = [@"a" dataUsingEncoding:NSUTF8StringEncoding];
+    let keyB = [@"b" dataUsingEncoding:NSUTF8StringEncoding];
+    let keyC = [@"c" dataUsingEncoding:NSUTF8StringEncoding];
+    [cache addKey:keyA signingKeyFingerprint:firstFingerprint];
+    [cache addKey:keyB signingKeyFingerprint:secondFingerprint];
+    XCTAssertTrue([cache containsKey:keyA]);
+    // The least recently used is dropped
+    [cache addKey:keyC signingKeyFingerprint:firstFingerprint];
+    XCTAssertEqual(cache.count, (NSUInteger)2);
+    XCTAssertFalse([cache containsKey:keyB]);
+    XCTAssertTrue([cache containsKey:keyA]);
+    XCTAssertTrue([cache containsKey:keyC]);
+    [cache removeKeysOfSigningKeyFingerprint:firstFingerprint];
+    XCTAssertEqual(cache.count, (NSUInteger)0);
+
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key = [generator generateFor:@"test+1@example.com" passphrase:nil];
+    let plaintext = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+    let signature = [ObjectivePGP sign:plaintext detached:YES usingKeys:@[key] passphraseForKey:nil error:nil];
+
+    // The same signature of the same data is verified with the key once
+    let sharedCache = PGPVerificationCache.sharedCache;
+    [sharedCache removeAllKeys];
+    XCTAssertTrue([ObjectivePGP verify:plaintext withSignature:signature usingKeys:@[key] passphraseForKey:nil error:nil]);
+    let count = sharedCache.count;
+    XCTAssertGreaterThan(count, (NSUInteger)0);
+    XCTAssertTrue([ObjectivePGP verify:plaintext withSignature:signature usingKeys:@[key] passphraseForKey:nil error:nil]);
+    XCTAssertEqual(sharedCache.count, count);
+    // Not for the other data
+    XCTAssertFalse([ObjectivePGP verify:[@"other message" dataUsingEncoding:NSUTF8StringEncoding] withSignature:signature usingKeys:@[key] passphraseForKey:nil error:nil]);
+    XCTAssertEqual(sharedCache.count, count);
+
+    [sharedCache removeKeysOfSigningKeyFingerprint:PGPNN(key.publicKey).fingerprint.hashedData];
+    XCTAssertEqual(sharedCache.count, (NSUInteger)0);
+}
+
+- (void)testMessageStages {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key = [generator generateFor:@"test+1@example.com" passphrase:nil];
+
+    let plaintext = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+    let encryptedData = [ObjectivePGP encrypt:plaintext addSignature:YES usingKeys:@[key] passphraseForKey:nil error:nil];
+    let armoredData = [[PGPArmor armored:PGPNN(encryptedData) as:PGPArmorMessage] dataUsingEncoding:NSUTF8StringEncoding];
+
+    NSError *messageError;
+    let message = [[PGPMessage alloc] initWithData:PGPNN(armoredData) error:&messageError];
+    XCTAssertNotNil(message);
+    XCTAssertNil(messageError);
+    XCTAssertEqualObjects(message.data, encryptedData);
+    XCTAssertTrue(message.isEncrypted);
+    XCTAssertEqualObjects(message.recipientKeyIDs, [ObjectivePGP recipientsKeyIDForMessage:PGPNN(encryptedData) error:nil]);
+
+    // Missing key
+    XCTAssertNil([message decryptUsingKeys:@[] passphraseForKey:nil error:&messageError]);
+    XCTAssertNotNil(messageError);
+    messageError = nil;
+
+    let sessionKey = [message sessionKeyUsingKeys:@[key] passphraseForKey:nil error:&messageError];
+    XCTAssertNotNil(sessionKey);
+    XCTAssertNil(messageError);
+    // Kept for the decrypting key
+    XCTAssertEqual([message sessionKeyUsingKeys:@[key] passphraseForKey:nil error:nil], sessionKey);
+
+    // The plaintext is kept for the session key, not for the keys that can't decrypt it
+    let decrypted = [message decryptUsingKeys:@[key] passphraseForKey:nil error:&messageError];
+    XCTAssertEqualObjects(decrypted, plaintext);
+    XCTAssertNil(messageError);
+    XCTAssertEqual([message decryptUsingKeys:@[key] passphraseForKey:nil error:nil], decrypted);
+    XCTAssertEqual([message decryptWithSessionKey:PGPNN(sessionKey) error:nil], decrypted);
+    XCTAssertNil([message decryptUsingKeys:@[] passphraseForKey:nil error:nil]);
+    let otherKey = [generator generateFor:@"test+2@example.com" passphrase:nil];
+    XCTAssertNil([message decryptUsingKeys:@[otherKey] passphraseForKey:nil error:nil]);
+    let wrongSessionKey = [[PGPSessionKey alloc] initWithAlgorithm:sessionKey.algorithm keyData:[PGPCryptoUtils randomData:sessionKey.keyData.length]];
+    XCTAssertNil([message decryptWithSessionKey:PGPNN(wrongSessionKey) error:nil]);
+    XCTAssertEqual([message decryptUsingKeys:@[key] passphraseForKey:nil error:nil], decrypted);
+
+    XCTAssertTrue([message verifyUsingKeys:@[key] certifyWithRootKey:NO passphraseForKey:nil error:&messageError]);
+    XCTAssertNil(messageError);
+    XCTAssertFalse([message verifyUsingKeys:@[] certifyWithRootKey:NO passphraseForKey:nil error:&messageError]);
+    XCTAssertNotNil(messageError);
+
+    // Decrypt with the session key
+    let otherMessage = [[PGPMessage alloc] initWithData:PGPNN(encryptedData) error:nil];
+    XCTAssertEqualObjects([otherMessage decryptWithSessionKey:PGPNN(sessionKey) error:nil], plaintext);
+}
+
+- (void)testModifiedEncryptedDataNotParsed {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key = [generator generateFor:@"test+1@example.com" passphrase:nil];
+
+    let plaintext = [PGPCryptoUtils randomData:10000];
+    let encryptedData = [ObjectivePGP encrypt:plaintext addSignature:NO usingKeys:@[key] passphraseForKey:nil error:nil];
+    PGPSessionKey *sessionKey;
+    XCTAssertNotNil([ObjectivePGP decrypt:encryptedData andVerifySignature:NO usingKeys:@[key] passphraseForKey:nil sessionKey:&sessionKey error:nil]);
+
+    // The last octet is the last octet of the MDC hash
+    let modifiedData = [encryptedData mutableCopy];
+    ((UInt8 *)modifiedData.mutableBytes)[modifiedData.length - 1] ^= 0x01;
+
+    NSError *decryptError;
+    XCTAssertNil([ObjectivePGP decrypt:modifiedData withSessionKey:PGPNN(sessionKey) andVerifySignature:NO usingKeys:@[] error:&decryptError]);
+    XCTAssertNotNil(decryptError);
+
+    // Decrypted packets are not reported
+    __block NSUInteger nestedPackets = 0;
+    let parser = [[PGPPacketParser alloc] initWithHandler:^(PGPPacketParserEvent event, PGPPacketTag tag, NSUInteger depth, NSData * _Nullable bodyData) {
+        if (depth > 0) {
+            nestedPackets += 1;
+        }
+    }];
+    parser.sessionKey = sessionKey;
+    XCTAssertTrue([parser feedData:modifiedData error:nil]);
+    XCTAssertFalse([parser finish:nil]);
+    XCTAssertEqual(nestedPackets, (NSUInteger)0);
+
+    // Plaintext larger than held back fails
+    let limitedParser = [[PGPPacketParser alloc] initWithHandler:^(PGPPacketParserEvent event, PGPPacketTag tag, NSUInteger depth, NSData * _Nullable bodyData) {}];
+    limitedParser.sessionKey = sessionKey;
+    limitedParser.maximumUnverifiedPlaintextLength = 1024;
+    NSError *parseError;
+    XCTAssertFalse([limitedParser feedData:encryptedData error:&parseError]);
+    XCTAssertNotNil(parseError);
+
+    // Released plaintext is reported before the check fails
+    let releasingParser = [[PGPPacketParser alloc] initWithHandler:^(PGPPacketParserEvent event, PGPPacketTag tag, NSUInteger depth, NSData * _Nullable bodyData) {
+        if (depth > 0) {
+            nestedPackets += 1;
+        }
+    }];
+    releasingParser.sessionKey = sessionKey;
+    releasingParser.maximumUnverifiedPlaintextLength = 1024;
+    releasingParser.releasesUnverifiedPlaintext = YES;
+    XCTAssertTrue([releasingParser feedData:modifiedData error:nil]);
+    XCTAssertGreaterThan(nestedPackets, (NSUInteger)0);
+    XCTAssertFalse([releasingParser finish:nil]);
+}
+
+- (void)testReadKeysResync {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let key1 = [generator generateFor:@"test+1@example.com" passphrase:nil];
+    let key2 = [generator generateFor:@"test+2@example.com" passphrase:nil];
+
+    // Keys separated with 1 MiB of invalid data
+    let data = [NSMutableData dataWithData:PGPNN([key1 export:PGPKeyTypePublic error:nil])];
+    let garbage = [NSMutableData dataWithLength:1024 * 1024];
+    memset(garbage.mutableBytes, 0xFF, garbage.length);
+    [data appendData:garbage];
+    [data appendData:PGPNN([key2 export:PGPKeyTypePublic error:nil])];
+
+    NSError *readError;
+    let skippedKeys = [ObjectivePGP readKeysFromData:data resyncPolicy:PGPPacketResyncPolicySkip error:&readError];
+    XCTAssertNil(readError);
+    XCTAssertEqual(skippedKeys.count, (NSUInteger)2);
+    XCTAssertEqualObjects([ObjectivePGP readKeysFromData:data error:nil], skippedKeys);
+
+    let stoppedKeys = [ObjectivePGP readKeysFromData:data resyncPolicy:PGPPacketResyncPolicyStop error:&readError];
+    XCTAssertNil(readError);
+    XCTAssertEqual(stoppedKeys.count, (NSUInteger)1);
+    XCTAssertEqualObjects(stoppedKeys.firstObject.keyID, key1.keyID);
+
+    XCTAssertNil([ObjectivePGP readKeysFromData:data resyncPolicy:PGPPacketResyncPolicyReport error:&readError]);
+    XCTAssertNotNil(readError);
+}
+
 - (void)testECC_encrypt_sign {
     let keyPub = [[PGPTestUtils readKeysFromPath:@"ecc-curve25519-pub1.asc"] firstObject];
     XCTAssertNotNil(keyPub);
@@ -899,4 +1693,300 @@ Hy2rxOlSAfBZaJr9A7XSPlU=\n\
     XCTAssertEqualObjects(@"Hi Marcin, this a signed message", [[NSString alloc] initWithData:decrypted encoding:NSUTF8StringEncoding]);
 }
 
+- (void)testSEIPDv2AEADWithPassphrase {
+    let plaintext = [[@"" stringByPaddingToLength:1000 withString:@"Lorem ipsum dolor sit amet. " startingAtIndex:0] dataUsingEncoding:NSUTF8StringEncoding];
+    for (NSNumber *aeadAlgorithm in @[@(PGPAEADOCB), @(PGPAEADGCM)]) {
+        let sessionKeyData = [NSMutableData dataWithLength:32];
+        arc4random_buf(sessionKeyData.mutableBytes, sessionKeyData.length);
+
+        let skesk = [[PGPSymetricKeyEncryptedSessionKeyPacket alloc] init];
+        skesk.version = 6;
+        skesk.symmetricAlgorithm = PGPSymmetricAES256;
+        skesk.aeadAlgorithm = (PGPAEADAlgorithm)aeadAlgorithm.unsignedIntValue;
+        skesk.s2k = [[PGPS2K alloc] initWithSpecifier:PGPS2KSpecifierIteratedAndSalted hashAlgorithm:PGPHashSHA256];
+        XCTAssertTrue([skesk encryptSessionKeyData:sessionKeyData sessionKeyAlgorithm:PGPSymmetricAES256 passphrase:@"passphrase" error:nil]);
+
+        let literalPacket = [PGPLiteralPacket literalPacket:PGPLiteralPacketBinary withData:plaintext];
+        literalPacket.timestamp = NSDate.date;
+        let seipd = [[PGPSymmetricallyEncryptedIntegrityProtectedDataPacket alloc] init];
+        // small chunks to exercise the chunking
+        XCTAssertTrue([seipd encrypt:PGPNN([literalPacket export:nil]) symmetricAlgorithm:PGPSymmetricAES256 aeadAlgorithm:skesk.aeadAlgorithm chunkSizeOctet:0 sessionKeyData:sessionKeyData error:nil]);
+        XCTAssertEqual(seipd.version, (NSUInteger)2);
+
+        let message = [NSMutableData data];
+        [message appendData:PGPNN([skesk export:nil])];
+        [message appendData:PGPNN([seipd export:nil])];
+
+        NSError *decryptError = nil;
+        let decrypted = [ObjectivePGP decrypt:message andVerifySignature:NO usingKeys:@[] passphraseForKey:^NSString * _Nullable(PGPKey * _Nullable k) { return @"passphrase"; } error:&decryptError];
+        XCTAssertNil(decryptError);
+        XCTAssertEqualObjects(decrypted, plaintext);
+
+        // Stopped decryption does not verify the final tag
+        __block NSUInteger chunksCount = 0;
+        NSError *stopError = nil;
+        XCTAssertFalse([seipd decryptChunksWithSessionKeyData:sessionKeyData error:&stopError usingBlock:^(NSData *plaintextChunk, BOOL *stop) {
+            chunksCount++;
+            *stop = YES;
+        }]);
+        XCTAssertNotNil(stopError);
+        XCTAssertEqual(chunksCount, (NSUInteger)1);
+        XCTAssertTrue([seipd decryptChunksWithSessionKeyData:sessionKeyData error:nil usingBlock:^(NSData *plaintextChunk, BOOL *stop) {}]);
+
+        // Modified ciphertext does not authenticate
+        NSMutableData *tampered = [message mutableCopy];
+        ((UInt8 *)tampered.mutableBytes)[tampered.length - 40] ^= 0x01;
+        NSError *tamperedError = nil;
+        let tamperedDecrypted = [ObjectivePGP decrypt:tampered andVerifySignature:NO usingKeys:@[] passphraseForKey:^NSString * _Nullable(PGPKey * _Nullable k) { return @"passphrase"; } error:&tamperedError];
+        XCTAssertNil(tamperedDecrypted);
+    }
+}
+
+- (void)testArgon2S2K {
+    // specifier 4, salt 0x01...0x10, t = 1, p = 4, m = 5 (32 KiB)
+    let s2kData = [NSMutableData dataWithBytes:(UInt8[]){0x04} length:1];
+    for (UInt8 i = 1; i <= 16; i++) {
+        [s2kData appendBytes:&i length:1];
+    }
+    [s2kData appendBytes:(UInt8[]){0x01, 0x04, 0x05} length:3];
+
+    NSUInteger s2kLength = 0;
+    let s2k = [PGPS2K S2KFromData:s2kData atPosition:0 length:&s2kLength];
+    XCTAssertEqual(s2kLength, s2kData.length);
+    XCTAssertEqual(s2k.specifier, PGPS2KSpecifierArgon2);
+    XCTAssertEqual(s2k.argon2Passes, 1);
+    XCTAssertEqual(s2k.argon2Parallelism, 4);
+    XCTAssertEqual(s2k.argon2EncodedMemory, 5);
+    XCTAssertEqualObjects([s2k export:nil], s2kData);
+
+    // Argon2id reference output
+    let expectedKey = [NSData dataWithBytes:(UInt8[]){0xe4, 0x4a, 0x83, 0x59, 0x64, 0x8b, 0x1e, 0xfb, 0x83, 0x64, 0x13, 0xad, 0xf1, 0x5e, 0x6d, 0x15} length:16];
+    XCTAssertEqualObjects([s2k produceSessionKeyWithPassphrase:@"password" symmetricAlgorithm:PGPSymmetricAES128], expectedKey);
+
+    // Session key protected with Argon2
+    let sessionKeyData = [NSMutableData dataWithLength:32];
+    arc4random_buf(sessionKeyData.mutableBytes, sessionKeyData.length);
+    let skesk = [[PGPSymetricKeyEncryptedSessionKeyPacket alloc] init];
+    skesk.version = 6;
+    skesk.symmetricAlgorithm = PGPSymmetricAES256;
+    skesk.aeadAlgorithm = PGPAEADOCB;
+    skesk.s2k = s2k;
+    XCTAssertTrue([skesk encryptSessionKeyData:sessionKeyData sessionKeyAlgorithm:PGPSymmetricAES256 passphrase:@"password" error:nil]);
+
+    let parsedSKESK = PGPCast([PGPPacketFactory packetWithData:PGPNN([skesk export:nil]) offset:0 consumedBytes:nil], PGPSymetricKeyEncryptedSessionKeyPacket);
+    XCTAssertEqual(parsedSKESK.s2k.specifier, PGPS2KSpecifierArgon2);
+    PGPSymmetricAlgorithm sessionKeyAlgorithm = PGPSymmetricPlaintext;
+    XCTAssertEqualObjects([parsedSKESK decryptSessionKeyWithPassphrase:@"password" sessionKeyAlgorithm:&sessionKeyAlgorithm error:nil], sessionKeyData);
+
+    // Secret key protected with Argon2 without AEAD (S2K usage 254) is rejected
+    let keyGenerator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let protectedKey = [keyGenerator generateFor:@"test+argon2@example.com" passphrase:@"password"];
+    let secretKeyPacket = PGPNN(PGPCast(protectedKey.secretKey.primaryKeyPacket, PGPSecretKeyPacket));
+    let secretKeyData = PGPNN([secretKeyPacket export:nil]);
+    let header = PGPNN([PGPPacketHeader headerFromData:secretKeyData offset:0]);
+    let secretKeyBody = [NSMutableData dataWithData:[secretKeyData subdataWithRange:(NSRange){header.headerLength, header.bodyLength}]];
+    let s2kRange = [secretKeyBody rangeOfData:PGPNN([secretKeyPacket.s2k export:nil]) options:0 range:(NSRange){0, secretKeyBody.length}];
+    XCTAssertNotEqual(s2kRange.location, (NSUInteger)NSNotFound);
+    [secretKeyBody replaceBytesInRange:s2kRange withBytes:s2kData.bytes length:s2kData.length];
+    XCTAssertNil([PGPSecretKeyPacket packetWithBody:secretKeyBody]);
+
+    let argon2SecretKeyPacket = PGPCast(secretKeyPacket.copy, PGPSecretKeyPacket);
+    argon2SecretKeyPacket.s2k = s2k;
+    NSError *exportError = nil;
+    XCTAssertNil([argon2SecretKeyPacket export:&exportError]);
+    XCTAssertNotNil(exportError);
+    XCTAssertNil([argon2SecretKeyPacket decryptedWithPassphrase:@"password" error:nil]);
+
+    // Secret key protected with Argon2 and AEAD (S2K usage 253)
+    let aeadKeyGenerator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    aeadKeyGenerator.argon2UnlockDuration = 0.05;
+    let aeadKey = [aeadKeyGenerator generateFor:@"test+argon2-aead@example.com" passphrase:@"password"];
+    let aeadKeyData = PGPNN([aeadKey export:PGPKeyTypeSecret error:nil]);
+    let readKey = [ObjectivePGP readKeysFromData:aeadKeyData error:nil].firstObject;
+    XCTAssertNotNil(readKey);
+    XCTAssertTrue(readKey.isEncryptedWithPassword);
+    let readSecretKeyPacket = PGPNN(PGPCast(readKey.secretKey.primaryKeyPacket, PGPSecretKeyPacket));
+    XCTAssertEqual(readSecretKeyPacket.s2kUsage, PGPS2KUsageEncryptedAEAD);
+    XCTAssertEqual(readSecretKeyPacket.aeadAlgorithm, PGPAEADOCB);
+    XCTAssertEqual(readSecretKeyPacket.s2k.specifier, PGPS2KSpecifierArgon2);
+    XCTAssertEqualObjects(PGPNN([readSecretKeyPacket export:nil]), PGPNN([PGPCast(aeadKey.secretKey.primaryKeyPacket, PGPSecretKeyPacket) export:nil]));
+
+    NSError *wrongPassphraseError = nil;
+    XCTAssertNil([PGPNN(readKey) decryptedWithPassphrase:@"wrong" error:&wrongPassphraseError]);
+    XCTAssertEqual(wrongPassphraseError.code, PGPErrorPassphraseInvalid);
+    let decryptedKey = [PGPNN(readKey) decryptedWithPassphrase:@"password" error:nil];
+    XCTAssertNotNil(decryptedKey);
+    XCTAssertFalse(decryptedKey.isEncryptedWithPassword);
+
+    let message = [@"argon2" dataUsingEncoding:NSUTF8StringEncoding];
+    let signature = [ObjectivePGP sign:message detached:YES usingKeys:@[PGPNN(readKey)] passphraseForKey:^NSString * _Nullable(PGPKey * _Nonnull k) { return @"password"; } error:nil];
+    XCTAssertNotNil(signature);
+    XCTAssertTrue([ObjectivePGP verify:message withSignature:PGPNN(signature) usingKeys:@[PGPNN(readKey)] passphraseForKey:nil error:nil]);
+
+    let calibrated = [PGPS2K argon2S2KWithTargetDuration:0.05];
+    XCTAssertEqual(calibrated.specifier, PGPS2KSpecifierArgon2);
+    XCTAssertGreaterThanOrEqual(calibrated.argon2Passes, 1);
+    XCTAssertGreaterThanOrEqual(calibrated.argon2Parallelism, 1);
+}
+
+- (void)testEncryptWithPassphrase {
+    let message = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+
+    let iterationsCount = [PGPS2K calibratedIterationsCountForHashAlgorithm:PGPHashSHA256];
+    XCTAssertGreaterThanOrEqual(iterationsCount, 96);
+    XCTAssertEqual([PGPS2K calibratedIterationsCountForHashAlgorithm:PGPHashSHA256], iterationsCount);
+
+    NSError *encryptError;
+    let encryptedMessage = [ObjectivePGP encrypt:message withPassphrase:@"passphrase" error:&encryptError];
+    XCTAssertNil(encryptError);
+    XCTAssertNotNil(encryptedMessage);
+
+    let decryptedMessage = [ObjectivePGP decrypt:PGPNN(encryptedMessage) andVerifySignature:NO usingKeys:@[] passphraseForKey:^NSString * _Nullable(PGPKey * _Nullable k) { return @"passphrase"; } error:nil];
+    XCTAssertEqualObjects(decryptedMessage, message);
+
+    let wrongPassphraseMessage = [ObjectivePGP decrypt:PGPNN(encryptedMessage) andVerifySignature:NO usingKeys:@[] passphraseForKey:^NSString * _Nullable(PGPKey * _Nullable k) { return @"wrong"; } error:nil];
+    XCTAssertNil(wrongPassphraseMessage);
+
+    // Passphrase and the key
+    let key = [[[PGPKeyGenerator alloc] init] generateFor:@"test+passphrase@example.com" passphrase:nil];
+    let encryptedMessage2 = [ObjectivePGP encrypt:message withPassphrase:@"passphrase" addSignature:NO usingKeys:@[key] passphraseForKey:nil error:&encryptError];
+    XCTAssertNil(encryptError);
+
+    let decryptedWithKey = [ObjectivePGP decrypt:PGPNN(encryptedMessage2) andVerifySignature:NO usingKeys:@[key] passphraseForKey:nil error:nil];
+    XCTAssertEqualObjects(decryptedWithKey, message);
+    let decryptedWithPassphrase = [ObjectivePGP decrypt:PGPNN(encryptedMessage2) andVerifySignature:NO usingKeys:@[] passphraseForKey:^NSString * _Nullable(PGPKey * _Nullable k) { return @"passphrase"; } error:nil];
+    XCTAssertEqualObjects(decryptedWithPassphrase, message);
+}
+
+- (void)ed25519Signatures:(NSUInteger)count digests:(NSMutableArray<NSData *> *)digests signatures:(NSMutableArray<NSData *> *)signatures publicKeys:(NSMutableArray<NSData *> *)publicKeys {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:256 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    let keys = @[[generator generateFor:@"test+ed25519-1@example.com" passphrase:nil], [generator generateFor:@"test+ed25519-2@example.com" passphrase:nil]];
+    for (NSUInteger i = 0; i < count; i++) {
+        let key = keys[i % keys.count];
+        let Q = PGPNN([[key.signingSecretKey publicMPI:PGPMPIdentifierQ] bodyData]);
+        let message = [[NSString stringWithFormat:@"message %@", @(i)] dataUsingEncoding:NSUTF8StringEncoding];
+        let mpis = [PGPEC sign:message key:key withHashAlgorithm:PGPHashSHA256];
+        [digests addObject:[message pgp_HashedWithAlgorithm:PGPHashSHA256]];
+        [signatures addObject:PGPNN([PGPEC ed25519SignatureDataWithR:mpis[0].bodyData s:mpis[1].bodyData])];
+        [publicKeys addObject:[Q subdataWithRange:(NSRange){1, Q.length - 1}]];
+    }
+}
+
+- (void)testEd25519VerificationOfManySignatures {
+    let digests = [NSMutableArray<NSData *> array];
+    let signatures = [NSMutableArray<NSData *> array];
+    let publicKeys = [NSMutableArray<NSData *> array];
+    [self ed25519Signatures:64 digests:digests signatures:signatures publicKeys:publicKeys];
+    XCTAssertEqual([PGPEC verifyEd25519Digests:digests signatures:signatures publicKeys:publicKeys].count, (NSUInteger)0);
+
+    // Bad signatures are pointed out
+    NSMutableData *signature = [signatures[5] mutableCopy];
+    ((UInt8 *)signature.mutableBytes)[10] ^= 0x01;
+    signatures[5] = signature;
+    digests[40] = [[@"other message" dataUsingEncoding:NSUTF8StringEncoding] pgp_HashedWithAlgorithm:PGPHashSHA256];
+    publicKeys[63] = publicKeys[62];
+    let invalid = [PGPEC verifyEd25519Digests:digests signatures:signatures publicKeys:publicKeys];
+    XCTAssertEqualObjects(invalid, ([NSIndexSet indexSetWithIndexes:@[@5, @40, @63]]));
+
+    // Mismatched counts fail every signature
+    [publicKeys removeLastObject];
+    XCTAssertEqualObjects([PGPEC verifyEd25519Digests:digests signatures:signatures publicKeys:publicKeys], [NSIndexSet indexSetWithIndexesInRange:(NSRange){0, 64}]);
+}
+
+- (void)measureEd25519VerificationOfBatchSize:(NSUInteger)batchSize {
+    let digests = [NSMutableArray<NSData *> array];
+    let signatures = [NSMutableArray<NSData *> array];
+    let publicKeys = [NSMutableArray<NSData *> array];
+    [self ed25519Signatures:batchSize digests:digests signatures:signatures publicKeys:publicKeys];
+
+    // 1024 signatures per iteration
+    let rounds = 1024 / batchSize;
+    [self measureBlock:^{
+        for (NSUInteger round = 0; round < rounds; round++) {
+            XCTAssertEqual([PGPEC verifyEd25519Digests:digests signatures:signatures publicKeys:publicKeys].count, (NSUInteger)0);
+        }
+    }];
+}
+
+- (void)testEd25519VerificationPerformance {
+    [self measureEd25519VerificationOfBatchSize:1];
+}
+
+- (void)testEd25519VerificationOfBatch16Performance {
+    [self measureEd25519VerificationOfBatchSize:16];
+}
+
+- (void)testEd25519VerificationOfBatch256Performance {
+    [self measureEd25519VerificationOfBatchSize:256];
+}
+
+- (void)testECDSA_sign_verify_encrypt {
+    for (NSNumber *curve in @[@(PGPCurveP256), @(PGPCurveP384), @(PGPCurveP521), @(PGPCurveBrainpoolP256r1), @(PGPCurveBrainpoolP512r1)]) {
+        let keyGenerator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmECDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA512];
+        keyGenerator.curveKind = (PGPCurve)curve.intValue;
+        let key = [keyGenerator generateFor:@"test+ecdsa@example.com" passphrase:nil];
+        XCTAssertNotNil(key);
+
+        let keys = [ObjectivePGP readKeysFromData:PGPNN([key export:PGPKeyTypeSecret error:nil]) error:nil];
+        XCTAssertEqual(keys.count, (NSUInteger)1);
+
+        let plaintext = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+        NSError *signError;
+        let signature = [ObjectivePGP sign:plaintext detached:YES usingKeys:keys passphraseForKey:nil error:&signError];
+        XCTAssertNil(signError);
+        XCTAssertNotNil(signature);
+
+        NSError *verifyError;
+        XCTAssertTrue([ObjectivePGP verify:plaintext withSignature:PGPNN(signature) usingKeys:keys passphraseForKey:nil error:&verifyError]);
+        XCTAssertNil(verifyError);
+        XCTAssertFalse([ObjectivePGP verify:[@"other message" dataUsingEncoding:NSUTF8StringEncoding] withSignature:PGPNN(signature) usingKeys:keys passphraseForKey:nil error:nil]);
+
+        // ECDH subkey on the same curve
+        NSError *encryptError;
+        let encryptedData = [ObjectivePGP encrypt:plaintext addSignature:YES usingKeys:keys passphraseForKey:nil error:&encryptError];
+        XCTAssertNil(encryptError);
+        XCTAssertNotNil(encryptedData);
+
+        NSError *decryptError;
+        let decrypted = [ObjectivePGP decrypt:PGPNN(encryptedData) andVerifySignature:YES usingKeys:keys passphraseForKey:nil error:&decryptError];
+        XCTAssertNil(decryptError);
+        XCTAssertEqualObjects(plaintext, decrypted);
+    }
+}
+
+// Signs and verifies 64 times per iteration.
+- (void)measureSigningWithKey:(PGPKey *)key {
+    let message = [@"test message" dataUsingEncoding:NSUTF8StringEncoding];
+    let rounds = 64;
+    [self measureBlock:^{
+        for (int round = 0; round < rounds; round++) {
+            let signature = [ObjectivePGP sign:message detached:YES usingKeys:@[key] passphraseForKey:nil error:nil];
+            XCTAssertNotNil(signature);
+            // Verify with the public key, not the cached result.
+            [PGPVerificationCache.sharedCache removeAllKeys];
+            XCTAssertTrue([ObjectivePGP verify:message withSignature:PGPNN(signature) usingKeys:@[key] passphraseForKey:nil error:nil]);
+        }
+    }];
+}
+
+- (void)testRSASigningPerformance {
+    [self measureSigningWithKey:[[[PGPKeyGenerator alloc] init] generateFor:@"test+rsa@example.com" passphrase:nil]];
+}
+
+- (void)testEd25519SigningPerformance {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmEdDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    [self measureSigningWithKey:[generator generateFor:@"test+ed25519@example.com" passphrase:nil]];
+}
+
+- (void)testECDSASigningPerformance {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmECDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    [self measureSigningWithKey:[generator generateFor:@"test+p256@example.com" passphrase:nil]];
+}
+
+- (void)testECDSABrainpoolSigningPerformance {
+    let generator = [[PGPKeyGenerator alloc] initWithAlgorithm:PGPPublicKeyAlgorithmECDSA keyBitsLength:0 cipherAlgorithm:PGPSymmetricAES256 hashAlgorithm:PGPHashSHA256];
+    generator.curveKind = PGPCurveBrainpoolP256r1;
+    [self measureSigningWithKey:[generator generateFor:@"test+brainpoolp256r1@example.com" passphrase:nil]];
+}
+
 @end